@@ -0,0 +1,26 @@
+﻿using System;
+
+namespace BarCodeFinder
+{
+    /// <summary>
+    /// How the single block of native memory of a <see cref="BarCodeFinder"/> or <see cref="BarCodeFindContextArray"/> is allocated.
+    /// </summary>
+    [Flags]
+    public enum BarCodeArenaOptions : int
+    {
+        /// <summary>
+        /// Normal pages, which are faulted in when they are first written.
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Try to use huge (large) pages. On Windows, this needs the 'Lock pages in memory' privilege. Normal pages are used when huge pages are not available.
+        /// </summary>
+        HugePages = 1,
+
+        /// <summary>
+        /// Touch every page when the memory is allocated, so that no search pays for the first write to a page.
+        /// </summary>
+        Prefault = 2
+    }
+}
@@ -0,0 +1,71 @@
+﻿using BarCodeFinder.Native;
+using System;
+using System.Drawing;
+
+namespace BarCodeFinder
+{
+    /// <summary>
+    /// The appearances of each bar code in each frame of a batch that was searched by <see cref="BarCodeFinder.FindBatch"/>. They are copied out of the
+    /// native memory in one piece, so they stay valid after the next search.
+    /// </summary>
+    public sealed class BarCodeBatchResults
+    {
+        private readonly BarCodeFrameMatch[] matches;
+        private readonly ulong[] matchCounts;
+        private readonly int appearanceCapacityPerBarCode;
+
+        internal BarCodeBatchResults(BarCodeFrameMatch[] matches, ulong[] matchCounts, int frameCount, int barCodeCount, int appearanceCapacityPerBarCode)
+        {
+            this.matches = matches;
+            this.matchCounts = matchCounts;
+            this.FrameCount = frameCount;
+            this.BarCodeCount = barCodeCount;
+            this.appearanceCapacityPerBarCode = appearanceCapacityPerBarCode;
+        }
+
+        /// <summary>
+        /// The number of frames that were searched.
+        /// </summary>
+        public int FrameCount { get; private set; }
+
+        /// <summary>
+        /// The number of bar codes that were searched for, in the order of the <see cref="BarCodeFindContextArray"/>.
+        /// </summary>
+        public int BarCodeCount { get; private set; }
+
+        /// <summary>
+        /// Gets the number of appearances of a bar code in a frame.
+        /// </summary>
+        public int GetAppearanceCount(int frame, int barCode)
+        {
+            return (int)this.matchCounts[GetCountIndex(frame, barCode)];
+        }
+
+        /// <summary>
+        /// Gets the appearances of a bar code in a frame, sorted by descending match score.
+        /// </summary>
+        /// <param name="frame">The index of the frame in the batch.</param>
+        /// <param name="barCode">The index of the bar code in the <see cref="BarCodeFindContextArray"/>.</param>
+        public BarCodeAppearance[] GetAppearances(int frame, int barCode)
+        {
+            int count = (int)this.matchCounts[GetCountIndex(frame, barCode)];
+            int first = ((frame * this.BarCodeCount) + barCode) * this.appearanceCapacityPerBarCode;
+            BarCodeAppearance[] appearances = new BarCodeAppearance[count];
+            for (int i = 0; i < count; i++)
+            {
+                BarCodeFrameMatch match = this.matches[first + i];
+                appearances[i] = new BarCodeAppearance(Rectangle.FromLTRB(match.FirstBoxLeft, match.FirstBoxTop, match.FirstBoxRight, match.FirstBoxBottom), Rectangle.FromLTRB(match.SecondBoxLeft, match.SecondBoxTop, match.SecondBoxRight, match.SecondBoxBottom), new Point(match.ColorStartX, match.ColorStartY), new Point(match.ColorEndX, match.ColorEndY), match.MatchScore);
+            }
+            return appearances;
+        }
+
+        private int GetCountIndex(int frame, int barCode)
+        {
+            if (frame < 0 || frame >= this.FrameCount)
+                throw new ArgumentOutOfRangeException(nameof(frame));
+            if (barCode < 0 || barCode >= this.BarCodeCount)
+                throw new ArgumentOutOfRangeException(nameof(barCode));
+            return (frame * this.BarCodeCount) + barCode;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+﻿namespace BarCodeFinder
+{
+    /// <summary>
+    /// A conversion between two pixel layouts (see <see cref="BitmapHelper.Convert"/>).
+    /// </summary>
+    public enum BarCodeConversion : int
+    {
+        /// <summary>
+        /// RGBA to BGRA, or BGRA to RGBA. The destination may be the same as the source if both strides are the same.
+        /// </summary>
+        SwapRedBlue = 0,
+
+        /// <summary>
+        /// RGB24 to RGBA (or BGR24 to BGRA), with an alpha of 255.
+        /// </summary>
+        Rgb24ToRgba8 = 1,
+
+        /// <summary>
+        /// BGR24 to RGBA (or RGB24 to BGRA), with an alpha of 255.
+        /// </summary>
+        Bgr24ToRgba8 = 2,
+
+        /// <summary>
+        /// RGBA to RGB24 (or BGRA to BGR24). The destination may be the same as the source if both strides are the same.
+        /// </summary>
+        Rgba8ToRgb24 = 3,
+
+        /// <summary>
+        /// BGRA to RGB24 (or RGBA to BGR24). The destination may be the same as the source if both strides are the same.
+        /// </summary>
+        Bgra8ToRgb24 = 4
+    }
+}
@@ -11,29 +11,21 @@ namespace BarCodeFinder
         private List<BarCodeFindContext> contexts = new List<BarCodeFindContext>(16);
         internal IntPtr nativePointer;
 
-        public BarCodeFindContextArray(IReadOnlyCollection<BarCode> barCodes, float minMatchScore, int minLineDistance = 8, int appearanceCapacityPerBarCode = 16)
+        /// <summary>
+        /// The number of appearances that each bar code keeps, which is also the number that each bar code keeps per frame of a batch.
+        /// </summary>
+        internal readonly int appearanceCapacityPerBarCode;
+
+        /// <param name="arenaOptions">How the native memory is allocated. The array and the buffers of every bar code are carved from one block of memory.</param>
+        public BarCodeFindContextArray(IReadOnlyCollection<BarCode> barCodes, float minMatchScore, int minLineDistance = 8, int appearanceCapacityPerBarCode = 16, BarCodeArenaOptions arenaOptions = BarCodeArenaOptions.None)
         {
             if (barCodes == null)
                 throw new ArgumentNullException(nameof(barCodes));
-
-            //Make sure all BarCodes have the same number of colors (section count)
-            int colorCount = -1;
-            foreach(var code in barCodes)
-            {
-                if (colorCount == -1)
-                {
-                    colorCount = code.Count;
-                }
-                else
-                {
-                    if (code.Count != colorCount)
-                        throw new ArgumentException("All of the "+nameof(BarCode)+"s must have the same number of colors (aka section count).", nameof(barCodes));
-                }
-            }
+            this.appearanceCapacityPerBarCode = appearanceCapacityPerBarCode;
 
             //Allocate the entire array
-            nativePointer = Imports.AllocateBarCodeFindContextArray((ulong)barCodes.Count);
-            if(nativePointer != null)
+            nativePointer = Imports.AllocateBarCodeFindContextArrayInArena((ulong)barCodes.Count, (ulong)appearanceCapacityPerBarCode, (int)arenaOptions);
+            if(nativePointer != IntPtr.Zero)
             {
                 //Allocate each context
                 int index = 0;
@@ -0,0 +1,68 @@
+﻿namespace BarCodeFinder
+{
+    /// <summary>
+    /// A value that the native library records for each single-threaded search, when it is compiled with BAR_CODE_STATS (see <see cref="BarCodeFinder.EnableStats"/>).
+    /// </summary>
+    public enum BarCodeFindCounter : int
+    {
+        /// <summary>
+        /// Nanoseconds spent finding the runs of yellow pixels and the yellow regions, which are found in a single pass.
+        /// </summary>
+        YellowNanoseconds = 0,
+
+        /// <summary>
+        /// Nanoseconds spent pairing the yellow regions and reading the colorful lines between them.
+        /// </summary>
+        AppearanceNanoseconds = 1,
+
+        /// <summary>
+        /// Nanoseconds spent matching the colorful lines to the bar codes.
+        /// </summary>
+        MatchNanoseconds = 2,
+
+        /// <summary>
+        /// Nanoseconds spent in the whole search.
+        /// </summary>
+        TotalNanoseconds = 3,
+
+        /// <summary>
+        /// The number of yellow pixels.
+        /// </summary>
+        YellowPixels = 4,
+
+        /// <summary>
+        /// The number of runs of yellow pixels.
+        /// </summary>
+        ScanLines = 5,
+
+        /// <summary>
+        /// The number of yellow regions.
+        /// </summary>
+        YellowBoxes = 6,
+
+        /// <summary>
+        /// The number of yellow regions that may be cut short because a buffer was full.
+        /// </summary>
+        IncompleteBoxes = 7,
+
+        /// <summary>
+        /// The number of pairs of yellow regions whose line was followed.
+        /// </summary>
+        Pairs = 8,
+
+        /// <summary>
+        /// The number of pixels that were read to find where the colorful part of each line begins and ends.
+        /// </summary>
+        EndpointPixels = 9,
+
+        /// <summary>
+        /// The number of pixels that were read on the colorful part of each line.
+        /// </summary>
+        ReadPixels = 10,
+
+        /// <summary>
+        /// The number of colorful lines that were kept for matching.
+        /// </summary>
+        Appearances = 11
+    }
+}
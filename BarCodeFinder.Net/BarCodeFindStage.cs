@@ -0,0 +1,28 @@
+﻿namespace BarCodeFinder
+{
+    /// <summary>
+    /// A stage of a search whose native buffer has a fixed capacity (see <see cref="BarCodeFinder.GetStageUsage"/>).
+    /// </summary>
+    public enum BarCodeFindStage : int
+    {
+        /// <summary>
+        /// The runs of yellow pixels of the most recent rows (the scanLineCapacity of the finder).
+        /// </summary>
+        ScanLines = 0,
+
+        /// <summary>
+        /// The yellow regions (the smaller of the yellowBoxCapacity and tempIndexCapacity of the finder).
+        /// </summary>
+        YellowBoxes = 1,
+
+        /// <summary>
+        /// The colorful lines between pairs of yellow regions (the appearanceCapacity of the finder).
+        /// </summary>
+        Appearances = 2,
+
+        /// <summary>
+        /// The best matches of each bar code (the appearanceSortBufferCapacity of the finder).
+        /// </summary>
+        Matches = 3
+    }
+}
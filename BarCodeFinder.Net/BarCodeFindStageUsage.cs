@@ -0,0 +1,28 @@
+﻿namespace BarCodeFinder
+{
+    /// <summary>
+    /// How much of the native buffer of a <see cref="BarCodeFindStage"/> a search needed.
+    /// </summary>
+    public struct BarCodeFindStageUsage
+    {
+        /// <summary>
+        /// The number of values that the buffer can hold.
+        /// </summary>
+        public ulong Capacity;
+
+        /// <summary>
+        /// The most values that the buffer held at once during the last search.
+        /// </summary>
+        public ulong Used;
+
+        /// <summary>
+        /// The greatest <see cref="Used"/> of every search so far.
+        /// </summary>
+        public ulong HighWater;
+
+        /// <summary>
+        /// True if the buffer was full during the last search, so some bar codes may have gone unnoticed.
+        /// </summary>
+        public bool Overflowed;
+    }
+}
@@ -1,5 +1,6 @@
 ﻿using BarCodeFinder.Native;
 using System;
+using System.Drawing;
 
 namespace BarCodeFinder
 {
@@ -10,17 +11,221 @@ namespace BarCodeFinder
         /// </summary>
         private IntPtr barCodeFindTemporaryMemory;
 
-        public BarCodeFinder(uint scanLineCapacity = 1080 * 16, uint yellowBoxCapacity = 512 * 16, uint tempIndexCapacity = 512 * 16, uint appearanceCapacity = 512 * 16, uint appearanceSortBufferCapacity = 512)
+        /// <summary>
+        /// Pointer to the native 'BarCodeFindWorkers' structure, or zero when searching on the calling thread only.
+        /// </summary>
+        private IntPtr barCodeFindWorkers;
+
+        /// <summary>
+        /// Pointer to the native 'BarCodeTracker' structure, or zero until <see cref="Track"/> is first called.
+        /// </summary>
+        private IntPtr barCodeTracker;
+
+        /// <summary>
+        /// Pointer to the native 'BarCodePyramid' structure, or zero until <see cref="FindCoarse"/> is first called.
+        /// </summary>
+        private IntPtr barCodePyramid;
+
+        /// <param name="appearanceCapacity">The maximum number of colorful lines that are read in each search. The native memory for them grows as
+        /// lines are found, and only holds the sections of the bar codes' color counts.</param>
+        /// <param name="threadCount">The number of threads that each search is spread across, including the calling thread. Zero or less
+        /// selects the number of logical processors. The results are the same for any number of threads.</param>
+        /// <param name="maxPairDistance">The maximum distance, in pixels, between two yellow regions that are read as the ends of a bar code.
+        /// Zero means no limit.</param>
+        /// <param name="maxPairNeighbors">If not zero, each yellow region is only paired with this many of its nearest yellow regions (at most 64).</param>
+        /// <param name="arenaOptions">How the native buffers are allocated. They are all carved from one block of memory.</param>
+        public BarCodeFinder(uint scanLineCapacity = 1080 * 16, uint yellowBoxCapacity = 512 * 16, uint tempIndexCapacity = 512 * 16, uint appearanceCapacity = 512 * 16, uint appearanceSortBufferCapacity = 512, int threadCount = 1, int maxPairDistance = 0, int maxPairNeighbors = 0, BarCodeArenaOptions arenaOptions = BarCodeArenaOptions.None)
         {
-            IntPtr pointer = Imports.AllocateBarCodeFindTemporaryMemory(scanLineCapacity, yellowBoxCapacity, tempIndexCapacity, appearanceCapacity, appearanceSortBufferCapacity);
+            IntPtr pointer = Imports.AllocateBarCodeFindTemporaryMemoryInArena(scanLineCapacity, yellowBoxCapacity, tempIndexCapacity, appearanceCapacity, appearanceSortBufferCapacity, (int)arenaOptions);
             if (pointer == IntPtr.Zero)
                 throw new InvalidOperationException("Failed to allocate the native memory. Perhaps an argument was too large.");
             this.barCodeFindTemporaryMemory = pointer;
+            Imports.SetBarCodeFindPairing(pointer, maxPairDistance, maxPairNeighbors);
+
+            if (threadCount != 1)
+            {
+                this.barCodeFindWorkers = Imports.AllocateBarCodeFindWorkers(threadCount);
+                if (this.barCodeFindWorkers == IntPtr.Zero)
+                {
+                    Imports.FreeBarCodeFindTemporaryMemory(this.barCodeFindTemporaryMemory);
+                    this.barCodeFindTemporaryMemory = IntPtr.Zero;
+                    throw new InvalidOperationException("Failed to create the native worker threads.");
+                }
+            }
+        }
+
+        /// <summary>
+        /// Lets the native buffers grow, up to these capacities, after each search in which they were full. Each full buffer at least doubles,
+        /// so a stream of similar frames only misses bar codes in the first few frames. Zero keeps a buffer at its current capacity.
+        /// </summary>
+        public void SetMemoryGrowth(uint maxScanLineCapacity, uint maxYellowBoxCapacity, uint maxAppearanceCapacity, uint maxAppearanceSortBufferCapacity)
+        {
+            Imports.SetBarCodeFindMemoryGrowth(this.barCodeFindTemporaryMemory, maxScanLineCapacity, maxYellowBoxCapacity, maxAppearanceCapacity, maxAppearanceSortBufferCapacity);
+        }
+
+        /// <summary>
+        /// Gets how much of the native buffer of a <see cref="BarCodeFindStage"/> the last search needed, and whether it was full. The capacity
+        /// is read after the buffer grew (see <see cref="SetMemoryGrowth"/>).
+        /// </summary>
+        public BarCodeFindStageUsage GetStageUsage(BarCodeFindStage stage)
+        {
+            BarCodeFindStageUsage usage;
+            if (!Imports.TryGetBarCodeFindStageUsage(this.barCodeFindTemporaryMemory, (int)stage, out usage.Capacity, out usage.Used, out usage.HighWater, out usage.Overflowed))
+                throw new ArgumentOutOfRangeException(nameof(stage));
+            return usage;
+        }
+
+        /// <summary>
+        /// Starts recording the timings and counters of each search (see <see cref="GetCounter"/>). They are only recorded by <see cref="Find(IntPtr, int, int, YellowConfig, BarCodeFindContextArray, int)"/>
+        /// and its overloads when the finder has a single thread.
+        /// </summary>
+        /// <param name="maxBarCodeCount">The number of bar codes whose kept appearances are recorded (see <see cref="GetKeptAppearanceCount"/>).</param>
+        /// <returns>False if the native library was compiled without BAR_CODE_STATS.</returns>
+        public bool EnableStats(int maxBarCodeCount)
+        {
+            return Imports.EnableBarCodeFindStats(this.barCodeFindTemporaryMemory, (ulong)maxBarCodeCount);
+        }
+
+        /// <summary>
+        /// Gets a <see cref="BarCodeFindCounter"/> of the last search. <see cref="EnableStats"/> must have succeeded.
+        /// </summary>
+        public ulong GetCounter(BarCodeFindCounter counter)
+        {
+            ulong value;
+            if (!Imports.TryGetBarCodeFindCounter(this.barCodeFindTemporaryMemory, (int)counter, out value))
+                throw new InvalidOperationException("Stats are not enabled, or the counter is not recognized.");
+            return value;
+        }
+
+        /// <summary>
+        /// Gets the number of appearances that a bar code kept in the last search. <see cref="EnableStats"/> must have succeeded.
+        /// </summary>
+        /// <param name="index">The index of the bar code in the <see cref="BarCodeFindContextArray"/>.</param>
+        public int GetKeptAppearanceCount(int index)
+        {
+            ulong count;
+            if (!Imports.TryGetBarCodeFindKeptAppearanceCount(this.barCodeFindTemporaryMemory, (ulong)index, out count))
+                throw new ArgumentOutOfRangeException(nameof(index));
+            return (int)count;
         }
 
         public void Find(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5)
         {
-            Imports.FindAppearancesOfBarCodeInterestsInBitmap(rgba8, width, height, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory);
+            if (this.barCodeFindWorkers != IntPtr.Zero)
+                Imports.FindAppearancesOfBarCodeInterestsInBitmapParallel(rgba8, width, height, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory, this.barCodeFindWorkers);
+            else
+                Imports.FindAppearancesOfBarCodeInterestsInBitmap(rgba8, width, height, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory);
+        }
+
+        /// <summary>
+        /// Searches an image in any <see cref="BarCodePixelFormat"/>, such as a camera frame, without converting it to RGBA first.
+        /// </summary>
+        /// <param name="pixels">The first byte of the image. For <see cref="BarCodePixelFormat.Nv12"/>, the chroma plane must follow the luma plane.</param>
+        /// <param name="stride">The number of bytes from the start of one row to the start of the next (such as <see cref="System.Drawing.Imaging.BitmapData.Stride"/>),
+        /// or zero if the rows are packed. For <see cref="BarCodePixelFormat.Nv12"/> it must also fit a chroma row, which is the width rounded up to
+        /// an even number of bytes; otherwise nothing is searched.</param>
+        public void Find(IntPtr pixels, int width, int height, int stride, BarCodePixelFormat format, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5)
+        {
+            Imports.FindAppearancesOfBarCodeInterestsInImage(pixels, width, height, (ulong)stride, (int)format, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory, this.barCodeFindWorkers);
+        }
+
+        /// <summary>
+        /// Searches a batch of frames, such as the latest frame of each of several cameras, in a single call. With more than one thread, each frame
+        /// is searched whole on one thread, and each thread keeps its own native memory (with the capacities and growth of this finder's).
+        /// </summary>
+        /// <param name="array">The bar codes to find. Only their settings are used: the appearances are returned in the <see cref="BarCodeBatchResults"/>,
+        /// and the contexts of <paramref name="array"/> are left as they were.</param>
+        public BarCodeBatchResults FindBatch(BarCodeFrame[] frames, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5)
+        {
+            if (frames == null)
+                throw new ArgumentNullException(nameof(frames));
+            if (array == null)
+                throw new ArgumentNullException(nameof(array));
+
+            BarCodeFrameMatch[] matches = new BarCodeFrameMatch[frames.Length * array.Count * array.appearanceCapacityPerBarCode];
+            ulong[] matchCounts = new ulong[frames.Length * array.Count];
+            if (!Imports.FindAppearancesOfBarCodeInterestsInImages(frames, (ulong)frames.Length, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory, this.barCodeFindWorkers, matches, matchCounts))
+                throw new ArgumentException("A frame has an unrecognized format or a stride that is smaller than a row (or an NV12 chroma row), or the native memory could not be allocated.", nameof(frames));
+            return new BarCodeBatchResults(matches, matchCounts, frames.Length, array.Count, array.appearanceCapacityPerBarCode);
+        }
+
+        /// <summary>
+        /// Converts an image between two pixel layouts, like <see cref="BitmapHelper.Convert"/>, but spreads a large image across the threads of this finder.
+        /// </summary>
+        public bool Convert(BarCodeConversion conversion, IntPtr src, int srcStride, IntPtr dst, int dstStride, int width, int height)
+        {
+            return Imports.ConvertBarCodePixels((int)conversion, src, (ulong)srcStride, dst, (ulong)dstStride, width, height, this.barCodeFindWorkers);
+        }
+
+        /// <summary>
+        /// Searches only some regions of a bitmap. Each bar code must lie entirely inside one region, and the regions should not overlap.
+        /// </summary>
+        public void FindInRegions(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, BarCodeFindContextArray array, Rectangle[] regions, int maxYellowSpacing = 5)
+        {
+            int[] nativeRegions = new int[regions.Length * 4];
+            for (int i = 0; i < regions.Length; i++)
+            {
+                nativeRegions[(i * 4) + 0] = regions[i].Left;
+                nativeRegions[(i * 4) + 1] = regions[i].Top;
+                nativeRegions[(i * 4) + 2] = regions[i].Right;
+                nativeRegions[(i * 4) + 3] = regions[i].Bottom;
+            }
+            Imports.FindAppearancesOfBarCodeInterestsInRegions(rgba8, width, height, yellowConfig, maxYellowSpacing, nativeRegions, (ulong)regions.Length, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory);
+        }
+
+        /// <summary>
+        /// Searches a large bitmap by first finding the yellow bars, and the pairs of them that may be bar codes, in a downsampled copy of it.
+        /// Only the pixels around those bars are searched at full size.
+        /// </summary>
+        /// <param name="scale">How many times smaller the downsampled copy is: 2, 4 or 8. Yellow bars and color sections that are smaller than about
+        /// this many pixels may be missed.</param>
+        public void FindCoarse(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5, int scale = 4)
+        {
+            if (this.barCodePyramid == IntPtr.Zero)
+            {
+                this.barCodePyramid = Imports.AllocateBarCodePyramid();
+                if (this.barCodePyramid == IntPtr.Zero)
+                    throw new InvalidOperationException("Failed to allocate the native pyramid.");
+            }
+            Imports.FindAppearancesOfBarCodeInterestsInBitmapCoarse(rgba8, width, height, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory, this.barCodePyramid, scale);
+        }
+
+        /// <summary>
+        /// Searches one frame of a video. Most frames are only searched near the bar codes that were found in the previous frame, so use the same
+        /// <paramref name="array"/> for every frame.
+        /// </summary>
+        /// <param name="fullScanInterval">The whole frame is searched at least once per this many frames, and after a bar code is lost.</param>
+        /// <param name="searchMargin">The number of pixels that a bar code may move between two frames without being lost.</param>
+        /// <returns>True if the whole frame was searched.</returns>
+        public bool Track(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5, int fullScanInterval = 30, int searchMargin = 16)
+        {
+            return Track(rgba8, width, height, 0, BarCodePixelFormat.Rgba8, yellowConfig, array, maxYellowSpacing, fullScanInterval, searchMargin);
+        }
+
+        /// <summary>
+        /// Searches one frame of a video, like <see cref="Track(IntPtr, int, int, YellowConfig, BarCodeFindContextArray, int, int, int)"/>, in any
+        /// <see cref="BarCodePixelFormat"/>.
+        /// </summary>
+        /// <param name="stride">The number of bytes from the start of one row to the start of the next, or zero if the rows are packed, with the same
+        /// rules as in <see cref="Find(IntPtr, int, int, int, BarCodePixelFormat, YellowConfig, BarCodeFindContextArray, int)"/>.</param>
+        public bool Track(IntPtr pixels, int width, int height, int stride, BarCodePixelFormat format, YellowConfig yellowConfig, BarCodeFindContextArray array, int maxYellowSpacing = 5, int fullScanInterval = 30, int searchMargin = 16)
+        {
+            if (this.barCodeTracker == IntPtr.Zero)
+            {
+                this.barCodeTracker = Imports.AllocateBarCodeTracker(fullScanInterval, searchMargin);
+                if (this.barCodeTracker == IntPtr.Zero)
+                    throw new InvalidOperationException("Failed to allocate the native tracker.");
+            }
+            return Imports.TrackBarCodeInterestsInImage(pixels, width, height, (ulong)stride, (int)format, yellowConfig, maxYellowSpacing, array.nativePointer, (ulong)array.Count, this.barCodeFindTemporaryMemory, this.barCodeFindWorkers, this.barCodeTracker);
+        }
+
+        /// <summary>
+        /// Makes the next call to <see cref="Track"/> search the whole frame, for example after a scene cut.
+        /// </summary>
+        public void ResetTracking()
+        {
+            if (this.barCodeTracker != IntPtr.Zero)
+                Imports.ResetBarCodeTracker(this.barCodeTracker);
         }
 
         #region IDisposable Support
@@ -34,9 +239,18 @@ namespace BarCodeFinder
                 {
                     if(barCodeFindTemporaryMemory != IntPtr.Zero)
                         Imports.FreeBarCodeFindTemporaryMemory(barCodeFindTemporaryMemory);
+                    if (barCodeFindWorkers != IntPtr.Zero)
+                        Imports.FreeBarCodeFindWorkers(barCodeFindWorkers);
+                    if (barCodeTracker != IntPtr.Zero)
+                        Imports.FreeBarCodeTracker(barCodeTracker);
+                    if (barCodePyramid != IntPtr.Zero)
+                        Imports.FreeBarCodePyramid(barCodePyramid);
                 }
 
                 barCodeFindTemporaryMemory = IntPtr.Zero;
+                barCodeFindWorkers = IntPtr.Zero;
+                barCodeTracker = IntPtr.Zero;
+                barCodePyramid = IntPtr.Zero;
                 IsDisposed = true;
             }
         }
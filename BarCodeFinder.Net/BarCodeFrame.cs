@@ -0,0 +1,46 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace BarCodeFinder
+{
+    /// <summary>
+    /// One frame of a batch that is searched by <see cref="BarCodeFinder.FindBatch"/>, such as the latest frame of one camera.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct BarCodeFrame
+    {
+        /// <summary>
+        /// The first byte of the frame. For <see cref="BarCodePixelFormat.Nv12"/>, the chroma plane must follow the luma plane.
+        /// </summary>
+        public IntPtr Pixels;
+
+        public int Width;
+
+        public int Height;
+
+        private ulong stride;
+
+        public BarCodePixelFormat Format;
+
+        /// <param name="stride">The number of bytes from the start of one row to the start of the next, or zero if the rows are packed.
+        /// For <see cref="BarCodePixelFormat.Nv12"/> it must also fit a chroma row, which is the width rounded up to an even number of bytes.</param>
+        public BarCodeFrame(IntPtr pixels, int width, int height, int stride, BarCodePixelFormat format)
+        {
+            this.Pixels = pixels;
+            this.Width = width;
+            this.Height = height;
+            this.stride = (ulong)stride;
+            this.Format = format;
+        }
+
+        /// <summary>
+        /// The number of bytes from the start of one row to the start of the next, or zero if the rows are packed.
+        /// For <see cref="BarCodePixelFormat.Nv12"/> it must also fit a chroma row, which is the width rounded up to an even number of bytes.
+        /// </summary>
+        public int Stride
+        {
+            get { return (int)this.stride; }
+            set { this.stride = (ulong)value; }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+﻿namespace BarCodeFinder
+{
+    /// <summary>
+    /// Defines the layout of the pixels of an image that is searched for bar codes.
+    /// </summary>
+    public enum BarCodePixelFormat : int
+    {
+        /// <summary>
+        /// Four bytes per pixel: red, green, blue and alpha.
+        /// </summary>
+        Rgba8 = 0,
+
+        /// <summary>
+        /// Four bytes per pixel: blue, green, red and alpha. This is the layout of <see cref="System.Drawing.Imaging.PixelFormat.Format32bppArgb"/> bitmaps.
+        /// </summary>
+        Bgra8 = 1,
+
+        /// <summary>
+        /// Three bytes per pixel: red, green and blue.
+        /// </summary>
+        Rgb24 = 2,
+
+        /// <summary>
+        /// Packed 4:2:2 YCbCr (BT.601 video range): each pair of pixels is stored as Y0, U, Y1, V.
+        /// </summary>
+        Yuyv = 3,
+
+        /// <summary>
+        /// Planar 4:2:0 YCbCr (BT.601 video range): a plane of Y bytes, followed by a plane of interleaved U, V bytes.
+        /// If the width is odd, each chroma row holds one more byte than a luma row, so the stride must be at least the width rounded up to an even number of bytes.
+        /// </summary>
+        Nv12 = 4
+    }
+}
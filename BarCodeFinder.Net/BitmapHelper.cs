@@ -14,5 +14,36 @@ namespace BarCodeFinder
         {
             Imports.ConvertFromRGBAToBGRA(src, dst, width, height);
         }
+
+        /// <summary>
+        /// Converts an image between two pixel layouts on the calling thread. Use <see cref="BarCodeFinder.Convert"/> to spread a large image across threads.
+        /// </summary>
+        /// <param name="srcStride">The number of bytes from the start of one source row to the start of the next, or zero if the rows are packed.</param>
+        /// <param name="dstStride">The number of bytes from the start of one destination row to the start of the next, or zero if the rows are packed.</param>
+        /// <returns>False if the arguments are not valid (see <see cref="BarCodeConversion"/>), in which case nothing was converted.</returns>
+        public static bool Convert(BarCodeConversion conversion, IntPtr src, int srcStride, IntPtr dst, int dstStride, int width, int height)
+        {
+            return Imports.ConvertBarCodePixels((int)conversion, src, (ulong)srcStride, dst, (ulong)dstStride, width, height, IntPtr.Zero);
+        }
+
+        /// <summary>
+        /// Interleaves three planes (red, green and blue) into RGBA pixels with an alpha of 255. Pass the planes in reverse order to get BGRA.
+        /// </summary>
+        /// <param name="planeStride">The number of bytes from the start of one row of a plane to the start of the next, or zero if the rows are packed.</param>
+        /// <param name="stride">The number of bytes from the start of one RGBA row to the start of the next, or zero if the rows are packed.</param>
+        public static bool InterleavePlanes(IntPtr reds, IntPtr greens, IntPtr blues, int planeStride, IntPtr rgba8, int stride, int width, int height)
+        {
+            return Imports.InterleaveBarCodePlanes(reds, greens, blues, (ulong)planeStride, rgba8, (ulong)stride, width, height, IntPtr.Zero);
+        }
+
+        /// <summary>
+        /// Splits RGBA pixels into three planes (red, green and blue). Pass the planes in reverse order to split BGRA pixels.
+        /// </summary>
+        /// <param name="stride">The number of bytes from the start of one RGBA row to the start of the next, or zero if the rows are packed.</param>
+        /// <param name="planeStride">The number of bytes from the start of one row of a plane to the start of the next, or zero if the rows are packed.</param>
+        public static bool SplitPlanes(IntPtr rgba8, int stride, IntPtr reds, IntPtr greens, IntPtr blues, int planeStride, int width, int height)
+        {
+            return Imports.SplitBarCodePlanes(rgba8, (ulong)stride, reds, greens, blues, (ulong)planeStride, width, height, IntPtr.Zero);
+        }
     }
 }
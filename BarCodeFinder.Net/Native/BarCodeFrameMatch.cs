@@ -0,0 +1,19 @@
+﻿using System.Runtime.InteropServices;
+
+namespace BarCodeFinder.Native
+{
+    /// <summary>
+    /// The native 'BarCodeFrameMatch' structure: one appearance that was found by a batch search.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct BarCodeFrameMatch
+    {
+        public int ColorStartX, ColorStartY, ColorEndX, ColorEndY;
+
+        public int FirstBoxLeft, FirstBoxTop, FirstBoxRight, FirstBoxBottom;
+
+        public int SecondBoxLeft, SecondBoxTop, SecondBoxRight, SecondBoxBottom;
+
+        public float MatchScore;
+    }
+}
@@ -13,22 +13,52 @@ namespace BarCodeFinder.Native
         [DllImport(Filename)]
         public static extern IntPtr AllocateBarCodeFindTemporaryMemory(ulong scanLineCapacity, ulong yellowBoxCapacity, ulong tempIndexBufferCapacity, ulong appearanceCapacity, ulong appearanceSortBufferCapacity);
 
+        [DllImport(Filename)]
+        public static extern IntPtr AllocateBarCodeFindTemporaryMemoryInArena(ulong scanLineCapacity, ulong yellowBoxCapacity, ulong tempIndexBufferCapacity, ulong appearanceCapacity, ulong appearanceSortBufferCapacity, int arenaFlags);
+
         [DllImport(Filename)]
         public static extern void FreeBarCodeFindTemporaryMemory(IntPtr pointer);
 
+        [DllImport(Filename)]
+        public static extern void SetBarCodeFindPairing(IntPtr barCodeFindTemporaryMemory, int maxPairDistance, int maxPairNeighbors);
+
+        [DllImport(Filename)]
+        public static extern void SetBarCodeFindMemoryGrowth(IntPtr barCodeFindTemporaryMemory, ulong maxScanLineCapacity, ulong maxYellowBoxCapacity, ulong maxAppearanceCapacity, ulong maxAppearanceSortBufferCapacity);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool TryGetBarCodeFindStageUsage(IntPtr barCodeFindTemporaryMemory, int stage, out ulong capacity, out ulong used, out ulong highWater, [MarshalAs(UnmanagedType.U1)] out bool overflowed);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool EnableBarCodeFindStats(IntPtr barCodeFindTemporaryMemory, ulong maxContextCount);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool TryGetBarCodeFindCounter(IntPtr barCodeFindTemporaryMemory, int counter, out ulong value);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool TryGetBarCodeFindKeptAppearanceCount(IntPtr barCodeFindTemporaryMemory, ulong contextIndex, out ulong count);
+
         [DllImport(Filename)]
         public static extern IntPtr AllocateBarCodeFindContextArray(ulong count);
 
+        [DllImport(Filename)]
+        public static extern IntPtr AllocateBarCodeFindContextArrayInArena(ulong count, ulong appearanceBufferCapacity, int arenaFlags);
+
         [DllImport(Filename)]
         public static extern void FreeBarCodeFindContextArray(IntPtr pointer);
 
         [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
         public static extern bool TryInitBarCodeFindContext(IntPtr contextArrayPointer, ulong contextIndex, ulong appearanceCapacity, int barCodeColorCount, [In] int[] barCodeColors, float minMatchScore, int minLineDistance);
 
         [DllImport(Filename)]
         public static extern int GetBarCodeAppearanceCount(IntPtr contextArrayPointer, ulong contextIndex);
 
         [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
         public static extern bool TryReadBarCodeAppearance(IntPtr contextArrayPointer, ulong contextIndex, ulong appearanceIndex, [Out] int[] points, [Out] float[] matchScore);
 
         [DllImport(Filename)]
@@ -37,10 +67,67 @@ namespace BarCodeFinder.Native
         [DllImport(Filename)]
         public static extern void FindAppearancesOfBarCodeInterestsInBitmap(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory);
 
+        [DllImport(Filename)]
+        public static extern void FindAppearancesOfBarCodeInterestsInRegions(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, int maxYellowSpacing, [In] int[] regions, ulong regionCount, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory);
+
+        [DllImport(Filename)]
+        public static extern IntPtr AllocateBarCodeFindWorkers(int threadCount);
+
+        [DllImport(Filename)]
+        public static extern void FreeBarCodeFindWorkers(IntPtr workers);
+
+        [DllImport(Filename)]
+        public static extern void FindAppearancesOfBarCodeInterestsInBitmapParallel(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodeFindWorkers);
+
+        [DllImport(Filename)]
+        public static extern IntPtr AllocateBarCodeTracker(int fullScanInterval, int searchMargin);
+
+        [DllImport(Filename)]
+        public static extern void FreeBarCodeTracker(IntPtr tracker);
+
+        [DllImport(Filename)]
+        public static extern void ResetBarCodeTracker(IntPtr tracker);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool TrackBarCodeInterestsInBitmap(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodeFindWorkers, IntPtr barCodeTracker);
+
+        [DllImport(Filename)]
+        public static extern void FindAppearancesOfBarCodeInterestsInImage(IntPtr pixels, int width, int height, ulong stride, int format, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodeFindWorkers);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool TrackBarCodeInterestsInImage(IntPtr pixels, int width, int height, ulong stride, int format, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodeFindWorkers, IntPtr barCodeTracker);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool FindAppearancesOfBarCodeInterestsInImages([In] BarCodeFrame[] frames, ulong frameCount, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodeFindWorkers, [Out] BarCodeFrameMatch[] matches, [Out] ulong[] matchCounts);
+
+        [DllImport(Filename)]
+        public static extern IntPtr AllocateBarCodePyramid();
+
+        [DllImport(Filename)]
+        public static extern void FreeBarCodePyramid(IntPtr pyramid);
+
+        [DllImport(Filename)]
+        public static extern void FindAppearancesOfBarCodeInterestsInBitmapCoarse(IntPtr rgba8, int width, int height, YellowConfig yellowConfig, int maxYellowSpacing, IntPtr barCodeFindContextArray, ulong barCodeFindContextArrayCount, IntPtr barCodeFindTemporaryMemory, IntPtr barCodePyramid, int scale);
+
         [DllImport(Filename)]
         public static extern void ConvertFromBGRAToRGBA(IntPtr src, IntPtr dst, int width, int height);
 
         [DllImport(Filename)]
         public static extern void ConvertFromRGBAToBGRA(IntPtr src, IntPtr dst, int width, int height);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool ConvertBarCodePixels(int conversion, IntPtr src, ulong srcStride, IntPtr dst, ulong dstStride, int width, int height, IntPtr barCodeFindWorkers);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool InterleaveBarCodePlanes(IntPtr reds, IntPtr greens, IntPtr blues, ulong planeStride, IntPtr rgba8, ulong stride, int width, int height, IntPtr barCodeFindWorkers);
+
+        [DllImport(Filename)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool SplitBarCodePlanes(IntPtr rgba8, ulong stride, IntPtr reds, IntPtr greens, IntPtr blues, ulong planeStride, int width, int height, IntPtr barCodeFindWorkers);
     }
 }
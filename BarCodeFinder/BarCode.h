@@ -1,96 +1,18 @@
 #pragma once
-#include <immintrin.h>
+#include "Platform.h"
+#include "YellowKernels.h"
+#include "MatchKernels.h"
+#include "BarCodeArena.h"
+#include "BarCodeStats.h"
 #include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 #include <limits.h>
 #include <assert.h>
 
-///<summary>Configuration that defines whether a pixel is considered 'yellow'.</summary>
-typedef struct YellowConfig
-{
-	///<summary>The maximum separation value between the red and the green channels.</summary>
-	uint8_t maxRedGreenSeparation;
-
-	///<summary>The maximum separation value between the red and the blue channels.</summary>
-	uint8_t minRedBlueSeparation;
-
-	///<summary>The minimum value for the red channel.</summary>
-	uint8_t minRed;
-} YellowConfig;
-
-///<summary>Configuration that defines whether a pixel is considered 'yellow' using AVX data types.</summary>
-typedef struct YellowConfigAVX
-{
-	///<summary>The separation between the red and green channels must be less than this value, stored in all epi32 positions.</summary>
-	__m256i redGreenSeparationLessThan;
-
-	///<summary>The separation between the red and blue channels must be larger than this value, stored in all epi32 positions.</summary>
-	__m256i redBlueSeparationGreaterThan;
-
-	///<summary>The red channel must be larger than this value, stored in all epi32 positions.</summary>
-	__m256i redGreaterThan;
-} YellowConfigAVX;
-
-///<summary>Checks whether a pixel is considered 'yellow' as defined by the <see cref="YellowConfig"/>.</summary>
-///<param name="r">The value of the pixel's red channel.</param>
-///<param name="g">The value of the pixel's green channel.</param>
-///<param name="b">The value of the pixel's blue channel.</param>
-///<param name="config">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow'.</param>
-///<returns>True if the pixel is considered yellow, otherwise false.</returns>
-__forceinline bool is_yellow(uint8_t r, uint8_t g, uint8_t b, YellowConfig config)
-{
-	uint8_t redGreenSeparation = abs(r - g);
-	int redBlueSeparation = (int)r - (int)b;
-	return redGreenSeparation <= config.maxRedGreenSeparation && redBlueSeparation >= config.minRedBlueSeparation && r >= config.minRed;
-}
-
-///<summary>Converts a <see cref="YellowConfig"/> to a <see cref="YellowConfigAVX"/>.</summary>
-///<param name="config">The source <see cref="YellowConfig"/>.</param>
-///<returns>The equivalent <see cref="YellowConfigAVX"/>.</returns>
-__forceinline YellowConfigAVX to_avx(YellowConfig config)
-{
-	YellowConfigAVX ret;
-
-	ret.redGreenSeparationLessThan = _mm256_set1_epi32(config.maxRedGreenSeparation + 1/*+1 to go from '<=' to '<'*/);
-	ret.redBlueSeparationGreaterThan = _mm256_set1_epi32(config.minRedBlueSeparation - 1/*-1 to go from '>=' to '>'*/);
-	ret.redGreaterThan = _mm256_set1_epi32(config.minRed - 1/*-1 to go from '>=' to '>'*/);
-
-	return ret;
-}
-
-///<summary>Checks whether pixels are yellow within a group of 8.</summary>
-///<param name="rgba8"><see cref="__m256i"/> containing the 8 pixels, stored in RGBA 8-bit format.</param>
-///<param name="config">The <see cref="YellowConfigAVX"/> that defines when a pixel is considered 'yellow.'</param>
-///<returns>A <see cref="__m256i"/> where each byte is 0 (no bits set) or -1 (all bits set) depending on whether
-///the pixel that contains that byte's channel is considered 'yellow.' So for a given pixel (4 channels: Red, Green
-///Blue, and Alpha), if that pixel in the <paramref name="rgba8"/> was considered 'yellow,' then all of those four
-///channels will be set to true (all bits set). If the pixel was not considered 'yellow,' then all bits in
-///those four channels will be clear.</returns>
-__forceinline __m256i _are_yellow(__m256i rgba8, YellowConfigAVX config)
-{
-	//Get the individual RGB channels
-	__m256i reds = _mm256_and_si256(rgba8, _mm256_set_epi8(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1));
-	__m256i greens = _mm256_and_si256(rgba8, _mm256_set_epi8(0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0));
-	__m256i blues = _mm256_and_si256(rgba8, _mm256_set_epi8(0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0));
-
-	//Move the bytes for greens and blues to the correct position (so we can treat them as epi32) [reds are already in the correct position]
-	greens = _mm256_shuffle_epi8(greens, _mm256_set_epi8(0, 0, 0, 29, 0, 0, 0, 25, 0, 0, 0, 21, 0, 0, 0, 17, 0, 0, 0, 13, 0, 0, 0, 9, 0, 0, 0, 5, 0, 0, 0, 1));//Byte value at '0' is '0' due to mask above
-	blues = _mm256_shuffle_epi8(blues, _mm256_set_epi8(0, 0, 0, 30, 0, 0, 0, 26, 0, 0, 0, 22, 0, 0, 0, 18, 0, 0, 0, 14, 0, 0, 0, 10, 0, 0, 0, 6, 0, 0, 0, 2));//Byte value at '0' is '0' due to mask above
-
-	//From here on, we can treat reds, greens, and blues as epi32 values
-
-	__m256i redSubGreen = _mm256_sub_epi32(reds, greens);
-	__m256i redSubBlue = _mm256_sub_epi32(reds, blues);
-
-	__m256i redPassed = _mm256_cmpgt_epi32(reds, config.redGreaterThan);
-	__m256i redSubGreenPassed = _mm256_cmpgt_epi32(config.redGreenSeparationLessThan, redSubGreen);
-	__m256i redSubBluePassed = _mm256_cmpgt_epi32(redSubBlue, config.redBlueSeparationGreaterThan);
-
-	//Since we compared using epi32, all channels for each pixel are set to true or false.
-	return _mm256_and_si256(redPassed, _mm256_and_si256(redSubGreenPassed, redSubBluePassed));
-}
-
 ///<summary>Copies an image, replacing 'yellow' pixels with a specific color.</summary>
 ///<param name="rgba8Source">The source image, in RGBA 8-bit format.</param>
 ///<param name="rgba8Dest">The destination image, in RGBA 8-bit format. May be equal to <paramref name="rgba8Source"/>.</param>
@@ -102,24 +24,8 @@ __forceinline __m256i _are_yellow(__m256i rgba8, YellowConfigAVX config)
 ///<param name="b">The blue component of the 'new' pixel (which will replace the 'yellow' pixels).</param>
 void show_yellow(const uint8_t * rgba8Source, uint8_t * rgba8Dest, int width, int height, YellowConfig config, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
-	YellowConfigAVX configAvx = to_avx(config);
-	const __m256i* groupSource = (const __m256i*)rgba8Source;
-	__m256i* groupDest = (__m256i*)rgba8Dest;
-	int pixelCount = width * height * 4/*RGBA*/;
-	assert(pixelCount % 32 == 0);
-	int m256iCount = pixelCount / (32);
-
-	__m256i color = _mm256_set_epi8(a, b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a, b, g, r);
-
-	for (int i = 0; i < m256iCount; i++)
-	{
-		__m256i results = _are_yellow(groupSource[i], configAvx);
-
-		__m256i src = _mm256_andnot_si256(results, groupSource[i]);
-		__m256i draw = _mm256_and_si256(results, color);
-
-		groupDest[i] = _mm256_or_si256(src, draw);
-	}
+	uint32_t color = (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+	get_yellow_kernels()->showYellow(rgba8Source, rgba8Dest, (size_t)width * (size_t)height, config, color);
 }
 
 ///<summary>Stores information about a line of 'yellow' pixels.</summary>
@@ -134,111 +40,172 @@ typedef struct YellowScanLine
 	///<summary>The y-position of the line.</summary>
 	int y;
 
-	///<summary>Flag that is internally used to determine whether to temporarily ignore this <see cref="YellowScanLine"/>.
+	///<summary>Index of the parent <see cref="YellowScanLine"/> in the union-find forest that is internally built by <see cref="find_yellow_rectangles"/>.
 	///The application should not read from or write to this field.</summary>
-	bool _ignore;
+	int _parent;
 } YellowScanLine;
 
+///<summary>The number of pixels that are classified per call to <see cref="YellowKernels.classifyRow"/>.
+///The packed bitmask for this many pixels is kept on the stack.</summary>
+#define YELLOW_ROW_CHUNK_PIXELS (4096)
+
+///<summary>The maximum number of <see cref="YellowScanLine"/>s that <see cref="_extract_yellow_runs"/> can complete from a single word.</summary>
+#define YELLOW_RUNS_PER_WORD (33)
+
+///<summary>State that <see cref="_extract_yellow_runs"/> keeps between the words of a row.</summary>
+typedef struct YellowRunExtractor
+{
+	///<summary>True if a line of yellow pixels reaches the end of the previous word.</summary>
+	bool onLine;
+
+	///<summary>The line that is still open if <see cref="onLine"/> is true.</summary>
+	YellowScanLine currentLine;
+} YellowRunExtractor;
+
+///<summary>Extracts the completed lines of yellow pixels from one word of a packed yellow bitmask.</summary>
+///<param name="state">The <see cref="YellowRunExtractor"/> of the row. It must start with <see cref="YellowRunExtractor.onLine"/> cleared.</param>
+///<param name="word">The word of the bitmask (see <see cref="YellowKernels.classifyRow"/>).</param>
+///<param name="wordX">The x-position of the pixel of bit 0.</param>
+///<param name="y">The y-position of the row.</param>
+///<param name="runs">Receives the completed lines, in order. Must be able to hold <see cref="YELLOW_RUNS_PER_WORD"/> lines.</param>
+///<returns>The number of lines that were completed.</returns>
+///<remarks>Bits beyond the width of a row are always clear, so a line can only stay open past the last word of a row if that word is
+///full. Each case below works on whole runs of bits rather than on individual pixels.</remarks>
+BAR_CODE_FORCEINLINE int _extract_yellow_runs(YellowRunExtractor* state, uint64_t word, int wordX, int y, YellowScanLine* runs)
+{
+	int count = 0;
+	if (state->onLine)
+	{
+		if (word == ~0ull)
+		{
+			//The whole word is yellow, so just expand the existing line
+			state->currentLine.end = wordX + 63;
+			return 0;
+		}
+
+		//The line continues through the low (leading) yellow pixels of this word, then ends
+		int continuedCount = count_trailing_zeros64(~word);
+		state->currentLine.end = wordX + continuedCount - 1;
+		runs[count++] = state->currentLine;
+		state->onLine = false;
+		word &= ~0ull << continuedCount;//continuedCount < 64 since the word was not full
+	}
+	else if (word == ~0ull)
+	{
+		//Starting a new line that covers the whole word
+		state->currentLine.start = wordX;
+		state->currentLine.end = wordX + 63;
+		state->currentLine.y = y;
+		state->currentLine._parent = 0;
+		state->onLine = true;
+		return 0;
+	}
+
+	//A run that reaches the high end of the word may continue into the next word, so keep it aside
+	int openStart = 64;
+	if (word >> 63)
+	{
+		openStart = 64 - count_leading_zeros64(~word);//~word is not zero since the word is not full
+		word &= ~(~0ull << openStart);
+	}
+
+	//All remaining runs start and end within this word
+	while (word != 0)
+	{
+		int start = count_trailing_zeros64(word);
+		int length = count_trailing_zeros64(~(word >> start));
+
+		runs[count].start = wordX + start;
+		runs[count].end = wordX + start + length - 1;
+		runs[count].y = y;
+		runs[count]._parent = 0;
+		count++;
+
+		word &= ~0ull << (start + length);//start + length < 64 since bit 63 is clear
+	}
+
+	if (openStart < 64)
+	{
+		//Starting a new line at the high end of the word
+		state->currentLine.start = wordX + openStart;
+		state->currentLine.end = wordX + 63;
+		state->currentLine.y = y;
+		state->currentLine._parent = 0;
+		state->onLine = true;
+	}
+	return count;
+}
+
 ///<summary>Finds all lines of consecutive 'yellow' pixels in an image.</summary>
-///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
-///<param name="width">The width of the image, measured in pixels.</param>
-///<param name="height">The height of the image, measured in pixels.</param>
+///<param name="image">The <see cref="BarCodeImage"/>, in any <see cref="BarCodePixelFormat"/>.</param>
 ///<param name="cfg">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow.'</param>
 ///<param name="dst">The destination <see cref="YellowScanLine"/> buffer.</param>
 ///<param name="maxCount">The maximum number of <see cref="YellowScanLine"/>s that can be stored in the <paramref name="dst"/> buffer.</param>
 ///<returns>The number of <see cref="YellowScanLine"/>s that have been found.</returns>
-size_t find_yellow_lines(const uint8_t * rgba8, int width, int height, YellowConfig cfg, YellowScanLine * dst, size_t maxCount)
+size_t find_yellow_lines_in_image(const BarCodeImage* image, YellowConfig cfg, YellowScanLine* dst, size_t maxCount)
 {
-	assert(width % 8 == 0);//Width must be divisible by 8 so it can fit inside the __m256i values
+	int width = image->width, height = image->height;
+	const YellowKernels* kernels = get_yellow_kernels();
+	uint64_t yellowBits[YELLOW_ROW_CHUNK_PIXELS / 64];
+	YellowScanLine runs[YELLOW_RUNS_PER_WORD];
 
-	YellowConfigAVX configAvx = to_avx(cfg);
-
-	const __m256i * blocks = (const __m256i*)rgba8;
 	size_t found = 0;
 	for (int y = 0; y < height; y++)
 	{
-		bool onLine = false;
-		YellowScanLine currentLine;
-		for (int x = 0; x < width; x += 8/*There are 8 pixels per __m256i*/)
+		const uint8_t* row = _get_image_row(image, y);
+		const uint8_t* chromaRow = _get_image_chroma_row(image, y);
+		YellowRunExtractor extractor;
+		extractor.onLine = false;
+		for (int chunkX = 0; chunkX < width; chunkX += YELLOW_ROW_CHUNK_PIXELS)
 		{
-			__m256i currentBlock = blocks[0];
-			blocks++;
-
-			__m256i yellowMask = _are_yellow(currentBlock, configAvx);
-			bool noneYellow = _mm256_testz_si256(yellowMask, yellowMask) != 0;
+			int chunkWidth = width - chunkX < YELLOW_ROW_CHUNK_PIXELS ? width - chunkX : YELLOW_ROW_CHUNK_PIXELS;
+			kernels->classifyImageRow[image->format](row, chromaRow, chunkX, chunkWidth, cfg, yellowBits);
 
-			if (noneYellow)
+			for (int x = 0; x < chunkWidth; x += 64)
 			{
-				//Very common case: There are no yellow pixels here.
-				if (onLine)
+				uint64_t word = yellowBits[x / 64];
+				if (word == 0 && !extractor.onLine)
+					continue;//Very common case: There are no yellow pixels here.
+
+				int runCount = _extract_yellow_runs(&extractor, word, chunkX + x, y, runs);
+				for (int i = 0; i < runCount; i++)
 				{
-					//The line has ended
 					if (found < maxCount)
-						dst[found++] = currentLine;
+						dst[found++] = runs[i];
 					else
 						return found;
-
-					onLine = false;
-				}
-				//Else we have nothing to do, just skip to the next block
-			}
-			else
-			{
-				//At least one pixel on the current block is yellow
-				for (int i = 0; i < 8/*8 pixels per __m256i block*/; i++)
-				{
-					bool isYellow = yellowMask.m256i_i32[i] != 0;
-					if (isYellow)
-					{
-						if (onLine)
-						{
-							//Just expand the existing line
-							currentLine.end++;
-						}
-						else
-						{
-							//Starting a new line
-							currentLine.start = x + i;
-							currentLine.end = currentLine.start;
-							currentLine.y = y;
-							currentLine._ignore = false;
-							onLine = true;
-						}
-					}
-					else
-					{
-						if (onLine)
-						{
-							//The line has ended
-							if (found < maxCount)
-								dst[found++] = currentLine;
-							else
-								return found;
-
-							onLine = false;
-						}
-						//Else nothing to do, just continue to the next pixel
-					}
 				}
 			}
 		}
 
 		//Now we are done searching horizontally, but maybe a yellow line spanned all the way to the last 'x' pixel.
-		if (onLine)
+		if (extractor.onLine)
 		{
 			//End the line
 			if (found < maxCount)
-				dst[found++] = currentLine;
+				dst[found++] = extractor.currentLine;
 			else
 				return found;
-
-			onLine = false;
 		}
 	}
 
 	return found;
 }
 
+///<summary>Finds all lines of consecutive 'yellow' pixels in an image like <see cref="find_yellow_lines_in_image"/>.</summary>
+///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
+///<param name="width">The width of the image, measured in pixels.</param>
+///<param name="height">The height of the image, measured in pixels.</param>
+///<param name="cfg">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow.'</param>
+///<param name="dst">The destination <see cref="YellowScanLine"/> buffer.</param>
+///<param name="maxCount">The maximum number of <see cref="YellowScanLine"/>s that can be stored in the <paramref name="dst"/> buffer.</param>
+///<returns>The number of <see cref="YellowScanLine"/>s that have been found.</returns>
+size_t find_yellow_lines(const uint8_t * rgba8, int width, int height, YellowConfig cfg, YellowScanLine * dst, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	return find_yellow_lines_in_image(&image, cfg, dst, maxCount);
+}
+
 ///<summary>Draws <see cref="YellowScanLine"s/> onto an image.</summary>
 ///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
 ///<param name="width">The width of the image,  measured in pixels.</param>
@@ -295,7 +262,7 @@ typedef struct YellowBoundingBox
 ///<param name="b">The second <see cref="YellowScanLine"/>.</param>
 ///<param name="maxSpacing">The maximum spacing between adjacent lines.</param>
 ///<returns>True if the two lines are adjacent within the specified <paramref name="maxSpacing"/>.</returns>
-__forceinline bool _are_lines_adjacent(YellowScanLine a, YellowScanLine b, int maxSpacing)
+BAR_CODE_FORCEINLINE bool _are_lines_adjacent(YellowScanLine a, YellowScanLine b, int maxSpacing)
 {
 	int verticalSpacing = abs(a.y - b.y);
 	if (verticalSpacing > (maxSpacing + 1 /*Because we consider 'vertically touching' lines to have spacing of zero. Consider what happens if we don't do +1 while 'maxSpacing' is zero.*/))
@@ -316,509 +283,1062 @@ __forceinline bool _are_lines_adjacent(YellowScanLine a, YellowScanLine b, int m
 	return false;
 }
 
-///<summary>Finds <see cref="YellowBoundingBox"/>es for all grouped <see cref="YellowScanLine"/>s.</summary>
+///<summary>Finds the root of a <see cref="YellowScanLine"/> in the union-find forest built by <see cref="find_yellow_rectangles"/>.</summary>
+///<param name="lines">The <see cref="YellowScanLine"/>s.</param>
+///<param name="index">The index of the <see cref="YellowScanLine"/>.</param>
+///<returns>The index of the root, which is always the lowest index in the group.</returns>
+BAR_CODE_FORCEINLINE int _find_line_root(YellowScanLine* lines, int index)
+{
+	while (lines[index]._parent != index)
+	{
+		//Path halving: point at the grandparent while walking up, so later searches are shorter
+		lines[index]._parent = lines[lines[index]._parent]._parent;
+		index = lines[index]._parent;
+	}
+	return index;
+}
+
+///<summary>Merges the groups of two <see cref="YellowScanLine"/>s.</summary>
 ///<param name="lines">The <see cref="YellowScanLine"/>s.</param>
+///<param name="a">The index of the first <see cref="YellowScanLine"/>.</param>
+///<param name="b">The index of the second <see cref="YellowScanLine"/>.</param>
+BAR_CODE_FORCEINLINE void _union_lines(YellowScanLine* lines, int a, int b)
+{
+	a = _find_line_root(lines, a);
+	b = _find_line_root(lines, b);
+
+	//The lower index always becomes the root, so a parent is never after its child
+	if (a < b)
+		lines[b]._parent = a;
+	else if (b < a)
+		lines[a]._parent = b;
+}
+
+///<summary>Finds <see cref="YellowBoundingBox"/>es for all grouped <see cref="YellowScanLine"/>s.</summary>
+///<param name="lines">The <see cref="YellowScanLine"/>s, sorted by <see cref="YellowScanLine.y"/> and then by <see cref="YellowScanLine.start"/>
+///(which is the order that <see cref="find_yellow_lines"/> produces them in).</param>
 ///<param name="lineCount">The number of <see cref="YellowScanLine"/>s in <paramref name="lines"/>.</param>
 ///<param name="maxSpacing">The maximum spacing between adjacent pixels.</param>
-///<param name="tmpIndexBuffer">Buffer into which temporary indices will be stored. The caller does not need to initialize any value to this buffer,
-///and it should expect garbage when this function ends.</param>
-///<param name="maxTmpIndexCount">The maximum number of indices (<see cref="size_t"/> values) that can be stored in <paramref name="tmpIndexBuffer"/>.
-///Note that this size directly affects the maximum number of <see cref="YellowScanLine"/>s that can make up a <see cref="YellowBoundingBox"/>, so it should
-///be sufficiently large. If there are any <see cref="YellowBoundingBox"/>es with more <see cref="YellowScanLine"/>s than can be indexed by the
-///<paramref name="tmpIndexBuffer"/>, then those <see cref="YellowBoundingBox"/>es may be corrupt (Their <see cref="YellowBoundingBox.isComplete"/>
-///field may be false and they may be smaller than the actual group of <see cref="YellowScanLine"/>s).</param>
-///<param name="dst">The destination <see cref="YellowBoundingBox"/> buffer.</param>
-///<param name="maxCount">The maximum number of <see cref="YellowScanLine"/>s to store in <paramref name="dst"/>.</param>
-size_t find_yellow_rectangles(YellowScanLine * lines, size_t lineCount, int maxSpacing, size_t * tmpIndexBuffer, size_t maxTmpIndexCount, YellowBoundingBox * dst, size_t maxCount)
+///<param name="dst">The destination <see cref="YellowBoundingBox"/> buffer. The <see cref="YellowBoundingBox"/>es are stored in the order of the
+///first <see cref="YellowScanLine"/> that they contain.</param>
+///<param name="maxCount">The maximum number of <see cref="YellowBoundingBox"/>es to store in <paramref name="dst"/>.</param>
+///<returns>The number of <see cref="YellowBoundingBox"/>es that have been found.</returns>
+///<remarks>Lines are grouped with a union-find forest. Since the lines are sorted, each line only has to be compared with the lines of the
+///previous maxSpacing + 1 rows, and within each of those rows only with the lines that overlap it horizontally. So the cost is close to
+///linear in the number of lines, and no group of lines is too large to be tracked.</remarks>
+size_t find_yellow_rectangles(YellowScanLine * lines, size_t lineCount, int maxSpacing, YellowBoundingBox * dst, size_t maxCount)
 {
-	//Reset the '_ignore' field of all lines
-	for (size_t i = 0; i < lineCount; i++)
-		lines[i]._ignore = false;
+	assert(lineCount <= INT_MAX);
+	int count = (int)lineCount;
+	for (int i = 0; i < count; i++)
+		lines[i]._parent = i;
 
-	size_t boxCount = 0;
-	for (size_t i = 0; i < lineCount; i++)
+	int windowStart = 0;//The first line that is within 'maxSpacing + 1' rows of the current row
+	for (int rowStart = 0, rowEnd; rowStart < count; rowStart = rowEnd)
 	{
-		if (lines[i]._ignore)
-			continue;//We already scanned this line as a member of a previously-scanned YellowBoundingBox, so don't read it again, we would just get the same YellowBoundingBox.
+		int y = lines[rowStart].y;
+		for (rowEnd = rowStart + 1; rowEnd < count && lines[rowEnd].y == y; rowEnd++)
+		{
+			//Lines on the same row never overlap, so only neighbouring lines need to be checked
+			if (_are_lines_adjacent(lines[rowEnd - 1], lines[rowEnd], maxSpacing))
+				_union_lines(lines, rowEnd - 1, rowEnd);
+		}
+		assert(rowEnd == count || lines[rowEnd].y > y);//The lines must be sorted
 
-		YellowBoundingBox currentBox;
-		currentBox.left = lines[i].start;
-		currentBox.top = lines[i].y;
-		currentBox.right = lines[i].end;
-		currentBox.bottom = lines[i].y;
+		while (lines[windowStart].y < y - (maxSpacing + 1 /*Because we consider 'vertically touching' lines to have spacing of zero*/))
+			windowStart++;
 
-		//Find all YellowScanLines that fit in 'currentBox' (starting from lines[i])
-		size_t containedLineCount = 0;
-		bool ranOutOfTempSpace = false;
-		tmpIndexBuffer[containedLineCount++] = i;
-		for (int j = 0; j < containedLineCount; j++)//Search through all 'contained' lines (this grows as we iterate, until bounding box is complete)
+		//Check the lines of each previous row in the window
+		for (int previousStart = windowStart, previousEnd; previousStart < rowStart; previousStart = previousEnd)
 		{
-			size_t currentIndex = tmpIndexBuffer[j];
-			YellowScanLine currentLine = lines[currentIndex];
-
-			lines[currentIndex]._ignore = true;//Make sure we don't duplicate this line in the future
+			for (previousEnd = previousStart + 1; previousEnd < rowStart && lines[previousEnd].y == lines[previousStart].y; previousEnd++);
 
-			//Find all lines that are adjacent to 'currentLine'
-			for (size_t k = i + 1; k < lineCount; k++)
+			//Both rows are sorted, so sweep through them together
+			int first = previousStart;
+			for (int i = rowStart; i < rowEnd; i++)
 			{
-				if (lines[k]._ignore)
-					continue;//Don't re-read this line
-				if (k == currentIndex)
-					continue;//Don't check whether a line is adjacent to itself
+				//Skip the previous lines that end too far left of this line (they also end too far left of all of the following lines)
+				while (first < previousEnd && lines[first].end + maxSpacing < lines[i].start)
+					first++;
 
-				if (_are_lines_adjacent(currentLine, lines[k], maxSpacing))
+				for (int j = first; j < previousEnd && lines[j].start - maxSpacing <= lines[i].end; j++)
 				{
-					if (containedLineCount < maxTmpIndexCount)
-					{
-						tmpIndexBuffer[containedLineCount++] = k;
-						lines[k]._ignore = true;
-					}
-					else
-						ranOutOfTempSpace = true;//The 'tmpIndexBuffer' was too small!
+					if (_are_lines_adjacent(lines[j], lines[i], maxSpacing))
+						_union_lines(lines, j, i);
 				}
 			}
 		}
+	}
 
-		//If we ran out of space in 'tmpIndexBuffer,' then the current bounding box is incomplete.
-		currentBox.isComplete = !ranOutOfTempSpace;
-
-		//Now we have the indices of all contained lines for this bounding box stored in 'tmpIndexBuffer,' so simply fit the bounding box
-		//around all those lines
-		for (int j = 0; j < containedLineCount; j++)
+	//Now fit a bounding box around each group. Parents are never after their children, so in a single pass, each line's parent
+	//already points at its root. Roots are marked with a negative value: -(boxIndex + 1), or INT_MIN if 'dst' was already full.
+	size_t boxCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		YellowScanLine currentLine = lines[i];
+		if (currentLine._parent == i)
 		{
-			YellowScanLine currentLine = lines[tmpIndexBuffer[j]];
-
-			if (currentLine.start < currentBox.left)
-				currentBox.left = currentLine.start;
-			if (currentLine.end > currentBox.right)
-				currentBox.right = currentLine.end;
-			if (currentLine.y < currentBox.top)
-				currentBox.top = currentLine.y;
-			if (currentLine.y > currentBox.bottom)
-				currentBox.bottom = currentLine.y;
-
-			//Make sure we don't read this line later (doing so would cause nested rectangles)
-			lines[tmpIndexBuffer[j]]._ignore = true;
+			//The first line of a new group (the group's top row, since lines are sorted)
+			if (boxCount < maxCount)
+			{
+				YellowBoundingBox box;
+				box.left = currentLine.start;
+				box.top = currentLine.y;
+				box.right = currentLine.end;
+				box.bottom = currentLine.y;
+				box.isComplete = true;
+				dst[boxCount] = box;
+				lines[i]._parent = -(int)(++boxCount);
+			}
+			else
+				lines[i]._parent = INT_MIN;
+			continue;
 		}
 
-		if (boxCount < maxCount)
-			dst[boxCount++] = currentBox;
-		else
-			return boxCount;
+		int root = currentLine._parent;
+		if (lines[root]._parent >= 0)
+			root = lines[root]._parent;//The parent has already been pointed at its root
+		lines[i]._parent = root;
+
+		if (lines[root]._parent == INT_MIN)
+			continue;//This group did not fit in 'dst'
+
+		YellowBoundingBox* box = &dst[-lines[root]._parent - 1];
+		if (currentLine.start < box->left)
+			box->left = currentLine.start;
+		if (currentLine.end > box->right)
+			box->right = currentLine.end;
+		if (currentLine.y > box->bottom)
+			box->bottom = currentLine.y;
 	}
 
 	return boxCount;
 }
 
-///<summary>Draws <see cref="YellowBoundingBox"/>es to an image.</summary>
-///<param name="rgba8">The pixels of the image, stored in RGBA 8-bit format.</param>
-///<param name="width">The width of the image, measured in pixels.</param>
-///<param name="height">The height of the image, measured in pixels.</param>
-///<param name="boxes">The <see cref="YellowBoundingBox"/>es to draw.</param>
-///<param name="boxCount">The number of <see cref="YellowBoundingBox"/>es in <paramref name="boxes"/> to draw.</param>
-///<param name="r">The red component of the color of the boxes to be drawn.</param>
-///<param name="g">The green component of the color of the boxes to be drawn.</param>
-///<param name="b">The blue component of the color of the boxes to be drawn.</param>
-///<param name="a">The alpha component of the color of the boxes to be drawn.</param>
-void show_yellow_rectangles(uint8_t * rgba8, int width, int height, const YellowBoundingBox * boxes, size_t boxCount, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
-{
-	for (size_t i = 0; i < boxCount; i++)
-	{
-		//Draw the top and bottom lines
-		for (int x = boxes[i].left; x <= boxes[i].right; x++)
-		{
-			//Top line
-			rgba8[((x + (boxes[i].top * width)) * 4) + 0] = r;
-			rgba8[((x + (boxes[i].top * width)) * 4) + 1] = g;
-			rgba8[((x + (boxes[i].top * width)) * 4) + 2] = b;
-			rgba8[((x + (boxes[i].top * width)) * 4) + 3] = a;
+///<summary>Value of <see cref="YellowScanLine._parent"/> in <see cref="find_yellow_boxes"/> for a line whose box did not fit in the destination.</summary>
+#define YELLOW_RUN_DROPPED (-1)
 
-			//Bottom line
-			rgba8[((x + (boxes[i].bottom * width)) * 4) + 0] = r;
-			rgba8[((x + (boxes[i].bottom * width)) * 4) + 1] = g;
-			rgba8[((x + (boxes[i].bottom * width)) * 4) + 2] = b;
-			rgba8[((x + (boxes[i].bottom * width)) * 4) + 3] = a;
-		}
+///<summary>Value of <see cref="YellowScanLine._parent"/> in <see cref="find_yellow_boxes"/> for a line that has not been assigned a box yet.</summary>
+#define YELLOW_RUN_UNASSIGNED (-2)
 
-		//Draw the left and right lines
-		for (int y = boxes[i].top; y <= boxes[i].bottom; y++)
-		{
-			//Left line
-			rgba8[((boxes[i].left + (y * width)) * 4) + 0] = r;
-			rgba8[((boxes[i].left + (y * width)) * 4) + 1] = g;
-			rgba8[((boxes[i].left + (y * width)) * 4) + 2] = b;
-			rgba8[((boxes[i].left + (y * width)) * 4) + 3] = a;
+///<summary>Like <see cref="YELLOW_RUN_UNASSIGNED"/>, but the line is adjacent to a line whose box was dropped.</summary>
+#define YELLOW_RUN_UNASSIGNED_NEAR_DROPPED (-3)
 
-			//Right line
-			rgba8[((boxes[i].right + (y * width)) * 4) + 0] = r;
-			rgba8[((boxes[i].right + (y * width)) * 4) + 1] = g;
-			rgba8[((boxes[i].right + (y * width)) * 4) + 2] = b;
-			rgba8[((boxes[i].right + (y * width)) * 4) + 3] = a;
-		}
-	}
-}
+///<summary>How much of its buffers <see cref="find_yellow_boxes"/> needed, which is reported in <see cref="BarCodeFindTemporaryMemory.usage"/>.</summary>
+typedef struct _YellowBoxUsage
+{
+	///<summary>The most <see cref="YellowScanLine"/>s that were in the window at once.</summary>
+	size_t lineCount;
 
-///<summary>The maximum number of <see cref="BarCodeColor"/>s that can fit in a <see cref="BarCode"/>.</summary>
-#define BAR_CODE_MAX_COLOR_COUNT (25)
+	///<summary>The most boxes that existed at once, not counting those that had been merged into older boxes (which compacting frees).</summary>
+	size_t boxCount;
 
-///<summary>Defines a color within a bar code.</summary>
-typedef enum BarCodeColor
-{
-	BAR_CODE_RED = 'R',
-	BAR_CODE_GREEN = 'G',
-	BAR_CODE_BLUE = 'B'
-} BarCodeColor;
+	///<summary>Set when a line or a row had to be dropped, or a row forgotten early, because the line buffer was full.</summary>
+	bool linesOverflowed;
 
-///<summary>Defines a sequence of <see cref="BarCodeColor"/>s.</summary>
-typedef struct BarCode
-{
-	///<summary>The buffer of <see cref="BarCodeColor"/>s. Since there is no 'polarity' on an observed bar code, 
-	///palindromes are considered equivalent. For example: {BAR_CODE_RED, BAR_CODE_GREEN, BAR_CODE_GREEN, BAR_CODE_BLUE} and 
-	///{BAR_CODE_BLUE, BAR_CODE_GREEN, BAR_CODE_GREEN, BAR_CODE_RED} are equal.</summary>
-	BarCodeColor colors[BAR_CODE_MAX_COLOR_COUNT];
+	///<summary>Set when a box had to be dropped because the box buffer was full.</summary>
+	bool boxesOverflowed;
+} _YellowBoxUsage;
 
-	///<summary>The number of <see cref="BarCodeColor"/>s stored in <see cref="BarCode.colors"/>.
-	///This value cannot be larger than <see cref="BAR_CODE_MAX_COLOR_COUNT"/>.</summary>
-	size_t colorCount;
-} BarCode;
+///<summary>Adds the usage of one call of <see cref="find_yellow_boxes"/> to the usage of earlier calls that share the same buffers.</summary>
+BAR_CODE_FORCEINLINE void _add_yellow_box_usage(_YellowBoxUsage* total, const _YellowBoxUsage* usage)
+{
+	if (usage->lineCount > total->lineCount)
+		total->lineCount = usage->lineCount;
+	if (usage->boxCount > total->boxCount)
+		total->boxCount = usage->boxCount;
+	total->linesOverflowed = total->linesOverflowed || usage->linesOverflowed;
+	total->boxesOverflowed = total->boxesOverflowed || usage->boxesOverflowed;
+}
 
-///<summary>Defines the appearance information about a bar code.</summary>
-typedef struct BarCodeAppearance
+///<summary>State of <see cref="find_yellow_boxes"/>.</summary>
+typedef struct _YellowBoxBuilder
 {
-	///<summary>The <see cref="YellowBoundingBox"/> that contained the first 'yellow bar.'</summary>
-	YellowBoundingBox _firstBox;
+	///<summary>The <see cref="YellowScanLine"/>s of the most recent rows. <see cref="YellowScanLine._parent"/> holds the index of
+	///the line's box (which may have been merged into another box since), or one of the YELLOW_RUN_* values.</summary>
+	YellowScanLine* runs;
 
-	///<summary>The <see cref="YellowBoundingBox"/> that contained the second 'yellow bar.'</summary>
-	YellowBoundingBox _secondBox;
+	///<summary>The number of <see cref="YellowScanLine"/>s that fit in <see cref="runs"/>.</summary>
+	size_t runCapacity;
 
-	///<summary>The x-coordinate where the 'color line' begins.</summary>
-	int colorStartX;
+	///<summary>The index of the oldest line in <see cref="runs"/> that may still be adjacent to the current row.</summary>
+	size_t windowStart;
 
-	///<summary>The y-coordinate where the 'color line' begins.</summary>
-	int colorStartY;
+	///<summary>The index of the first line of the current row.</summary>
+	size_t rowStart;
 
-	///<summary>The x-coordinate where the 'color line' ends.</summary>
-	int colorEndX;
+	///<summary>The index at which the next line will be written. When it reaches <see cref="runCapacity"/>, the window is moved back to the start.</summary>
+	size_t writePosition;
 
-	///<summary>The y-coordinate where the 'color line' ends.</summary>
-	int colorEndY;
+	///<summary>The boxes, in the order that they were started. A box that has been merged into an older box stays in place until it is compacted.</summary>
+	YellowBoundingBox* boxes;
 
-	///<summary>The number of sections in the bar code.</summary>
-	int sectionCount;
+	///<summary>The union-find parent of each box in <see cref="boxes"/>. A parent is never after its child.</summary>
+	size_t* parents;
 
-	///<summary>The average rank for how 'red' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
-	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
-	float redAverage[BAR_CODE_MAX_COLOR_COUNT];
+	///<summary>The number of boxes that fit in <see cref="boxes"/> and <see cref="parents"/>.</summary>
+	size_t boxCapacity;
 
-	///<summary>The average rank for how 'green' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
-	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
-	float greenAverage[BAR_CODE_MAX_COLOR_COUNT];
+	///<summary>The number of boxes (including merged ones) in <see cref="boxes"/>.</summary>
+	size_t boxCount;
 
-	///<summary>The average rank for how 'blue' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
-	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
-	float blueAverage[BAR_CODE_MAX_COLOR_COUNT];
+	///<summary>The number of merges since the boxes were last compacted, so compacting is only tried when it can free something.</summary>
+	size_t mergesSinceCompaction;
 
-	///<summary>The total number of pixels that were observed per section of the bar code.</summary>
-	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
-	int pixelCount[BAR_CODE_MAX_COLOR_COUNT];
-} BarCodeAppearance;
+	///<summary>How much of the buffers has been used so far. A line, a row or a box had to be dropped if either of its overflow flags is set.</summary>
+	_YellowBoxUsage usage;
 
-__forceinline float _quantify_bar_code_appearance_match(const BarCode* code, const float* rAvg, const float* gAvg, const float* bAvg, bool reverse)
-{
-	size_t sectionCount = code->colorCount;
-	size_t start = reverse ? sectionCount - 1 : 0;
-	size_t increment = reverse ? -1 : 1;
-	float sum = 0.0f;
-	for (size_t scanI = start, codeI = 0; scanI >= 0 && scanI < sectionCount; scanI += increment, codeI++)
-	{
-		//scanI is to iterate the observed color values. If 'reverse' is true, we will iterate from end to start.
-		//codeI is to iterate the expected color values. This value always iterates from 0 to 'sectionCount'.
-		BarCodeColor expectedColor = code->colors[codeI];
-		float r = rAvg[scanI];
-		float g = gAvg[scanI];
-		float b = bAvg[scanI];
+	///<summary>Optional buffer that receives a copy of the lines of every row above <see cref="pinnedBottom"/>. Their boxes are kept up to date
+	///like those of the lines in the window, so they can be joined to the lines of another band (see <see cref="find_yellow_boxes_parallel"/>).</summary>
+	YellowScanLine* pinned;
 
-		switch (expectedColor)
-		{
-		case BAR_CODE_RED:
-			sum += r;
-			sum -= g;
-			sum -= b;
-			break;
+	///<summary>The number of lines in <see cref="pinned"/>.</summary>
+	size_t pinnedCount;
 
-		case BAR_CODE_GREEN:
-			sum += g;
-			sum -= r;
-			sum -= b;
-			break;
+	///<summary>The number of lines that fit in <see cref="pinned"/>.</summary>
+	size_t pinnedCapacity;
 
-		case BAR_CODE_BLUE:
-			sum += b;
-			sum -= r;
-			sum -= g;
-			break;
+	///<summary>The lines of the rows above this y-coordinate are copied to <see cref="pinned"/>.</summary>
+	int pinnedBottom;
 
-		default:
-			assert(0 && "Unrecognized BarCodeColor value");
-			break;
-		}
+	///<summary>If not NULL, receives the number of lines and yellow pixels (see <see cref="BarCodeFindStats"/>).</summary>
+	BarCodeFindStats* stats;
+} _YellowBoxBuilder;
+
+BAR_CODE_FORCEINLINE size_t _find_box_root(_YellowBoxBuilder* builder, size_t index)
+{
+	size_t* parents = builder->parents;
+	while (parents[index] != index)
+	{
+		parents[index] = parents[parents[index]];//Path halving
+		index = parents[index];
 	}
+	return index;
+}
 
-	float score = sum / sectionCount;
-	if (score < 0.0f)
-		score = 0.0f;
-	if (score > 1.0f)
-		score = 1.0f;
-	return score;
+BAR_CODE_FORCEINLINE void _extend_box(YellowBoundingBox* box, const YellowScanLine* line)
+{
+	if (line->start < box->left)
+		box->left = line->start;
+	if (line->end > box->right)
+		box->right = line->end;
+	if (line->y < box->top)
+		box->top = line->y;
+	if (line->y > box->bottom)
+		box->bottom = line->y;
 }
 
-///<summary>Quantifies how well a <see cref="BarCodeAppearance"/> matches a specific <see cref="BarCode"/>, ranging from
-///0.0 (no match) to 1.0 (full match).</summary>
-///<param name="code">The <see cref="BarCode"/>.</param>
-///<param name="appearance">The <see cref="BarCodeAppearance"/>.</param>
-///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is no match and 1.0f is full match.</returns>
-__forceinline float quantify_bar_code_appearance_match(const BarCode* code, const BarCodeAppearance* appearance)
+///<summary>Merges two boxes, keeping the older one (so the final order matches <see cref="find_yellow_rectangles"/>).</summary>
+///<returns>The index of the merged box.</returns>
+static size_t _merge_boxes(_YellowBoxBuilder* builder, size_t a, size_t b)
 {
-	assert(code->colorCount == appearance->sectionCount);
-
-	//Since bar codes do not have polarity, we have to 'scan' the line in two directions.
-	float forward = _quantify_bar_code_appearance_match(code, appearance->redAverage, appearance->greenAverage, appearance->blueAverage, false);
-	float reverse = _quantify_bar_code_appearance_match(code, appearance->redAverage, appearance->greenAverage, appearance->blueAverage, true);
+	a = _find_box_root(builder, a);
+	b = _find_box_root(builder, b);
+	if (a == b)
+		return a;
+	if (b < a)
+	{
+		size_t tmp = a;
+		a = b;
+		b = tmp;
+	}
 
-	//We will take the best match of 'forward' or 'reverse.'
-	if (forward > reverse)
-		return forward;
-	else
-		return reverse;
+	YellowBoundingBox* keep = &builder->boxes[a];
+	const YellowBoundingBox* merged = &builder->boxes[b];
+	if (merged->left < keep->left)
+		keep->left = merged->left;
+	if (merged->right > keep->right)
+		keep->right = merged->right;
+	if (merged->top < keep->top)
+		keep->top = merged->top;
+	if (merged->bottom > keep->bottom)
+		keep->bottom = merged->bottom;
+	keep->isComplete = keep->isComplete && merged->isComplete;
+
+	builder->parents[b] = a;
+	builder->mergesSinceCompaction++;
+	return a;
 }
 
-///<summary>Quantifies how distinctly red a particular color is.</summary>
-///<param name="r">The red component of the color.</param>
-///<param name="g">The green component of the color.</param>
-///<param name="b">The blue component of the color.</param>
-///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not red' and 1.0f is 'full red.'</returns>
-__forceinline float quantify_red(uint8_t r, uint8_t g, uint8_t b)
+///<summary>Points each of the <paramref name="lines"/> directly at the root of its box.</summary>
+BAR_CODE_FORCEINLINE void _point_lines_at_roots(_YellowBoxBuilder* builder, YellowScanLine* lines, size_t count)
 {
-	return (r > g&& r > b)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+	for (size_t i = 0; i < count; i++)
+	{
+		if (lines[i]._parent >= 0)
+			lines[i]._parent = (int)_find_box_root(builder, (size_t)lines[i]._parent);
+	}
 }
 
-///<summary>Quantifies how distinctly green a particular color is.</summary>
-///<param name="r">The red component of the color.</param>
-///<param name="g">The green component of the color.</param>
-///<param name="b">The blue component of the color.</param>
-///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not green' and 1.0f is 'full green.'</returns>
-__forceinline float quantify_green(uint8_t r, uint8_t g, uint8_t b)
+///<summary>Replaces the box of each of the <paramref name="lines"/> by the new index that <see cref="_compact_boxes"/> stored in its parent.</summary>
+BAR_CODE_FORCEINLINE void _renumber_lines(_YellowBoxBuilder* builder, YellowScanLine* lines, size_t count)
 {
-	return (g > r&& g > b)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+	for (size_t i = 0; i < count; i++)
+	{
+		if (lines[i]._parent >= 0)
+			lines[i]._parent = (int)builder->parents[lines[i]._parent];
+	}
 }
 
-///<summary>Quantifies how distinctly blue a particular color is.</summary>
-///<param name="r">The red component of the color.</param>
-///<param name="g">The green component of the color.</param>
-///<param name="b">The blue component of the color.</param>
-///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not blue' and 1.0f is 'full blue.'</returns>
-__forceinline float quantify_blue(uint8_t r, uint8_t g, uint8_t b)
+///<summary>Removes the boxes that have been merged into other boxes, keeping the order of the remaining boxes.</summary>
+static void _compact_boxes(_YellowBoxBuilder* builder)
 {
-	return (b > r&& b > g)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+	//Point every line that is still in the window (or pinned) directly at its root
+	YellowScanLine* window = builder->runs + builder->windowStart;
+	size_t windowCount = builder->writePosition - builder->windowStart;
+	_point_lines_at_roots(builder, window, windowCount);
+	_point_lines_at_roots(builder, builder->pinned, builder->pinnedCount);
+
+	//Move the roots down, temporarily storing each root's new index in its parent
+	size_t count = 0;
+	for (size_t i = 0; i < builder->boxCount; i++)
+	{
+		if (builder->parents[i] == i)
+		{
+			builder->boxes[count] = builder->boxes[i];
+			builder->parents[i] = count++;
+		}
+	}
+
+	_renumber_lines(builder, window, windowCount);
+	_renumber_lines(builder, builder->pinned, builder->pinnedCount);
+
+	for (size_t i = 0; i < count; i++)
+		builder->parents[i] = i;
+	builder->boxCount = count;
+	builder->mergesSinceCompaction = 0;
 }
 
-void _draw_line(uint8_t * rgba8, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+///<summary>Starts a new box around a line.</summary>
+///<returns>The index of the new box, or <see cref="YELLOW_RUN_DROPPED"/> if there is no room for it.</returns>
+static int _start_box(_YellowBoxBuilder* builder, const YellowScanLine* line)
 {
-	int dx = abs(x2 - x1);
-	int dy = abs(y2 - y1);
-	int sx = x1 < x2 ? 1 : -1;
-	int sy = y1 < y2 ? 1 : -1;
-	int error = (dx > dy ? dx : -dy) / 2;
-	while (true) {
+	if (builder->boxCount == builder->boxCapacity && builder->mergesSinceCompaction > 0)
+		_compact_boxes(builder);
+	if (builder->boxCount == builder->boxCapacity)
+	{
+		builder->usage.boxesOverflowed = true;
+		return YELLOW_RUN_DROPPED;
+	}
 
-		rgba8[((x1 + (y1 * width)) * 4) + 0] = r;
-		rgba8[((x1 + (y1 * width)) * 4) + 1] = g;
-		rgba8[((x1 + (y1 * width)) * 4) + 2] = b;
-		rgba8[((x1 + (y1 * width)) * 4) + 3] = a;
+	YellowBoundingBox box;
+	box.left = line->start;
+	box.top = line->y;
+	box.right = line->end;
+	box.bottom = line->y;
+	box.isComplete = true;
+
+	size_t index = builder->boxCount++;
+	builder->boxes[index] = box;
+	builder->parents[index] = index;
+
+	//Each merge since the last compaction left exactly one box that compacting would free
+	size_t liveCount = builder->boxCount - builder->mergesSinceCompaction;
+	if (liveCount > builder->usage.boxCount)
+		builder->usage.boxCount = liveCount;
+	return (int)index;
+}
 
-		if (x1 == x2 && y1 == y2)
-			break;
+///<summary>Records that a line of the current row is adjacent to a line with the box <paramref name="otherBox"/>.</summary>
+static void _connect_line(_YellowBoxBuilder* builder, YellowScanLine* line, int otherBox)
+{
+	if (otherBox == YELLOW_RUN_DROPPED)
+	{
+		//We do not know the extent of the other line's group, so this line's box may be too small
+		if (line->_parent == YELLOW_RUN_UNASSIGNED)
+			line->_parent = YELLOW_RUN_UNASSIGNED_NEAR_DROPPED;
+		else if (line->_parent >= 0)
+			builder->boxes[_find_box_root(builder, (size_t)line->_parent)].isComplete = false;
+		return;
+	}
 
-		int errorCopy = error;
-		if (errorCopy > -dx)
+	size_t root = _find_box_root(builder, (size_t)otherBox);
+	if (line->_parent >= 0)
+	{
+		line->_parent = (int)_merge_boxes(builder, (size_t)line->_parent, root);
+	}
+	else
+	{
+		if (line->_parent == YELLOW_RUN_UNASSIGNED_NEAR_DROPPED)
+			builder->boxes[root].isComplete = false;
+		line->_parent = (int)root;
+		_extend_box(&builder->boxes[root], line);
+	}
+}
+
+///<summary>Appends a line of the current row to the window.</summary>
+///<returns>False if the current row alone filled the buffer, so the line was dropped.</returns>
+static bool _push_line(_YellowBoxBuilder* builder, YellowScanLine line)
+{
+	if (builder->writePosition == builder->runCapacity)
+	{
+		if (builder->windowStart == builder->rowStart)
 		{
-			error -= dy;
-			x1 += sx;
+			builder->usage.linesOverflowed = true;
+			return false;
 		}
 
-		if (errorCopy < dy)
+		if (builder->windowStart == 0)
 		{
-			error += dx;
-			y1 += sy;
+			builder->usage.linesOverflowed = true;
+
+			//The window fills the whole buffer, so forget the oldest row early. Its lines can no longer join their boxes to the
+			//lines below, so those boxes may be too small.
+			int oldestY = builder->runs[0].y;
+			for (; builder->windowStart < builder->rowStart && builder->runs[builder->windowStart].y == oldestY; builder->windowStart++)
+			{
+				int box = builder->runs[builder->windowStart]._parent;
+				if (box >= 0)
+					builder->boxes[_find_box_root(builder, (size_t)box)].isComplete = false;
+			}
 		}
+
+		//Move the window back to the start of the buffer
+		size_t count = builder->writePosition - builder->windowStart;
+		memmove(builder->runs, builder->runs + builder->windowStart, count * sizeof(YellowScanLine));
+		builder->rowStart -= builder->windowStart;
+		builder->writePosition = count;
+		builder->windowStart = 0;
 	}
+
+	line._parent = YELLOW_RUN_UNASSIGNED;
+	builder->runs[builder->writePosition++] = line;
+	if (builder->writePosition - builder->windowStart > builder->usage.lineCount)
+		builder->usage.lineCount = builder->writePosition - builder->windowStart;
+	return true;
 }
 
-///<summary>Given a line that starts and ends in 'yellow bars,' finds the endpoints of the 'colorful' line between the 'yellow bars.'</summary>
-///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
-///<param name="width">The width of the image, measured in pixels.</param>
-///<param name="height">The height of the image, measured in pixels.</param>
-///<param name="yellowCfg">The <see cref="YellowConfig"/> that identifies the 'yellow bars.'</param>
-///<param name="firstX">As input, identifies the X position of the midpoint of the first 'yellow bar.' As output, identifies the X
-///position where the 'colorful' line begins.</param>
-///<param name="firstY">As input, identifies the Y position of the midpoint of the first 'yellow bar.' As output, identifies the Y
-///position where the 'colorful' line begins.</param>
-///<param name="secondX">As input, identifies the X position of the midpoint of the last 'yellow bar.' As output, identifies the X
-///position where the 'colorful' line ends.</param>
-///<param name="secondY">As input, identifies the Y position of the midpoint of the last 'yellow bar.' As output, identifies the Y
-///position where the 'colorful' line ends.</param>
-void _find_colorful_line_endpoints(const uint8_t * rgba8, int width, int height, YellowConfig yellowCfg, int* firstX, int* firstY, int* secondX, int* secondY)
+///<summary>Prepares a <see cref="_YellowBoxBuilder"/> for the first row.</summary>
+static void _init_yellow_box_builder(_YellowBoxBuilder* builder, YellowScanLine* lineBuffer, size_t lineBufferCapacity, size_t* boxParents, YellowBoundingBox* dst, size_t maxCount)
 {
-	int x1 = firstX[0];
-	int y1 = firstY[0];
-	int x2 = secondX[0];
-	int y2 = secondY[0];
-	int dx = abs(x2 - x1);
-	int dy = abs(y2 - y1);
-	int sx = x1 < x2 ? 1 : -1;
-	int sy = y1 < y2 ? 1 : -1;
-	int error = (dx > dy ? dx : -dy) / 2;
-	bool foundColorStart = false;
-	bool inColor = false;
-	int lastX = x2, lastY = y2;
-	while (true) {
+	assert(maxCount <= INT_MAX);
+
+	builder->runs = lineBuffer;
+	builder->runCapacity = lineBufferCapacity;
+	builder->windowStart = 0;
+	builder->rowStart = 0;
+	builder->writePosition = 0;
+	builder->boxes = dst;
+	builder->parents = boxParents;
+	builder->boxCapacity = maxCount;
+	builder->boxCount = 0;
+	builder->mergesSinceCompaction = 0;
+	builder->usage.lineCount = 0;
+	builder->usage.boxCount = 0;
+	builder->usage.linesOverflowed = false;
+	builder->usage.boxesOverflowed = false;
+	builder->pinned = NULL;
+	builder->pinnedCount = 0;
+	builder->pinnedCapacity = 0;
+	builder->pinnedBottom = INT_MIN;
+	builder->stats = NULL;
+}
 
-		uint8_t r = rgba8[((x1 + (y1 * width)) * 4) + 0];
-		uint8_t g = rgba8[((x1 + (y1 * width)) * 4) + 1];
-		uint8_t b = rgba8[((x1 + (y1 * width)) * 4) + 2];
+///<summary>Finds the lines of the rows from <paramref name="top"/> to <paramref name="bottom"/> (exclusive) and adds them to the boxes. Only the
+///columns from <paramref name="left"/> to <paramref name="right"/> (exclusive) are classified.</summary>
+static void _build_yellow_boxes(_YellowBoxBuilder* builder, const BarCodeImage* image, int left, int right, int top, int bottom, YellowConfig cfg, int maxSpacing)
+{
+	const YellowKernels* kernels = get_yellow_kernels();
+	uint64_t yellowBits[YELLOW_ROW_CHUNK_PIXELS / 64];
+	YellowScanLine runs[YELLOW_RUNS_PER_WORD];
 
-		if (is_yellow(r, g, b, yellowCfg))
+	for (int y = top; y < bottom; y++)
+	{
+		//Forget the rows that are too far above this one to be adjacent to it
+		while (builder->windowStart < builder->writePosition && builder->runs[builder->windowStart].y < y - (maxSpacing + 1))
+			builder->windowStart++;
+
+		//Find the lines of this row
+		builder->rowStart = builder->writePosition;
+		bool truncated = false;
+		const uint8_t* row = _get_image_row(image, y);
+		const uint8_t* chromaRow = _get_image_chroma_row(image, y);
+		YellowRunExtractor extractor;
+		extractor.onLine = false;
+		for (int chunkX = left; chunkX < right; chunkX += YELLOW_ROW_CHUNK_PIXELS)
 		{
-			if (inColor)
+			int chunkWidth = right - chunkX < YELLOW_ROW_CHUNK_PIXELS ? right - chunkX : YELLOW_ROW_CHUNK_PIXELS;
+			kernels->classifyImageRow[image->format](row, chromaRow, chunkX, chunkWidth, cfg, yellowBits);
+
+			for (int x = 0; x < chunkWidth; x += 64)
 			{
-				//We found the start of the 'end yellow bar', so stop just before here.
-				//NOTE: We may be wrong! This may be an anomalous pixel on the line which happens to trigger the 'is yellow pixel' filter.
-				//      This function will always take the LAST position just before a 'yellow bar' region. Usually there is only one (hopefully always!)
-				secondX[0] = lastX;
-				secondY[0] = lastY;
-				inColor = false;
+				uint64_t word = yellowBits[x / 64];
+				if (word == 0 && !extractor.onLine)
+					continue;
+
+				int runCount = _extract_yellow_runs(&extractor, word, chunkX + x, y, runs);
+				for (int i = 0; i < runCount && !truncated; i++)
+					truncated = !_push_line(builder, runs[i]);
 			}
-			//else we are still in the 'start yellow bar', so do nothing
 		}
-		else
+		if (extractor.onLine && !truncated)
+			truncated = !_push_line(builder, extractor.currentLine);
+
+		YellowScanLine* lines = builder->runs;
+		size_t rowStart = builder->rowStart, rowEnd = builder->writePosition;
+		if (rowStart == rowEnd)
+			continue;
+
+#if defined(BAR_CODE_STATS)
+		if (builder->stats != NULL)
 		{
-			if (inColor)
-			{
-				//We are still in the 'colorful' part of the line, so keep searching
-			}
-			else
+			builder->stats->counters[BAR_CODE_FIND_COUNTER_SCAN_LINES] += rowEnd - rowStart;
+			for (size_t i = rowStart; i < rowEnd; i++)
+				builder->stats->counters[BAR_CODE_FIND_COUNTER_YELLOW_PIXELS] += (uint64_t)(lines[i].end - lines[i].start + 1);
+		}
+#endif
+
+		//Connect this row's lines to the lines of each previous row in the window. Both rows are sorted, so sweep through them together.
+		for (size_t previousStart = builder->windowStart, previousEnd; previousStart < rowStart; previousStart = previousEnd)
+		{
+			int previousY = lines[previousStart].y;
+			for (previousEnd = previousStart + 1; previousEnd < rowStart && lines[previousEnd].y == previousY; previousEnd++);
+
+			size_t first = previousStart;
+			for (size_t i = rowStart; i < rowEnd; i++)
 			{
-				if (!foundColorStart)
-				{
-					//We found the start of the 'colorful' part of the line
-					firstX[0] = x1;
-					firstY[0] = y1;
-					foundColorStart = true;
-				}
-				else
+				while (first < previousEnd && lines[first].end + maxSpacing < lines[i].start)
+					first++;
+
+				for (size_t j = first; j < previousEnd && lines[j].start - maxSpacing <= lines[i].end; j++)
 				{
-					//This indicates an anomaly. We already found some color, then thought we saw the 'end yellow bar,' but now we are seeing more color.
-					//This means that the 'yellow' that we previously observed was an anomalous bit of yellow between the endpoints.
-					//We will continue to search until we reach the last 'yellow bar.'
+					if (_are_lines_adjacent(lines[j], lines[i], maxSpacing))
+						_connect_line(builder, &lines[i], lines[j]._parent);
 				}
-
-				inColor = true;
 			}
 		}
 
-		if (x1 == x2 && y1 == y2)
-			break;
-
-		int errorCopy = error;
-		if (errorCopy > -dx)
+		//Connect neighbouring lines of this row, in order, and start a new box for each line that is not connected to an earlier one
+		for (size_t i = rowStart; i < rowEnd; i++)
 		{
-			error -= dy;
-			x1 += sx;
+			YellowScanLine* line = &lines[i];
+			if (i > rowStart && _are_lines_adjacent(lines[i - 1], *line, maxSpacing))
+				_connect_line(builder, line, lines[i - 1]._parent);
+
+			if (line->_parent == YELLOW_RUN_UNASSIGNED)
+				line->_parent = _start_box(builder, line);
+			else if (line->_parent == YELLOW_RUN_UNASSIGNED_NEAR_DROPPED)
+				line->_parent = YELLOW_RUN_DROPPED;
 		}
 
-		if (errorCopy < dy)
+		if (truncated)
 		{
-			error += dx;
-			y1 += sy;
+			//Some lines of this row did not fit in the buffer at all
+			int box = lines[rowEnd - 1]._parent;
+			if (box >= 0)
+				builder->boxes[_find_box_root(builder, (size_t)box)].isComplete = false;
 		}
 
-		lastX = x1;
-		lastY = y1;
+		if (y < builder->pinnedBottom)
+		{
+			size_t count = rowEnd - rowStart;
+			if (count > builder->pinnedCapacity - builder->pinnedCount)
+			{
+				count = builder->pinnedCapacity - builder->pinnedCount;
+				builder->usage.linesOverflowed = true;
+			}
+			memcpy(builder->pinned + builder->pinnedCount, lines + rowStart, count * sizeof(YellowScanLine));
+			builder->pinnedCount += count;
+		}
 	}
+}
+
+///<summary>Finds <see cref="YellowBoundingBox"/>es around all groups of 'yellow' pixels in a single pass over the image.</summary>
+///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
+///<param name="width">The width of the image, measured in pixels.</param>
+///<param name="height">The height of the image, measured in pixels.</param>
+///<param name="cfg">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow.'</param>
+///<param name="maxSpacing">The maximum spacing between adjacent pixels.</param>
+///<param name="lineBuffer">Buffer for the <see cref="YellowScanLine"/>s of the most recent rows. The caller does not need to initialize it.</param>
+///<param name="lineBufferCapacity">The number of <see cref="YellowScanLine"/>s that fit in <paramref name="lineBuffer"/>. It should hold all of the lines
+///of <paramref name="maxSpacing"/> + 2 consecutive rows (at most (<paramref name="maxSpacing"/> + 2) * (<paramref name="width"/> / 2 + 1)), and a few
+///times that avoids moving the lines often. If it is too small, the oldest rows are forgotten early, and the <see cref="YellowBoundingBox"/>es that
+///they belong to may be split and are marked as incomplete.</param>
+///<param name="boxParents">Buffer for the union-find parents of the <see cref="YellowBoundingBox"/>es. Must be able to hold <paramref name="maxCount"/> values.</param>
+///<param name="dst">The destination <see cref="YellowBoundingBox"/> buffer.</param>
+///<param name="maxCount">The maximum number of <see cref="YellowBoundingBox"/>es to store in <paramref name="dst"/>.</param>
+///<returns>The number of <see cref="YellowBoundingBox"/>es that have been found.</returns>
+///<remarks>This produces the same <see cref="YellowBoundingBox"/>es, in the same order, as <see cref="find_yellow_lines"/> followed by
+///<see cref="find_yellow_rectangles"/>, but each row's lines are grouped right after the row is classified and only the lines of the previous
+///<paramref name="maxSpacing"/> + 1 rows are kept. So the image and the lines are only touched once, and the number of lines in the image is not limited.
+///If <paramref name="dst"/> runs out of room, the groups that start last are dropped, and a kept box that touches a dropped group is marked as incomplete.</remarks>
+size_t find_yellow_boxes(const uint8_t * rgba8, int width, int height, YellowConfig cfg, int maxSpacing, YellowScanLine * lineBuffer, size_t lineBufferCapacity, size_t * boxParents, YellowBoundingBox * dst, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	_YellowBoxBuilder builder;
+	_init_yellow_box_builder(&builder, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount);
+	_build_yellow_boxes(&builder, &image, 0, width, 0, height, cfg, maxSpacing);
+	_compact_boxes(&builder);
+	return builder.boxCount;
+}
 
+///<summary>Finds the <see cref="YellowBoundingBox"/>es of a window like <see cref="find_yellow_boxes_in_window"/>, and adds how much of the buffers
+///it needed to <paramref name="usage"/> (if not NULL).</summary>
+///<param name="stats">If not NULL, receives the number of lines, yellow pixels and boxes that were found.</param>
+static size_t _find_yellow_boxes_in_window(const BarCodeImage* image, int left, int top, int right, int bottom, YellowConfig cfg, int maxSpacing, YellowScanLine* lineBuffer, size_t lineBufferCapacity, size_t* boxParents, YellowBoundingBox* dst, size_t maxCount, _YellowBoxUsage* usage, BarCodeFindStats* stats)
+{
+	assert(left >= 0 && left <= right && right <= image->width && top >= 0 && top <= bottom && bottom <= image->height);
+	assert(image->stride == 0 || image->stride >= _get_image_row_size(image));
+
+	_YellowBoxBuilder builder;
+	_init_yellow_box_builder(&builder, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount);
+	builder.stats = stats;
+	_build_yellow_boxes(&builder, image, left, right, top, bottom, cfg, maxSpacing);
+	_compact_boxes(&builder);
+	if (usage != NULL)
+		_add_yellow_box_usage(usage, &builder.usage);
+
+#if defined(BAR_CODE_STATS)
+	if (stats != NULL)
+	{
+		stats->counters[BAR_CODE_FIND_COUNTER_YELLOW_BOXES] += builder.boxCount;
+		for (size_t i = 0; i < builder.boxCount; i++)
+			stats->counters[BAR_CODE_FIND_COUNTER_INCOMPLETE_BOXES] += dst[i].isComplete ? 0 : 1;
+	}
+#endif
+	return builder.boxCount;
 }
 
-__forceinline int _get_distance(int x0, int y0, int x1, int y1)
+///<summary>Finds <see cref="YellowBoundingBox"/>es like <see cref="find_yellow_boxes"/>, but only looks at the pixels inside a window of an image.</summary>
+///<param name="image">The <see cref="BarCodeImage"/>, in any <see cref="BarCodePixelFormat"/>.</param>
+///<param name="left">The first column of the window.</param>
+///<param name="top">The first row of the window.</param>
+///<param name="right">The column after the last column of the window, no greater than the width of the image.</param>
+///<param name="bottom">The row after the last row of the window, no greater than the height of the image.</param>
+///<returns>The number of <see cref="YellowBoundingBox"/>es that have been found.</returns>
+///<remarks>The other parameters are the same as those of <see cref="find_yellow_boxes"/>. The boxes use the coordinates of the whole image, and a
+///group of yellow pixels that crosses the edge of the window is cut off at the edge. The window does not need to be aligned.</remarks>
+size_t find_yellow_boxes_in_window(const BarCodeImage* image, int left, int top, int right, int bottom, YellowConfig cfg, int maxSpacing, YellowScanLine* lineBuffer, size_t lineBufferCapacity, size_t* boxParents, YellowBoundingBox* dst, size_t maxCount)
 {
-	return (int)sqrt(((x1 - x0) * (x1 - x0)) + ((y1 - y0) * (y1 - y0)));
+	return _find_yellow_boxes_in_window(image, left, top, right, bottom, cfg, maxSpacing, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount, NULL, NULL);
 }
 
-///<summary>Reads a <see cref="BarCodeAppearance"/> from an image.</summary>
-///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
+///<summary>Draws <see cref="YellowBoundingBox"/>es to an image.</summary>
+///<param name="rgba8">The pixels of the image, stored in RGBA 8-bit format.</param>
 ///<param name="width">The width of the image, measured in pixels.</param>
 ///<param name="height">The height of the image, measured in pixels.</param>
-///<param name="sectionCount">The number of sections (value colors) on the bar code.</param>
-///<param name="startBox">The <see cref="YellowBoundingBox"/> that surrounds the first 'yellow bar.'</param>
-///<param name="endBox">The <see cref="YellowBoundingBox"/> that surrounds the second 'yellow bar.'</param>
-///<param name="startX">The X position where the colorful line begins.</param>
-///<param name="startY">The Y position where the colorful line begins.</param>
-///<param name="endX">The X position where the colorful line ends.</param>
-///<param name="endY">The Y position where the colorful line ends.</param>
-///<returns>The resulting <see cref="BarCodeAppearance"/>.</returns>
-BarCodeAppearance _read_bar_code_appearance(const uint8_t * rgba8, int width, int height, int sectionCount, YellowBoundingBox startBox, YellowBoundingBox endBox, int startX, int startY, int endX, int endY)
+///<param name="boxes">The <see cref="YellowBoundingBox"/>es to draw.</param>
+///<param name="boxCount">The number of <see cref="YellowBoundingBox"/>es in <paramref name="boxes"/> to draw.</param>
+///<param name="r">The red component of the color of the boxes to be drawn.</param>
+///<param name="g">The green component of the color of the boxes to be drawn.</param>
+///<param name="b">The blue component of the color of the boxes to be drawn.</param>
+///<param name="a">The alpha component of the color of the boxes to be drawn.</param>
+void show_yellow_rectangles(uint8_t * rgba8, int width, int height, const YellowBoundingBox * boxes, size_t boxCount, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
-	BarCodeAppearance ret;
-	ret._firstBox = startBox;
-	ret._secondBox = endBox;
-	ret.sectionCount = sectionCount;
-	ret.colorStartX = startX;
-	ret.colorStartY = startY;
-	ret.colorEndX = endX;
-	ret.colorEndY = endY;
-	for (int i = 0; i < sectionCount; i++)
-	{
-		ret.redAverage[i] = 0.0f;
-		ret.blueAverage[i] = 0.0f;
-		ret.greenAverage[i] = 0.0f;
-		ret.pixelCount[i] = 0;
-	}
-
-	int origX = startX;
-	int origY = startY;
-	int dx = abs(endX - startX);
-	int dy = abs(endY - startY);
-	int sx = startX < endX ? 1 : -1;
-	int sy = startY < endY ? 1 : -1;
-	int error = (dx > dy ? dx : -dy) / 2;
-
-	int totalDistance = _get_distance(startX, startY, endX, endY);
-
-	while (true) {
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		//Draw the top and bottom lines
+		for (int x = boxes[i].left; x <= boxes[i].right; x++)
+		{
+			//Top line
+			rgba8[((x + (boxes[i].top * width)) * 4) + 0] = r;
+			rgba8[((x + (boxes[i].top * width)) * 4) + 1] = g;
+			rgba8[((x + (boxes[i].top * width)) * 4) + 2] = b;
+			rgba8[((x + (boxes[i].top * width)) * 4) + 3] = a;
 
-		int currentDistance = _get_distance(startX, startY, origX, origY);
-		float progress = currentDistance / (float)totalDistance;
-		int sectionIndex = (int)(progress * sectionCount);
+			//Bottom line
+			rgba8[((x + (boxes[i].bottom * width)) * 4) + 0] = r;
+			rgba8[((x + (boxes[i].bottom * width)) * 4) + 1] = g;
+			rgba8[((x + (boxes[i].bottom * width)) * 4) + 2] = b;
+			rgba8[((x + (boxes[i].bottom * width)) * 4) + 3] = a;
+		}
 
-		//Saturate barIndex (though we should never have to!)
-		if (sectionIndex >= BAR_CODE_MAX_COLOR_COUNT)
-			sectionIndex = BAR_CODE_MAX_COLOR_COUNT - 1;
-		if (sectionIndex < 0)
-			sectionIndex = 0;
+		//Draw the left and right lines
+		for (int y = boxes[i].top; y <= boxes[i].bottom; y++)
+		{
+			//Left line
+			rgba8[((boxes[i].left + (y * width)) * 4) + 0] = r;
+			rgba8[((boxes[i].left + (y * width)) * 4) + 1] = g;
+			rgba8[((boxes[i].left + (y * width)) * 4) + 2] = b;
+			rgba8[((boxes[i].left + (y * width)) * 4) + 3] = a;
 
-		uint8_t r = rgba8[((startX + (startY * width)) * 4) + 0];
-		uint8_t g = rgba8[((startX + (startY * width)) * 4) + 1];
-		uint8_t b = rgba8[((startX + (startY * width)) * 4) + 2];
+			//Right line
+			rgba8[((boxes[i].right + (y * width)) * 4) + 0] = r;
+			rgba8[((boxes[i].right + (y * width)) * 4) + 1] = g;
+			rgba8[((boxes[i].right + (y * width)) * 4) + 2] = b;
+			rgba8[((boxes[i].right + (y * width)) * 4) + 3] = a;
+		}
+	}
+}
 
-		float redNess = quantify_red(r, g, b);
-		float greenNess = quantify_green(r, g, b);
-		float blueNess = quantify_blue(r, g, b);
+///<summary>The maximum number of <see cref="BarCodeColor"/>s that can fit in a <see cref="BarCode"/>.</summary>
+#define BAR_CODE_MAX_COLOR_COUNT (25)
 
-		ret.redAverage[sectionIndex] += redNess;
-		ret.greenAverage[sectionIndex] += greenNess;
-		ret.blueAverage[sectionIndex] += blueNess;
-		ret.pixelCount[sectionIndex]++;
+///<summary>Defines a color within a bar code.</summary>
+typedef enum BarCodeColor
+{
+	BAR_CODE_RED = 'R',
+	BAR_CODE_GREEN = 'G',
+	BAR_CODE_BLUE = 'B'
+} BarCodeColor;
 
-		if (startX == endX && startY == endY)
+///<summary>Defines a sequence of <see cref="BarCodeColor"/>s.</summary>
+typedef struct BarCode
+{
+	///<summary>The buffer of <see cref="BarCodeColor"/>s. Since there is no 'polarity' on an observed bar code, 
+	///palindromes are considered equivalent. For example: {BAR_CODE_RED, BAR_CODE_GREEN, BAR_CODE_GREEN, BAR_CODE_BLUE} and 
+	///{BAR_CODE_BLUE, BAR_CODE_GREEN, BAR_CODE_GREEN, BAR_CODE_RED} are equal.</summary>
+	BarCodeColor colors[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The number of <see cref="BarCodeColor"/>s stored in <see cref="BarCode.colors"/>.
+	///This value cannot be larger than <see cref="BAR_CODE_MAX_COLOR_COUNT"/>.</summary>
+	size_t colorCount;
+} BarCode;
+
+///<summary>Defines the appearance information about a bar code.</summary>
+typedef struct BarCodeAppearance
+{
+	///<summary>The <see cref="YellowBoundingBox"/> that contained the first 'yellow bar.'</summary>
+	YellowBoundingBox _firstBox;
+
+	///<summary>The <see cref="YellowBoundingBox"/> that contained the second 'yellow bar.'</summary>
+	YellowBoundingBox _secondBox;
+
+	///<summary>The x-coordinate where the 'color line' begins.</summary>
+	int colorStartX;
+
+	///<summary>The y-coordinate where the 'color line' begins.</summary>
+	int colorStartY;
+
+	///<summary>The x-coordinate where the 'color line' ends.</summary>
+	int colorEndX;
+
+	///<summary>The y-coordinate where the 'color line' ends.</summary>
+	int colorEndY;
+
+	///<summary>The number of sections in the bar code.</summary>
+	int sectionCount;
+
+	///<summary>The average rank for how 'red' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
+	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
+	float redAverage[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The average rank for how 'green' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
+	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
+	float greenAverage[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The average rank for how 'blue' a particular section of the bar code was, ranging from 0.0f to 1.0f.</summary>
+	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
+	float blueAverage[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The total number of pixels that were observed per section of the bar code.</summary>
+	///<remarks>The number of values is determined by <see cref="sectionCount"/>.</remarks>
+	int pixelCount[BAR_CODE_MAX_COLOR_COUNT];
+} BarCodeAppearance;
+
+BAR_CODE_FORCEINLINE float _quantify_bar_code_appearance_match(const BarCode* code, const float* rAvg, const float* gAvg, const float* bAvg, bool reverse)
+{
+	size_t sectionCount = code->colorCount;
+	size_t start = reverse ? sectionCount - 1 : 0;
+	size_t increment = reverse ? -1 : 1;
+	float sum = 0.0f;
+	for (size_t scanI = start, codeI = 0; scanI >= 0 && scanI < sectionCount; scanI += increment, codeI++)
+	{
+		//scanI is to iterate the observed color values. If 'reverse' is true, we will iterate from end to start.
+		//codeI is to iterate the expected color values. This value always iterates from 0 to 'sectionCount'.
+		BarCodeColor expectedColor = code->colors[codeI];
+		float r = rAvg[scanI];
+		float g = gAvg[scanI];
+		float b = bAvg[scanI];
+
+		switch (expectedColor)
+		{
+		case BAR_CODE_RED:
+			sum += r;
+			sum -= g;
+			sum -= b;
+			break;
+
+		case BAR_CODE_GREEN:
+			sum += g;
+			sum -= r;
+			sum -= b;
+			break;
+
+		case BAR_CODE_BLUE:
+			sum += b;
+			sum -= r;
+			sum -= g;
+			break;
+
+		default:
+			assert(0 && "Unrecognized BarCodeColor value");
+			break;
+		}
+	}
+
+	float score = sum / sectionCount;
+	if (score < 0.0f)
+		score = 0.0f;
+	if (score > 1.0f)
+		score = 1.0f;
+	return score;
+}
+
+///<summary>Quantifies how well a <see cref="BarCodeAppearance"/> matches a specific <see cref="BarCode"/>, ranging from
+///0.0 (no match) to 1.0 (full match).</summary>
+///<param name="code">The <see cref="BarCode"/>.</param>
+///<param name="appearance">The <see cref="BarCodeAppearance"/>.</param>
+///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is no match and 1.0f is full match.</returns>
+BAR_CODE_FORCEINLINE float quantify_bar_code_appearance_match(const BarCode* code, const BarCodeAppearance* appearance)
+{
+	assert(code->colorCount == appearance->sectionCount);
+
+	//Since bar codes do not have polarity, we have to 'scan' the line in two directions.
+	float forward = _quantify_bar_code_appearance_match(code, appearance->redAverage, appearance->greenAverage, appearance->blueAverage, false);
+	float reverse = _quantify_bar_code_appearance_match(code, appearance->redAverage, appearance->greenAverage, appearance->blueAverage, true);
+
+	//We will take the best match of 'forward' or 'reverse.'
+	if (forward > reverse)
+		return forward;
+	else
+		return reverse;
+}
+
+///<summary>Quantifies how distinctly red a particular color is.</summary>
+///<param name="r">The red component of the color.</param>
+///<param name="g">The green component of the color.</param>
+///<param name="b">The blue component of the color.</param>
+///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not red' and 1.0f is 'full red.'</returns>
+BAR_CODE_FORCEINLINE float quantify_red(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (r > g&& r > b)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+}
+
+///<summary>Quantifies how distinctly green a particular color is.</summary>
+///<param name="r">The red component of the color.</param>
+///<param name="g">The green component of the color.</param>
+///<param name="b">The blue component of the color.</param>
+///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not green' and 1.0f is 'full green.'</returns>
+BAR_CODE_FORCEINLINE float quantify_green(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (g > r&& g > b)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+}
+
+///<summary>Quantifies how distinctly blue a particular color is.</summary>
+///<param name="r">The red component of the color.</param>
+///<param name="g">The green component of the color.</param>
+///<param name="b">The blue component of the color.</param>
+///<returns>A value ranging from 0.0f to 1.0f, where 0.0f is 'not blue' and 1.0f is 'full blue.'</returns>
+BAR_CODE_FORCEINLINE float quantify_blue(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (b > r&& b > g)?1.0f:0.0f;//TODO: Tune this according to your specific needs (depending on camera, lighting, etc)
+}
+
+void _draw_line(uint8_t * rgba8, int width, int height, int x1, int y1, int x2, int y2, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+	int dx = abs(x2 - x1);
+	int dy = abs(y2 - y1);
+	int sx = x1 < x2 ? 1 : -1;
+	int sy = y1 < y2 ? 1 : -1;
+	int error = (dx > dy ? dx : -dy) / 2;
+	while (true) {
+
+		rgba8[((x1 + (y1 * width)) * 4) + 0] = r;
+		rgba8[((x1 + (y1 * width)) * 4) + 1] = g;
+		rgba8[((x1 + (y1 * width)) * 4) + 2] = b;
+		rgba8[((x1 + (y1 * width)) * 4) + 3] = a;
+
+		if (x1 == x2 && y1 == y2)
+			break;
+
+		int errorCopy = error;
+		if (errorCopy > -dx)
+		{
+			error -= dy;
+			x1 += sx;
+		}
+
+		if (errorCopy < dy)
+		{
+			error += dx;
+			y1 += sy;
+		}
+	}
+}
+
+///<summary>Given a line that starts and ends in 'yellow bars,' finds the endpoints of the 'colorful' line between the 'yellow bars.'</summary>
+///<param name="image">The <see cref="BarCodeImage"/>, in any <see cref="BarCodePixelFormat"/>.</param>
+///<param name="format">The format of <paramref name="image"/>. It is passed separately so that it is a constant wherever this function is inlined.</param>
+///<param name="yellowCfg">The <see cref="YellowConfig"/> that identifies the 'yellow bars.'</param>
+///<param name="firstX">As input, identifies the X position of the midpoint of the first 'yellow bar.' As output, identifies the X
+///position where the 'colorful' line begins.</param>
+///<param name="firstY">As input, identifies the Y position of the midpoint of the first 'yellow bar.' As output, identifies the Y
+///position where the 'colorful' line begins.</param>
+///<param name="secondX">As input, identifies the X position of the midpoint of the last 'yellow bar.' As output, identifies the X
+///position where the 'colorful' line ends.</param>
+///<param name="secondY">As input, identifies the Y position of the midpoint of the last 'yellow bar.' As output, identifies the Y
+///position where the 'colorful' line ends.</param>
+BAR_CODE_FORCEINLINE void _find_colorful_line_endpoints(const BarCodeImage* image, BarCodePixelFormat format, YellowConfig yellowCfg, int* firstX, int* firstY, int* secondX, int* secondY)
+{
+	int x1 = firstX[0];
+	int y1 = firstY[0];
+	int x2 = secondX[0];
+	int y2 = secondY[0];
+	int dx = abs(x2 - x1);
+	int dy = abs(y2 - y1);
+	int sx = x1 < x2 ? 1 : -1;
+	int sy = y1 < y2 ? 1 : -1;
+	int error = (dx > dy ? dx : -dy) / 2;
+	bool foundColorStart = false;
+	bool inColor = false;
+	int lastX = x2, lastY = y2;
+	const uint8_t* row = _get_image_row(image, y1);
+	const uint8_t* chromaRow = _get_image_chroma_row(image, y1);
+	ptrdiff_t rowStep = (ptrdiff_t)sy * (ptrdiff_t)_get_image_stride(image);
+	while (true) {
+
+		uint8_t rgb[3];
+		_read_row_pixel(format, row, chromaRow, x1, rgb);
+
+		if (is_yellow(rgb[0], rgb[1], rgb[2], yellowCfg))
+		{
+			if (inColor)
+			{
+				//We found the start of the 'end yellow bar', so stop just before here.
+				//NOTE: We may be wrong! This may be an anomalous pixel on the line which happens to trigger the 'is yellow pixel' filter.
+				//      This function will always take the LAST position just before a 'yellow bar' region. Usually there is only one (hopefully always!)
+				secondX[0] = lastX;
+				secondY[0] = lastY;
+				inColor = false;
+			}
+			//else we are still in the 'start yellow bar', so do nothing
+		}
+		else
+		{
+			if (inColor)
+			{
+				//We are still in the 'colorful' part of the line, so keep searching
+			}
+			else
+			{
+				if (!foundColorStart)
+				{
+					//We found the start of the 'colorful' part of the line
+					firstX[0] = x1;
+					firstY[0] = y1;
+					foundColorStart = true;
+				}
+				else
+				{
+					//This indicates an anomaly. We already found some color, then thought we saw the 'end yellow bar,' but now we are seeing more color.
+					//This means that the 'yellow' that we previously observed was an anomalous bit of yellow between the endpoints.
+					//We will continue to search until we reach the last 'yellow bar.'
+				}
+
+				inColor = true;
+			}
+		}
+
+		if (x1 == x2 && y1 == y2)
+			break;
+
+		int errorCopy = error;
+		if (errorCopy > -dx)
+		{
+			error -= dy;
+			x1 += sx;
+		}
+
+		if (errorCopy < dy)
+		{
+			error += dx;
+			y1 += sy;
+			row += rowStep;
+			if (chromaRow != NULL)
+				chromaRow = _get_image_chroma_row(image, y1);
+		}
+
+		lastX = x1;
+		lastY = y1;
+	}
+
+}
+
+BAR_CODE_FORCEINLINE int _get_distance(int x0, int y0, int x1, int y1)
+{
+	return (int)sqrt(((x1 - x0) * (x1 - x0)) + ((y1 - y0) * (y1 - y0)));
+}
+
+///<summary>Reads several <see cref="BarCodeAppearance"/>s of the same colorful line from an image, each divided into a different number of sections.</summary>
+///<param name="image">The <see cref="BarCodeImage"/>, in any <see cref="BarCodePixelFormat"/>.</param>
+///<param name="format">The format of <paramref name="image"/> (see <see cref="_find_colorful_line_endpoints"/>).</param>
+///<param name="sectionCounts">The number of sections (value colors) of each <see cref="BarCodeAppearance"/>.</param>
+///<param name="sectionCountCount">The number of values in <paramref name="sectionCounts"/>, from 1 to <see cref="BAR_CODE_MAX_COLOR_COUNT"/>.</param>
+///<param name="startBox">The <see cref="YellowBoundingBox"/> that surrounds the first 'yellow bar.'</param>
+///<param name="endBox">The <see cref="YellowBoundingBox"/> that surrounds the second 'yellow bar.'</param>
+///<param name="startX">The X position where the colorful line begins.</param>
+///<param name="startY">The Y position where the colorful line begins.</param>
+///<param name="endX">The X position where the colorful line ends.</param>
+///<param name="endY">The Y position where the colorful line ends.</param>
+///<param name="results">Receives one <see cref="BarCodeAppearance"/> for each value of <paramref name="sectionCounts"/>, in the same order.</param>
+///<remarks>Each pixel on the line is read and quantified once, then added to the section that it falls in for every section count.</remarks>
+BAR_CODE_FORCEINLINE void _read_bar_code_appearances(const BarCodeImage* image, BarCodePixelFormat format, const int * sectionCounts, int sectionCountCount, YellowBoundingBox startBox, YellowBoundingBox endBox, int startX, int startY, int endX, int endY, BarCodeAppearance * results)
+{
+	assert(sectionCountCount >= 1 && sectionCountCount <= BAR_CODE_MAX_COLOR_COUNT);
+	for (int k = 0; k < sectionCountCount; k++)
+	{
+		BarCodeAppearance* ret = &results[k];
+		ret->_firstBox = startBox;
+		ret->_secondBox = endBox;
+		ret->sectionCount = sectionCounts[k];
+		ret->colorStartX = startX;
+		ret->colorStartY = startY;
+		ret->colorEndX = endX;
+		ret->colorEndY = endY;
+		for (int i = 0; i < sectionCounts[k]; i++)
+		{
+			ret->redAverage[i] = 0.0f;
+			ret->blueAverage[i] = 0.0f;
+			ret->greenAverage[i] = 0.0f;
+			ret->pixelCount[i] = 0;
+		}
+	}
+
+	int dx = abs(endX - startX);
+	int dy = abs(endY - startY);
+	int sx = startX < endX ? 1 : -1;
+	int sy = startY < endY ? 1 : -1;
+	int error = (dx > dy ? dx : -dy) / 2;
+
+	//Each step moves one pixel along the line's major axis, so a pixel's projection onto the line is (step / stepCount) of the way along it.
+	//Track floor(step * sectionCount / stepCount) with an integer remainder instead of measuring each pixel's distance from the start.
+	int stepCount = dx > dy ? dx : dy;
+	int sectionIndices[BAR_CODE_MAX_COLOR_COUNT];
+	int sectionRemainders[BAR_CODE_MAX_COLOR_COUNT];
+	for (int k = 0; k < sectionCountCount; k++)
+	{
+		sectionIndices[k] = 0;
+		sectionRemainders[k] = 0;
+	}
+
+	const uint8_t* row = _get_image_row(image, startY);
+	const uint8_t* chromaRow = _get_image_chroma_row(image, startY);
+	ptrdiff_t rowStep = (ptrdiff_t)sy * (ptrdiff_t)_get_image_stride(image);
+
+	while (true) {
+
+		uint8_t rgb[3];
+		_read_row_pixel(format, row, chromaRow, startX, rgb);
+		uint8_t r = rgb[0];
+		uint8_t g = rgb[1];
+		uint8_t b = rgb[2];
+
+		float redNess = quantify_red(r, g, b);
+		float greenNess = quantify_green(r, g, b);
+		float blueNess = quantify_blue(r, g, b);
+
+		for (int k = 0; k < sectionCountCount; k++)
+		{
+			//Only the last pixel reaches sectionCount, and it belongs to the last section
+			int section = sectionIndices[k] < sectionCounts[k] ? sectionIndices[k] : sectionCounts[k] - 1;
+			results[k].redAverage[section] += redNess;
+			results[k].greenAverage[section] += greenNess;
+			results[k].blueAverage[section] += blueNess;
+			results[k].pixelCount[section]++;
+		}
+
+		if (startX == endX && startY == endY)
 			break;
 
 		int errorCopy = error;
@@ -832,18 +1352,826 @@ BarCodeAppearance _read_bar_code_appearance(const uint8_t * rgba8, int width, in
 		{
 			error += dx;
 			startY += sy;
+			row += rowStep;
+			if (chromaRow != NULL)
+				chromaRow = _get_image_chroma_row(image, startY);
+		}
+
+		for (int k = 0; k < sectionCountCount; k++)
+		{
+			sectionRemainders[k] += sectionCounts[k];
+			while (sectionRemainders[k] >= stepCount)
+			{
+				sectionRemainders[k] -= stepCount;
+				sectionIndices[k]++;
+			}
+		}
+	}
+
+	for (int k = 0; k < sectionCountCount; k++)
+	{
+		BarCodeAppearance* ret = &results[k];
+		for (int i = 0; i < ret->sectionCount; i++)
+		{
+			//Up to here, the 'average' values have actually been sums. Now divide to make them average.
+			ret->redAverage[i] /= ret->pixelCount[i];
+			ret->greenAverage[i] /= ret->pixelCount[i];
+			ret->blueAverage[i] /= ret->pixelCount[i];
+		}
+	}
+}
+
+///<summary>Reads a <see cref="BarCodeAppearance"/> from an image.</summary>
+///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
+///<param name="width">The width of the image, measured in pixels.</param>
+///<param name="height">The height of the image, measured in pixels.</param>
+///<param name="sectionCount">The number of sections (value colors) on the bar code.</param>
+///<param name="startBox">The <see cref="YellowBoundingBox"/> that surrounds the first 'yellow bar.'</param>
+///<param name="endBox">The <see cref="YellowBoundingBox"/> that surrounds the second 'yellow bar.'</param>
+///<param name="startX">The X position where the colorful line begins.</param>
+///<param name="startY">The Y position where the colorful line begins.</param>
+///<param name="endX">The X position where the colorful line ends.</param>
+///<param name="endY">The Y position where the colorful line ends.</param>
+///<returns>The resulting <see cref="BarCodeAppearance"/>.</returns>
+BarCodeAppearance _read_bar_code_appearance(const uint8_t * rgba8, int width, int height, int sectionCount, YellowBoundingBox startBox, YellowBoundingBox endBox, int startX, int startY, int endX, int endY)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	BarCodeAppearance ret;
+	_read_bar_code_appearances(&image, BAR_CODE_PIXEL_FORMAT_RGBA8, &sectionCount, 1, startBox, endBox, startX, startY, endX, endY, &ret);
+	return ret;
+}
+
+///<summary>Reads the <see cref="BarCodeAppearance"/>s on the line between two <see cref="YellowBoundingBox"/>es, one for each section count
+///(see <see cref="_read_bar_code_appearances"/>).</summary>
+///<returns>False if the colorful portion of the line has no length, so there is nothing to read.</returns>
+BAR_CODE_FORCEINLINE bool _try_read_bar_code_appearances_in_format(const BarCodeImage* image, BarCodePixelFormat format, YellowConfig yellowCfg, YellowBoundingBox start, YellowBoundingBox end, const int* sectionCounts, int sectionCountCount, BarCodeAppearance* results)
+{
+	int startX = (start.left + start.right) / 2;
+	int startY = (start.top + start.bottom) / 2;
+	int endX = (end.left + end.right) / 2;
+	int endY = (end.top + end.bottom) / 2;
+
+	//'start' and 'end' points are inside the yellow bar regions. We want a line that defines the colorful region between the yellow bars.
+	//So find the colorful line's endpoints
+	_find_colorful_line_endpoints(image, format, yellowCfg, &startX, &startY, &endX, &endY);
+
+	if (startX == endX && startY == endY)
+		return false;//Cannot scan a line with no length, so skip it
+
+	_read_bar_code_appearances(image, format, sectionCounts, sectionCountCount, start, end, startX, startY, endX, endY, results);
+	return true;
+}
+
+///<summary>Reads the <see cref="BarCodeAppearance"/>s on the line between two <see cref="YellowBoundingBox"/>es, like
+///<see cref="_try_read_bar_code_appearances_in_format"/>.</summary>
+///<remarks>Each format gets its own copy of the line walkers, so the pixels are not read through a switch.</remarks>
+static bool _try_read_bar_code_appearances_between(const BarCodeImage* image, YellowConfig yellowCfg, YellowBoundingBox start, YellowBoundingBox end, const int* sectionCounts, int sectionCountCount, BarCodeAppearance* results)
+{
+	switch (image->format)
+	{
+	case BAR_CODE_PIXEL_FORMAT_BGRA8:
+		return _try_read_bar_code_appearances_in_format(image, BAR_CODE_PIXEL_FORMAT_BGRA8, yellowCfg, start, end, sectionCounts, sectionCountCount, results);
+	case BAR_CODE_PIXEL_FORMAT_RGB24:
+		return _try_read_bar_code_appearances_in_format(image, BAR_CODE_PIXEL_FORMAT_RGB24, yellowCfg, start, end, sectionCounts, sectionCountCount, results);
+	case BAR_CODE_PIXEL_FORMAT_YUYV:
+		return _try_read_bar_code_appearances_in_format(image, BAR_CODE_PIXEL_FORMAT_YUYV, yellowCfg, start, end, sectionCounts, sectionCountCount, results);
+	case BAR_CODE_PIXEL_FORMAT_NV12:
+		return _try_read_bar_code_appearances_in_format(image, BAR_CODE_PIXEL_FORMAT_NV12, yellowCfg, start, end, sectionCounts, sectionCountCount, results);
+	default:
+		return _try_read_bar_code_appearances_in_format(image, BAR_CODE_PIXEL_FORMAT_RGBA8, yellowCfg, start, end, sectionCounts, sectionCountCount, results);
+	}
+}
+
+///<summary>The maximum value of <see cref="BarCodePairingConfig.maxNeighbors"/>.</summary>
+#define BAR_CODE_MAX_PAIR_NEIGHBORS (64)
+
+///<summary>Limits which pairs of <see cref="YellowBoundingBox"/>es are read by <see cref="find_bar_code_appearances"/>.</summary>
+///<remarks>Most pairs of boxes are too far apart to be the two ends of a real bar code, and each pair that is read costs a walk along the line
+///between the boxes. With both limits set to zero, every pair is read.</remarks>
+typedef struct BarCodePairingConfig
+{
+	///<summary>The maximum distance, in pixels, between the centers of two <see cref="YellowBoundingBox"/>es that are read as a pair. Zero means no limit.</summary>
+	int maxDistance;
+
+	///<summary>If not zero, each <see cref="YellowBoundingBox"/> is only paired with its nearest <see cref="maxNeighbors"/> boxes (ties are broken by the
+	///lower index), and with the boxes that have it among their nearest. Cannot be larger than <see cref="BAR_CODE_MAX_PAIR_NEIGHBORS"/>.</summary>
+	int maxNeighbors;
+} BarCodePairingConfig;
+
+///<summary>A uniform grid over the centers of a set of <see cref="YellowBoundingBox"/>es, used to find the pairs that <see cref="BarCodePairingConfig"/> allows
+///without measuring the distance between every pair.</summary>
+///<remarks>The buffers grow as needed (see <see cref="build_yellow_box_index"/>) and are kept for later calls. A zero-initialized <see cref="YellowBoxIndex"/>
+///is empty and valid. Free the buffers with <see cref="free_yellow_box_index"/>.</remarks>
+typedef struct YellowBoxIndex
+{
+	///<summary>The x-coordinate of the left edge of the grid.</summary>
+	int originX;
+
+	///<summary>The y-coordinate of the top edge of the grid.</summary>
+	int originY;
+
+	///<summary>The width and height of each cell, in pixels.</summary>
+	int cellSize;
+
+	///<summary>The number of columns of cells.</summary>
+	int columns;
+
+	///<summary>The number of rows of cells.</summary>
+	int rows;
+
+	///<summary>The number of <see cref="YellowBoundingBox"/>es in the index.</summary>
+	size_t boxCount;
+
+	///<summary>The <see cref="BarCodePairingConfig"/> that the index was built for.</summary>
+	BarCodePairingConfig pairing;
+
+	///<summary>For each cell (in row-major order), the position of its first box in <see cref="cellBoxes"/>, followed by the total box count.</summary>
+	size_t* cellStarts;
+
+	///<summary>The number of values that fit in <see cref="cellStarts"/>.</summary>
+	size_t cellStartCapacity;
+
+	///<summary>The indices of the boxes, sorted by cell, and by index within each cell.</summary>
+	size_t* cellBoxes;
+
+	///<summary>The number of values that fit in <see cref="cellBoxes"/>.</summary>
+	size_t cellBoxCapacity;
+
+	///<summary>When <see cref="BarCodePairingConfig.maxNeighbors"/> is used: for each box, the position of its first partner in <see cref="partners"/>,
+	///followed by the total partner count.</summary>
+	size_t* partnerStarts;
+
+	///<summary>The number of values that fit in <see cref="partnerStarts"/>.</summary>
+	size_t partnerStartCapacity;
+
+	///<summary>When <see cref="BarCodePairingConfig.maxNeighbors"/> is used: the partners of each box that have a higher index, sorted by index.
+	///Before they are sorted, this also holds the nearest neighbors of each box.</summary>
+	size_t* partners;
+
+	///<summary>The number of values that fit in <see cref="partners"/>.</summary>
+	size_t partnerCapacity;
+
+	///<summary>Scratch space for the partners of one box, used by <see cref="find_bar_code_appearances"/>.</summary>
+	size_t* candidates;
+
+	///<summary>The number of values that fit in <see cref="candidates"/>.</summary>
+	size_t candidateCapacity;
+} YellowBoxIndex;
+
+///<summary>Frees the buffers of a <see cref="YellowBoxIndex"/>, leaving it empty.</summary>
+static void free_yellow_box_index(YellowBoxIndex* index)
+{
+	free(index->cellStarts);
+	free(index->cellBoxes);
+	free(index->partnerStarts);
+	free(index->partners);
+	free(index->candidates);
+	memset(index, 0, sizeof(YellowBoxIndex));
+}
+
+///<summary>Makes sure that one of the buffers of a <see cref="YellowBoxIndex"/> can hold at least <paramref name="count"/> values.</summary>
+static bool _reserve_index_buffer(size_t** buffer, size_t* capacity, size_t count)
+{
+	if (count <= *capacity)
+		return true;
+	size_t* grown = (size_t*)realloc(*buffer, count * sizeof(size_t));
+	if (grown == NULL)
+		return false;
+	*buffer = grown;
+	*capacity = count;
+	return true;
+}
+
+///<summary>Gets the point of a <see cref="YellowBoundingBox"/> that is used for pairing, which is where <see cref="find_bar_code_appearances"/>
+///starts looking for the colorful line.</summary>
+BAR_CODE_FORCEINLINE void _get_box_center(YellowBoundingBox box, int* x, int* y)
+{
+	*x = (box.left + box.right) / 2;
+	*y = (box.top + box.bottom) / 2;
+}
+
+BAR_CODE_FORCEINLINE int64_t _get_box_distance_squared(YellowBoundingBox a, YellowBoundingBox b)
+{
+	int ax, ay, bx, by;
+	_get_box_center(a, &ax, &ay);
+	_get_box_center(b, &bx, &by);
+	int64_t dx = (int64_t)ax - bx, dy = (int64_t)ay - by;
+	return dx * dx + dy * dy;
+}
+
+BAR_CODE_FORCEINLINE int _get_cell_coordinate(int value, int origin, int cellSize, int cellCount)
+{
+	int cell = (value - origin) / cellSize;
+	return cell < 0 ? 0 : (cell >= cellCount ? cellCount - 1 : cell);
+}
+
+///<summary>Finds the nearest <paramref name="k"/> boxes to box <paramref name="self"/>, searching the grid in rings of cells around it.</summary>
+///<param name="nearest">Receives the indices of the nearest boxes, nearest first (ties are broken by the lower index).</param>
+///<returns>The number of boxes found, which is less than <paramref name="k"/> only if there are not enough other boxes.</returns>
+static int _find_nearest_boxes(const YellowBoxIndex* index, const YellowBoundingBox* boxes, size_t self, int k, size_t* nearest)
+{
+	int64_t nearestDistances[BAR_CODE_MAX_PAIR_NEIGHBORS];
+	int count = 0;
+
+	int x, y;
+	_get_box_center(boxes[self], &x, &y);
+	int cellX = _get_cell_coordinate(x, index->originX, index->cellSize, index->columns);
+	int cellY = _get_cell_coordinate(y, index->originY, index->cellSize, index->rows);
+	int maxRing = index->columns > index->rows ? index->columns : index->rows;
+	for (int ring = 0; ring <= maxRing; ring++)
+	{
+		//The center can be anywhere within its cell, so every box that has not been seen yet is at least ring - 1 cells away.
+		//Stop once none of them can be nearer than (or as near as, since it may have a lower index) the farthest neighbor.
+		int64_t minUnseenDistance = (int64_t)(ring - 1) * index->cellSize;
+		if (ring > 0 && count == k && nearestDistances[count - 1] < minUnseenDistance * minUnseenDistance)
+			break;
+
+		for (int cy = cellY - ring; cy <= cellY + ring; cy++)
+		{
+			if (cy < 0 || cy >= index->rows)
+				continue;
+			bool edgeRow = cy == cellY - ring || cy == cellY + ring;
+			for (int cx = cellX - ring; cx <= cellX + ring; cx += (edgeRow || ring == 0) ? 1 : 2 * ring)
+			{
+				if (cx < 0 || cx >= index->columns)
+					continue;
+
+				size_t cell = (size_t)cy * (size_t)index->columns + (size_t)cx;
+				for (size_t p = index->cellStarts[cell]; p < index->cellStarts[cell + 1]; p++)
+				{
+					size_t other = index->cellBoxes[p];
+					if (other == self)
+						continue;
+
+					//Insert into the sorted list of the nearest boxes
+					int64_t distance = _get_box_distance_squared(boxes[self], boxes[other]);
+					int position = count;
+					while (position > 0 && (nearestDistances[position - 1] > distance || (nearestDistances[position - 1] == distance && nearest[position - 1] > other)))
+						position--;
+					if (position == k)
+						continue;
+					for (int i = (count < k ? count : k - 1); i > position; i--)
+					{
+						nearestDistances[i] = nearestDistances[i - 1];
+						nearest[i] = nearest[i - 1];
+					}
+					nearestDistances[position] = distance;
+					nearest[position] = other;
+					if (count < k)
+						count++;
+				}
+			}
+		}
+	}
+	return count;
+}
+
+static int _compare_size_t(const void* a, const void* b)
+{
+	size_t x = *(const size_t*)a, y = *(const size_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+///<summary>Builds a <see cref="YellowBoxIndex"/> over a set of <see cref="YellowBoundingBox"/>es.</summary>
+///<param name="index">The index, whose buffers grow as needed.</param>
+///<param name="boxes">The <see cref="YellowBoundingBox"/>es.</param>
+///<param name="boxCount">The number of <see cref="YellowBoundingBox"/>es in <paramref name="boxes"/>.</param>
+///<param name="pairing">The limits that the index will be used for.</param>
+///<returns>False if the buffers could not grow, in which case the index cannot be used.</returns>
+static bool build_yellow_box_index(YellowBoxIndex* index, const YellowBoundingBox* boxes, size_t boxCount, BarCodePairingConfig pairing)
+{
+	assert(pairing.maxNeighbors >= 0 && pairing.maxNeighbors <= BAR_CODE_MAX_PAIR_NEIGHBORS);
+	index->boxCount = boxCount;
+	index->pairing = pairing;
+	if (boxCount == 0)
+		return true;
+
+	//Size the cells so that there are about as many cells as boxes, but no smaller than the maximum distance (so a distance query only
+	//needs to look at the neighboring cells)
+	int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		int x, y;
+		_get_box_center(boxes[i], &x, &y);
+		minX = x < minX ? x : minX;
+		minY = y < minY ? y : minY;
+		maxX = x > maxX ? x : maxX;
+		maxY = y > maxY ? y : maxY;
+	}
+	int64_t spanX = (int64_t)maxX - minX + 1, spanY = (int64_t)maxY - minY + 1;
+	int cellSize = (int)sqrt((double)(spanX * spanY) / (double)boxCount) + 1;
+	if (pairing.maxDistance > cellSize)
+		cellSize = pairing.maxDistance;
+	index->originX = minX;
+	index->originY = minY;
+	index->cellSize = cellSize;
+	index->columns = (int)(spanX / cellSize) + 1;
+	index->rows = (int)(spanY / cellSize) + 1;
+	size_t cellCount = (size_t)index->columns * (size_t)index->rows;
+
+	if (!_reserve_index_buffer(&index->cellStarts, &index->cellStartCapacity, cellCount + 1) || !_reserve_index_buffer(&index->cellBoxes, &index->cellBoxCapacity, boxCount))
+		return false;
+
+	//Counting sort of the boxes by cell. Boxes are visited in order, so each cell's boxes stay sorted by index.
+	memset(index->cellStarts, 0, (cellCount + 1) * sizeof(size_t));
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		int x, y;
+		_get_box_center(boxes[i], &x, &y);
+		size_t cell = (size_t)_get_cell_coordinate(y, minY, cellSize, index->rows) * (size_t)index->columns + (size_t)_get_cell_coordinate(x, minX, cellSize, index->columns);
+		index->cellStarts[cell + 1]++;
+	}
+	for (size_t c = 0; c < cellCount; c++)
+		index->cellStarts[c + 1] += index->cellStarts[c];
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		int x, y;
+		_get_box_center(boxes[i], &x, &y);
+		size_t cell = (size_t)_get_cell_coordinate(y, minY, cellSize, index->rows) * (size_t)index->columns + (size_t)_get_cell_coordinate(x, minX, cellSize, index->columns);
+		index->cellBoxes[index->cellStarts[cell]++] = i;
+	}
+	for (size_t c = cellCount; c > 0; c--)
+		index->cellStarts[c] = index->cellStarts[c - 1];
+	index->cellStarts[0] = 0;
+
+	if (pairing.maxNeighbors == 0)
+		return true;
+
+	//Find the nearest neighbors of every box. Each neighbor relation is stored once, at the box with the lower index,
+	//so that the partners of each box can be read in order.
+	size_t k = (size_t)pairing.maxNeighbors;
+	if (!_reserve_index_buffer(&index->partnerStarts, &index->partnerStartCapacity, boxCount + 1) || !_reserve_index_buffer(&index->partners, &index->partnerCapacity, boxCount * k * 2))
+		return false;
+
+	size_t* nearest = index->partners + boxCount * k;//The second half holds the nearest neighbors until they are distributed to the first half
+	memset(index->partnerStarts, 0, (boxCount + 1) * sizeof(size_t));
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		int count = _find_nearest_boxes(index, boxes, i, (int)k, nearest + i * k);
+		for (int n = 0; n < count; n++)
+		{
+			size_t other = nearest[i * k + n];
+			index->partnerStarts[(other < i ? other : i) + 1]++;
+		}
+		for (size_t n = (size_t)count; n < k; n++)
+			nearest[i * k + n] = SIZE_MAX;
+	}
+	for (size_t i = 0; i < boxCount; i++)
+		index->partnerStarts[i + 1] += index->partnerStarts[i];
+
+	//Distribute the relations, of which there are at most boxCount * k
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		for (size_t n = 0; n < k; n++)
+		{
+			size_t other = nearest[i * k + n];
+			if (other == SIZE_MAX)
+				break;
+			size_t low = other < i ? other : i, high = other < i ? i : other;
+			index->partners[index->partnerStarts[low]++] = high;
+		}
+	}
+	for (size_t i = boxCount; i > 0; i--)
+		index->partnerStarts[i] = index->partnerStarts[i - 1];
+	index->partnerStarts[0] = 0;
+
+	//Sort each box's partners and remove duplicates (two boxes that are each other's neighbors), compacting the lists as we go
+	size_t write = 0;
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		size_t start = index->partnerStarts[i], end = index->partnerStarts[i + 1];
+		qsort(index->partners + start, end - start, sizeof(size_t), _compare_size_t);
+		index->partnerStarts[i] = write;
+		for (size_t p = start; p < end; p++)
+		{
+			if (p == start || index->partners[p] != index->partners[p - 1])
+				index->partners[write++] = index->partners[p];
+		}
+	}
+	index->partnerStarts[boxCount] = write;
+	return true;
+}
+
+///<summary>Finds the boxes with a higher index than <paramref name="first"/> that it should be paired with, using a <see cref="YellowBoxIndex"/>.</summary>
+///<param name="index">The <see cref="YellowBoxIndex"/>, built for <paramref name="boxes"/> and a pairing that is not unlimited.</param>
+///<param name="candidates">Receives the indices of the partner boxes, sorted. Must be able to hold one value per box.</param>
+///<returns>The number of partner boxes.</returns>
+static size_t _find_pair_candidates(const YellowBoxIndex* index, const YellowBoundingBox* boxes, size_t first, size_t* candidates)
+{
+	int64_t maxDistanceSquared = (int64_t)index->pairing.maxDistance * index->pairing.maxDistance;
+	size_t count = 0;
+
+	if (index->pairing.maxNeighbors > 0)
+	{
+		for (size_t p = index->partnerStarts[first]; p < index->partnerStarts[first + 1]; p++)
+		{
+			size_t other = index->partners[p];
+			if (index->pairing.maxDistance <= 0 || _get_box_distance_squared(boxes[first], boxes[other]) <= maxDistanceSquared)
+				candidates[count++] = other;
+		}
+		return count;
+	}
+
+	//The cells are at least as big as the maximum distance, so only the neighboring cells need to be searched
+	int x, y;
+	_get_box_center(boxes[first], &x, &y);
+	int cellX = _get_cell_coordinate(x, index->originX, index->cellSize, index->columns);
+	int cellY = _get_cell_coordinate(y, index->originY, index->cellSize, index->rows);
+	for (int cy = cellY - 1; cy <= cellY + 1; cy++)
+	{
+		for (int cx = cellX - 1; cx <= cellX + 1; cx++)
+		{
+			if (cx < 0 || cy < 0 || cx >= index->columns || cy >= index->rows)
+				continue;
+			size_t cell = (size_t)cy * (size_t)index->columns + (size_t)cx;
+			for (size_t p = index->cellStarts[cell]; p < index->cellStarts[cell + 1]; p++)
+			{
+				size_t other = index->cellBoxes[p];
+				if (other > first && _get_box_distance_squared(boxes[first], boxes[other]) <= maxDistanceSquared)
+					candidates[count++] = other;
+			}
+		}
+	}
+	qsort(candidates, count, sizeof(size_t), _compare_size_t);
+	return count;
+}
+
+///<summary>True if the <see cref="BarCodePairingConfig"/> allows every pair.</summary>
+BAR_CODE_FORCEINLINE bool _is_pairing_unlimited(BarCodePairingConfig pairing)
+{
+	return pairing.maxDistance <= 0 && pairing.maxNeighbors <= 0;
+}
+
+///<summary>True if two <see cref="YellowBoundingBox"/>es are close enough to be read as a pair, ignoring <see cref="BarCodePairingConfig.maxNeighbors"/>.</summary>
+BAR_CODE_FORCEINLINE bool _is_pair_within_distance(BarCodePairingConfig pairing, YellowBoundingBox a, YellowBoundingBox b)
+{
+	return pairing.maxDistance <= 0 || _get_box_distance_squared(a, b) <= (int64_t)pairing.maxDistance * pairing.maxDistance;
+}
+
+///<summary>Prepares a <see cref="YellowBoxIndex"/> for reading the pairs of a set of <see cref="YellowBoundingBox"/>es.</summary>
+///<returns>True if the pairs should be read with <see cref="_find_pair_candidates"/>; false if every pair should be considered (and checked
+///with <see cref="_is_pair_within_distance"/>), which happens when the pairing is unlimited, there is no index, or the index could not grow.</returns>
+static bool _prepare_pair_index(YellowBoxIndex* index, const YellowBoundingBox* boxes, size_t boxCount, BarCodePairingConfig pairing)
+{
+	if (_is_pairing_unlimited(pairing) || index == NULL)
+		return false;
+	return build_yellow_box_index(index, boxes, boxCount, pairing);
+}
+
+///<summary>Makes sure that a buffer can hold at least <paramref name="count"/> values, keeping its content.</summary>
+///<returns>False if the buffer could not grow, in which case it is left unchanged.</returns>
+static bool _reserve_buffer(void** buffer, size_t* capacity, size_t count, size_t valueSize)
+{
+	if (count <= *capacity)
+		return true;
+	void* grown = realloc(*buffer, count * valueSize);
+	if (grown == NULL)
+		return false;
+	*buffer = grown;
+	*capacity = count;
+	return true;
+}
+
+///<summary>Stores the <see cref="BarCodeAppearance"/>s of a set of colorful lines as a structure of arrays, with one block of rows per section count.</summary>
+///<remarks>Each row holds one value per line: the geometry has one row per field, and each section count 'n' has 3 * n rows of colors (see
+///<see cref="get_bar_code_weights"/>) and 'n' rows of pixel counts. Unlike an array of <see cref="BarCodeAppearance"/>s, which always reserves
+///<see cref="BAR_CODE_MAX_COLOR_COUNT"/> sections, only the sections that exist are stored, and the rows can be scored by the vector kernels
+///without being transposed first. Fill it with <see cref="find_bar_code_appearances_in_pool"/>, and read an appearance back with
+///<see cref="get_pool_appearance"/>. The buffers grow as needed and are kept for later calls.</remarks>
+typedef struct BarCodeAppearancePool
+{
+	///<summary>The number of lines that are stored.</summary>
+	size_t count;
+
+	///<summary>The number of lines that fit in each row.</summary>
+	size_t rowCapacity;
+
+	///<summary>The section count of each block.</summary>
+	int sectionCounts[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The number of blocks.</summary>
+	int sectionCountCount;
+
+	///<summary>The first section of each block, counting the sections of all blocks before it. Block 'k' starts at row 3 * sectionOffsets[k]
+	///of <see cref="colors"/> and at row sectionOffsets[k] of <see cref="pixelCounts"/>.</summary>
+	size_t sectionOffsets[BAR_CODE_MAX_COLOR_COUNT];
+
+	///<summary>The total number of sections of all blocks.</summary>
+	size_t sectionTotal;
+
+	///<summary>The <see cref="BarCodeAppearance._firstBox"/> of each line.</summary>
+	YellowBoundingBox* firstBoxes;
+
+	///<summary>The <see cref="BarCodeAppearance._secondBox"/> of each line.</summary>
+	YellowBoundingBox* secondBoxes;
+
+	///<summary>The <see cref="BarCodeAppearance.colorStartX"/>, <see cref="BarCodeAppearance.colorStartY"/>, <see cref="BarCodeAppearance.colorEndX"/> and
+	///<see cref="BarCodeAppearance.colorEndY"/> of each line, in four rows.</summary>
+	int* endpoints;
+
+	///<summary>The length of each line, as measured by <see cref="_get_distance"/>.</summary>
+	int* lineLengths;
+
+	///<summary>The rows of average colors.</summary>
+	float* colors;
+
+	///<summary>The rows of pixel counts.</summary>
+	int* pixelCounts;
+
+	///<summary>The number of values that fit in <see cref="colors"/>.</summary>
+	size_t colorCapacity;
+
+	///<summary>The number of values that fit in <see cref="pixelCounts"/>.</summary>
+	size_t pixelCountCapacity;
+
+	///<summary>Scratch space for the score of each line, used by the thread that filled the pool (see <see cref="find_appearances_of_bar_code_in_pool"/>).</summary>
+	float* scores;
+
+	///<summary>The number of values that fit in <see cref="scores"/>.</summary>
+	size_t scoreCapacity;
+} BarCodeAppearancePool;
+
+///<summary>Frees the buffers of a <see cref="BarCodeAppearancePool"/>, leaving it empty.</summary>
+static void free_bar_code_appearance_pool(BarCodeAppearancePool* pool)
+{
+	free(pool->firstBoxes);
+	free(pool->secondBoxes);
+	free(pool->endpoints);
+	free(pool->lineLengths);
+	free(pool->colors);
+	free(pool->pixelCounts);
+	free(pool->scores);
+	memset(pool, 0, sizeof(BarCodeAppearancePool));
+}
+
+///<summary>Finds the block of a <see cref="BarCodeAppearancePool"/> that holds a section count.</summary>
+///<returns>The index of the block, or -1 if the pool does not hold <paramref name="sectionCount"/>.</returns>
+BAR_CODE_FORCEINLINE int _get_pool_block(const BarCodeAppearancePool* pool, size_t sectionCount)
+{
+	for (int k = 0; k < pool->sectionCountCount; k++)
+	{
+		if ((size_t)pool->sectionCounts[k] == sectionCount)
+			return k;
+	}
+	return -1;
+}
+
+///<summary>Gets the first row of colors of a block of a <see cref="BarCodeAppearancePool"/>.</summary>
+BAR_CODE_FORCEINLINE const float* _get_pool_colors(const BarCodeAppearancePool* pool, int block)
+{
+	return pool->colors + (pool->sectionOffsets[block] * 3 * pool->rowCapacity);
+}
+
+///<summary>Empties a <see cref="BarCodeAppearancePool"/> and sets the section counts of its blocks.</summary>
+///<returns>False if the rows of the new blocks could not be allocated, in which case the pool has no rows.</returns>
+static bool _reset_bar_code_appearance_pool(BarCodeAppearancePool* pool, const int* sectionCounts, int sectionCountCount)
+{
+	pool->count = 0;
+	pool->sectionCountCount = sectionCountCount;
+	pool->sectionTotal = 0;
+	for (int k = 0; k < sectionCountCount; k++)
+	{
+		pool->sectionCounts[k] = sectionCounts[k];
+		pool->sectionOffsets[k] = pool->sectionTotal;
+		pool->sectionTotal += (size_t)sectionCounts[k];
+	}
+
+	//The old values are not needed, so the rows of the blocks can simply be made to fit
+	if (!_reserve_buffer((void**)&pool->colors, &pool->colorCapacity, pool->sectionTotal * 3 * pool->rowCapacity, sizeof(float)) ||
+		!_reserve_buffer((void**)&pool->pixelCounts, &pool->pixelCountCapacity, pool->sectionTotal * pool->rowCapacity, sizeof(int)))
+	{
+		pool->rowCapacity = 0;
+		return false;
+	}
+	return true;
+}
+
+///<summary>Copies the first <paramref name="count"/> values of each row of a buffer to rows of a different length.</summary>
+static void _copy_pool_rows(void* dst, const void* src, size_t rowCount, size_t srcRowCapacity, size_t dstRowCapacity, size_t count, size_t valueSize)
+{
+	for (size_t row = 0; row < rowCount; row++)
+		memcpy((uint8_t*)dst + (row * dstRowCapacity * valueSize), (const uint8_t*)src + (row * srcRowCapacity * valueSize), count * valueSize);
+}
+
+///<summary>Makes sure that the rows of a <see cref="BarCodeAppearancePool"/> can hold at least <paramref name="count"/> lines, keeping its content.</summary>
+///<param name="maxCount">The most lines that the pool will need to hold, which limits how far the rows grow ahead.</param>
+///<returns>False if the pool could not grow, in which case its content is left unchanged.</returns>
+static bool _reserve_pool_rows(BarCodeAppearancePool* pool, size_t count, size_t maxCount)
+{
+	if (count <= pool->rowCapacity)
+		return true;
+
+	size_t rowCapacity = pool->rowCapacity < 64 ? 64 : pool->rowCapacity * 2;
+	if (rowCapacity > maxCount)
+		rowCapacity = maxCount;
+	if (rowCapacity < count)
+		rowCapacity = count;
+
+	//The single-row buffers can simply grow, since growing them early does no harm
+	size_t firstCapacity = pool->rowCapacity, secondCapacity = pool->rowCapacity, lengthCapacity = pool->rowCapacity;
+	if (!_reserve_buffer((void**)&pool->firstBoxes, &firstCapacity, rowCapacity, sizeof(YellowBoundingBox)) ||
+		!_reserve_buffer((void**)&pool->secondBoxes, &secondCapacity, rowCapacity, sizeof(YellowBoundingBox)) ||
+		!_reserve_buffer((void**)&pool->lineLengths, &lengthCapacity, rowCapacity, sizeof(int)))
+		return false;
+
+	//The other buffers hold several rows, which have to be moved apart, so all of them are allocated before any is replaced
+	int* endpoints = (int*)malloc(4 * rowCapacity * sizeof(int));
+	float* colors = (float*)malloc(pool->sectionTotal * 3 * rowCapacity * sizeof(float));
+	int* pixelCounts = (int*)malloc(pool->sectionTotal * rowCapacity * sizeof(int));
+	if (endpoints == NULL || colors == NULL || pixelCounts == NULL)
+	{
+		free(endpoints);
+		free(colors);
+		free(pixelCounts);
+		return false;
+	}
+
+	if (pool->count != 0)
+	{
+		_copy_pool_rows(endpoints, pool->endpoints, 4, pool->rowCapacity, rowCapacity, pool->count, sizeof(int));
+		_copy_pool_rows(colors, pool->colors, pool->sectionTotal * 3, pool->rowCapacity, rowCapacity, pool->count, sizeof(float));
+		_copy_pool_rows(pixelCounts, pool->pixelCounts, pool->sectionTotal, pool->rowCapacity, rowCapacity, pool->count, sizeof(int));
+	}
+	free(pool->endpoints);
+	free(pool->colors);
+	free(pool->pixelCounts);
+	pool->endpoints = endpoints;
+	pool->colors = colors;
+	pool->pixelCounts = pixelCounts;
+	pool->colorCapacity = pool->sectionTotal * 3 * rowCapacity;
+	pool->pixelCountCapacity = pool->sectionTotal * rowCapacity;
+	pool->rowCapacity = rowCapacity;
+	return true;
+}
+
+///<summary>Adds a line to a <see cref="BarCodeAppearancePool"/>.</summary>
+///<param name="appearances">The line's <see cref="BarCodeAppearance"/>s, one for each block of the pool (in the same order).</param>
+///<param name="maxCount">The most lines that the pool will need to hold.</param>
+///<returns>False if the pool could not grow, in which case the line was not added.</returns>
+static bool _add_pool_appearances(BarCodeAppearancePool* pool, const BarCodeAppearance* appearances, size_t maxCount)
+{
+	if (!_reserve_pool_rows(pool, pool->count + 1, maxCount))
+		return false;
+
+	size_t i = pool->count++;
+	size_t rowCapacity = pool->rowCapacity;
+	const BarCodeAppearance* first = &appearances[0];
+	pool->firstBoxes[i] = first->_firstBox;
+	pool->secondBoxes[i] = first->_secondBox;
+	pool->endpoints[i] = first->colorStartX;
+	pool->endpoints[rowCapacity + i] = first->colorStartY;
+	pool->endpoints[(rowCapacity * 2) + i] = first->colorEndX;
+	pool->endpoints[(rowCapacity * 3) + i] = first->colorEndY;
+	pool->lineLengths[i] = _get_distance(first->colorStartX, first->colorStartY, first->colorEndX, first->colorEndY);
+
+	for (int k = 0; k < pool->sectionCountCount; k++)
+	{
+		int sectionCount = pool->sectionCounts[k];
+		float* reds = pool->colors + (pool->sectionOffsets[k] * 3 * rowCapacity);
+		float* greens = reds + ((size_t)sectionCount * rowCapacity);
+		float* blues = greens + ((size_t)sectionCount * rowCapacity);
+		int* pixelCounts = pool->pixelCounts + (pool->sectionOffsets[k] * rowCapacity);
+		for (int s = 0; s < sectionCount; s++)
+		{
+			reds[((size_t)s * rowCapacity) + i] = appearances[k].redAverage[s];
+			greens[((size_t)s * rowCapacity) + i] = appearances[k].greenAverage[s];
+			blues[((size_t)s * rowCapacity) + i] = appearances[k].blueAverage[s];
+			pixelCounts[((size_t)s * rowCapacity) + i] = appearances[k].pixelCount[s];
+		}
+	}
+	return true;
+}
+
+///<summary>Reads a <see cref="BarCodeAppearance"/> from a <see cref="BarCodeAppearancePool"/>.</summary>
+///<param name="pool">The <see cref="BarCodeAppearancePool"/>.</param>
+///<param name="block">The block of the section count to read, as found by <see cref="_get_pool_block"/>.</param>
+///<param name="index">The index of the line, less than <see cref="BarCodeAppearancePool.count"/>.</param>
+///<param name="appearance">Receives the <see cref="BarCodeAppearance"/>. Its sections beyond the section count are left unset.</param>
+static void get_pool_appearance(const BarCodeAppearancePool* pool, int block, size_t index, BarCodeAppearance* appearance)
+{
+	size_t rowCapacity = pool->rowCapacity;
+	appearance->_firstBox = pool->firstBoxes[index];
+	appearance->_secondBox = pool->secondBoxes[index];
+	appearance->colorStartX = pool->endpoints[index];
+	appearance->colorStartY = pool->endpoints[rowCapacity + index];
+	appearance->colorEndX = pool->endpoints[(rowCapacity * 2) + index];
+	appearance->colorEndY = pool->endpoints[(rowCapacity * 3) + index];
+
+	int sectionCount = pool->sectionCounts[block];
+	const float* reds = _get_pool_colors(pool, block);
+	const float* greens = reds + ((size_t)sectionCount * rowCapacity);
+	const float* blues = greens + ((size_t)sectionCount * rowCapacity);
+	const int* pixelCounts = pool->pixelCounts + (pool->sectionOffsets[block] * rowCapacity);
+	appearance->sectionCount = sectionCount;
+	for (int s = 0; s < sectionCount; s++)
+	{
+		appearance->redAverage[s] = reds[((size_t)s * rowCapacity) + index];
+		appearance->greenAverage[s] = greens[((size_t)s * rowCapacity) + index];
+		appearance->blueAverage[s] = blues[((size_t)s * rowCapacity) + index];
+		appearance->pixelCount[s] = pixelCounts[((size_t)s * rowCapacity) + index];
+	}
+}
+
+///<summary>Reads the pairs of <see cref="YellowBoundingBox"/>es for <see cref="find_bar_code_appearances_for_section_counts"/> and
+///<see cref="find_bar_code_appearances_in_pool"/>, storing the <see cref="BarCodeAppearance"/>s in <paramref name="dst"/> or, if it is NULL, in <paramref name="pool"/>.
+///The lines are added after those that the pool already holds, and <paramref name="maxCount"/> limits the total.</summary>
+///<param name="overflowed">If not NULL, set when a pair had to be skipped because <paramref name="maxCount"/> lines had already been stored.</param>
+///<param name="stats">If not NULL, receives the number of pairs that were read and the number of pixels that were walked.</param>
+///<returns>The number of lines in <paramref name="dst"/>, or the total number of lines in <paramref name="pool"/>.</returns>
+static size_t _find_bar_code_appearances(const BarCodeImage* image, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, const int* sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearance* dst, BarCodeAppearancePool* pool, size_t maxCount, bool* overflowed, BarCodeFindStats* stats)
+{
+	size_t count = pool != NULL ? pool->count : 0;
+
+	bool indexed = _prepare_pair_index(index, yellowBoxes, yellowBoxCount, pairing) && _reserve_index_buffer(&index->candidates, &index->candidateCapacity, yellowBoxCount);
+	for (size_t i = 0; i < yellowBoxCount; i++)
+	{
+		size_t partnerCount = indexed ? _find_pair_candidates(index, yellowBoxes, i, index->candidates) : yellowBoxCount - 1 - i;
+		for (size_t p = 0; p < partnerCount; p++)
+		{
+			size_t j = indexed ? index->candidates[p] : i + 1 + p;
+			if (!indexed && !_is_pair_within_distance(pairing, yellowBoxes[i], yellowBoxes[j]))
+				continue;
+
+			if (count == maxCount)
+			{
+				if (overflowed != NULL)
+					*overflowed = true;
+				return count;
+			}
+
+			BarCodeAppearance appearances[BAR_CODE_MAX_COLOR_COUNT];
+			bool found = _try_read_bar_code_appearances_between(image, yellowCfg, yellowBoxes[i], yellowBoxes[j], sectionCounts, sectionCountCount, appearances);
+
+#if defined(BAR_CODE_STATS)
+			if (stats != NULL)
+			{
+				//Both walks step once per pixel along the major axis of their line, and the endpoints are always walked from one box center to the other
+				int centerX1, centerY1, centerX2, centerY2;
+				_get_box_center(yellowBoxes[i], &centerX1, &centerY1);
+				_get_box_center(yellowBoxes[j], &centerX2, &centerY2);
+				int dx = abs(centerX2 - centerX1), dy = abs(centerY2 - centerY1);
+				stats->counters[BAR_CODE_FIND_COUNTER_PAIRS]++;
+				stats->counters[BAR_CODE_FIND_COUNTER_ENDPOINT_PIXELS] += (uint64_t)(dx > dy ? dx : dy) + 1;
+				if (found)
+				{
+					dx = abs(appearances[0].colorEndX - appearances[0].colorStartX);
+					dy = abs(appearances[0].colorEndY - appearances[0].colorStartY);
+					stats->counters[BAR_CODE_FIND_COUNTER_READ_PIXELS] += (uint64_t)(dx > dy ? dx : dy) + 1;
+				}
+			}
+#else
+			(void)stats;
+#endif
+			if (!found)
+				continue;
+
+			if (pool != NULL)
+			{
+				if (!_add_pool_appearances(pool, appearances, maxCount))
+					return count;
+			}
+			else
+			{
+				for (int k = 0; k < sectionCountCount; k++)
+					dst[((size_t)k * maxCount) + count] = appearances[k];
+			}
+			count++;
 		}
 	}
 
-	for (int i = 0; i < sectionCount; i++)
-	{
-		//Up to here, the 'average' values have actually been sums. Now divide to make them average.
-		ret.redAverage[i] /= ret.pixelCount[i];
-		ret.greenAverage[i] /= ret.pixelCount[i];
-		ret.blueAverage[i] /= ret.pixelCount[i];
-	}
+	return count;
+}
 
-	return ret;
+///<summary>Finds all <see cref="BarCodeAppearance"/>s in an image like <see cref="find_bar_code_appearances"/>, but for several section counts at once.
+///The yellow boxes are paired, and each colorful line is found and read, only once; its pixels are then divided into sections for each section count.</summary>
+///<param name="sectionCounts">The numbers of sections (value colors) to divide each colorful line into.</param>
+///<param name="sectionCountCount">The number of values in <paramref name="sectionCounts"/>, from 1 to <see cref="BAR_CODE_MAX_COLOR_COUNT"/>.</param>
+///<param name="dst">The destination <see cref="BarCodeAppearance"/> buffer, which holds one block of <paramref name="maxCount"/> values per section count.
+///The <see cref="BarCodeAppearance"/>s with sectionCounts[k] sections are stored from dst + k * <paramref name="maxCount"/>.</param>
+///<param name="maxCount">The maximum number of <see cref="BarCodeAppearance"/>s to find for each section count.</param>
+///<returns>The number of <see cref="BarCodeAppearance"/>s that have been found for each section count. This is the same for every section count,
+///since the sections do not affect which lines are read.</returns>
+///<remarks>The other parameters are the same as those of <see cref="find_bar_code_appearances"/>, and each block holds the same
+///<see cref="BarCodeAppearance"/>s (in the same order) that <see cref="find_bar_code_appearances"/> would find for its section count.</remarks>
+size_t find_bar_code_appearances_for_section_counts(const uint8_t * rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox * yellowBoxes, size_t yellowBoxCount, const int * sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex * index, BarCodeAppearance * dst, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	return _find_bar_code_appearances(&image, yellowCfg, yellowBoxes, yellowBoxCount, sectionCounts, sectionCountCount, pairing, index, dst, NULL, maxCount, NULL, NULL);
+}
+
+///<summary>Finds all <see cref="BarCodeAppearance"/>s in an image like <see cref="find_bar_code_appearances_for_section_counts"/>, but stores them in a
+///<see cref="BarCodeAppearancePool"/>, with one block per section count.</summary>
+///<param name="pool">The <see cref="BarCodeAppearancePool"/> that receives the <see cref="BarCodeAppearance"/>s. Its previous content is discarded.</param>
+///<param name="maxCount">The maximum number of lines to store. The pool grows as lines are found, up to this many.</param>
+///<returns>The number of lines that have been stored, which is also <see cref="BarCodeAppearancePool.count"/>.</returns>
+///<remarks>The other parameters are the same as those of <see cref="find_bar_code_appearances_for_section_counts"/>, and the pool holds the same
+///<see cref="BarCodeAppearance"/>s in the same order. If the pool cannot grow, the lines that were found so far are kept.</remarks>
+size_t find_bar_code_appearances_in_pool(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, const int* sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearancePool* pool, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	if (!_reset_bar_code_appearance_pool(pool, sectionCounts, sectionCountCount))
+		return 0;
+	return _find_bar_code_appearances(&image, yellowCfg, yellowBoxes, yellowBoxCount, sectionCounts, sectionCountCount, pairing, index, NULL, pool, maxCount, NULL, NULL);
 }
 
 ///<summary>Finds all <see cref="BarCodeAppearance"/>s in an image using already-defined <see cref="YellowBoundingBox"/> regions.</summary>
@@ -855,40 +2183,91 @@ BarCodeAppearance _read_bar_code_appearance(const uint8_t * rgba8, int width, in
 ///These are essentially <see cref="YellowBoundingBox"/>es surrounding all yellow regions in the image.</param>
 ///<param name="yellowBoxCount">The number of <see cref="YellowBoundingBox"/>es in <paramref name="yellowBoxes"/>.</param>
 ///<param name="sectionCount">The number of sections (value colors) in each bar code.</param>
+///<param name="pairing">Limits which pairs of <see cref="YellowBoundingBox"/>es are read. Zero-initialize it to read every pair.</param>
+///<param name="index">A <see cref="YellowBoxIndex"/> that is used to find the pairs allowed by <paramref name="pairing"/>, or NULL to measure
+///the distance between every pair instead (in which case <see cref="BarCodePairingConfig.maxNeighbors"/> is ignored).</param>
 ///<param name="dst">The destination <see cref="BarCodeAppearance"/> buffer.</param>
 ///<param name="maxCount">The maximum number of <see cref="BarCodeAppearance"/>s to find.</param>
 ///<returns>The number of <see cref="BarCodeAppearance"/>s that have been found.</returns>
-size_t find_bar_code_appearances(const uint8_t * rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox * yellowBoxes, size_t yellowBoxCount, int sectionCount, BarCodeAppearance * dst, size_t maxCount)
+///<remarks>Pairs are always read in order of the first box's index, then the second box's index, so the limits only remove
+///<see cref="BarCodeAppearance"/>s from the result; they never reorder it.</remarks>
+size_t find_bar_code_appearances(const uint8_t * rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox * yellowBoxes, size_t yellowBoxCount, int sectionCount, BarCodePairingConfig pairing, YellowBoxIndex * index, BarCodeAppearance * dst, size_t maxCount)
 {
-	size_t count = 0;
+	return find_bar_code_appearances_for_section_counts(rgba8, width, height, yellowCfg, yellowBoxes, yellowBoxCount, &sectionCount, 1, pairing, index, dst, maxCount);
+}
 
-	for (size_t i = 0; i < yellowBoxCount; i++)
+///<summary>True if a match ranks below another: it has a lower score, or the same score and a later <see cref="BarCodeAppearance"/>.</summary>
+BAR_CODE_FORCEINLINE bool _ranks_below(float score, size_t appearance, float otherScore, size_t otherAppearance)
+{
+	return score < otherScore || (score == otherScore && appearance > otherAppearance);
+}
+
+///<summary>Restores the heap of <see cref="find_appearances_of_bar_code"/> below <paramref name="position"/>, whose lowest-ranked match is at the root.</summary>
+static void _sift_down_match(size_t* results, float* scores, size_t count, size_t position)
+{
+	size_t appearance = results[position];
+	float score = scores[position];
+	for (;;)
+	{
+		size_t child = (position * 2) + 1;
+		if (child >= count)
+			break;
+		if (child + 1 < count && _ranks_below(scores[child + 1], results[child + 1], scores[child], results[child]))
+			child++;
+		if (!_ranks_below(scores[child], results[child], score, appearance))
+			break;
+		results[position] = results[child];
+		scores[position] = scores[child];
+		position = child;
+	}
+	results[position] = appearance;
+	scores[position] = score;
+}
+
+///<summary>Adds a match to the heap of <see cref="find_appearances_of_bar_code"/>, or replaces the worst match if the heap is full and the new
+///match ranks above it. Matches must be offered in the order of their <see cref="BarCodeAppearance"/>s.</summary>
+///<param name="count">The number of matches in the heap, which is updated.</param>
+BAR_CODE_FORCEINLINE void _offer_match(size_t* results, float* resultScores, size_t* count, size_t maxResultCount, size_t appearance, float matchScore)
+{
+	if (*count < maxResultCount)
 	{
-		for (size_t j = i + 1; j < yellowBoxCount; j++)
+		//Add the appearance to the heap, moving it up past every match that ranks below it
+		size_t position = (*count)++;
+		while (position > 0)
 		{
-			YellowBoundingBox start = yellowBoxes[i];
-			int startX = (start.left + start.right) / 2;
-			int startY = (start.top + start.bottom) / 2;
-
-			YellowBoundingBox end = yellowBoxes[j];
-			int endX = (end.left + end.right) / 2;
-			int endY = (end.top + end.bottom) / 2;
-			
-			//'start' and 'end' points are inside the yellow bar regions. We want a line that defines the colorful region between the yellow bars.
-			//So find the colorful line's endpoints
-			_find_colorful_line_endpoints(rgba8, width, height, yellowCfg, &startX, &startY, &endX, &endY);
-
-			if (startX == endX && startY == endY)
-				continue;//Cannot scan a line with no length, so skip it
-
-			if (count < maxCount)
-				dst[count++] = _read_bar_code_appearance(rgba8, width, height, sectionCount, start, end, startX, startY, endX, endY);
-			else
-				return count;
+			size_t parent = (position - 1) / 2;
+			if (!_ranks_below(matchScore, appearance, resultScores[parent], results[parent]))
+				break;
+			results[position] = results[parent];
+			resultScores[position] = resultScores[parent];
+			position = parent;
 		}
+		results[position] = appearance;
+		resultScores[position] = matchScore;
 	}
+	else if (matchScore > resultScores[0])
+	{
+		//Replace the worst match so far. Appearances are visited in order, so one with an equal score ranks below it.
+		results[0] = appearance;
+		resultScores[0] = matchScore;
+		_sift_down_match(results, resultScores, *count, 0);
+	}
+}
 
-	return count;
+///<summary>Sorts the heap of <see cref="find_appearances_of_bar_code"/> by descending rank.</summary>
+static void _sort_matches(size_t* results, float* resultScores, size_t count)
+{
+	//Repeatedly move the worst remaining match to the end
+	for (size_t remaining = count; remaining > 1; remaining--)
+	{
+		size_t worst = results[0];
+		float worstScore = resultScores[0];
+		results[0] = results[remaining - 1];
+		resultScores[0] = resultScores[remaining - 1];
+		results[remaining - 1] = worst;
+		resultScores[remaining - 1] = worstScore;
+		_sift_down_match(results, resultScores, remaining - 1, 0);
+	}
 }
 
 ///<summary>Searches through a set of <see cref="BarCodeAppearance"/>s to find those that match a specific <see cref="BarCode"/>.</summary>
@@ -899,13 +2278,19 @@ size_t find_bar_code_appearances(const uint8_t * rgba8, int width, int height, Y
 ///as determined by <see cref="quantify_bar_code_appearance_match(const BarCode*, const BarCodeAppearance*)"/>.</param>
 ///<param name="appearances">All <see cref="BarCodeAppearance"/>s.</param>
 ///<param name="appearanceCount">The number of <paramref name="appearances"/>.</param>
-///<param name="results">Will contain pointers to the <see cref="BarCodeAppearance"/>s that matched the <paramref name="barCode"/>.</param>
+///<param name="results">Will contain the indices (in <paramref name="appearances"/>) of the <see cref="BarCodeAppearance"/>s that matched the <paramref name="barCode"/>.</param>
 ///<param name="resultScores">Will contain the 'match' score of each <see cref="BarCodeAppearance"/> in <paramref name="results"/>, as determined by
 ///the <see cref="quantify_bar_code_appearance_match(const BarCode*, const BarCodeAppearance*)"/> function.</param>
 ///<param name="maxResultCount">The maximum number of values that can be stored in <paramref name="results"/> and <paramref name="resultScores"/>.</param>
 ///<returns>The number of <see cref="BarCodeAppearances"/> that matched the <paramref name="barCode"/>.</returns>
-size_t find_appearances_of_bar_code(BarCode barCode, int minLineDistance, float minMatchScore, const BarCodeAppearance * appearances, size_t appearanceCount, const BarCodeAppearance * *results, float* resultScores, size_t maxResultCount)
+///<remarks>The results are the <paramref name="maxResultCount"/> best matches, sorted by descending score (and, for equal scores, in the order of
+///<paramref name="appearances"/>). While searching, the results are kept in a heap whose root is the worst match so far, so each appearance costs
+///O(log <paramref name="maxResultCount"/>) at most. An appearance whose score is not a number (because one of its sections has no pixels) never matches.</remarks>
+size_t find_appearances_of_bar_code(BarCode barCode, int minLineDistance, float minMatchScore, const BarCodeAppearance * appearances, size_t appearanceCount, size_t * results, float* resultScores, size_t maxResultCount)
 {
+	if (maxResultCount == 0)
+		return 0;
+
 	size_t count = 0;
 	for (size_t i = 0; i < appearanceCount; i++)
 	{
@@ -914,59 +2299,129 @@ size_t find_appearances_of_bar_code(BarCode barCode, int minLineDistance, float
 			continue;//This appearance's line is considered too small
 
 		float matchScore = quantify_bar_code_appearance_match(&barCode, &appearances[i]);
-		if (matchScore < minMatchScore)
+		if (!(matchScore >= minMatchScore))
 			continue;//This appearance doesn't meet the minimum match score
 
-		//Find where to insert the appearance in the sorted array
-		size_t insertPosition;
-		bool foundInsertPosition = false;
-		for (size_t j = 0; j < count; j++)
+		_offer_match(results, resultScores, &count, maxResultCount, i, matchScore);
+	}
+
+	_sort_matches(results, resultScores, count);
+	return count;
+}
+
+///<summary>A <see cref="BarCode"/>, encoded as the terms that a <see cref="ScoreAppearancesFunction"/> adds up to score a
+///<see cref="BarCodeAppearance"/> in the layout of a <see cref="BarCodeAppearancePool"/> block.</summary>
+typedef struct BarCodeWeights
+{
+	///<summary>The number of sections, which is the <see cref="BarCode.colorCount"/>.</summary>
+	int sectionCount;
+
+	///<summary>The number of terms, which is three per section.</summary>
+	int termCount;
+
+	///<summary>The plane of each term when the line is read forward.</summary>
+	uint16_t forwardPlanes[BAR_CODE_MAX_COLOR_COUNT * 3];
+
+	///<summary>The plane of each term when the line is read in reverse.</summary>
+	uint16_t reversePlanes[BAR_CODE_MAX_COLOR_COUNT * 3];
+
+	///<summary>The weight of each term: +1.0f for the expected color and -1.0f for the other two.</summary>
+	float weights[BAR_CODE_MAX_COLOR_COUNT * 3];
+} BarCodeWeights;
+
+///<summary>Encodes a <see cref="BarCode"/> as a <see cref="BarCodeWeights"/>.</summary>
+///<param name="code">The <see cref="BarCode"/>.</param>
+///<param name="weights">Receives the encoded <see cref="BarCode"/>.</param>
+///<remarks>The terms are in the same order as the additions and subtractions of <see cref="_quantify_bar_code_appearance_match"/>, which is what
+///makes the scores identical. Plane 'p' of a section count 'n' holds channel p / n (red, green, then blue) of section p % n.</remarks>
+static void get_bar_code_weights(const BarCode* code, BarCodeWeights* weights)
+{
+	int sectionCount = (int)code->colorCount;
+	weights->sectionCount = sectionCount;
+	weights->termCount = sectionCount * 3;
+	for (int codeI = 0; codeI < sectionCount; codeI++)
+	{
+		//The channel that is added, then the two that are subtracted
+		int channels[3];
+		switch (code->colors[codeI])
 		{
-			if (matchScore > resultScores[j])
-			{
-				foundInsertPosition = true;
-				insertPosition = j;
-				break;
-			}
+		case BAR_CODE_RED:
+			channels[0] = 0; channels[1] = 1; channels[2] = 2;
+			break;
+
+		case BAR_CODE_GREEN:
+			channels[0] = 1; channels[1] = 0; channels[2] = 2;
+			break;
+
+		case BAR_CODE_BLUE:
+			channels[0] = 2; channels[1] = 0; channels[2] = 1;
+			break;
+
+		default:
+			assert(0 && "Unrecognized BarCodeColor value");
+			channels[0] = 0; channels[1] = 1; channels[2] = 2;
+			break;
 		}
 
-		if (!foundInsertPosition)
+		for (int i = 0; i < 3; i++)
 		{
-			if (count < maxResultCount)
-			{
-				//This appearance does not have a higher 'match' score than any others so far, so we will put this one at the end
-				insertPosition = count;//We will increment 'count' later
-			}
-			else
-			{
-				//We can't store a record of this appearance since the buffer is full.
-				//But since 'foundInsertPosition' is false, we know that this appearance had a low score, 
-				//so let's just ignore it (and continue searching for more appearances which may have a higher score)
-				continue;
-			}
+			int term = (codeI * 3) + i;
+			weights->forwardPlanes[term] = (uint16_t)((channels[i] * sectionCount) + codeI);
+			weights->reversePlanes[term] = (uint16_t)((channels[i] * sectionCount) + (sectionCount - 1 - codeI));
+			weights->weights[term] = i == 0 ? 1.0f : -1.0f;
 		}
+	}
+}
 
-		if (insertPosition < maxResultCount && count < maxResultCount)
-		{
-			if (count > 0)
-			{
-				//First move every value at and after 'insertPosition' down by one
-				for (size_t j = count; j > insertPosition; j--)
-				{
-					results[j] = results[j - 1];
-					resultScores[j] = resultScores[j - 1];
-				}
-			}
+///<summary>Searches for the lines of a <see cref="BarCodeAppearancePool"/> that match a <see cref="BarCode"/> like <see cref="find_appearances_of_bar_code_in_pool"/>,
+///and also counts every line that matched, including those that did not fit in <paramref name="results"/>.</summary>
+///<param name="matchCount">If not NULL, receives the number of lines that matched. The lines are still scored when <paramref name="maxResultCount"/> is 0.</param>
+static size_t _find_appearances_of_bar_code_in_pool(BarCode barCode, int minLineDistance, float minMatchScore, const BarCodeAppearancePool* pool, float* scores, size_t* results, float* resultScores, size_t maxResultCount, size_t* matchCount)
+{
+	if (matchCount != NULL)
+		*matchCount = 0;
 
-			results[insertPosition] = &appearances[i];
-			resultScores[insertPosition] = matchScore;
-			count++;
-		}
+	int block = _get_pool_block(pool, barCode.colorCount);
+	if (block < 0)
+		return 0;
+
+	BarCodeWeights weights;
+	get_bar_code_weights(&barCode, &weights);
+	get_match_kernels()->scoreAppearances(_get_pool_colors(pool, block), pool->rowCapacity, pool->count, weights.forwardPlanes, weights.reversePlanes, weights.weights, weights.termCount, weights.sectionCount, scores);
+
+	size_t count = 0, total = 0;
+	for (size_t i = 0; i < pool->count; i++)
+	{
+		if (pool->lineLengths[i] < minLineDistance)
+			continue;//This appearance's line is considered too small
+		if (!(scores[i] >= minMatchScore))
+			continue;//This appearance doesn't meet the minimum match score
+		total++;
+		if (maxResultCount > 0)
+			_offer_match(results, resultScores, &count, maxResultCount, i, scores[i]);
 	}
 
+	if (matchCount != NULL)
+		*matchCount = total;
+	_sort_matches(results, resultScores, count);
 	return count;
 }
 
+///<summary>Searches for the lines of a <see cref="BarCodeAppearancePool"/> that match a specific <see cref="BarCode"/> like <see cref="find_appearances_of_bar_code"/>,
+///but scores all of them at once with the vector kernels (see <see cref="get_match_kernels"/>).</summary>
+///<param name="pool">The <see cref="BarCodeAppearancePool"/>, which must have a block for the <paramref name="barCode"/>'s <see cref="BarCode.colorCount"/>
+///(otherwise nothing matches).</param>
+///<param name="scores">Scratch space for the score of each line. Must hold <see cref="BarCodeAppearancePool.count"/> values.</param>
+///<param name="results">Will contain the indices of the lines that matched the <paramref name="barCode"/>.</param>
+///<remarks>The other parameters and the results are the same as those of <see cref="find_appearances_of_bar_code"/>. The <paramref name="barCode"/> is
+///encoded once per call, and the line lengths were measured once when the lines were added to the pool.</remarks>
+size_t find_appearances_of_bar_code_in_pool(BarCode barCode, int minLineDistance, float minMatchScore, const BarCodeAppearancePool* pool, float* scores, size_t* results, float* resultScores, size_t maxResultCount)
+{
+	if (maxResultCount == 0)
+		return 0;
+	return _find_appearances_of_bar_code_in_pool(barCode, minLineDistance, minMatchScore, pool, scores, results, resultScores, maxResultCount, NULL);
+}
+
 ///<summary>Structure that stores a 'BarCode find request' and all of its <see cref="BarCodeAppearance"/>s.</summary>
 ///<remarks>This structure is used for the <see cref="find_appearances_of_bar_code_interests_in_bitmap"/> function to store the
 ///input <see cref="BarCode"/> 'request' as well as all of the <see cref="BarCodeAppearance"/>s that were found to match
@@ -994,6 +2449,16 @@ typedef struct BarCodeFindContext
 	///<summary>The number of <see cref="BarCodeAppearance"/>s that are currently stored in <see cref="appearanceBuffer"/>.</summary>
 	size_t appearanceCount;
 
+	///<summary>Optional buffer of line indices in <see cref="appearancePool"/>, with the same capacity as <see cref="appearanceBuffer"/>. If not NULL,
+	///the matching <see cref="BarCodeAppearance"/>s are stored here (in the same order) instead of being copied to <see cref="appearanceBuffer"/>,
+	///which may then be NULL. Read them with <see cref="get_pool_appearance"/>.</summary>
+	size_t* appearanceIndices;
+
+	///<summary>Set by <see cref="find_appearances_of_bar_code_interests_in_bitmap"/> to the <see cref="BarCodeAppearance"/>s that
+	///<see cref="appearanceIndices"/> refers to. They are stored in the <see cref="BarCodeFindTemporaryMemory"/> that was used, so they are
+	///only valid until it is used again or freed.</summary>
+	const BarCodeAppearancePool* appearancePool;
+
 	///<summary>The <see cref="BarCode"/> to find.</summary>
 	BarCode barCode;
 
@@ -1009,16 +2474,48 @@ typedef struct BarCodeFindContext
 
 } BarCodeFindContext;
 
+///<summary>The stages of <see cref="find_appearances_of_bar_code_interests_in_bitmap"/> whose buffers are provided by a <see cref="BarCodeFindTemporaryMemory"/>.</summary>
+typedef enum BarCodeFindStage
+{
+	///<summary>The <see cref="YellowScanLine"/>s of the most recent rows, stored in <see cref="BarCodeFindTemporaryMemory.scanLines"/>.</summary>
+	BAR_CODE_FIND_STAGE_SCAN_LINES = 0,
+
+	///<summary>The <see cref="YellowBoundingBox"/>es, stored in <see cref="BarCodeFindTemporaryMemory.yellowBoxes"/> and <see cref="BarCodeFindTemporaryMemory.temporaryIndexBuffer"/>.</summary>
+	BAR_CODE_FIND_STAGE_YELLOW_BOXES = 1,
+
+	///<summary>The colorful lines, stored in <see cref="BarCodeFindTemporaryMemory.appearances"/>.</summary>
+	BAR_CODE_FIND_STAGE_APPEARANCES = 2,
+
+	///<summary>The best matches of each <see cref="BarCodeFindContext"/>, sorted in <see cref="BarCodeFindTemporaryMemory.appearanceSortBuffer"/>.</summary>
+	BAR_CODE_FIND_STAGE_MATCHES = 3,
+
+	///<summary>The number of stages.</summary>
+	BAR_CODE_FIND_STAGE_COUNT = 4
+} BarCodeFindStage;
+
+///<summary>How much of the buffer of one <see cref="BarCodeFindStage"/> a search needed.</summary>
+typedef struct BarCodeFindStageUsage
+{
+	///<summary>The most values that the stage held at once during the last search. If it overflowed, it needed more than this (usually more than its capacity).</summary>
+	size_t used;
+
+	///<summary>The greatest <see cref="used"/> of every search since the usage was allocated.</summary>
+	size_t highWater;
+
+	///<summary>Set when the stage had to drop values during the last search because its buffer was full, so some <see cref="BarCode"/>s may have gone unnoticed.</summary>
+	bool overflowed;
+} BarCodeFindStageUsage;
+
 ///<summary>Contains temporary memory for use by the <see cref="find_appearances_of_bar_code_interests_in_bitmap"/> function.</summary>
 ///<remarks>This structure can (and should) be shared across repeated calls to <see cref="find_appearances_of_bar_code_interests_in_bitmap"/>.</remarks>
 typedef struct BarCodeFindTemporaryMemory
 {
-	///<summary>Array of <see cref="YellowScanLine"/>s.</summary>
+	///<summary>Array of <see cref="YellowScanLine"/>s. Only the lines of the most recent rows are kept (see <see cref="find_yellow_boxes"/>).</summary>
 	YellowScanLine* scanLines;
 
-	///<summary>The maximum number of <see cref="YellowScanLine"/>s that can be stored in <see cref="scanLines"/>. Generally,
-	///this should be somewhere near the number of horizontal lines in the input bitmap(s). If you provide too few, some
-	///<see cref="BarCode"/>s may go unnoticed.</summary>
+	///<summary>The maximum number of <see cref="YellowScanLine"/>s that can be stored in <see cref="scanLines"/>. This no longer limits the
+	///number of lines in a bitmap; it only needs to hold the lines of maxYellowSpacing + 2 consecutive rows, so the old default (somewhere near
+	///the number of horizontal lines in the input bitmap) is plenty. If you provide too few, some <see cref="BarCode"/>s may go unnoticed.</summary>
 	size_t scanLineCapacity;
 
 	///<summary>Array of <see cref="YellowBoundingBox"/>es.</summary>
@@ -1030,36 +2527,441 @@ typedef struct BarCodeFindTemporaryMemory
 	///likely be found. If you provide too few, some <see cref="BarCode"/>s may go unnoticed.</summary>
 	size_t yellowBoxCapacity;
 
-	///<summary>Array of indices, used for sorting.</summary>
+	///<summary>Array of indices, used as scratch space for the union-find parents of the <see cref="YellowBoundingBox"/>es.</summary>
 	size_t* temporaryIndexBuffer;
 
-	///<summary>The maximum number of indices that can be stored in <see cref="temporaryIndexBuffer"/>. Generally, this should
-	///be slightly greater than the maximum number of <see cref="BarCodeAppearance"/>s you expect to be found in a single
-	///bitmap, plus some padding for noise. If you provide too few, some <see cref="BarCode"/>s may go unnoticed.</summary>
+	///<summary>The maximum number of indices that can be stored in <see cref="temporaryIndexBuffer"/>. The number of <see cref="YellowBoundingBox"/>es
+	///is limited by both this and <see cref="yellowBoxCapacity"/>, so this should be at least <see cref="yellowBoxCapacity"/>.</summary>
 	size_t temporaryIndexBufferCapacity;
 
-	///<summary>Buffer that will store all <see cref="BarCodeAppearance"/>s that are found in a bitmap.</summary>
-	BarCodeAppearance* appearances;
+	///<summary>The <see cref="BarCodeAppearancePool"/> that will store all <see cref="BarCodeAppearance"/>s that are found in a bitmap, for every
+	///distinct <see cref="BarCode.colorCount"/>. Its buffers grow as needed, up to <see cref="appearanceCapacity"/> lines.</summary>
+	BarCodeAppearancePool* appearances;
 
-	///<summary>The maximum number of <see cref="BarCodeAppearance"/>s that can be stored in <see cref="appearances"/>. Generally,
+	///<summary>The maximum number of colorful lines whose <see cref="BarCodeAppearance"/>s can be stored in <see cref="appearances"/>. Generally,
 	///this should be slightly greater than the maximum number of <see cref="BarCodeAppearance"/>s that you expect to find in a
 	///single bitmap, plus reasonable padding for noise. If you provide too few, some <see cref="BarCode"/>s may go unnoticed.</summary>
 	size_t appearanceCapacity;
 
-	///<summary>Array of pointers, used for sorting. The capacity is defined by <see cref="appearanceSortBufferCapacity"/>.</summary>
-	BarCodeAppearance** appearanceSortBuffer;
+	///<summary>Array of line indices, used for sorting. The capacity is defined by <see cref="appearanceSortBufferCapacity"/>.</summary>
+	size_t* appearanceSortBuffer;
 
 	///<summary>Array of 'match scores', used for sorting. The capacity is defined by <see cref="appearanceSortBufferCapacity"/>.</summary>
 	float* appearanceSortMatchScoreBuffer;
 
-	///<summary>The maximum number of <see cref="BarCodeAppearance"/> <em>pointers</em> that can be stored in <see cref="appearanceSortBuffer"/>.
+	///<summary>The maximum number of <see cref="BarCodeAppearance"/> <em>indices</em> that can be stored in <see cref="appearanceSortBuffer"/>.
 	///This also defines the maximum number of floats that can be stored in <see cref="appearanceSortMatchScoreBuffer"/>. Generally, this should
 	///be slightly greater than the maximum number of <see cref="BarCodeAppearance"/>s you expect to find in a single bitmap, plus some padding
 	///for noise. If you provide too few, some <see cref="BarCode"/>s may go unnoticed.</summary>
 	size_t appearanceSortBufferCapacity;
 
+	///<summary>The <see cref="YellowBoxIndex"/> that is used to find the pairs of <see cref="YellowBoundingBox"/>es allowed by <see cref="pairing"/>.
+	///Its buffers grow as needed. If NULL, the distance between every pair is measured instead, and <see cref="BarCodePairingConfig.maxNeighbors"/> is ignored.</summary>
+	YellowBoxIndex* boxIndex;
+
+	///<summary>Limits which pairs of <see cref="YellowBoundingBox"/>es are read (see <see cref="find_bar_code_appearances"/>). Zero-initialize it to read
+	///every pair.</summary>
+	BarCodePairingConfig pairing;
+
+	///<summary>Optional array of <see cref="BAR_CODE_FIND_STAGE_COUNT"/> <see cref="BarCodeFindStageUsage"/>s, indexed by <see cref="BarCodeFindStage"/>, that
+	///each search fills in. If NULL, the usage is not recorded.</summary>
+	BarCodeFindStageUsage* usage;
+
+	///<summary>The capacity that <see cref="grow_bar_code_find_temporary_memory"/> may grow the buffer of each <see cref="BarCodeFindStage"/> to,
+	///or 0 to keep it at its current size.</summary>
+	size_t maxCapacities[BAR_CODE_FIND_STAGE_COUNT];
+
+	///<summary>The <see cref="BarCodeArena"/> that holds this structure and its buffers, if it was created by <see cref="allocate_bar_code_find_temporary_memory"/>.
+	///NULL if the buffers were allocated separately with malloc.</summary>
+	BarCodeArena* arena;
+
+	///<summary>The <see cref="BarCodeArena"/> that holds the buffers once <see cref="grow_bar_code_find_temporary_memory"/> has grown them (the regions of
+	///<see cref="arena"/> cannot grow), or NULL.</summary>
+	BarCodeArena* growthArena;
+
+	///<summary>Optional <see cref="BarCodeFindStats"/> that <see cref="find_appearances_of_bar_code_interests_in_image"/> fills in. Ignored unless the
+	///library is compiled with BAR_CODE_STATS defined.</summary>
+	BarCodeFindStats* stats;
+
 } BarCodeFindTemporaryMemory;
 
+///<summary>Clears what <paramref name="usage"/> recorded of the previous search (but not the high-water marks), at the start of a new search.</summary>
+static void _begin_bar_code_find_usage(BarCodeFindStageUsage* usage)
+{
+	if (usage == NULL)
+		return;
+
+	for (int i = 0; i < BAR_CODE_FIND_STAGE_COUNT; i++)
+	{
+		usage[i].used = 0;
+		usage[i].overflowed = false;
+	}
+}
+
+///<summary>Records that a <see cref="BarCodeFindStage"/> needed to hold <paramref name="used"/> values at once, and whether it overflowed.</summary>
+BAR_CODE_FORCEINLINE void _record_bar_code_find_usage(BarCodeFindStageUsage* usage, BarCodeFindStage stage, size_t used, bool overflowed)
+{
+	if (usage == NULL)
+		return;
+
+	if (used > usage[stage].used)
+		usage[stage].used = used;
+	if (used > usage[stage].highWater)
+		usage[stage].highWater = used;
+	usage[stage].overflowed = usage[stage].overflowed || overflowed;
+}
+
+///<summary>Records the <see cref="_YellowBoxUsage"/> of <see cref="find_yellow_boxes"/> in the usage of its two stages.</summary>
+static void _record_yellow_box_usage(BarCodeFindStageUsage* usage, const _YellowBoxUsage* boxUsage)
+{
+	_record_bar_code_find_usage(usage, BAR_CODE_FIND_STAGE_SCAN_LINES, boxUsage->lineCount, boxUsage->linesOverflowed);
+	_record_bar_code_find_usage(usage, BAR_CODE_FIND_STAGE_YELLOW_BOXES, boxUsage->boxCount, boxUsage->boxesOverflowed);
+}
+
+///<summary>Gets the capacity of the buffer of a <see cref="BarCodeFindStage"/>.</summary>
+static size_t get_bar_code_find_stage_capacity(const BarCodeFindTemporaryMemory* memory, BarCodeFindStage stage)
+{
+	switch (stage)
+	{
+	case BAR_CODE_FIND_STAGE_SCAN_LINES:
+		return memory->scanLineCapacity;
+
+	case BAR_CODE_FIND_STAGE_YELLOW_BOXES:
+		return memory->yellowBoxCapacity < memory->temporaryIndexBufferCapacity ? memory->yellowBoxCapacity : memory->temporaryIndexBufferCapacity;
+
+	case BAR_CODE_FIND_STAGE_APPEARANCES:
+		return memory->appearanceCapacity;
+
+	case BAR_CODE_FIND_STAGE_MATCHES:
+		return memory->appearanceSortBufferCapacity;
+
+	default:
+		assert(0 && "Unrecognized BarCodeFindStage value");
+		return 0;
+	}
+}
+
+///<summary>Adds the size of a region of <paramref name="count"/> values of <paramref name="valueSize"/> bytes to the size of a <see cref="BarCodeArena"/>.</summary>
+///<returns>False if the size does not fit in a size_t.</returns>
+static bool _add_arena_region(size_t* arenaSize, size_t count, size_t valueSize)
+{
+	if (count > (SIZE_MAX / 2) / valueSize)
+		return false;
+
+	size_t regionSize = get_bar_code_arena_region_size(count * valueSize);
+	if (regionSize > SIZE_MAX / 2 - *arenaSize)
+		return false;
+	*arenaSize += regionSize;
+	return true;
+}
+
+///<summary>Moves the buffers of a <see cref="BarCodeFindTemporaryMemory"/> that lives in a <see cref="BarCodeArena"/> to a new arena, with room for
+///<paramref name="newCapacities"/> (where they are bigger than the current capacities). The old buffers hold nothing that is needed after a search.</summary>
+static bool _move_bar_code_find_buffers(BarCodeFindTemporaryMemory* memory, const size_t* newCapacities)
+{
+	size_t scanLineCapacity = newCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES] > memory->scanLineCapacity ? newCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES] : memory->scanLineCapacity;
+	size_t yellowBoxCapacity = newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] > memory->yellowBoxCapacity ? newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] : memory->yellowBoxCapacity;
+	size_t indexCapacity = newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] > memory->temporaryIndexBufferCapacity ? newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] : memory->temporaryIndexBufferCapacity;
+	size_t sortCapacity = newCapacities[BAR_CODE_FIND_STAGE_MATCHES] > memory->appearanceSortBufferCapacity ? newCapacities[BAR_CODE_FIND_STAGE_MATCHES] : memory->appearanceSortBufferCapacity;
+	if (scanLineCapacity == memory->scanLineCapacity && yellowBoxCapacity == memory->yellowBoxCapacity && indexCapacity == memory->temporaryIndexBufferCapacity && sortCapacity == memory->appearanceSortBufferCapacity)
+		return true;//Nothing that lives in the arena has to grow
+
+	size_t size = 0;
+	if (!_add_arena_region(&size, scanLineCapacity, sizeof(YellowScanLine)) || !_add_arena_region(&size, yellowBoxCapacity, sizeof(YellowBoundingBox)) ||
+		!_add_arena_region(&size, indexCapacity, sizeof(size_t)) || !_add_arena_region(&size, sortCapacity, sizeof(size_t)) || !_add_arena_region(&size, sortCapacity, sizeof(float)))
+		return false;
+
+	BarCodeArena* arena = create_bar_code_arena(size, memory->arena->flags);
+	if (arena == NULL)
+		return false;
+
+	memory->scanLines = (YellowScanLine*)bar_code_arena_alloc(arena, scanLineCapacity * sizeof(YellowScanLine));
+	memory->scanLineCapacity = scanLineCapacity;
+	memory->yellowBoxes = (YellowBoundingBox*)bar_code_arena_alloc(arena, yellowBoxCapacity * sizeof(YellowBoundingBox));
+	memory->yellowBoxCapacity = yellowBoxCapacity;
+	memory->temporaryIndexBuffer = (size_t*)bar_code_arena_alloc(arena, indexCapacity * sizeof(size_t));
+	memory->temporaryIndexBufferCapacity = indexCapacity;
+	memory->appearanceSortBuffer = (size_t*)bar_code_arena_alloc(arena, sortCapacity * sizeof(size_t));
+	memory->appearanceSortMatchScoreBuffer = (float*)bar_code_arena_alloc(arena, sortCapacity * sizeof(float));
+	memory->appearanceSortBufferCapacity = sortCapacity;
+
+	destroy_bar_code_arena(memory->growthArena);
+	memory->growthArena = arena;
+	return true;
+}
+
+///<summary>Grows the buffers of the <see cref="BarCodeFindStage"/>s that overflowed during the last search, so that the next search can hold more.</summary>
+///<param name="memory">The <see cref="BarCodeFindTemporaryMemory"/>. Its <see cref="BarCodeFindTemporaryMemory.usage"/> must not be NULL for anything to grow,
+///and unless it lives in a <see cref="BarCodeArena"/>, the buffers that may grow (those with a nonzero <see cref="BarCodeFindTemporaryMemory.maxCapacities"/>)
+///must have been allocated with malloc.</param>
+///<returns>False if a buffer could not be grown. It then keeps its old capacity, and the other buffers still grow.</returns>
+///<remarks>Each buffer that overflowed at least doubles in capacity, up to its <see cref="BarCodeFindTemporaryMemory.maxCapacities"/>, so a stream of similar
+///bitmaps only drops values during the first few searches. The buffers never shrink. The <see cref="BarCodeAppearancePool"/> grows by itself, so only its
+///limit is raised. The buffers of a memory that lives in a <see cref="BarCodeArena"/> all move to a new arena (<see cref="BarCodeFindTemporaryMemory.growthArena"/>)
+///with the same <see cref="BarCodeArenaFlags"/> whenever one of them grows.</remarks>
+static bool grow_bar_code_find_temporary_memory(BarCodeFindTemporaryMemory* memory)
+{
+	if (memory->usage == NULL)
+		return true;
+
+	size_t newCapacities[BAR_CODE_FIND_STAGE_COUNT] = { 0 };
+	bool growing = false;
+	for (int i = 0; i < BAR_CODE_FIND_STAGE_COUNT; i++)
+	{
+		BarCodeFindStage stage = (BarCodeFindStage)i;
+		size_t capacity = get_bar_code_find_stage_capacity(memory, stage);
+		size_t maxCapacity = memory->maxCapacities[stage];
+		if (!memory->usage[stage].overflowed || capacity >= maxCapacity)
+			continue;
+
+		//Doubling is enough for most overflows, but a stage that needed far more than it had (and reported how much) grows straight to that
+		size_t newCapacity = capacity < 32 ? 64 : capacity * 2;
+		if (newCapacity < memory->usage[stage].used)
+			newCapacity = memory->usage[stage].used;
+		newCapacities[stage] = newCapacity > maxCapacity ? maxCapacity : newCapacity;
+		growing = true;
+	}
+	if (!growing)
+		return true;
+
+	//The pool's own buffers grow as lines are added, so only its limit is raised
+	if (newCapacities[BAR_CODE_FIND_STAGE_APPEARANCES] != 0)
+		memory->appearanceCapacity = newCapacities[BAR_CODE_FIND_STAGE_APPEARANCES];
+	if (memory->arena != NULL)
+		return _move_bar_code_find_buffers(memory, newCapacities);
+
+	bool grown = true;
+	if (newCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES] != 0)
+		grown = _reserve_buffer((void**)&memory->scanLines, &memory->scanLineCapacity, newCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES], sizeof(YellowScanLine)) && grown;
+
+	if (newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] != 0)
+	{
+		grown = _reserve_buffer((void**)&memory->yellowBoxes, &memory->yellowBoxCapacity, newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES], sizeof(YellowBoundingBox)) && grown;
+		grown = _reserve_buffer((void**)&memory->temporaryIndexBuffer, &memory->temporaryIndexBufferCapacity, newCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES], sizeof(size_t)) && grown;
+	}
+
+	if (newCapacities[BAR_CODE_FIND_STAGE_MATCHES] != 0)
+	{
+		//Both sort buffers share one capacity, so it only grows once both have
+		size_t newCapacity = newCapacities[BAR_CODE_FIND_STAGE_MATCHES];
+		size_t indexCapacity = memory->appearanceSortBufferCapacity, scoreCapacity = memory->appearanceSortBufferCapacity;
+		if (_reserve_buffer((void**)&memory->appearanceSortBuffer, &indexCapacity, newCapacity, sizeof(size_t)) &&
+			_reserve_buffer((void**)&memory->appearanceSortMatchScoreBuffer, &scoreCapacity, newCapacity, sizeof(float)))
+			memory->appearanceSortBufferCapacity = newCapacity;
+		else
+			grown = false;
+	}
+	return grown;
+}
+
+///<summary>Allocates a <see cref="BarCodeFindTemporaryMemory"/> and all of its buffers from a single <see cref="BarCodeArena"/>, so that it has one
+///predictable footprint.</summary>
+///<param name="arenaFlags">A combination of <see cref="BarCodeArenaFlags"/>. With <see cref="BAR_CODE_ARENA_PREFAULT"/>, no search pays for the first touch
+///of a page of the buffers.</param>
+///<returns>The memory, which records its <see cref="BarCodeFindTemporaryMemory.usage"/> and does not grow until <see cref="BarCodeFindTemporaryMemory.maxCapacities"/>
+///is set, or NULL if the arena could not be mapped. Free it with <see cref="free_bar_code_find_temporary_memory"/>.</returns>
+///<remarks>The other parameters are the capacities of the buffers (see <see cref="BarCodeFindTemporaryMemory"/>). Each buffer starts on its own cache line. Only
+///the lines of the <see cref="BarCodeAppearancePool"/> and the cells of the <see cref="YellowBoxIndex"/> live outside of the arena, since they grow as needed.</remarks>
+static BarCodeFindTemporaryMemory* allocate_bar_code_find_temporary_memory(size_t scanLineCapacity, size_t yellowBoxCapacity, size_t temporaryIndexBufferCapacity, size_t appearanceCapacity, size_t appearanceSortBufferCapacity, int arenaFlags)
+{
+	size_t size = 0;
+	if (!_add_arena_region(&size, 1, sizeof(BarCodeFindTemporaryMemory)) ||
+		!_add_arena_region(&size, scanLineCapacity, sizeof(YellowScanLine)) ||
+		!_add_arena_region(&size, yellowBoxCapacity, sizeof(YellowBoundingBox)) ||
+		!_add_arena_region(&size, temporaryIndexBufferCapacity, sizeof(size_t)) ||
+		!_add_arena_region(&size, 1, sizeof(BarCodeAppearancePool)) ||
+		!_add_arena_region(&size, appearanceSortBufferCapacity, sizeof(size_t)) ||
+		!_add_arena_region(&size, appearanceSortBufferCapacity, sizeof(float)) ||
+		!_add_arena_region(&size, 1, sizeof(YellowBoxIndex)) ||
+		!_add_arena_region(&size, BAR_CODE_FIND_STAGE_COUNT, sizeof(BarCodeFindStageUsage)))
+		return NULL;
+
+	BarCodeArena* arena = create_bar_code_arena(size, arenaFlags);
+	if (arena == NULL)
+		return NULL;
+
+	//The arena is zeroed, which is also an empty pool, an empty index, and no usage yet
+	BarCodeFindTemporaryMemory* memory = (BarCodeFindTemporaryMemory*)bar_code_arena_alloc(arena, sizeof(BarCodeFindTemporaryMemory));
+	memory->scanLines = (YellowScanLine*)bar_code_arena_alloc(arena, scanLineCapacity * sizeof(YellowScanLine));
+	memory->scanLineCapacity = scanLineCapacity;
+	memory->yellowBoxes = (YellowBoundingBox*)bar_code_arena_alloc(arena, yellowBoxCapacity * sizeof(YellowBoundingBox));
+	memory->yellowBoxCapacity = yellowBoxCapacity;
+	memory->temporaryIndexBuffer = (size_t*)bar_code_arena_alloc(arena, temporaryIndexBufferCapacity * sizeof(size_t));
+	memory->temporaryIndexBufferCapacity = temporaryIndexBufferCapacity;
+	memory->appearances = (BarCodeAppearancePool*)bar_code_arena_alloc(arena, sizeof(BarCodeAppearancePool));
+	memory->appearanceCapacity = appearanceCapacity;
+	memory->appearanceSortBuffer = (size_t*)bar_code_arena_alloc(arena, appearanceSortBufferCapacity * sizeof(size_t));
+	memory->appearanceSortMatchScoreBuffer = (float*)bar_code_arena_alloc(arena, appearanceSortBufferCapacity * sizeof(float));
+	memory->appearanceSortBufferCapacity = appearanceSortBufferCapacity;
+	memory->boxIndex = (YellowBoxIndex*)bar_code_arena_alloc(arena, sizeof(YellowBoxIndex));
+	memory->usage = (BarCodeFindStageUsage*)bar_code_arena_alloc(arena, BAR_CODE_FIND_STAGE_COUNT * sizeof(BarCodeFindStageUsage));
+	memory->arena = arena;
+	return memory;
+}
+
+///<summary>Frees a <see cref="BarCodeFindTemporaryMemory"/> that was created by <see cref="allocate_bar_code_find_temporary_memory"/>, including the structure itself.</summary>
+static void free_bar_code_find_temporary_memory(BarCodeFindTemporaryMemory* memory)
+{
+	free_bar_code_appearance_pool(memory->appearances);
+	free_yellow_box_index(memory->boxIndex);
+	free(memory->stats);
+	destroy_bar_code_arena(memory->growthArena);
+	destroy_bar_code_arena(memory->arena);//Last, since the structure lives in it
+}
+
+///<summary>Allocates the <see cref="BarCodeFindStats"/> of a <see cref="BarCodeFindTemporaryMemory"/> that was created by
+///<see cref="allocate_bar_code_find_temporary_memory"/>, so that the searches record them. They are freed by <see cref="free_bar_code_find_temporary_memory"/>.</summary>
+///<param name="maxContextCount">The number of <see cref="BarCodeFindContext"/>s whose kept appearances are recorded.</param>
+///<returns>False if the library was compiled without BAR_CODE_STATS, or the memory could not be allocated.</returns>
+static bool enable_bar_code_find_stats(BarCodeFindTemporaryMemory* memory, size_t maxContextCount)
+{
+#if defined(BAR_CODE_STATS)
+	if (maxContextCount > (SIZE_MAX - sizeof(BarCodeFindStats)) / sizeof(size_t))
+		return false;
+
+	BarCodeFindStats* stats = (BarCodeFindStats*)calloc(1, sizeof(BarCodeFindStats) + (maxContextCount * sizeof(size_t)));
+	if (stats == NULL)
+		return false;
+
+	stats->keptAppearanceCounts = (size_t*)(stats + 1);
+	stats->keptAppearanceCountCapacity = maxContextCount;
+	free(memory->stats);
+	memory->stats = stats;
+	return true;
+#else
+	(void)memory;
+	(void)maxContextCount;
+	return false;
+#endif
+}
+
+///<summary>Determines the distinct numbers of 'sections' (color counts) of the <see cref="BarCode"/>s of a set of <see cref="BarCodeFindContext"/>s.</summary>
+///<param name="sectionCounts">Receives the distinct section counts in ascending order. Must be able to hold <see cref="BAR_CODE_MAX_COLOR_COUNT"/> values.</param>
+///<returns>The number of distinct section counts.</returns>
+static int _get_section_counts(const BarCodeFindContext* contexts, size_t contextCount, int* sectionCounts)
+{
+	bool used[BAR_CODE_MAX_COLOR_COUNT + 1] = { false };
+	for (size_t i = 0; i < contextCount; i++)
+	{
+		assert(contexts[i].barCode.colorCount >= 1 && contexts[i].barCode.colorCount <= BAR_CODE_MAX_COLOR_COUNT);
+		used[contexts[i].barCode.colorCount] = true;
+	}
+
+	int count = 0;
+	for (int sectionCount = 1; sectionCount <= BAR_CODE_MAX_COLOR_COUNT; sectionCount++)
+	{
+		if (used[sectionCount])
+			sectionCounts[count++] = sectionCount;
+	}
+	return count;
+}
+
+///<summary>Stores the <see cref="BarCodeAppearance"/>s that match a <see cref="BarCodeFindContext"/>'s <see cref="BarCode"/> in the context.</summary>
+///<param name="pool">The <see cref="BarCodeAppearancePool"/> that holds the <see cref="BarCodeAppearance"/>s.</param>
+///<param name="scores">Scratch space for <see cref="find_appearances_of_bar_code_in_pool"/>.</param>
+///<returns>The number of matches that the sort buffers needed to hold, which is more than <paramref name="sortBufferCapacity"/> if some of the matches
+///that the context had room for were dropped.</returns>
+static size_t _match_appearances_to_context(BarCodeFindContext* context, const BarCodeAppearancePool* pool, float* scores, size_t* sortBuffer, float* sortMatchScores, size_t sortBufferCapacity)
+{
+	//Find the BarCodeAppearances that best match the context's BarCode, sorted by how well they match
+	size_t maxCount = context->appearanceBufferCapacity < sortBufferCapacity ? context->appearanceBufferCapacity : sortBufferCapacity;
+	size_t matchCount;
+	context->appearanceCount = _find_appearances_of_bar_code_in_pool(context->barCode, context->minLineDistance, context->minMatchScore, pool, scores, sortBuffer, sortMatchScores, maxCount, &matchCount);
+	context->appearancePool = pool;
+
+	//Store the BarCodeAppearances (or their indices) in the context's destination buffers
+	int block = _get_pool_block(pool, context->barCode.colorCount);
+	for (size_t j = 0; j < context->appearanceCount; j++)
+	{
+		if (context->appearanceIndices != NULL)
+			context->appearanceIndices[j] = sortBuffer[j];
+		else
+			get_pool_appearance(pool, block, sortBuffer[j], &context->appearanceBuffer[j]);
+		context->appearanceMatchScores[j] = sortMatchScores[j];
+	}
+	return matchCount < context->appearanceBufferCapacity ? matchCount : context->appearanceBufferCapacity;
+}
+
+///<summary>Stores the <see cref="BarCodeAppearance"/>s of <see cref="BarCodeFindTemporaryMemory.appearances"/> that match each
+///<see cref="BarCodeFindContext"/>'s <see cref="BarCode"/> in the context.</summary>
+static void _match_pool_to_contexts(BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	BarCodeAppearancePool* pool = memory.appearances;
+	if (!_reserve_buffer((void**)&pool->scores, &pool->scoreCapacity, pool->count, sizeof(float)))
+		pool->count = 0;//There is no room to score them
+
+	size_t sortCount = 0;
+	for (size_t i = 0; i < contextCount; i++)
+	{
+		size_t required = _match_appearances_to_context(&contexts[i], pool, pool->scores, memory.appearanceSortBuffer, memory.appearanceSortMatchScoreBuffer, memory.appearanceSortBufferCapacity);
+		sortCount = required > sortCount ? required : sortCount;
+	}
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_MATCHES, sortCount, sortCount > memory.appearanceSortBufferCapacity);
+}
+
+///<summary>Searches an image in any <see cref="BarCodePixelFormat"/> for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s,
+///like <see cref="find_appearances_of_bar_code_interests_in_bitmap"/>.</summary>
+///<param name="image">The <see cref="BarCodeImage"/> to search.</param>
+///<remarks>The other parameters are the same as those of <see cref="find_appearances_of_bar_code_interests_in_bitmap"/>. The pixels are classified by the
+///kernels of their own format, and the colorful lines are read straight from the image, so it never has to be converted to RGBA.</remarks>
+void find_appearances_of_bar_code_interests_in_image(const BarCodeImage* image, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	if (contextCount == 0)
+		return;//Nothing to do
+
+	int sectionCounts[BAR_CODE_MAX_COLOR_COUNT];
+	int sectionCountCount = _get_section_counts(contexts, contextCount, sectionCounts);
+	_begin_bar_code_find_usage(memory.usage);
+
+#if defined(BAR_CODE_STATS)
+	BarCodeFindStats* stats = memory.stats;
+	uint64_t startTime = 0, stageTime = 0;
+	if (stats != NULL)
+	{
+		_begin_bar_code_find_stats(stats, contextCount);
+		startTime = stageTime = get_monotonic_nanoseconds();
+	}
+#else
+	BarCodeFindStats* stats = NULL;
+#endif
+
+	//Find the 'yellow bounding boxes' (and the 'yellow scan lines' that make them up) in a single pass
+	_YellowBoxUsage boxUsage = { 0 };
+	size_t boxCapacity = memory.yellowBoxCapacity < memory.temporaryIndexBufferCapacity ? memory.yellowBoxCapacity : memory.temporaryIndexBufferCapacity;
+	size_t boxCount = _find_yellow_boxes_in_window(image, 0, 0, image->width, image->height, yellowCfg, maxYellowSpacing, memory.scanLines, memory.scanLineCapacity, memory.temporaryIndexBuffer, memory.yellowBoxes, boxCapacity, &boxUsage, stats);
+	_record_yellow_box_usage(memory.usage, &boxUsage);
+#if defined(BAR_CODE_STATS)
+	if (stats != NULL)
+		_add_bar_code_stats_time(stats, BAR_CODE_FIND_COUNTER_YELLOW_NANOSECONDS, &stageTime);
+#endif
+
+	//Find all BarCodeAppearances, reading each line once for all of the section counts
+	BarCodeAppearancePool* pool = memory.appearances;
+	bool poolOverflowed = false;
+	if (_reset_bar_code_appearance_pool(pool, sectionCounts, sectionCountCount))
+		_find_bar_code_appearances(image, yellowCfg, memory.yellowBoxes, boxCount, sectionCounts, sectionCountCount, memory.pairing, memory.boxIndex, NULL, pool, memory.appearanceCapacity, &poolOverflowed, stats);
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_APPEARANCES, pool->count, poolOverflowed);
+#if defined(BAR_CODE_STATS)
+	if (stats != NULL)
+	{
+		stats->counters[BAR_CODE_FIND_COUNTER_APPEARANCES] = pool->count;
+		_add_bar_code_stats_time(stats, BAR_CODE_FIND_COUNTER_APPEARANCE_NANOSECONDS, &stageTime);
+	}
+#endif
+
+	//Match all BarCodeAppearances to their respective BarCodeFindContext (if any)
+	_match_pool_to_contexts(contexts, contextCount, memory);
+#if defined(BAR_CODE_STATS)
+	if (stats != NULL)
+	{
+		_add_bar_code_stats_time(stats, BAR_CODE_FIND_COUNTER_MATCH_NANOSECONDS, &stageTime);
+		stats->counters[BAR_CODE_FIND_COUNTER_TOTAL_NANOSECONDS] = stageTime - startTime;
+		for (size_t i = 0; i < contextCount && i < stats->keptAppearanceCountCapacity; i++)
+			stats->keptAppearanceCounts[i] = contexts[i].appearanceCount;
+	}
+#endif
+}
+
 ///<summary>Searches for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s.</summary>
 ///<param name="rgba8">The image's pixels, stored in RGBA 8-bit format.</param>
 ///<param name="width">The width, in pixels, of the bitmap.</param>
@@ -1069,45 +2971,125 @@ typedef struct BarCodeFindTemporaryMemory
 ///<param name="contexts">Array of <see cref="BarCodeFindContext"/>s.</param>
 ///<param name="contextCount">The number of <see cref="BarCodeFindContext"/>s in <paramref name="contexts"/>.</param>
 ///<param name="memory">The <see cref="BarCodeFindTemporaryMemory"/> that provides temporary memory for this function.</param>
-///<remarks>All <see cref="BarCodeFindContext"/>s must have a <see cref="BarCode"/> with the same number of 'sections' (see <see cref="BarCode.colorCount"/>).</remarks>
+///<remarks>The <see cref="BarCode"/>s may have different numbers of 'sections' (see <see cref="BarCode.colorCount"/>). Each colorful line is still only
+///found and read once, and <see cref="BarCodeFindTemporaryMemory.appearances"/> holds its sections for each distinct section count.</remarks>
 void find_appearances_of_bar_code_interests_in_bitmap(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
 {
-	if (contextCount == 0)
-		return;//Nothing to do
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	find_appearances_of_bar_code_interests_in_image(&image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory);
+}
 
-	//Determine the number of 'sections' on all BarCodes (this function requires the same number of sections per BarCode)
-	int sectionCount = 0;
-	for (size_t i = 0; i < contextCount; i++)
+///<summary>A rectangular region of a bitmap that is searched by <see cref="find_appearances_of_bar_code_interests_in_regions"/>.</summary>
+typedef struct BarCodeSearchRegion
+{
+	///<summary>The first column of the region.</summary>
+	int left;
+
+	///<summary>The first row of the region.</summary>
+	int top;
+
+	///<summary>The column after the last column of the region.</summary>
+	int right;
+
+	///<summary>The row after the last row of the region.</summary>
+	int bottom;
+} BarCodeSearchRegion;
+
+///<summary>Checks whether two <see cref="BarCodeSearchRegion"/>s overlap, or are close enough that a group of yellow pixels could reach from one into the other.</summary>
+BAR_CODE_FORCEINLINE bool _are_search_regions_near(BarCodeSearchRegion a, BarCodeSearchRegion b, int maxSpacing)
+{
+	return a.left < b.right + maxSpacing && b.left < a.right + maxSpacing && a.top < b.bottom + maxSpacing && b.top < a.bottom + maxSpacing;
+}
+
+///<summary>Joins the <see cref="BarCodeSearchRegion"/>s that are near each other (see <see cref="_are_search_regions_near"/>) into their bounding regions,
+///in place, then sorts them from top to bottom.</summary>
+///<returns>The number of regions that are left, none of which are near each other.</returns>
+static size_t _join_search_regions(BarCodeSearchRegion* regions, size_t regionCount, int maxSpacing)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < regionCount; i++)
 	{
-		if (i == 0)
-			sectionCount = (int)contexts[i].barCode.colorCount;
-		else
-			assert(sectionCount == contexts[i].barCode.colorCount);//Make sure all BarCodes have the same 'section count' (color count)
+		//Join the region with every kept region that it is near. Each join may bring it near another one, so start over after each one.
+		BarCodeSearchRegion region = regions[i];
+		for (size_t j = 0; j < count;)
+		{
+			if (!_are_search_regions_near(region, regions[j], maxSpacing + 1))
+			{
+				j++;
+				continue;
+			}
+
+			BarCodeSearchRegion other = regions[j];
+			region.left = other.left < region.left ? other.left : region.left;
+			region.top = other.top < region.top ? other.top : region.top;
+			region.right = other.right > region.right ? other.right : region.right;
+			region.bottom = other.bottom > region.bottom ? other.bottom : region.bottom;
+			regions[j] = regions[--count];
+			j = 0;
+		}
+		regions[count++] = region;//count <= i, so this never overwrites a region that has not been read yet
+	}
+
+	//Search the regions from top to bottom, like a full scan, so the lines are read in a similar order
+	for (size_t i = 1; i < count; i++)
+	{
+		BarCodeSearchRegion region = regions[i];
+		size_t j = i;
+		for (; j > 0 && (regions[j - 1].top > region.top || (regions[j - 1].top == region.top && regions[j - 1].left > region.left)); j--)
+			regions[j] = regions[j - 1];
+		regions[j] = region;
 	}
+	return count;
+}
 
-	//Find the 'yellow scan lines'
-	size_t scanLineCount = find_yellow_lines(rgba8, width, height, yellowCfg, memory.scanLines, memory.scanLineCapacity);
+///<summary>Searches for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s like <see cref="find_appearances_of_bar_code_interests_in_bitmap"/>,
+///but only inside some regions of an image.</summary>
+///<param name="image">The <see cref="BarCodeImage"/> to search, in any <see cref="BarCodePixelFormat"/>.</param>
+///<param name="regions">The regions to search. Each is clipped to the image, and the regions should not overlap.</param>
+///<param name="regionCount">The number of regions in <paramref name="regions"/>.</param>
+///<remarks>The other parameters are the same as those of <see cref="find_appearances_of_bar_code_interests_in_bitmap"/>. Only the pixels of the regions are
+///classified, and a yellow bar is only paired with the yellow bars of the same region, so the bar codes must lie entirely inside one region. A group of
+///yellow pixels that crosses the edge of a region is cut off at the edge. The regions are searched in order.</remarks>
+void find_appearances_of_bar_code_interests_in_image_regions(const BarCodeImage* image, YellowConfig yellowCfg, int maxYellowSpacing, const BarCodeSearchRegion* regions, size_t regionCount, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	if (contextCount == 0)
+		return;//Nothing to do
 
-	//Find the 'yellow bounding boxes'
-	size_t boxCount = find_yellow_rectangles(memory.scanLines, scanLineCount, maxYellowSpacing, memory.temporaryIndexBuffer, memory.temporaryIndexBufferCapacity, memory.yellowBoxes, memory.yellowBoxCapacity);
+	int sectionCounts[BAR_CODE_MAX_COLOR_COUNT];
+	int sectionCountCount = _get_section_counts(contexts, contextCount, sectionCounts);
 
-	//Find all BarCodeAppearances
-	size_t appearanceCount = find_bar_code_appearances(rgba8, width, height, yellowCfg, memory.yellowBoxes, boxCount, sectionCount, memory.appearances, memory.appearanceCapacity);
+	_begin_bar_code_find_usage(memory.usage);
 
-	//Match all BarCodeAppearances to their respective BarCodeFindContext (if any)
-	for (size_t i = 0; i < contextCount; i++)
+	BarCodeAppearancePool* pool = memory.appearances;
+	bool poolOverflowed = false;
+	size_t boxCapacity = memory.yellowBoxCapacity < memory.temporaryIndexBufferCapacity ? memory.yellowBoxCapacity : memory.temporaryIndexBufferCapacity;
+	if (_reset_bar_code_appearance_pool(pool, sectionCounts, sectionCountCount))
 	{
-		//Sort all BarCodeAppearances by how well they match the context's BarCode
-		contexts[i].appearanceCount = find_appearances_of_bar_code(contexts[i].barCode, contexts[i].minLineDistance, contexts[i].minMatchScore, memory.appearances, appearanceCount, memory.appearanceSortBuffer, memory.appearanceSortMatchScoreBuffer, memory.appearanceSortBufferCapacity);
-		if (contexts[i].appearanceCount > contexts[i].appearanceBufferCapacity)
-			contexts[i].appearanceCount = contexts[i].appearanceBufferCapacity;
-
-		//Copy the BarCodeAppearances to the context's destination buffer
-		for (size_t j = 0; j < contexts[i].appearanceCount; j++)
+		for (size_t i = 0; i < regionCount && !poolOverflowed; i++)
 		{
-			BarCodeAppearance appearance = *(memory.appearanceSortBuffer[j]);
-			contexts[i].appearanceBuffer[j] = appearance;
-			contexts[i].appearanceMatchScores[j] = memory.appearanceSortMatchScoreBuffer[j];
+			int left = regions[i].left < 0 ? 0 : regions[i].left;
+			int top = regions[i].top < 0 ? 0 : regions[i].top;
+			int right = regions[i].right > image->width ? image->width : regions[i].right;
+			int bottom = regions[i].bottom > image->height ? image->height : regions[i].bottom;
+			if (left >= right || top >= bottom)
+				continue;//Nothing of this region is inside the bitmap
+
+			//Each region's lines are added after those of the previous regions, but its boxes reuse the same buffers
+			_YellowBoxUsage boxUsage = { 0 };
+			size_t boxCount = _find_yellow_boxes_in_window(image, left, top, right, bottom, yellowCfg, maxYellowSpacing, memory.scanLines, memory.scanLineCapacity, memory.temporaryIndexBuffer, memory.yellowBoxes, boxCapacity, &boxUsage, NULL);
+			_record_yellow_box_usage(memory.usage, &boxUsage);
+			_find_bar_code_appearances(image, yellowCfg, memory.yellowBoxes, boxCount, sectionCounts, sectionCountCount, memory.pairing, memory.boxIndex, NULL, pool, memory.appearanceCapacity, &poolOverflowed, NULL);
 		}
 	}
-}
\ No newline at end of file
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_APPEARANCES, pool->count, poolOverflowed);
+
+	//Match all BarCodeAppearances to their respective BarCodeFindContext (if any)
+	_match_pool_to_contexts(contexts, contextCount, memory);
+}
+
+///<summary>Searches for <see cref="BarCodeAppearance"/>s like <see cref="find_appearances_of_bar_code_interests_in_image_regions"/>, in a bitmap that is stored in RGBA 8-bit format.</summary>
+void find_appearances_of_bar_code_interests_in_regions(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, const BarCodeSearchRegion* regions, size_t regionCount, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	find_appearances_of_bar_code_interests_in_image_regions(&image, yellowCfg, maxYellowSpacing, regions, regionCount, contexts, contextCount, memory);
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include "Platform.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+///<summary>The alignment of every region of a <see cref="BarCodeArena"/>, in bytes. This is the size of a cache line, and of an AVX-512 register.</summary>
+#define BAR_CODE_ARENA_ALIGNMENT (64)
+
+///<summary>The size of the pages that pre-faulting touches. Larger pages are touched more than once, which does no harm.</summary>
+#define BAR_CODE_ARENA_PAGE_SIZE (4096)
+
+///<summary>The size of the huge pages that <see cref="BAR_CODE_ARENA_HUGE_PAGES"/> rounds an arena up to on Linux.</summary>
+#define BAR_CODE_ARENA_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+///<summary>Options for <see cref="create_bar_code_arena"/>.</summary>
+typedef enum BarCodeArenaFlags
+{
+	///<summary>Normal pages, which are faulted in when they are first written.</summary>
+	BAR_CODE_ARENA_DEFAULT = 0,
+
+	///<summary>Try to back the arena with huge (large) pages, which need far fewer TLB entries. On Linux, explicit huge pages are used if any are
+	///reserved, and transparent huge pages are requested otherwise. On Windows, large pages need the 'Lock pages in memory' privilege. The arena
+	///falls back to normal pages when they are not available.</summary>
+	BAR_CODE_ARENA_HUGE_PAGES = 1,
+
+	///<summary>Touch every page when the arena is created, so that no search pays for the first write to a page.</summary>
+	BAR_CODE_ARENA_PREFAULT = 2
+} BarCodeArenaFlags;
+
+///<summary>One block of memory that is carved into aligned regions, which are all freed at once.</summary>
+///<remarks>The arena is mapped straight from the operating system, so it starts out zeroed. A <see cref="BarCodeArena"/> is stored in the first
+///region of its own memory, so creating an arena is a single allocation.</remarks>
+typedef struct BarCodeArena
+{
+	///<summary>The first byte of the arena, which is also the address of this structure.</summary>
+	uint8_t* base;
+
+	///<summary>The number of bytes that were mapped.</summary>
+	size_t size;
+
+	///<summary>The number of bytes that have been carved into regions, including the region of this structure.</summary>
+	size_t used;
+
+	///<summary>The <see cref="BarCodeArenaFlags"/> that the arena was created with, which are also used for any arena that replaces it.</summary>
+	int flags;
+
+	///<summary>True if the arena is backed by explicit huge (large) pages. Transparent huge pages are not reported, since the kernel may or may not use them.</summary>
+	bool hugePages;
+} BarCodeArena;
+
+///<summary>Gets the number of bytes that a region of <paramref name="size"/> bytes takes up in a <see cref="BarCodeArena"/>. Regions are padded to
+///whole cache lines, so two regions never share a cache line.</summary>
+BAR_CODE_FORCEINLINE size_t get_bar_code_arena_region_size(size_t size)
+{
+	return (size + (BAR_CODE_ARENA_ALIGNMENT - 1)) & ~(size_t)(BAR_CODE_ARENA_ALIGNMENT - 1);
+}
+
+///<summary>Maps <paramref name="size"/> bytes of zeroed memory, using huge pages if <paramref name="hugePages"/> and they are available.</summary>
+///<param name="hugePages">Whether to try huge pages. Set to false if they were not used.</param>
+///<param name="size">The number of bytes to map, which is rounded up to whole huge pages if they are used.</param>
+static void* _map_bar_code_arena(size_t* size, bool* hugePages)
+{
+#if defined(_WIN32)
+	if (*hugePages)
+	{
+		SIZE_T largePageSize = GetLargePageMinimum();
+		if (largePageSize != 0)
+		{
+			size_t largeSize = (*size + largePageSize - 1) & ~(size_t)(largePageSize - 1);
+			void* memory = VirtualAlloc(NULL, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (memory != NULL)
+			{
+				*size = largeSize;
+				return memory;
+			}
+		}
+		*hugePages = false;//The process does not hold the privilege, or there are no large pages left
+	}
+	return VirtualAlloc(NULL, *size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	void* memory = MAP_FAILED;
+	size_t mappedSize = *size;
+	if (*hugePages)
+	{
+		mappedSize = (*size + BAR_CODE_ARENA_HUGE_PAGE_SIZE - 1) & ~(BAR_CODE_ARENA_HUGE_PAGE_SIZE - 1);
+#if defined(MAP_HUGETLB)
+		memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+		if (memory == MAP_FAILED)
+		{
+			//No huge pages are reserved, so ask for transparent huge pages instead. Those only fill whole aligned huge pages,
+			//so the arena is still a multiple of their size.
+			*hugePages = false;
+			memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+			if (memory != MAP_FAILED)
+				madvise(memory, mappedSize, MADV_HUGEPAGE);
+#endif
+		}
+	}
+	else
+	{
+		memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+
+	if (memory == MAP_FAILED)
+		return NULL;
+	*size = mappedSize;
+	return memory;
+#endif
+}
+
+///<summary>Creates a <see cref="BarCodeArena"/> with room for <paramref name="size"/> bytes of regions.</summary>
+///<param name="size">The total size of the regions that will be carved from the arena. Add up <see cref="get_bar_code_arena_region_size"/> of each of them.</param>
+///<param name="flags">A combination of <see cref="BarCodeArenaFlags"/>.</param>
+///<returns>The arena, which is stored in its own memory, or NULL if the memory could not be mapped. Free it with <see cref="destroy_bar_code_arena"/>.</returns>
+static BarCodeArena* create_bar_code_arena(size_t size, int flags)
+{
+	size_t headerSize = get_bar_code_arena_region_size(sizeof(BarCodeArena));
+	if (size > SIZE_MAX - headerSize - BAR_CODE_ARENA_HUGE_PAGE_SIZE)
+		return NULL;
+
+	size_t mappedSize = headerSize + size;
+	bool hugePages = (flags & BAR_CODE_ARENA_HUGE_PAGES) != 0;
+	uint8_t* base = (uint8_t*)_map_bar_code_arena(&mappedSize, &hugePages);
+	if (base == NULL)
+		return NULL;
+
+	if ((flags & BAR_CODE_ARENA_PREFAULT) != 0)
+	{
+		//Write to every page (a read would only map the shared zero page). The memory is already zeroed, so this changes nothing.
+		volatile uint8_t* page = base;
+		for (size_t offset = 0; offset < mappedSize; offset += BAR_CODE_ARENA_PAGE_SIZE)
+			page[offset] = 0;
+	}
+
+	BarCodeArena* arena = (BarCodeArena*)base;
+	arena->base = base;
+	arena->size = mappedSize;
+	arena->used = headerSize;
+	arena->flags = flags;
+	arena->hugePages = hugePages;
+	return arena;
+}
+
+///<summary>Frees a <see cref="BarCodeArena"/> and every region that was carved from it. Does nothing if <paramref name="arena"/> is NULL.</summary>
+static void destroy_bar_code_arena(BarCodeArena* arena)
+{
+	if (arena == NULL)
+		return;
+
+#if defined(_WIN32)
+	VirtualFree(arena->base, 0, MEM_RELEASE);
+#else
+	munmap(arena->base, arena->size);
+#endif
+}
+
+///<summary>Carves a zeroed region of <paramref name="size"/> bytes from a <see cref="BarCodeArena"/>, aligned to <see cref="BAR_CODE_ARENA_ALIGNMENT"/> bytes.</summary>
+///<returns>The region, or NULL if the arena does not have enough room left.</returns>
+static void* bar_code_arena_alloc(BarCodeArena* arena, size_t size)
+{
+	size_t regionSize = get_bar_code_arena_region_size(size);
+	if (regionSize < size || regionSize > arena->size - arena->used)
+		return NULL;
+
+	void* region = arena->base + arena->used;
+	arena->used += regionSize;
+	return region;
+}
+
+///<summary>Checks whether <paramref name="pointer"/> points into a region of a <see cref="BarCodeArena"/>, rather than to memory that was allocated separately.</summary>
+BAR_CODE_FORCEINLINE bool bar_code_arena_contains(const BarCodeArena* arena, const void* pointer)
+{
+	return arena != NULL && (const uint8_t*)pointer >= arena->base && (const uint8_t*)pointer < arena->base + arena->used;
+}
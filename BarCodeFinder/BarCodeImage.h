@@ -0,0 +1,192 @@
+#pragma once
+#include "Platform.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+///<summary>The layout of the pixels of a <see cref="BarCodeImage"/>.</summary>
+typedef enum BarCodePixelFormat
+{
+	///<summary>Four bytes per pixel: red, green, blue and alpha.</summary>
+	BAR_CODE_PIXEL_FORMAT_RGBA8 = 0,
+
+	///<summary>Four bytes per pixel: blue, green, red and alpha (the usual layout of Windows bitmaps and many capture APIs).</summary>
+	BAR_CODE_PIXEL_FORMAT_BGRA8 = 1,
+
+	///<summary>Three bytes per pixel: red, green and blue.</summary>
+	BAR_CODE_PIXEL_FORMAT_RGB24 = 2,
+
+	///<summary>Packed 4:2:2 YCbCr: each pair of pixels is stored as Y0, U, Y1, V.</summary>
+	BAR_CODE_PIXEL_FORMAT_YUYV = 3,
+
+	///<summary>Planar 4:2:0 YCbCr: a plane of Y bytes, followed by a plane of interleaved U, V bytes with one pair for each 2x2 block of pixels.</summary>
+	///<remarks>If the width is odd, each chroma row holds one more byte than a luma row (the pair of the last pixel), so the stride must be at least
+	///the width rounded up to an even number of bytes.</remarks>
+	BAR_CODE_PIXEL_FORMAT_NV12 = 4,
+
+	///<summary>The number of pixel formats.</summary>
+	BAR_CODE_PIXEL_FORMAT_COUNT = 5
+} BarCodePixelFormat;
+
+///<summary>Describes the pixels of an image that is searched for bar codes.</summary>
+///<remarks>The YCbCr formats use the BT.601 'video range' (Y from 16 to 235), which is what cameras and video decoders produce. Each pixel
+///is converted to RGB as it is read (see <see cref="_yuv_to_rgb"/>), so the image never has to be converted as a whole. A YUYV or NV12
+///image with an odd width has one extra (unused) pixel at the end of each row, and an NV12 image with an odd height has one extra row of chroma.
+///The rows may be padded (see <see cref="stride"/>), and neither the pixels nor the rows need to be aligned, so a capture or decoder buffer can be
+///searched in place.</remarks>
+typedef struct BarCodeImage
+{
+	///<summary>The first byte of the image (of its luma plane, for <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/>).</summary>
+	const uint8_t* pixels;
+
+	///<summary>The width of the image, measured in pixels.</summary>
+	int width;
+
+	///<summary>The height of the image, measured in pixels.</summary>
+	int height;
+
+	///<summary>The number of bytes from the start of one row to the start of the next, for both planes of <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/>.
+	///Zero means that the rows are packed (see <see cref="_get_image_row_size"/>). Otherwise it must be at least the size of a row, and for NV12
+	///also of a chroma row, which is the width rounded up to an even number of bytes (see <see cref="_get_image_min_stride"/>).</summary>
+	size_t stride;
+
+	///<summary>The layout of <see cref="pixels"/>.</summary>
+	BarCodePixelFormat format;
+
+	///<summary>The first byte of the chroma plane of a <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/> image, or NULL if it directly follows the
+	///<see cref="height"/> rows of the luma plane. Not used by the other formats.</summary>
+	const uint8_t* chroma;
+} BarCodeImage;
+
+///<summary>Describes an image whose planes follow each other.</summary>
+///<param name="stride">The number of bytes from the start of one row to the start of the next, or zero if the rows are packed.</param>
+BAR_CODE_FORCEINLINE BarCodeImage bar_code_image(const uint8_t* pixels, int width, int height, size_t stride, BarCodePixelFormat format)
+{
+	BarCodeImage image;
+	image.pixels = pixels;
+	image.width = width;
+	image.height = height;
+	image.stride = stride;
+	image.format = format;
+	image.chroma = NULL;
+	return image;
+}
+
+///<summary>Describes an image that is stored in RGBA 8-bit format, with packed rows.</summary>
+BAR_CODE_FORCEINLINE BarCodeImage bar_code_image_rgba8(const uint8_t* rgba8, int width, int height)
+{
+	return bar_code_image(rgba8, width, height, 0, BAR_CODE_PIXEL_FORMAT_RGBA8);
+}
+
+///<summary>Gets the number of bytes in one row of a <see cref="BarCodeImage"/> (of its luma plane, for <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/>).</summary>
+BAR_CODE_FORCEINLINE size_t _get_image_row_size(const BarCodeImage* image)
+{
+	switch (image->format)
+	{
+	case BAR_CODE_PIXEL_FORMAT_RGB24:
+		return (size_t)image->width * 3;
+	case BAR_CODE_PIXEL_FORMAT_YUYV:
+		return (size_t)((image->width + 1) / 2) * 4;
+	case BAR_CODE_PIXEL_FORMAT_NV12:
+		return (size_t)image->width;
+	default:
+		return (size_t)image->width * 4;
+	}
+}
+
+///<summary>Gets the smallest stride that fits the rows of a <see cref="BarCodeImage"/> (the chroma rows too, for <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/>).</summary>
+BAR_CODE_FORCEINLINE size_t _get_image_min_stride(const BarCodeImage* image)
+{
+	if (image->format == BAR_CODE_PIXEL_FORMAT_NV12)
+		return (size_t)((image->width + 1) / 2) * 2;
+	return _get_image_row_size(image);
+}
+
+///<summary>Gets the number of bytes from the start of one row of a <see cref="BarCodeImage"/> to the start of the next.</summary>
+BAR_CODE_FORCEINLINE size_t _get_image_stride(const BarCodeImage* image)
+{
+	return image->stride != 0 ? image->stride : _get_image_row_size(image);
+}
+
+///<summary>Gets the first byte of a row of a <see cref="BarCodeImage"/>.</summary>
+BAR_CODE_FORCEINLINE const uint8_t* _get_image_row(const BarCodeImage* image, int y)
+{
+	return image->pixels + ((size_t)y * _get_image_stride(image));
+}
+
+///<summary>Gets the first byte of the chroma row that belongs to a row of a <see cref="BAR_CODE_PIXEL_FORMAT_NV12"/> image, or NULL for the other formats.</summary>
+BAR_CODE_FORCEINLINE const uint8_t* _get_image_chroma_row(const BarCodeImage* image, int y)
+{
+	if (image->format != BAR_CODE_PIXEL_FORMAT_NV12)
+		return NULL;
+
+	//Packed chroma rows hold a U, V pair for each two pixels, so they are one byte longer than the luma rows if the width is odd
+	assert(image->stride == 0 || image->stride >= _get_image_min_stride(image));
+	size_t chromaStride = image->stride != 0 ? image->stride : (size_t)((image->width + 1) / 2) * 2;
+	const uint8_t* chroma = image->chroma != NULL ? image->chroma : image->pixels + ((size_t)image->height * _get_image_stride(image));
+	return chroma + ((size_t)(y / 2) * chromaStride);
+}
+
+///<summary>Clamps a converted channel to the range of a byte.</summary>
+BAR_CODE_FORCEINLINE uint8_t _clamp_channel(int value)
+{
+	return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+///<summary>Converts a BT.601 video-range YCbCr pixel to RGB with the usual 8-bit fixed-point coefficients.</summary>
+///<param name="rgb">Receives the red, green and blue channels.</param>
+///<remarks>The vector kernels compute exactly the same values, so a pixel is classified the same way whichever kernel reads it.</remarks>
+BAR_CODE_FORCEINLINE void _yuv_to_rgb(int y, int u, int v, uint8_t* rgb)
+{
+	int c = ((y - 16) * 298) + 128;
+	int d = u - 128;
+	int e = v - 128;
+	rgb[0] = _clamp_channel((c + (409 * e)) >> 8);
+	rgb[1] = _clamp_channel((c - (100 * d) - (208 * e)) >> 8);
+	rgb[2] = _clamp_channel((c + (516 * d)) >> 8);
+}
+
+///<summary>Reads the red, green and blue channels of one pixel of a row.</summary>
+///<param name="row">The first byte of the row (see <see cref="_get_image_row"/>).</param>
+///<param name="chromaRow">The first byte of the row's chroma (see <see cref="_get_image_chroma_row"/>), or NULL if the format has none.</param>
+///<param name="rgb">Receives the red, green and blue channels.</param>
+BAR_CODE_FORCEINLINE void _read_row_pixel(BarCodePixelFormat format, const uint8_t* row, const uint8_t* chromaRow, int x, uint8_t* rgb)
+{
+	switch (format)
+	{
+	case BAR_CODE_PIXEL_FORMAT_BGRA8:
+		rgb[0] = row[((size_t)x * 4) + 2];
+		rgb[1] = row[((size_t)x * 4) + 1];
+		rgb[2] = row[((size_t)x * 4) + 0];
+		break;
+	case BAR_CODE_PIXEL_FORMAT_RGB24:
+		rgb[0] = row[((size_t)x * 3) + 0];
+		rgb[1] = row[((size_t)x * 3) + 1];
+		rgb[2] = row[((size_t)x * 3) + 2];
+		break;
+	case BAR_CODE_PIXEL_FORMAT_YUYV:
+	{
+		const uint8_t* pair = row + ((size_t)(x / 2) * 4);
+		_yuv_to_rgb(pair[(x & 1) * 2], pair[1], pair[3], rgb);
+		break;
+	}
+	case BAR_CODE_PIXEL_FORMAT_NV12:
+	{
+		const uint8_t* chroma = chromaRow + ((size_t)(x / 2) * 2);
+		_yuv_to_rgb(row[x], chroma[0], chroma[1], rgb);
+		break;
+	}
+	default:
+		rgb[0] = row[((size_t)x * 4) + 0];
+		rgb[1] = row[((size_t)x * 4) + 1];
+		rgb[2] = row[((size_t)x * 4) + 2];
+		break;
+	}
+}
+
+///<summary>Reads the red, green and blue channels of one pixel of a <see cref="BarCodeImage"/>.</summary>
+///<param name="rgb">Receives the red, green and blue channels.</param>
+BAR_CODE_FORCEINLINE void _read_image_pixel(const BarCodeImage* image, int x, int y, uint8_t* rgb)
+{
+	_read_row_pixel(image->format, _get_image_row(image, y), _get_image_chroma_row(image, y), x, rgb);
+}
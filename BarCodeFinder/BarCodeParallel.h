@@ -0,0 +1,829 @@
+#pragma once
+#include "BarCode.h"
+#include "ThreadPool.h"
+
+///<summary>A horizontal band of the image whose boxes are found by one task of <see cref="find_yellow_boxes_parallel"/>.</summary>
+typedef struct _YellowBand
+{
+	///<summary>The first row of the band.</summary>
+	int top;
+
+	///<summary>The row after the last row of the band.</summary>
+	int bottom;
+
+	///<summary>The band's window of <see cref="YellowScanLine"/>s. After the band is done, it holds the lines of the band's last rows.</summary>
+	YellowScanLine* lines;
+
+	///<summary>The number of <see cref="YellowScanLine"/>s that have been allocated for <see cref="lines"/>.</summary>
+	size_t lineCapacity;
+
+	///<summary>The lines of the band's first rows, which may be adjacent to the lines of the band above.</summary>
+	YellowScanLine* pinned;
+
+	///<summary>The number of <see cref="YellowScanLine"/>s that have been allocated for <see cref="pinned"/>.</summary>
+	size_t pinnedCapacity;
+
+	///<summary>The band's <see cref="YellowBoundingBox"/>es.</summary>
+	YellowBoundingBox* boxes;
+
+	///<summary>The number of <see cref="YellowBoundingBox"/>es that have been allocated for <see cref="boxes"/>.</summary>
+	size_t boxCapacity;
+
+	///<summary>The union-find parents of the band's <see cref="boxes"/>.</summary>
+	size_t* parents;
+
+	///<summary>The number of values that have been allocated for <see cref="parents"/>.</summary>
+	size_t parentCapacity;
+
+	///<summary>The state of the band after it is done.</summary>
+	_YellowBoxBuilder builder;
+} _YellowBand;
+
+///<summary>A range of yellow box pairs that is read by one task of <see cref="find_bar_code_appearances_parallel"/>.</summary>
+typedef struct _AppearanceChunk
+{
+	///<summary>The index of the first box of the first pair.</summary>
+	size_t firstBox;
+
+	///<summary>The index after the first box of the last pair.</summary>
+	size_t lastBox;
+
+	///<summary>The <see cref="BarCodeAppearance"/>s that were found, in the same order as <see cref="find_bar_code_appearances"/> finds them.
+	///Each pair that was read stores one <see cref="BarCodeAppearance"/> per section count, next to each other.</summary>
+	BarCodeAppearance* appearances;
+
+	///<summary>The number of pairs whose <see cref="BarCodeAppearance"/>s are in <see cref="appearances"/>.</summary>
+	size_t count;
+
+	///<summary>The number of <see cref="BarCodeAppearance"/>s that fit in <see cref="appearances"/>. It grows as needed and is kept across calls.</summary>
+	size_t capacity;
+
+	///<summary>Scratch space for the partners of one box (see <see cref="_find_pair_candidates"/>). It grows as needed and is kept across calls.</summary>
+	size_t* candidates;
+
+	///<summary>The number of values that fit in <see cref="candidates"/>.</summary>
+	size_t candidateCapacity;
+
+	///<summary>True if <see cref="appearances"/> or <see cref="candidates"/> could not grow.</summary>
+	bool failed;
+
+	///<summary>True if the chunk stopped at the maximum number of pairs while it still had pairs to read.</summary>
+	bool truncated;
+} _AppearanceChunk;
+
+///<summary>Per-thread buffers for <see cref="find_appearances_of_bar_code"/>.</summary>
+typedef struct _AppearanceSortBuffer
+{
+	size_t* appearances;
+	float* matchScores;
+	size_t capacity;
+
+	///<summary>Scratch space for <see cref="find_appearances_of_bar_code_in_pool"/>.</summary>
+	float* appearanceScores;
+	size_t appearanceScoreCapacity;
+
+	///<summary>The most matches that the contexts matched by this thread needed to sort (see <see cref="_match_appearances_to_context"/>).</summary>
+	size_t requiredCapacity;
+} _AppearanceSortBuffer;
+
+///<summary>Per-thread state for <see cref="find_appearances_of_bar_code_interests_in_images"/>, which searches a whole frame on each thread.</summary>
+typedef struct _FrameWorker
+{
+	///<summary>The thread's <see cref="BarCodeFindTemporaryMemory"/>, in its own <see cref="BarCodeArena"/>. NULL for the calling thread, which uses the
+	///caller's memory, and until the first batch.</summary>
+	BarCodeFindTemporaryMemory* memory;
+
+	///<summary>The thread's copies of the <see cref="BarCodeFindContext"/>s, which receive the <see cref="BarCodeAppearance"/>s of one frame at a time.</summary>
+	BarCodeFindContext* contexts;
+
+	///<summary>The number of values that fit in <see cref="contexts"/>.</summary>
+	size_t contextCapacity;
+
+	///<summary>The appearance buffers of <see cref="contexts"/>, one after the other.</summary>
+	BarCodeAppearance* appearances;
+
+	///<summary>The number of values that fit in <see cref="appearances"/>.</summary>
+	size_t appearanceCapacity;
+
+	///<summary>The match score buffers of <see cref="contexts"/>, one after the other.</summary>
+	float* matchScores;
+
+	///<summary>The number of values that fit in <see cref="matchScores"/>.</summary>
+	size_t matchScoreCapacity;
+} _FrameWorker;
+
+///<summary>Threads, and the scratch memory that they need, for the parallel versions of the search functions.</summary>
+///<remarks>A <see cref="BarCodeFindWorkers"/> can only be used by one call at a time. The scratch memory grows as needed and is kept for later calls.</remarks>
+typedef struct BarCodeFindWorkers
+{
+	///<summary>The threads.</summary>
+	ThreadPool* pool;
+
+	///<summary>The bands of <see cref="find_yellow_boxes_parallel"/>.</summary>
+	_YellowBand* bands;
+
+	///<summary>The number of values in <see cref="bands"/>.</summary>
+	size_t bandCount;
+
+	///<summary>The chunks of <see cref="find_bar_code_appearances_parallel"/>.</summary>
+	_AppearanceChunk* chunks;
+
+	///<summary>The number of values in <see cref="chunks"/>.</summary>
+	size_t chunkCount;
+
+	///<summary>One sort buffer per thread, except the calling thread (which uses the <see cref="BarCodeFindTemporaryMemory"/>'s buffers).</summary>
+	_AppearanceSortBuffer* sortBuffers;
+
+	///<summary>One <see cref="_FrameWorker"/> per thread, for <see cref="find_appearances_of_bar_code_interests_in_images"/>.</summary>
+	_FrameWorker* frameWorkers;
+} BarCodeFindWorkers;
+
+static void _free_frame_worker(_FrameWorker* worker)
+{
+	if (worker->memory != NULL)
+		free_bar_code_find_temporary_memory(worker->memory);
+	free(worker->contexts);
+	free(worker->appearances);
+	free(worker->matchScores);
+	memset(worker, 0, sizeof(_FrameWorker));
+}
+
+///<summary>Creates a <see cref="BarCodeFindWorkers"/>.</summary>
+///<param name="threadCount">The number of threads, including the calling thread. Zero or less selects the number of logical processors.</param>
+///<returns>The new <see cref="BarCodeFindWorkers"/>, or NULL if it could not be created. Destroy it with <see cref="destroy_bar_code_find_workers"/>.</returns>
+static BarCodeFindWorkers* create_bar_code_find_workers(int threadCount)
+{
+	BarCodeFindWorkers* workers = (BarCodeFindWorkers*)calloc(1, sizeof(BarCodeFindWorkers));
+	if (workers == NULL)
+		return NULL;
+
+	workers->pool = create_thread_pool(threadCount);
+	if (workers->pool != NULL)
+	{
+		int size = get_thread_pool_size(workers->pool);
+		workers->bandCount = (size_t)size;
+		workers->bands = (_YellowBand*)calloc(workers->bandCount, sizeof(_YellowBand));
+		workers->chunkCount = (size_t)size * 16;//Many chunks per thread, since the pairs of some boxes take much longer to read than others, so idle threads have something to steal
+		workers->chunks = (_AppearanceChunk*)calloc(workers->chunkCount, sizeof(_AppearanceChunk));
+		workers->sortBuffers = (_AppearanceSortBuffer*)calloc((size_t)size, sizeof(_AppearanceSortBuffer));
+		workers->frameWorkers = (_FrameWorker*)calloc((size_t)size, sizeof(_FrameWorker));
+	}
+
+	if (workers->pool == NULL || workers->bands == NULL || workers->chunks == NULL || workers->sortBuffers == NULL || workers->frameWorkers == NULL)
+	{
+		destroy_thread_pool(workers->pool);
+		free(workers->bands);
+		free(workers->chunks);
+		free(workers->sortBuffers);
+		free(workers->frameWorkers);
+		free(workers);
+		return NULL;
+	}
+	return workers;
+}
+
+///<summary>Stops the threads of a <see cref="BarCodeFindWorkers"/> and frees it.</summary>
+static void destroy_bar_code_find_workers(BarCodeFindWorkers* workers)
+{
+	if (workers == NULL)
+		return;
+
+	for (size_t i = 0; i < workers->bandCount; i++)
+	{
+		free(workers->bands[i].lines);
+		free(workers->bands[i].pinned);
+		free(workers->bands[i].boxes);
+		free(workers->bands[i].parents);
+	}
+	for (size_t i = 0; i < workers->chunkCount; i++)
+	{
+		free(workers->chunks[i].appearances);
+		free(workers->chunks[i].candidates);
+	}
+	for (int i = 0; i < get_thread_pool_size(workers->pool); i++)
+	{
+		free(workers->sortBuffers[i].appearances);
+		free(workers->sortBuffers[i].matchScores);
+		free(workers->sortBuffers[i].appearanceScores);
+		_free_frame_worker(&workers->frameWorkers[i]);
+	}
+
+	destroy_thread_pool(workers->pool);
+	free(workers->bands);
+	free(workers->chunks);
+	free(workers->sortBuffers);
+	free(workers->frameWorkers);
+	free(workers);
+}
+
+///<summary>The arguments of <see cref="_find_band_boxes"/>.</summary>
+typedef struct _YellowBandJob
+{
+	_YellowBand* bands;
+	const BarCodeImage* image;
+	YellowConfig cfg;
+	int maxSpacing;
+	size_t lineCapacity;
+	size_t maxCount;
+} _YellowBandJob;
+
+static void _find_band_boxes(void* arg, size_t index, int workerIndex)
+{
+	_YellowBandJob* job = (_YellowBandJob*)arg;
+	_YellowBand* band = &job->bands[index];
+	(void)workerIndex;
+
+	_YellowBoxBuilder* builder = &band->builder;
+	_init_yellow_box_builder(builder, band->lines, job->lineCapacity, band->parents, band->boxes, job->maxCount);
+	if (index > 0)
+	{
+		//Keep the lines that may be adjacent to the lines of the band above
+		builder->pinned = band->pinned;
+		builder->pinnedCapacity = job->lineCapacity;
+		builder->pinnedBottom = band->top + job->maxSpacing + 1;
+	}
+
+	_build_yellow_boxes(builder, job->image, 0, job->image->width, band->top, band->bottom, job->cfg, job->maxSpacing);
+	_compact_boxes(builder);
+}
+
+///<summary>Joins the boxes of the lines at the bottom of one band to the boxes of the adjacent lines at the top of the next band.</summary>
+///<param name="merger">A <see cref="_YellowBoxBuilder"/> over the boxes of all bands.</param>
+///<param name="above">The lines at the bottom of the band above, sorted by row and then by x-coordinate.</param>
+///<param name="aboveBoxOffset">The index of the first box of the band above in <paramref name="merger"/>.</param>
+///<param name="below">The lines at the top of the band below, sorted by row and then by x-coordinate.</param>
+///<param name="belowBoxOffset">The index of the first box of the band below in <paramref name="merger"/>.</param>
+static void _merge_band_seam(_YellowBoxBuilder* merger, const YellowScanLine* above, size_t aboveCount, size_t aboveBoxOffset, const YellowScanLine* below, size_t belowCount, size_t belowBoxOffset, int maxSpacing)
+{
+	for (size_t belowStart = 0, belowEnd; belowStart < belowCount; belowStart = belowEnd)
+	{
+		int belowY = below[belowStart].y;
+		for (belowEnd = belowStart + 1; belowEnd < belowCount && below[belowEnd].y == belowY; belowEnd++);
+
+		for (size_t aboveStart = 0, aboveEnd; aboveStart < aboveCount; aboveStart = aboveEnd)
+		{
+			int aboveY = above[aboveStart].y;
+			for (aboveEnd = aboveStart + 1; aboveEnd < aboveCount && above[aboveEnd].y == aboveY; aboveEnd++);
+			if (belowY - aboveY > maxSpacing + 1)
+				continue;//Too far apart to be adjacent
+
+			//Both rows are sorted, so sweep through them together (like _build_yellow_boxes)
+			size_t first = aboveStart;
+			for (size_t i = belowStart; i < belowEnd; i++)
+			{
+				while (first < aboveEnd && above[first].end + maxSpacing < below[i].start)
+					first++;
+
+				for (size_t j = first; j < aboveEnd && above[j].start - maxSpacing <= below[i].end; j++)
+				{
+					if (_are_lines_adjacent(above[j], below[i], maxSpacing))
+						_merge_boxes(merger, aboveBoxOffset + (size_t)above[j]._parent, belowBoxOffset + (size_t)below[i]._parent);
+				}
+			}
+		}
+	}
+}
+
+///<summary>Finds <see cref="YellowBoundingBox"/>es like <see cref="find_yellow_boxes_parallel"/>, and adds how much of the buffers it needed to
+///<paramref name="usage"/> (if not NULL). Each band needs its own window of lines, and the boxes of all bands must fit at once before the seams are joined.</summary>
+static size_t _find_yellow_boxes_parallel(BarCodeFindWorkers* workers, const BarCodeImage* image, YellowConfig cfg, int maxSpacing, YellowScanLine* lineBuffer, size_t lineBufferCapacity, size_t* boxParents, YellowBoundingBox* dst, size_t maxCount, _YellowBoxUsage* usage)
+{
+	assert(maxCount <= INT_MAX);
+	int height = image->height;
+
+	//Each band must be at least (maxSpacing + 1) rows high, so that lines are only ever adjacent to lines of the same or the next band
+	size_t bandCount = workers->bandCount;
+	int minBandHeight = maxSpacing + 1;
+	if ((size_t)(height / minBandHeight) < bandCount)
+		bandCount = (size_t)(height / minBandHeight);
+	if (bandCount <= 1)
+		return _find_yellow_boxes_in_window(image, 0, 0, image->width, height, cfg, maxSpacing, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount, usage, NULL);
+
+	for (size_t i = 0; i < bandCount; i++)
+	{
+		_YellowBand* band = &workers->bands[i];
+		band->top = (int)(((int64_t)height * (int64_t)i) / (int64_t)bandCount);
+		band->bottom = (int)(((int64_t)height * (int64_t)(i + 1)) / (int64_t)bandCount);
+
+		bool reserved = _reserve_buffer((void**)&band->lines, &band->lineCapacity, lineBufferCapacity, sizeof(YellowScanLine));
+		reserved = reserved && _reserve_buffer((void**)&band->pinned, &band->pinnedCapacity, lineBufferCapacity, sizeof(YellowScanLine));
+		reserved = reserved && _reserve_buffer((void**)&band->boxes, &band->boxCapacity, maxCount, sizeof(YellowBoundingBox));
+		reserved = reserved && _reserve_buffer((void**)&band->parents, &band->parentCapacity, maxCount, sizeof(size_t));
+		if (!reserved)
+			return _find_yellow_boxes_in_window(image, 0, 0, image->width, height, cfg, maxSpacing, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount, usage, NULL);
+	}
+
+	_YellowBandJob job;
+	job.bands = workers->bands;
+	job.image = image;
+	job.cfg = cfg;
+	job.maxSpacing = maxSpacing;
+	job.lineCapacity = lineBufferCapacity;//Use exactly the caller's capacities, even if the buffers are bigger from an earlier call
+	job.maxCount = maxCount;
+	parallel_for(workers->pool, bandCount, _find_band_boxes, &job);
+
+	//Gather the boxes of all bands, in order
+	_YellowBoxUsage bandUsage = { 0 };
+	size_t totalCount = 0;
+	for (size_t i = 0; i < bandCount; i++)
+	{
+		const _YellowBoxBuilder* builder = &workers->bands[i].builder;
+		if (builder->usage.linesOverflowed || builder->usage.boxesOverflowed || builder->boxCount > maxCount - totalCount)
+			return _find_yellow_boxes_in_window(image, 0, 0, image->width, height, cfg, maxSpacing, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount, usage, NULL);
+
+		memcpy(dst + totalCount, builder->boxes, builder->boxCount * sizeof(YellowBoundingBox));
+		totalCount += builder->boxCount;
+		_add_yellow_box_usage(&bandUsage, &builder->usage);
+	}
+
+	//All of the bands' boxes are held at once before the seams are joined
+	if (usage != NULL)
+	{
+		if (totalCount > bandUsage.boxCount)
+			bandUsage.boxCount = totalCount;
+		_add_yellow_box_usage(usage, &bandUsage);
+	}
+
+	//Join the groups that cross the seams. The band above always has the lower box indices, so the merged boxes keep the same order as the
+	//first lines of their groups, just like in find_yellow_boxes.
+	_YellowBoxBuilder merger;
+	_init_yellow_box_builder(&merger, NULL, 0, boxParents, dst, maxCount);
+	merger.boxCount = totalCount;
+	for (size_t i = 0; i < totalCount; i++)
+		boxParents[i] = i;
+
+	size_t boxOffset = 0;
+	for (size_t i = 0; i + 1 < bandCount; i++)
+	{
+		const _YellowBoxBuilder* above = &workers->bands[i].builder;
+		const _YellowBoxBuilder* below = &workers->bands[i + 1].builder;
+		_merge_band_seam(&merger, above->runs + above->windowStart, above->writePosition - above->windowStart, boxOffset,
+			below->pinned, below->pinnedCount, boxOffset + above->boxCount, maxSpacing);
+		boxOffset += above->boxCount;
+	}
+
+	_compact_boxes(&merger);
+	return merger.boxCount;
+}
+
+///<summary>Finds <see cref="YellowBoundingBox"/>es like <see cref="find_yellow_boxes"/>, but splits the image into horizontal bands that are processed in parallel.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads and the memory for each band.</param>
+///<param name="image">The <see cref="BarCodeImage"/>, in any <see cref="BarCodePixelFormat"/>.</param>
+///<remarks>The other parameters and the result are the same as those of <see cref="find_yellow_boxes"/>. Each band gets its own window of
+///<paramref name="lineBufferCapacity"/> lines and room for <paramref name="maxCount"/> boxes. The groups that cross the seams between bands are
+///then joined, so the result is exactly the same as that of <see cref="find_yellow_boxes"/> (which never runs out of room when this does not).
+///If any band runs out of room, or there is not enough memory for the bands, this falls back to <see cref="find_yellow_boxes"/>, so that the
+///<see cref="YellowBoundingBox"/>es are also dropped in the same way.</remarks>
+size_t find_yellow_boxes_parallel(BarCodeFindWorkers* workers, const BarCodeImage* image, YellowConfig cfg, int maxSpacing, YellowScanLine* lineBuffer, size_t lineBufferCapacity, size_t* boxParents, YellowBoundingBox* dst, size_t maxCount)
+{
+	return _find_yellow_boxes_parallel(workers, image, cfg, maxSpacing, lineBuffer, lineBufferCapacity, boxParents, dst, maxCount, NULL);
+}
+
+///<summary>The arguments of <see cref="_find_chunk_appearances"/>.</summary>
+typedef struct _AppearanceChunkJob
+{
+	_AppearanceChunk* chunks;
+	const BarCodeImage* image;
+	YellowConfig yellowCfg;
+	const YellowBoundingBox* yellowBoxes;
+	size_t yellowBoxCount;
+	const int* sectionCounts;
+	int sectionCountCount;
+	BarCodePairingConfig pairing;
+	const YellowBoxIndex* index;
+	size_t maxCount;
+} _AppearanceChunkJob;
+
+static void _find_chunk_appearances(void* arg, size_t index, int workerIndex)
+{
+	_AppearanceChunkJob* job = (_AppearanceChunkJob*)arg;
+	_AppearanceChunk* chunk = &job->chunks[index];
+	(void)workerIndex;
+
+	chunk->count = 0;
+	chunk->failed = false;
+	chunk->truncated = false;
+	if (job->index != NULL && !_reserve_buffer((void**)&chunk->candidates, &chunk->candidateCapacity, job->yellowBoxCount, sizeof(size_t)))
+	{
+		chunk->failed = true;
+		return;
+	}
+
+	for (size_t i = chunk->firstBox; i < chunk->lastBox; i++)
+	{
+		size_t partnerCount = job->index != NULL ? _find_pair_candidates(job->index, job->yellowBoxes, i, chunk->candidates) : job->yellowBoxCount - 1 - i;
+		for (size_t p = 0; p < partnerCount; p++)
+		{
+			size_t j = job->index != NULL ? chunk->candidates[p] : i + 1 + p;
+			if (job->index == NULL && !_is_pair_within_distance(job->pairing, job->yellowBoxes[i], job->yellowBoxes[j]))
+				continue;
+
+			if (chunk->count == job->maxCount)
+			{
+				//The chunks before this one can only add to the front, so nothing after this appearance can be kept
+				chunk->truncated = true;
+				return;
+			}
+
+			size_t appearanceCount = (size_t)job->sectionCountCount;
+			if ((chunk->count + 1) * appearanceCount > chunk->capacity)
+			{
+				size_t grownCapacity = chunk->capacity < 64 ? 64 : chunk->capacity * 2;
+				if (grownCapacity < (chunk->count + 1) * appearanceCount)
+					grownCapacity = (chunk->count + 1) * appearanceCount;
+				if (grownCapacity > job->maxCount * appearanceCount)
+					grownCapacity = job->maxCount * appearanceCount;
+				if (!_reserve_buffer((void**)&chunk->appearances, &chunk->capacity, grownCapacity, sizeof(BarCodeAppearance)))
+				{
+					chunk->failed = true;
+					return;
+				}
+			}
+
+			if (!_try_read_bar_code_appearances_between(job->image, job->yellowCfg, job->yellowBoxes[i], job->yellowBoxes[j], job->sectionCounts, job->sectionCountCount, chunk->appearances + (chunk->count * appearanceCount)))
+				continue;
+
+			chunk->count++;
+		}
+	}
+}
+
+///<summary>Reads the pairs of <see cref="YellowBoundingBox"/>es in parallel for <see cref="find_bar_code_appearances_for_section_counts_parallel"/> and
+///<see cref="find_bar_code_appearances_in_pool_parallel"/>, storing the <see cref="BarCodeAppearance"/>s in <paramref name="dst"/> or, if it is NULL, in <paramref name="pool"/>.</summary>
+///<param name="overflowed">If not NULL, set when lines had to be dropped because <paramref name="maxCount"/> lines had already been stored.</param>
+static size_t _find_bar_code_appearances_parallel(BarCodeFindWorkers* workers, const BarCodeImage* image, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, const int* sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearance* dst, BarCodeAppearancePool* pool, size_t maxCount, bool* overflowed)
+{
+	if (maxCount == 0 || yellowBoxCount < 2)
+		return 0;
+
+	//The index is built once, here, and only read by the chunks
+	bool indexed = _prepare_pair_index(index, yellowBoxes, yellowBoxCount, pairing);
+
+	//Split the pairs into chunks of consecutive first boxes, with roughly the same number of pairs per chunk. With an index, each box
+	//has about the same number of partners, so the chunks get about the same number of boxes instead.
+	size_t maxChunkCount = workers->chunkCount;
+	size_t totalWeight = indexed ? yellowBoxCount - 1 : yellowBoxCount * (yellowBoxCount - 1) / 2;
+	size_t weightPerChunk = (totalWeight + maxChunkCount - 1) / maxChunkCount;
+	size_t chunkCount = 0;
+	for (size_t firstBox = 0; firstBox < yellowBoxCount - 1; chunkCount++)
+	{
+		size_t lastBox = firstBox, weight = 0;
+		while (lastBox < yellowBoxCount - 1 && (weight < weightPerChunk || chunkCount + 1 == maxChunkCount))
+		{
+			weight += indexed ? 1 : yellowBoxCount - 1 - lastBox;
+			lastBox++;
+		}
+
+		workers->chunks[chunkCount].firstBox = firstBox;
+		workers->chunks[chunkCount].lastBox = lastBox;
+		firstBox = lastBox;
+	}
+
+	_AppearanceChunkJob job;
+	job.chunks = workers->chunks;
+	job.image = image;
+	job.yellowCfg = yellowCfg;
+	job.yellowBoxes = yellowBoxes;
+	job.yellowBoxCount = yellowBoxCount;
+	job.sectionCounts = sectionCounts;
+	job.sectionCountCount = sectionCountCount;
+	job.pairing = pairing;
+	job.index = indexed ? index : NULL;
+	job.maxCount = maxCount;
+	parallel_for(workers->pool, chunkCount, _find_chunk_appearances, &job);
+
+	//Concatenate the chunks in order, moving each section count's BarCodeAppearances to its own block
+	size_t count = 0, i = 0;
+	for (; i < chunkCount && count < maxCount; i++)
+	{
+		const _AppearanceChunk* chunk = &workers->chunks[i];
+		if (chunk->failed)
+		{
+			if (pool != NULL)
+				pool->count = 0;
+			return _find_bar_code_appearances(image, yellowCfg, yellowBoxes, yellowBoxCount, sectionCounts, sectionCountCount, pairing, index, dst, pool, maxCount, overflowed, NULL);
+		}
+
+		size_t copyCount = chunk->count < maxCount - count ? chunk->count : maxCount - count;
+		if (overflowed != NULL && (chunk->truncated || copyCount < chunk->count))
+			*overflowed = true;
+		if (pool != NULL)
+		{
+			for (size_t pair = 0; pair < copyCount; pair++)
+			{
+				if (!_add_pool_appearances(pool, chunk->appearances + (pair * (size_t)sectionCountCount), maxCount))
+					return count + pair;
+			}
+		}
+		else if (sectionCountCount == 1)
+		{
+			memcpy(dst + count, chunk->appearances, copyCount * sizeof(BarCodeAppearance));
+		}
+		else
+		{
+			for (size_t pair = 0; pair < copyCount; pair++)
+			{
+				for (int k = 0; k < sectionCountCount; k++)
+					dst[((size_t)k * maxCount) + count + pair] = chunk->appearances[(pair * (size_t)sectionCountCount) + (size_t)k];
+			}
+		}
+		count += copyCount;
+	}
+
+	//The chunks after the last one that fit were read for nothing
+	for (; i < chunkCount && overflowed != NULL; i++)
+	{
+		if (workers->chunks[i].count > 0 || workers->chunks[i].truncated)
+			*overflowed = true;
+	}
+	return count;
+}
+
+///<summary>Finds <see cref="BarCodeAppearance"/>s like <see cref="find_bar_code_appearances_for_section_counts"/>, but reads the pairs of boxes in parallel.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads and the memory for each chunk of pairs.</param>
+///<remarks>The other parameters and the result are the same as those of <see cref="find_bar_code_appearances_for_section_counts"/>, including the order
+///of the <see cref="BarCodeAppearance"/>s and which of them are kept when <paramref name="dst"/> is full.</remarks>
+size_t find_bar_code_appearances_for_section_counts_parallel(BarCodeFindWorkers* workers, const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, const int* sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearance* dst, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	return _find_bar_code_appearances_parallel(workers, &image, yellowCfg, yellowBoxes, yellowBoxCount, sectionCounts, sectionCountCount, pairing, index, dst, NULL, maxCount, NULL);
+}
+
+///<summary>Finds <see cref="BarCodeAppearance"/>s like <see cref="find_bar_code_appearances_in_pool"/>, but reads the pairs of boxes in parallel.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads and the memory for each chunk of pairs.</param>
+///<remarks>The other parameters and the result are the same as those of <see cref="find_bar_code_appearances_in_pool"/>.</remarks>
+size_t find_bar_code_appearances_in_pool_parallel(BarCodeFindWorkers* workers, const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, const int* sectionCounts, int sectionCountCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearancePool* pool, size_t maxCount)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	if (!_reset_bar_code_appearance_pool(pool, sectionCounts, sectionCountCount))
+		return 0;
+	return _find_bar_code_appearances_parallel(workers, &image, yellowCfg, yellowBoxes, yellowBoxCount, sectionCounts, sectionCountCount, pairing, index, NULL, pool, maxCount, NULL);
+}
+
+///<summary>Finds <see cref="BarCodeAppearance"/>s like <see cref="find_bar_code_appearances"/>, but reads the pairs of boxes in parallel.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads and the memory for each chunk of pairs.</param>
+///<remarks>The other parameters and the result are the same as those of <see cref="find_bar_code_appearances"/>, including the order of the
+///<see cref="BarCodeAppearance"/>s and which of them are kept when <paramref name="dst"/> is full.</remarks>
+size_t find_bar_code_appearances_parallel(BarCodeFindWorkers* workers, const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, const YellowBoundingBox* yellowBoxes, size_t yellowBoxCount, int sectionCount, BarCodePairingConfig pairing, YellowBoxIndex* index, BarCodeAppearance* dst, size_t maxCount)
+{
+	return find_bar_code_appearances_for_section_counts_parallel(workers, rgba8, width, height, yellowCfg, yellowBoxes, yellowBoxCount, &sectionCount, 1, pairing, index, dst, maxCount);
+}
+
+///<summary>The arguments of <see cref="_match_context"/>.</summary>
+typedef struct _ContextMatchJob
+{
+	BarCodeFindWorkers* workers;
+	BarCodeFindContext* contexts;
+	const BarCodeAppearancePool* appearances;
+	BarCodeFindTemporaryMemory* memory;
+} _ContextMatchJob;
+
+static void _match_context(void* arg, size_t index, int workerIndex)
+{
+	_ContextMatchJob* job = (_ContextMatchJob*)arg;
+	_AppearanceSortBuffer* buffer = &job->workers->sortBuffers[workerIndex];
+	size_t required;
+	if (workerIndex == 0)
+		required = _match_appearances_to_context(&job->contexts[index], job->appearances, job->appearances->scores, job->memory->appearanceSortBuffer, job->memory->appearanceSortMatchScoreBuffer, job->memory->appearanceSortBufferCapacity);
+	else
+		required = _match_appearances_to_context(&job->contexts[index], job->appearances, buffer->appearanceScores, buffer->appearances, buffer->matchScores, buffer->capacity);
+
+	if (required > buffer->requiredCapacity)
+		buffer->requiredCapacity = required;
+}
+
+///<summary>Searches for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s, like
+///<see cref="find_appearances_of_bar_code_interests_in_image"/>, but spreads each stage across the threads of <paramref name="workers"/>.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads.</param>
+///<remarks>The other parameters are the same as those of <see cref="find_appearances_of_bar_code_interests_in_image"/>, and so are the results.
+///See <see cref="find_yellow_boxes_parallel"/> and <see cref="find_bar_code_appearances_for_section_counts_parallel"/>. The <see cref="BarCodeFindContext"/>s are matched
+///in parallel too, each thread using its own sort buffers of the same capacity as those of <paramref name="memory"/>.</remarks>
+void find_appearances_of_bar_code_interests_in_image_parallel(const BarCodeImage* image, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory, BarCodeFindWorkers* workers)
+{
+	if (contextCount == 0)
+		return;//Nothing to do
+
+	int sectionCounts[BAR_CODE_MAX_COLOR_COUNT];
+	int sectionCountCount = _get_section_counts(contexts, contextCount, sectionCounts);
+	_begin_bar_code_find_usage(memory.usage);
+
+	_YellowBoxUsage boxUsage = { 0 };
+	size_t boxCapacity = memory.yellowBoxCapacity < memory.temporaryIndexBufferCapacity ? memory.yellowBoxCapacity : memory.temporaryIndexBufferCapacity;
+	size_t boxCount = _find_yellow_boxes_parallel(workers, image, yellowCfg, maxYellowSpacing, memory.scanLines, memory.scanLineCapacity, memory.temporaryIndexBuffer, memory.yellowBoxes, boxCapacity, &boxUsage);
+	_record_yellow_box_usage(memory.usage, &boxUsage);
+
+	BarCodeAppearancePool* appearances = memory.appearances;
+	size_t appearanceCount = 0;
+	bool poolOverflowed = false;
+	if (_reset_bar_code_appearance_pool(appearances, sectionCounts, sectionCountCount))
+		appearanceCount = _find_bar_code_appearances_parallel(workers, image, yellowCfg, memory.yellowBoxes, boxCount, sectionCounts, sectionCountCount, memory.pairing, memory.boxIndex, NULL, appearances, memory.appearanceCapacity, &poolOverflowed);
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_APPEARANCES, appearances->count, poolOverflowed);
+	if (!_reserve_buffer((void**)&appearances->scores, &appearances->scoreCapacity, appearanceCount, sizeof(float)))
+		appearances->count = 0;//There is no room to score them
+
+	//Each thread other than this one needs its own sort buffers. If they cannot be allocated, match the contexts on this thread.
+	ThreadPool* pool = workers->pool;
+	for (int i = 1; i < get_thread_pool_size(workers->pool) && pool != NULL; i++)
+	{
+		_AppearanceSortBuffer* buffer = &workers->sortBuffers[i];
+		size_t appearanceCapacity = buffer->capacity, scoreCapacity = buffer->capacity;
+		if (!_reserve_buffer((void**)&buffer->appearances, &appearanceCapacity, memory.appearanceSortBufferCapacity, sizeof(size_t)) ||
+			!_reserve_buffer((void**)&buffer->matchScores, &scoreCapacity, memory.appearanceSortBufferCapacity, sizeof(float)) ||
+			!_reserve_buffer((void**)&buffer->appearanceScores, &buffer->appearanceScoreCapacity, appearanceCount, sizeof(float)))
+		{
+			buffer->capacity = appearanceCapacity < scoreCapacity ? appearanceCapacity : scoreCapacity;
+			pool = NULL;
+		}
+		else
+		{
+			buffer->capacity = memory.appearanceSortBufferCapacity;
+		}
+	}
+
+	_ContextMatchJob job;
+	job.workers = workers;
+	job.contexts = contexts;
+	job.appearances = appearances;
+	job.memory = &memory;
+	for (int i = 0; i < get_thread_pool_size(workers->pool); i++)
+		workers->sortBuffers[i].requiredCapacity = 0;
+	parallel_for(pool, contextCount, _match_context, &job);
+
+	size_t sortCount = 0;
+	for (int i = 0; i < get_thread_pool_size(workers->pool); i++)
+		sortCount = workers->sortBuffers[i].requiredCapacity > sortCount ? workers->sortBuffers[i].requiredCapacity : sortCount;
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_MATCHES, sortCount, sortCount > memory.appearanceSortBufferCapacity);
+}
+
+///<summary>Searches for <see cref="BarCodeAppearance"/>s like <see cref="find_appearances_of_bar_code_interests_in_image_parallel"/>, in a bitmap that is stored in RGBA 8-bit format.</summary>
+void find_appearances_of_bar_code_interests_in_bitmap_parallel(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory, BarCodeFindWorkers* workers)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	find_appearances_of_bar_code_interests_in_image_parallel(&image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory, workers);
+}
+
+///<summary>A <see cref="BarCodeAppearance"/> that was found by <see cref="find_appearances_of_bar_code_interests_in_images"/>, reduced to its geometry
+///and match score so that a whole batch of them can be copied out at once.</summary>
+typedef struct BarCodeFrameMatch
+{
+	///<summary>Where the 'color line' begins and ends (see <see cref="BarCodeAppearance.colorStartX"/>).</summary>
+	int colorStartX, colorStartY, colorEndX, colorEndY;
+
+	///<summary>The bounds of the <see cref="YellowBoundingBox"/> that contained the first 'yellow bar.'</summary>
+	int firstBoxLeft, firstBoxTop, firstBoxRight, firstBoxBottom;
+
+	///<summary>The bounds of the <see cref="YellowBoundingBox"/> that contained the second 'yellow bar.'</summary>
+	int secondBoxLeft, secondBoxTop, secondBoxRight, secondBoxBottom;
+
+	///<summary>The 'match score' of the appearance, as determined by <see cref="quantify_bar_code_appearance_match"/>.</summary>
+	float matchScore;
+} BarCodeFrameMatch;
+
+///<summary>Gets the number of <see cref="BarCodeFrameMatch"/>es that <see cref="find_appearances_of_bar_code_interests_in_images"/> reserves for each
+///frame: the sum of the <see cref="BarCodeFindContext.appearanceBufferCapacity"/> of every context.</summary>
+static size_t get_frame_match_capacity(const BarCodeFindContext* contexts, size_t contextCount)
+{
+	size_t capacity = 0;
+	for (size_t i = 0; i < contextCount; i++)
+		capacity += contexts[i].appearanceBufferCapacity;
+	return capacity;
+}
+
+///<summary>Copies the settings of the <see cref="BarCodeFindContext"/>s to a thread's own contexts, whose buffers follow each other in the same order
+///as the frame's <see cref="BarCodeFrameMatch"/>es.</summary>
+///<returns>False if the thread's buffers could not grow.</returns>
+static bool _prepare_frame_worker(_FrameWorker* worker, const BarCodeFindContext* contexts, size_t contextCount, size_t matchCapacity)
+{
+	if (!_reserve_buffer((void**)&worker->contexts, &worker->contextCapacity, contextCount, sizeof(BarCodeFindContext)) ||
+		!_reserve_buffer((void**)&worker->appearances, &worker->appearanceCapacity, matchCapacity, sizeof(BarCodeAppearance)) ||
+		!_reserve_buffer((void**)&worker->matchScores, &worker->matchScoreCapacity, matchCapacity, sizeof(float)))
+		return false;
+
+	size_t offset = 0;
+	for (size_t i = 0; i < contextCount; i++)
+	{
+		BarCodeFindContext* context = &worker->contexts[i];
+		memset(context, 0, sizeof(BarCodeFindContext));
+		context->barCode = contexts[i].barCode;
+		context->minMatchScore = contexts[i].minMatchScore;
+		context->minLineDistance = contexts[i].minLineDistance;
+		context->appearanceBufferCapacity = contexts[i].appearanceBufferCapacity;
+		context->appearanceBuffer = worker->appearances + offset;
+		context->appearanceMatchScores = worker->matchScores + offset;
+		offset += contexts[i].appearanceBufferCapacity;
+	}
+	return true;
+}
+
+///<summary>Makes sure that a thread other than the calling thread has its own <see cref="BarCodeFindTemporaryMemory"/>, with the settings of the caller's.</summary>
+///<returns>False if the memory could not be allocated.</returns>
+static bool _prepare_frame_worker_memory(_FrameWorker* worker, const BarCodeFindTemporaryMemory* memory)
+{
+	if (worker->memory == NULL)
+	{
+		//Start at the caller's capacities, so the threads do not all overflow (and grow) on the first frames
+		int arenaFlags = memory->arena != NULL ? memory->arena->flags : BAR_CODE_ARENA_DEFAULT;
+		worker->memory = allocate_bar_code_find_temporary_memory(memory->scanLineCapacity, memory->yellowBoxCapacity, memory->temporaryIndexBufferCapacity,
+			memory->appearanceCapacity, memory->appearanceSortBufferCapacity, arenaFlags);
+		if (worker->memory == NULL)
+			return false;
+	}
+
+	worker->memory->pairing = memory->pairing;
+	for (int i = 0; i < BAR_CODE_FIND_STAGE_COUNT; i++)
+		worker->memory->maxCapacities[i] = memory->maxCapacities[i];
+	return true;
+}
+
+///<summary>The arguments of <see cref="_search_batch_frame"/>.</summary>
+typedef struct _FrameJob
+{
+	_FrameWorker* frameWorkers;
+	const BarCodeImage* images;
+	YellowConfig yellowCfg;
+	int maxYellowSpacing;
+	size_t contextCount;
+	BarCodeFindTemporaryMemory* memory;
+	BarCodeFrameMatch* matches;
+	size_t* matchCounts;
+	size_t matchCapacity;
+} _FrameJob;
+
+static void _search_batch_frame(void* arg, size_t index, int workerIndex)
+{
+	_FrameJob* job = (_FrameJob*)arg;
+	_FrameWorker* worker = &job->frameWorkers[workerIndex];
+	BarCodeFindTemporaryMemory* memory = workerIndex == 0 ? job->memory : worker->memory;
+	find_appearances_of_bar_code_interests_in_image(&job->images[index], job->yellowCfg, job->maxYellowSpacing, worker->contexts, job->contextCount, *memory);
+	grow_bar_code_find_temporary_memory(memory);//Only this thread uses it, so it can grow between frames
+
+	for (size_t c = 0; c < job->contextCount; c++)
+	{
+		const BarCodeFindContext* context = &worker->contexts[c];
+		BarCodeFrameMatch* dst = job->matches + (index * job->matchCapacity) + (size_t)(context->appearanceBuffer - worker->appearances);
+		for (size_t i = 0; i < context->appearanceCount; i++)
+		{
+			const BarCodeAppearance* appearance = &context->appearanceBuffer[i];
+			dst[i].colorStartX = appearance->colorStartX;
+			dst[i].colorStartY = appearance->colorStartY;
+			dst[i].colorEndX = appearance->colorEndX;
+			dst[i].colorEndY = appearance->colorEndY;
+			dst[i].firstBoxLeft = appearance->_firstBox.left;
+			dst[i].firstBoxTop = appearance->_firstBox.top;
+			dst[i].firstBoxRight = appearance->_firstBox.right;
+			dst[i].firstBoxBottom = appearance->_firstBox.bottom;
+			dst[i].secondBoxLeft = appearance->_secondBox.left;
+			dst[i].secondBoxTop = appearance->_secondBox.top;
+			dst[i].secondBoxRight = appearance->_secondBox.right;
+			dst[i].secondBoxBottom = appearance->_secondBox.bottom;
+			dst[i].matchScore = context->appearanceMatchScores[i];
+		}
+		job->matchCounts[(index * job->contextCount) + c] = context->appearanceCount;
+	}
+}
+
+///<summary>Searches a batch of images (such as the frames of several cameras) for <see cref="BarCodeAppearance"/>s, searching each image on one thread of
+///<paramref name="workers"/>, like <see cref="find_appearances_of_bar_code_interests_in_image"/>.</summary>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that provide the threads. Each thread other than the calling thread keeps its own
+///<see cref="BarCodeFindTemporaryMemory"/>, in its own <see cref="BarCodeArena"/>, for later batches. If NULL, every image is searched on the calling thread.</param>
+///<param name="contexts">The <see cref="BarCode"/>s to find, with their <see cref="BarCodeFindContext.minMatchScore"/>, <see cref="BarCodeFindContext.minLineDistance"/>
+///and <see cref="BarCodeFindContext.appearanceBufferCapacity"/>. They are only read: each thread searches with its own copies, so their buffers are not used.</param>
+///<param name="memory">The <see cref="BarCodeFindTemporaryMemory"/> of the calling thread. The other threads' memories start at its capacities, and
+///use its <see cref="BarCodeFindTemporaryMemory.pairing"/> and <see cref="BarCodeFindTemporaryMemory.maxCapacities"/>. Every memory grows
+///(see <see cref="grow_bar_code_find_temporary_memory"/>) after each image that overflowed it, so only the first images of a batch may be missing appearances.</param>
+///<param name="matches">Receives the <see cref="BarCodeFrameMatch"/>es: <see cref="get_frame_match_capacity"/> values per image, in which each context has
+///<see cref="BarCodeFindContext.appearanceBufferCapacity"/> values, in the order of the contexts. The matches of each context are sorted by descending match score.</param>
+///<param name="matchCounts">Receives the number of matches of each context in each image, at index (image * contextCount) + context.</param>
+///<returns>False if the calling thread's copies of the contexts could not be allocated, in which case nothing was searched.</returns>
+///<remarks>The results of each image are the same as those of <see cref="find_appearances_of_bar_code_interests_in_image"/> with memory of the same
+///capacities. If a thread's memory cannot be allocated, every image is searched on the calling thread.</remarks>
+bool find_appearances_of_bar_code_interests_in_images(BarCodeFindWorkers* workers, const BarCodeImage* images, size_t imageCount, YellowConfig yellowCfg, int maxYellowSpacing, const BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFrameMatch* matches, size_t* matchCounts)
+{
+	_FrameWorker callerWorker = { 0 };
+	_FrameJob job;
+	job.frameWorkers = workers != NULL ? workers->frameWorkers : &callerWorker;
+	job.images = images;
+	job.yellowCfg = yellowCfg;
+	job.maxYellowSpacing = maxYellowSpacing;
+	job.contextCount = contextCount;
+	job.memory = memory;
+	job.matches = matches;
+	job.matchCounts = matchCounts;
+	job.matchCapacity = get_frame_match_capacity(contexts, contextCount);
+
+	bool prepared = _prepare_frame_worker(&job.frameWorkers[0], contexts, contextCount, job.matchCapacity);
+	if (prepared)
+	{
+		//Each thread other than this one needs its own memory and contexts. If they cannot be allocated, search every image on this thread.
+		ThreadPool* pool = workers != NULL ? workers->pool : NULL;
+		for (int i = 1; i < get_thread_pool_size(pool) && pool != NULL; i++)
+		{
+			if (!_prepare_frame_worker_memory(&job.frameWorkers[i], memory) || !_prepare_frame_worker(&job.frameWorkers[i], contexts, contextCount, job.matchCapacity))
+				pool = NULL;
+		}
+		parallel_for(pool, imageCount, _search_batch_frame, &job);
+	}
+
+	_free_frame_worker(&callerWorker);
+	return prepared;
+}
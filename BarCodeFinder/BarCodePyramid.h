@@ -0,0 +1,344 @@
+#pragma once
+#include "BarCode.h"
+
+///<summary>How much lower than a <see cref="BarCodeFindContext.minMatchScore"/> the match score of a pair of yellow bars may be in the downsampled bitmap
+///for the pair to still be read at full size by <see cref="find_appearances_of_bar_code_interests_in_bitmap_coarse"/>. The sections of a downsampled line
+///blur into each other near their ends, so their scores are a little lower.</summary>
+#define BAR_CODE_COARSE_SCORE_MARGIN (0.25f)
+
+///<summary>Scratch memory for <see cref="find_appearances_of_bar_code_interests_in_bitmap_coarse"/>. Its buffers grow as needed, so it can be
+///initialized with <see cref="init_bar_code_pyramid"/> and reused for every bitmap.</summary>
+typedef struct BarCodePyramid
+{
+	///<summary>The downsampled bitmap, stored in RGBA 8-bit format.</summary>
+	uint8_t* image;
+
+	///<summary>The number of pixels that fit in <see cref="image"/>.</summary>
+	size_t imageCapacity;
+
+	///<summary>The <see cref="YellowScanLine"/>s of the most recent rows of the downsampled bitmap (see <see cref="find_yellow_boxes"/>).</summary>
+	YellowScanLine* lines;
+
+	///<summary>The number of <see cref="YellowScanLine"/>s that fit in <see cref="lines"/>.</summary>
+	size_t lineCapacity;
+
+	///<summary>The <see cref="YellowBoundingBox"/>es that were found in the downsampled bitmap.</summary>
+	YellowBoundingBox* boxes;
+
+	///<summary>The number of values that fit in <see cref="boxes"/>.</summary>
+	size_t boxCapacity;
+
+	///<summary>The union-find parents of <see cref="boxes"/>.</summary>
+	size_t* parents;
+
+	///<summary>The number of values that fit in <see cref="parents"/>.</summary>
+	size_t parentCapacity;
+
+	///<summary>The region of each of <see cref="boxes"/>, or SIZE_MAX if it is not part of any candidate pair.</summary>
+	size_t* boxRegions;
+
+	///<summary>The number of values that fit in <see cref="boxRegions"/>.</summary>
+	size_t boxRegionCapacity;
+
+	///<summary>The candidate pairs of <see cref="boxes"/>, as two indices each. Once the regions are known, each pair is replaced by a single key
+	///(first region * region count + second region).</summary>
+	size_t* pairs;
+
+	///<summary>The number of values that fit in <see cref="pairs"/>.</summary>
+	size_t pairCapacity;
+
+	///<summary>The regions of the full bitmap around the boxes of the candidate pairs.</summary>
+	BarCodeSearchRegion* regions;
+
+	///<summary>The number of values that fit in <see cref="regions"/>.</summary>
+	size_t regionCapacity;
+
+	///<summary>The index of the first full-size <see cref="YellowBoundingBox"/> of each region, followed by the total number of boxes.</summary>
+	size_t* regionBoxStarts;
+
+	///<summary>The number of values that fit in <see cref="regionBoxStarts"/>.</summary>
+	size_t regionBoxStartCapacity;
+
+	///<summary>The <see cref="YellowBoxIndex"/> over <see cref="boxes"/>, used to find the pairs of the downsampled bitmap that the pairing allows.</summary>
+	YellowBoxIndex boxIndex;
+} BarCodePyramid;
+
+///<summary>Initializes a <see cref="BarCodePyramid"/> with no buffers.</summary>
+static void init_bar_code_pyramid(BarCodePyramid* pyramid)
+{
+	memset(pyramid, 0, sizeof(BarCodePyramid));
+}
+
+///<summary>Frees the buffers of a <see cref="BarCodePyramid"/>, but not the pyramid itself.</summary>
+static void free_bar_code_pyramid(BarCodePyramid* pyramid)
+{
+	free(pyramid->image);
+	free(pyramid->lines);
+	free(pyramid->boxes);
+	free(pyramid->parents);
+	free(pyramid->boxRegions);
+	free(pyramid->pairs);
+	free(pyramid->regions);
+	free(pyramid->regionBoxStarts);
+	free_yellow_box_index(&pyramid->boxIndex);
+	init_bar_code_pyramid(pyramid);
+}
+
+///<summary>Downsamples an RGBA 8-bit <see cref="BarCodeImage"/> into <see cref="BarCodePyramid.image"/>, making it <paramref name="scale"/> times smaller in each direction.</summary>
+///<param name="levelWidth">Receives the width of the downsampled bitmap.</param>
+///<param name="levelHeight">Receives the height of the downsampled bitmap.</param>
+///<returns>False if the downsampled bitmap would be empty or could not be allocated.</returns>
+///<remarks>Each pixel averages two rows, <paramref name="scale"/> / 2 apart, over <paramref name="scale"/> columns. The other rows are never read, which
+///saves most of the memory traffic. A yellow bar that is at least <paramref name="scale"/> pixels high still covers at least one of the rows.</remarks>
+static bool _build_bar_code_pyramid(BarCodePyramid* pyramid, const BarCodeImage* image, int scale, int* levelWidth, int* levelHeight)
+{
+	int w = image->width / 2, h = image->height / scale;
+	if (image->width / scale == 0 || h == 0)
+		return false;
+	if (!_reserve_buffer((void**)&pyramid->image, &pyramid->imageCapacity, (size_t)w * (size_t)h, 4))
+		return false;
+
+	const YellowKernels* kernels = get_yellow_kernels();
+	for (int y = 0; y < h; y++)
+	{
+		kernels->halveRows(_get_image_row(image, y * scale), _get_image_row(image, (y * scale) + (scale / 2)), w, pyramid->image + ((size_t)y * w * 4));
+	}
+
+	for (int level = 2; level < scale; level *= 2)
+	{
+		//Halve the rows horizontally only (by averaging each row with itself). Each row is written at or before the start of the row that
+		//it is read from, so this can be done in place.
+		int nextWidth = w / 2;
+		for (int y = 0; y < h; y++)
+		{
+			const uint8_t* row = pyramid->image + ((size_t)y * w * 4);
+			kernels->halveRows(row, row, nextWidth, pyramid->image + ((size_t)y * nextWidth * 4));
+		}
+		w = nextWidth;
+	}
+
+	*levelWidth = w;
+	*levelHeight = h;
+	return true;
+}
+
+///<summary>Checks whether the line between two <see cref="YellowBoundingBox"/>es of the downsampled bitmap may match any <see cref="BarCodeFindContext"/>.</summary>
+static bool _is_coarse_pair_candidate(const BarCodePyramid* pyramid, int scale, int levelWidth, int levelHeight, YellowConfig yellowCfg, YellowBoundingBox first, YellowBoundingBox second,
+	const int* sectionCounts, int sectionCountCount, const BarCodeFindContext* contexts, size_t contextCount)
+{
+	BarCodeImage levelImage = bar_code_image_rgba8(pyramid->image, levelWidth, levelHeight);
+	BarCodeAppearance appearances[BAR_CODE_MAX_COLOR_COUNT];
+	if (!_try_read_bar_code_appearances_between(&levelImage, yellowCfg, first, second, sectionCounts, sectionCountCount, appearances))
+		return false;
+
+	//The line is measured in downsampled pixels, and each of its ends may be off by up to one of them
+	int lineLength = (_get_distance(appearances[0].colorStartX, appearances[0].colorStartY, appearances[0].colorEndX, appearances[0].colorEndY) + 2) * scale;
+	for (size_t i = 0; i < contextCount; i++)
+	{
+		if (lineLength < contexts[i].minLineDistance)
+			continue;
+
+		int k = 0;
+		while (sectionCounts[k] != (int)contexts[i].barCode.colorCount)
+			k++;
+		if (quantify_bar_code_appearance_match(&contexts[i].barCode, &appearances[k]) >= contexts[i].minMatchScore - BAR_CODE_COARSE_SCORE_MARGIN)
+			return true;
+	}
+	return false;
+}
+
+///<summary>Reads the pairs of <see cref="YellowBoundingBox"/>es of the downsampled bitmap, and keeps the pairs that may match a <see cref="BarCodeFindContext"/>.</summary>
+///<returns>The number of candidate pairs, or SIZE_MAX if the memory could not be allocated.</returns>
+static size_t _find_coarse_pairs(BarCodePyramid* pyramid, int scale, int levelWidth, int levelHeight, YellowConfig yellowCfg, int maxYellowSpacing, BarCodePairingConfig pairing,
+	const int* sectionCounts, int sectionCountCount, const BarCodeFindContext* contexts, size_t contextCount, size_t maxBoxCount, size_t* boxCount)
+{
+	//The spacing shrinks with the bitmap, but is rounded up so that nothing that touches at full size is split
+	int levelSpacing = (maxYellowSpacing + scale - 1) / scale;
+	size_t lineCount = (size_t)4 * (size_t)(levelSpacing + 2) * (size_t)((levelWidth / 2) + 1);
+	if (!_reserve_buffer((void**)&pyramid->lines, &pyramid->lineCapacity, lineCount, sizeof(YellowScanLine)))
+		return SIZE_MAX;
+	if (!_reserve_buffer((void**)&pyramid->boxes, &pyramid->boxCapacity, maxBoxCount, sizeof(YellowBoundingBox)) ||
+		!_reserve_buffer((void**)&pyramid->parents, &pyramid->parentCapacity, maxBoxCount, sizeof(size_t)) ||
+		!_reserve_buffer((void**)&pyramid->boxRegions, &pyramid->boxRegionCapacity, maxBoxCount, sizeof(size_t)))
+		return SIZE_MAX;
+
+	BarCodeImage levelImage = bar_code_image_rgba8(pyramid->image, levelWidth, levelHeight);
+	size_t count = find_yellow_boxes_in_window(&levelImage, 0, 0, levelWidth, levelHeight, yellowCfg, levelSpacing, pyramid->lines, pyramid->lineCapacity, pyramid->parents, pyramid->boxes, maxBoxCount);
+	*boxCount = count;
+
+	//The distance limit shrinks with the bitmap too, but is rounded up (plus one pixel for each box) so that no pair that is allowed at full size is skipped.
+	//A downsampled box may stand for several full-size boxes, and rounding can reorder neighbors that are about as far away, so twice as many are kept.
+	BarCodePairingConfig levelPairing = pairing;
+	if (pairing.maxDistance > 0)
+		levelPairing.maxDistance = ((pairing.maxDistance + scale - 1) / scale) + 2;
+	if (pairing.maxNeighbors > 0)
+		levelPairing.maxNeighbors = pairing.maxNeighbors * 2 < BAR_CODE_MAX_PAIR_NEIGHBORS ? pairing.maxNeighbors * 2 : BAR_CODE_MAX_PAIR_NEIGHBORS;
+
+	YellowBoxIndex* index = &pyramid->boxIndex;
+	bool indexed = _prepare_pair_index(index, pyramid->boxes, count, levelPairing) && _reserve_index_buffer(&index->candidates, &index->candidateCapacity, count);
+
+	size_t pairCount = 0;
+	for (size_t i = 0; i < count; i++)
+		pyramid->boxRegions[i] = SIZE_MAX;
+	for (size_t i = 0; i + 1 < count; i++)
+	{
+		size_t partnerCount = indexed ? _find_pair_candidates(index, pyramid->boxes, i, index->candidates) : count - 1 - i;
+		for (size_t c = 0; c < partnerCount; c++)
+		{
+			size_t j = indexed ? index->candidates[c] : i + 1 + c;
+			if ((!indexed && !_is_pair_within_distance(levelPairing, pyramid->boxes[i], pyramid->boxes[j])) ||
+				!_is_coarse_pair_candidate(pyramid, scale, levelWidth, levelHeight, yellowCfg, pyramid->boxes[i], pyramid->boxes[j], sectionCounts, sectionCountCount, contexts, contextCount))
+				continue;
+
+			if (!_reserve_buffer((void**)&pyramid->pairs, &pyramid->pairCapacity, (pairCount + 1) * 2, sizeof(size_t)))
+				return SIZE_MAX;
+			pyramid->pairs[pairCount * 2] = i;
+			pyramid->pairs[(pairCount * 2) + 1] = j;
+			pyramid->boxRegions[i] = pyramid->boxRegions[j] = 0;//Only marks the boxes as used for now
+			pairCount++;
+		}
+	}
+	return pairCount;
+}
+
+///<summary>Builds the regions of the full bitmap around the boxes of the candidate pairs, and stores the region of each of those boxes.</summary>
+///<returns>The number of regions, or SIZE_MAX if the memory could not be allocated.</returns>
+static size_t _build_coarse_regions(BarCodePyramid* pyramid, int scale, int width, int height, int maxYellowSpacing, size_t boxCount)
+{
+	if (!_reserve_buffer((void**)&pyramid->regions, &pyramid->regionCapacity, boxCount, sizeof(BarCodeSearchRegion)) ||
+		!_reserve_buffer((void**)&pyramid->regionBoxStarts, &pyramid->regionBoxStartCapacity, boxCount + 1, sizeof(size_t)))
+		return SIZE_MAX;
+
+	//A pixel of the downsampled bitmap covers 'scale' pixels of the full one, and the edge of a yellow bar may only be yellow at full size
+	int margin = scale + maxYellowSpacing;
+	size_t count = 0;
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		if (pyramid->boxRegions[i] == SIZE_MAX)
+			continue;
+
+		YellowBoundingBox box = pyramid->boxes[i];
+		BarCodeSearchRegion region;
+		region.left = (box.left * scale) - margin < 0 ? 0 : (box.left * scale) - margin;
+		region.top = (box.top * scale) - margin < 0 ? 0 : (box.top * scale) - margin;
+		region.right = ((box.right + 1) * scale) + margin > width ? width : ((box.right + 1) * scale) + margin;
+		region.bottom = ((box.bottom + 1) * scale) + margin > height ? height : ((box.bottom + 1) * scale) + margin;
+		pyramid->regions[count++] = region;
+	}
+	count = _join_search_regions(pyramid->regions, count, maxYellowSpacing);
+
+	//Each box lies inside exactly one of the joined regions
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		if (pyramid->boxRegions[i] == SIZE_MAX)
+			continue;
+
+		int x = ((pyramid->boxes[i].left + pyramid->boxes[i].right) / 2) * scale, y = ((pyramid->boxes[i].top + pyramid->boxes[i].bottom) / 2) * scale;
+		size_t r = 0;
+		while (r + 1 < count && !(x >= pyramid->regions[r].left && x < pyramid->regions[r].right && y >= pyramid->regions[r].top && y < pyramid->regions[r].bottom))
+			r++;
+		pyramid->boxRegions[i] = r;
+	}
+	return count;
+}
+
+///<summary>Searches for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s like <see cref="find_appearances_of_bar_code_interests_in_image"/>,
+///but first finds the yellow bars, and the pairs of them that may be bar codes, in a downsampled copy of the image. Only the pixels around those yellow
+///bars are classified at full size, and only the lines between the candidate pairs are read at full size.</summary>
+///<param name="pyramid">The <see cref="BarCodePyramid"/> that holds the downsampled bitmap.</param>
+///<param name="scale">How many times smaller (in each direction) the downsampled bitmap is: 2, 4 or 8. One (or less) searches the full bitmap only.</param>
+///<remarks>The other parameters are the same as those of <see cref="find_appearances_of_bar_code_interests_in_image"/>. A pair is a candidate if its line in
+///the downsampled bitmap scores at least <see cref="BAR_CODE_COARSE_SCORE_MARGIN"/> less than the <see cref="BarCodeFindContext.minMatchScore"/> of any context.
+///Every pair of the full-size yellow boxes around a candidate pair is then read exactly like <see cref="find_appearances_of_bar_code_interests_in_image"/>
+///reads it, so each <see cref="BarCodeAppearance"/> that is found has the same line and match score. The boxes are ordered by region rather than by the
+///order of the full search, though, so the two boxes of a pair (and the ends of its line) may be swapped. A yellow bar that is not at least about <paramref name="scale"/> pixels wide
+///and high can be missed, and so can a bar code whose sections are narrower than that. <see cref="BarCodePairingConfig.maxNeighbors"/> only limits the
+///pairs of the downsampled bitmap (to twice as many neighbors), and every pair of full-size boxes around a candidate pair is read. If the
+///memory for the downsampled bitmap cannot be allocated, or the image is not stored in RGBA 8-bit format, the full image is searched instead.</remarks>
+void find_appearances_of_bar_code_interests_in_image_coarse(BarCodePyramid* pyramid, int scale, const BarCodeImage* image, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	assert(scale <= 1 || scale == 2 || scale == 4 || scale == 8);
+	if (contextCount == 0)
+		return;//Nothing to do
+
+	int sectionCounts[BAR_CODE_MAX_COLOR_COUNT];
+	int sectionCountCount = _get_section_counts(contexts, contextCount, sectionCounts);
+
+	//Find the candidate pairs in the downsampled bitmap, then the regions of the full bitmap that hold their yellow bars
+	size_t boxCapacity = memory.yellowBoxCapacity < memory.temporaryIndexBufferCapacity ? memory.yellowBoxCapacity : memory.temporaryIndexBufferCapacity;
+	int levelWidth, levelHeight;
+	size_t coarseBoxCount = 0, pairCount = SIZE_MAX, regionCount = SIZE_MAX;
+	if (scale > 1 && image->format == BAR_CODE_PIXEL_FORMAT_RGBA8 && _build_bar_code_pyramid(pyramid, image, scale, &levelWidth, &levelHeight))
+		pairCount = _find_coarse_pairs(pyramid, scale, levelWidth, levelHeight, yellowCfg, maxYellowSpacing, memory.pairing, sectionCounts, sectionCountCount, contexts, contextCount, boxCapacity, &coarseBoxCount);
+	if (pairCount != SIZE_MAX)
+		regionCount = _build_coarse_regions(pyramid, scale, image->width, image->height, maxYellowSpacing, coarseBoxCount);
+	if (regionCount == SIZE_MAX || !_reset_bar_code_appearance_pool(memory.appearances, sectionCounts, sectionCountCount))
+	{
+		find_appearances_of_bar_code_interests_in_image(image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory);
+		return;
+	}
+
+	//Find the boxes again at full size, but only inside the regions. The boxes of each region are kept after those of the previous regions.
+	_begin_bar_code_find_usage(memory.usage);
+	size_t boxCount = 0;
+	for (size_t r = 0; r < regionCount; r++)
+	{
+		BarCodeSearchRegion region = pyramid->regions[r];
+		pyramid->regionBoxStarts[r] = boxCount;
+		_YellowBoxUsage boxUsage = { 0 };
+		size_t regionBoxCount = _find_yellow_boxes_in_window(image, region.left, region.top, region.right, region.bottom, yellowCfg, maxYellowSpacing, memory.scanLines, memory.scanLineCapacity, memory.temporaryIndexBuffer, memory.yellowBoxes + boxCount, boxCapacity - boxCount, &boxUsage, NULL);
+		boxUsage.boxCount += boxCount;
+		_record_yellow_box_usage(memory.usage, &boxUsage);
+		boxCount += regionBoxCount;
+	}
+	pyramid->regionBoxStarts[regionCount] = boxCount;
+
+	//Several candidate pairs may join the same two regions, so read each pair of regions once, in order
+	for (size_t p = 0; p < pairCount; p++)
+	{
+		size_t first = pyramid->boxRegions[pyramid->pairs[p * 2]], second = pyramid->boxRegions[pyramid->pairs[(p * 2) + 1]];
+		pyramid->pairs[p] = first < second ? (first * regionCount) + second : (second * regionCount) + first;
+	}
+	qsort(pyramid->pairs, pairCount, sizeof(size_t), _compare_size_t);
+
+	BarCodeAppearancePool* pool = memory.appearances;
+	bool poolOverflowed = false;
+	for (size_t p = 0; p < pairCount && !poolOverflowed; p++)
+	{
+		if (p > 0 && pyramid->pairs[p] == pyramid->pairs[p - 1])
+			continue;
+
+		size_t firstRegion = pyramid->pairs[p] / regionCount, secondRegion = pyramid->pairs[p] % regionCount;
+		for (size_t i = pyramid->regionBoxStarts[firstRegion]; i < pyramid->regionBoxStarts[firstRegion + 1]; i++)
+		{
+			size_t j = firstRegion == secondRegion ? i + 1 : pyramid->regionBoxStarts[secondRegion];
+			for (; j < pyramid->regionBoxStarts[secondRegion + 1]; j++)
+			{
+				if (!_is_pair_within_distance(memory.pairing, memory.yellowBoxes[i], memory.yellowBoxes[j]))
+					continue;
+
+				BarCodeAppearance appearances[BAR_CODE_MAX_COLOR_COUNT];
+				if (!_try_read_bar_code_appearances_between(image, yellowCfg, memory.yellowBoxes[i], memory.yellowBoxes[j], sectionCounts, sectionCountCount, appearances))
+					continue;
+				if (pool->count == memory.appearanceCapacity)
+				{
+					poolOverflowed = true;
+					break;//The pool is full
+				}
+				if (!_add_pool_appearances(pool, appearances, memory.appearanceCapacity))
+					break;//The pool cannot grow
+			}
+		}
+	}
+	_record_bar_code_find_usage(memory.usage, BAR_CODE_FIND_STAGE_APPEARANCES, pool->count, poolOverflowed);
+
+	//Match all BarCodeAppearances to their respective BarCodeFindContext (if any)
+	_match_pool_to_contexts(contexts, contextCount, memory);
+}
+
+///<summary>Searches for <see cref="BarCodeAppearance"/>s like <see cref="find_appearances_of_bar_code_interests_in_image_coarse"/>, in a bitmap that is stored in RGBA 8-bit format.</summary>
+void find_appearances_of_bar_code_interests_in_bitmap_coarse(BarCodePyramid* pyramid, int scale, const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	find_appearances_of_bar_code_interests_in_image_coarse(pyramid, scale, &image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Platform.h"
+#include <stddef.h>
+#include <stdint.h>
+
+//The counters are only recorded when the library is compiled with BAR_CODE_STATS defined (see the BAR_CODE_STATS option of CMakeLists.txt).
+//Otherwise every line that records them is compiled out, and enable_bar_code_find_stats fails.
+
+///<summary>The values that <see cref="find_appearances_of_bar_code_interests_in_image"/> records in <see cref="BarCodeFindStats"/>, which show where the
+///time of a slow search went.</summary>
+typedef enum BarCodeFindCounter
+{
+	///<summary>Nanoseconds spent finding the <see cref="YellowScanLine"/>s and <see cref="YellowBoundingBox"/>es. They are found in a single pass, so
+	///they are timed together.</summary>
+	BAR_CODE_FIND_COUNTER_YELLOW_NANOSECONDS = 0,
+
+	///<summary>Nanoseconds spent pairing the <see cref="YellowBoundingBox"/>es and reading the colorful lines between them.</summary>
+	BAR_CODE_FIND_COUNTER_APPEARANCE_NANOSECONDS = 1,
+
+	///<summary>Nanoseconds spent scoring the colorful lines against each <see cref="BarCode"/> and sorting the matches.</summary>
+	BAR_CODE_FIND_COUNTER_MATCH_NANOSECONDS = 2,
+
+	///<summary>Nanoseconds spent in the whole search.</summary>
+	BAR_CODE_FIND_COUNTER_TOTAL_NANOSECONDS = 3,
+
+	///<summary>The number of 'yellow' pixels that were stored as <see cref="YellowScanLine"/>s.</summary>
+	BAR_CODE_FIND_COUNTER_YELLOW_PIXELS = 4,
+
+	///<summary>The number of <see cref="YellowScanLine"/>s that were stored.</summary>
+	BAR_CODE_FIND_COUNTER_SCAN_LINES = 5,
+
+	///<summary>The number of <see cref="YellowBoundingBox"/>es.</summary>
+	BAR_CODE_FIND_COUNTER_YELLOW_BOXES = 6,
+
+	///<summary>The number of <see cref="YellowBoundingBox"/>es that are not <see cref="YellowBoundingBox.isComplete"/>.</summary>
+	BAR_CODE_FIND_COUNTER_INCOMPLETE_BOXES = 7,
+
+	///<summary>The number of pairs of <see cref="YellowBoundingBox"/>es whose line was followed (those that the <see cref="BarCodePairingConfig"/> allows).</summary>
+	BAR_CODE_FIND_COUNTER_PAIRS = 8,
+
+	///<summary>The number of pixels that were read to find where the colorful part of each line begins and ends (see <see cref="_find_colorful_line_endpoints"/>).</summary>
+	BAR_CODE_FIND_COUNTER_ENDPOINT_PIXELS = 9,
+
+	///<summary>The number of pixels that were read and quantified on the colorful part of each line (see <see cref="_read_bar_code_appearances"/>).</summary>
+	BAR_CODE_FIND_COUNTER_READ_PIXELS = 10,
+
+	///<summary>The number of colorful lines that were stored in <see cref="BarCodeFindTemporaryMemory.appearances"/>.</summary>
+	BAR_CODE_FIND_COUNTER_APPEARANCES = 11,
+
+	///<summary>The number of counters.</summary>
+	BAR_CODE_FIND_COUNTER_COUNT = 12
+} BarCodeFindCounter;
+
+///<summary>What the last search did, stage by stage. Set <see cref="BarCodeFindTemporaryMemory.stats"/> (see <see cref="enable_bar_code_find_stats"/>) to record it.</summary>
+typedef struct BarCodeFindStats
+{
+	///<summary>The value of each <see cref="BarCodeFindCounter"/> for the last search.</summary>
+	uint64_t counters[BAR_CODE_FIND_COUNTER_COUNT];
+
+	///<summary>Array that receives the number of <see cref="BarCodeAppearance"/>s that each <see cref="BarCodeFindContext"/> kept, in the order of the contexts.</summary>
+	size_t* keptAppearanceCounts;
+
+	///<summary>The number of values that fit in <see cref="keptAppearanceCounts"/>. The contexts after that many are not recorded.</summary>
+	size_t keptAppearanceCountCapacity;
+
+	///<summary>The number of <see cref="BarCodeFindContext"/>s of the last search.</summary>
+	size_t contextCount;
+} BarCodeFindStats;
+
+#if defined(BAR_CODE_STATS)
+///<summary>Clears the counters of the previous search.</summary>
+static void _begin_bar_code_find_stats(BarCodeFindStats* stats, size_t contextCount)
+{
+	for (int i = 0; i < BAR_CODE_FIND_COUNTER_COUNT; i++)
+		stats->counters[i] = 0;
+	stats->contextCount = contextCount;
+}
+
+///<summary>Adds the time since <paramref name="time"/> to a counter, and moves <paramref name="time"/> to the current time.</summary>
+static void _add_bar_code_stats_time(BarCodeFindStats* stats, BarCodeFindCounter counter, uint64_t* time)
+{
+	uint64_t now = get_monotonic_nanoseconds();
+	stats->counters[counter] += now - *time;
+	*time = now;
+}
+#endif
@@ -0,0 +1,218 @@
+#pragma once
+#include "BarCode.h"
+#include "BarCodeParallel.h"
+
+///<summary>Follows the <see cref="BarCode"/>s of a video from frame to frame. Most frames are only searched near the bar codes of the previous
+///frame, so their cost depends on the number of bar codes rather than the size of the image.</summary>
+///<remarks>Create it with <see cref="init_bar_code_tracker"/>, pass it to <see cref="track_bar_code_interests_in_image"/> once per frame, and
+///free it with <see cref="free_bar_code_tracker"/>. A bar code that enters the image between two full scans is only found by the next full scan.</remarks>
+typedef struct BarCodeTracker
+{
+	///<summary>The whole image is searched at least once per this many frames. One (or less) searches the whole image of every frame.</summary>
+	int fullScanInterval;
+
+	///<summary>The number of pixels that each tracked bar code may move between two frames. The region around both of its yellow bars is grown by
+	///this much (plus the maximum yellow spacing) to find the window that is searched in the next frame.</summary>
+	int searchMargin;
+
+	///<summary>The number of frames since the last full scan.</summary>
+	int framesSinceFullScan;
+
+	///<summary>True when the next frame must be a full scan, because nothing has been searched yet or because a tracked bar code was lost.</summary>
+	bool needsFullScan;
+
+	///<summary>The region around both yellow bars of each <see cref="BarCodeAppearance"/> that was kept by a <see cref="BarCodeFindContext"/> in the
+	///previous frame.</summary>
+	YellowBoundingBox* tracks;
+
+	///<summary>The number of regions in <see cref="tracks"/>.</summary>
+	size_t trackCount;
+
+	///<summary>The number of regions that fit in <see cref="tracks"/>.</summary>
+	size_t trackCapacity;
+
+	///<summary>The windows that are searched in the current frame. No two of them overlap.</summary>
+	BarCodeSearchRegion* windows;
+
+	///<summary>The number of windows in <see cref="windows"/>.</summary>
+	size_t windowCount;
+
+	///<summary>The number of windows that fit in <see cref="windows"/>.</summary>
+	size_t windowCapacity;
+
+	///<summary>Whether each window holds a <see cref="BarCodeAppearance"/> that was kept in the current frame.</summary>
+	bool* windowsKept;
+
+	///<summary>The number of values that fit in <see cref="windowsKept"/>.</summary>
+	size_t windowKeptCapacity;
+} BarCodeTracker;
+
+///<summary>Initializes a <see cref="BarCodeTracker"/>. Its buffers grow as needed.</summary>
+///<param name="tracker">The <see cref="BarCodeTracker"/>.</param>
+///<param name="fullScanInterval">The whole image is searched at least once per this many frames.</param>
+///<param name="searchMargin">The number of pixels that a bar code may move between two frames without being lost.</param>
+static void init_bar_code_tracker(BarCodeTracker* tracker, int fullScanInterval, int searchMargin)
+{
+	memset(tracker, 0, sizeof(BarCodeTracker));
+	tracker->fullScanInterval = fullScanInterval;
+	tracker->searchMargin = searchMargin < 0 ? 0 : searchMargin;
+	tracker->needsFullScan = true;
+}
+
+///<summary>Frees the buffers of a <see cref="BarCodeTracker"/>, but not the tracker itself.</summary>
+static void free_bar_code_tracker(BarCodeTracker* tracker)
+{
+	free(tracker->tracks);
+	free(tracker->windows);
+	free(tracker->windowsKept);
+	tracker->tracks = NULL;
+	tracker->windows = NULL;
+	tracker->windowsKept = NULL;
+	tracker->trackCount = tracker->trackCapacity = 0;
+	tracker->windowCount = tracker->windowCapacity = 0;
+	tracker->windowKeptCapacity = 0;
+}
+
+///<summary>Makes the next call to <see cref="track_bar_code_interests_in_image"/> search the whole image, for example after a scene cut.</summary>
+BAR_CODE_FORCEINLINE void reset_bar_code_tracker(BarCodeTracker* tracker)
+{
+	tracker->needsFullScan = true;
+}
+
+///<summary>Builds the windows around the tracked regions, joining the ones that are near each other.</summary>
+///<returns>False if the windows could not be allocated.</returns>
+static bool _build_tracker_windows(BarCodeTracker* tracker, int width, int height, int maxYellowSpacing)
+{
+	if (!_reserve_buffer((void**)&tracker->windows, &tracker->windowCapacity, tracker->trackCount, sizeof(BarCodeSearchRegion)) ||
+		!_reserve_buffer((void**)&tracker->windowsKept, &tracker->windowKeptCapacity, tracker->trackCount, sizeof(bool)))
+		return false;
+
+	//The window also has to hold the yellow pixels that join a bar to its box
+	int margin = tracker->searchMargin + maxYellowSpacing;
+	for (size_t i = 0; i < tracker->trackCount; i++)
+	{
+		YellowBoundingBox track = tracker->tracks[i];
+		BarCodeSearchRegion window;
+		window.left = track.left - margin < 0 ? 0 : track.left - margin;
+		window.top = track.top - margin < 0 ? 0 : track.top - margin;
+		window.right = track.right + 1 + margin > width ? width : track.right + 1 + margin;
+		window.bottom = track.bottom + 1 + margin > height ? height : track.bottom + 1 + margin;
+		tracker->windows[i] = window;
+	}
+
+	tracker->windowCount = _join_search_regions(tracker->windows, tracker->trackCount, maxYellowSpacing);
+	return true;
+}
+
+///<summary>Gets the region around both yellow bars of the <see cref="BarCodeAppearance"/> that a <see cref="BarCodeFindContext"/> kept.</summary>
+BAR_CODE_FORCEINLINE YellowBoundingBox _get_kept_appearance_region(const BarCodeFindContext* context, size_t index)
+{
+	YellowBoundingBox first, second;
+	if (context->appearanceIndices != NULL)
+	{
+		first = context->appearancePool->firstBoxes[context->appearanceIndices[index]];
+		second = context->appearancePool->secondBoxes[context->appearanceIndices[index]];
+	}
+	else
+	{
+		first = context->appearanceBuffer[index]._firstBox;
+		second = context->appearanceBuffer[index]._secondBox;
+	}
+
+	YellowBoundingBox region = first;
+	region.left = second.left < region.left ? second.left : region.left;
+	region.top = second.top < region.top ? second.top : region.top;
+	region.right = second.right > region.right ? second.right : region.right;
+	region.bottom = second.bottom > region.bottom ? second.bottom : region.bottom;
+	return region;
+}
+
+///<summary>Replaces the tracked regions with those of the <see cref="BarCodeAppearance"/>s that the <see cref="BarCodeFindContext"/>s kept.</summary>
+///<param name="windowed">True if only the windows were searched. Then a tracked bar code counts as lost if a window no longer holds any kept
+///<see cref="BarCodeAppearance"/>, or if fewer of them were kept than in the previous frame.</param>
+///<returns>True if a tracked bar code was lost.</returns>
+static bool _update_tracks(BarCodeTracker* tracker, const BarCodeFindContext* contexts, size_t contextCount, bool windowed)
+{
+	size_t previousCount = tracker->trackCount;
+	size_t total = 0;
+	for (size_t i = 0; i < contextCount; i++)
+		total += contexts[i].appearanceCount;
+	tracker->trackCount = 0;
+	if (!_reserve_buffer((void**)&tracker->tracks, &tracker->trackCapacity, total, sizeof(YellowBoundingBox)))
+		return true;//Without the tracks, only a full scan can find the bar codes again
+
+	for (size_t i = 0; i < contextCount; i++)
+	{
+		for (size_t j = 0; j < contexts[i].appearanceCount; j++)
+			tracker->tracks[tracker->trackCount++] = _get_kept_appearance_region(&contexts[i], j);
+	}
+	if (!windowed)
+		return false;
+	if (tracker->trackCount < previousCount)
+		return true;
+
+	//Each kept line was read from the boxes of one window, so its region lies inside that window
+	for (size_t w = 0; w < tracker->windowCount; w++)
+		tracker->windowsKept[w] = false;
+	for (size_t i = 0; i < tracker->trackCount; i++)
+	{
+		YellowBoundingBox region = tracker->tracks[i];
+		for (size_t w = 0; w < tracker->windowCount; w++)
+		{
+			BarCodeSearchRegion window = tracker->windows[w];
+			if (region.left >= window.left && region.right < window.right && region.top >= window.top && region.bottom < window.bottom)
+			{
+				tracker->windowsKept[w] = true;
+				break;
+			}
+		}
+	}
+	for (size_t w = 0; w < tracker->windowCount; w++)
+	{
+		if (!tracker->windowsKept[w])
+			return true;
+	}
+	return false;
+}
+
+///<summary>Searches one frame of a video for <see cref="BarCodeAppearance"/>s for a set of <see cref="BarCodeFindContext"/>s, like
+///<see cref="find_appearances_of_bar_code_interests_in_image"/>, but only near the bar codes of the previous frame when it can.</summary>
+///<param name="tracker">The <see cref="BarCodeTracker"/> that remembers the bar codes of the previous frame.</param>
+///<param name="workers">The <see cref="BarCodeFindWorkers"/> that spread each full scan across several threads, or NULL to search on the calling thread only.
+///The windows around the tracked bar codes are always searched on the calling thread.</param>
+///<returns>True if the whole image was searched, or false if only the windows around the tracked bar codes were.</returns>
+///<remarks>The other parameters are the same as those of <see cref="find_appearances_of_bar_code_interests_in_image"/>. The whole image is searched
+///on the first frame, once per <see cref="BarCodeTracker.fullScanInterval"/> frames, and on the frame after a tracked bar code was lost. Every other frame
+///only searches the windows, and only pairs the yellow bars that are in the same window, so it finds the same bar codes as a full scan as long as they
+///move less than <see cref="BarCodeTracker.searchMargin"/> pixels per frame. The same <see cref="BarCodeFindContext"/>s should be passed for every frame.</remarks>
+bool track_bar_code_interests_in_image(BarCodeTracker* tracker, const BarCodeImage* image, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory, BarCodeFindWorkers* workers)
+{
+	if (contextCount == 0)
+		return false;//Nothing to do
+
+	tracker->framesSinceFullScan++;
+	bool fullScan = tracker->needsFullScan || tracker->framesSinceFullScan >= tracker->fullScanInterval || !_build_tracker_windows(tracker, image->width, image->height, maxYellowSpacing);
+	if (fullScan)
+	{
+		if (workers != NULL)
+			find_appearances_of_bar_code_interests_in_image_parallel(image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory, workers);
+		else
+			find_appearances_of_bar_code_interests_in_image(image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory);
+		tracker->framesSinceFullScan = 0;
+	}
+	else
+	{
+		//Only the boxes of the same window are paired, so each window costs about as much as the bar codes in it
+		find_appearances_of_bar_code_interests_in_image_regions(image, yellowCfg, maxYellowSpacing, tracker->windows, tracker->windowCount, contexts, contextCount, memory);
+	}
+
+	tracker->needsFullScan = _update_tracks(tracker, contexts, contextCount, !fullScan);
+	return fullScan;
+}
+
+///<summary>Searches one frame of a video like <see cref="track_bar_code_interests_in_image"/>, in a bitmap that is stored in RGBA 8-bit format.</summary>
+bool track_bar_code_interests_in_bitmap(BarCodeTracker* tracker, const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory memory, BarCodeFindWorkers* workers)
+{
+	BarCodeImage image = bar_code_image_rgba8(rgba8, width, height);
+	return track_bar_code_interests_in_image(tracker, &image, yellowCfg, maxYellowSpacing, contexts, contextCount, memory, workers);
+}
@@ -0,0 +1,608 @@
+#pragma once
+#include "Platform.h"
+#include "YellowKernels.h"
+#include "ThreadPool.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+///<summary>Swaps the red and blue channels of four-byte pixels, which converts RGBA to BGRA and back.</summary>
+///<param name="src">The source pixels.</param>
+///<param name="dst">Receives the converted pixels. It may be the same as <paramref name="src"/>.</param>
+///<param name="pixelCount">The number of pixels to convert.</param>
+typedef void(*SwapRedBlueFunction)(const uint8_t* src, uint8_t* dst, size_t pixelCount);
+
+///<summary>Converts three-byte pixels to four-byte pixels whose alpha channel is 255.</summary>
+///<param name="src">The source pixels.</param>
+///<param name="dst">Receives the converted pixels. It must not overlap <paramref name="src"/>.</param>
+///<param name="pixelCount">The number of pixels to convert.</param>
+///<param name="swapRedBlue">True to swap the first and third channels (BGR to RGBA), false to keep their order (RGB to RGBA).</param>
+typedef void(*ExpandRgb24Function)(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue);
+
+///<summary>Converts four-byte pixels to three-byte pixels by dropping the alpha channel.</summary>
+///<param name="src">The source pixels.</param>
+///<param name="dst">Receives the converted pixels. It may be the same as <paramref name="src"/>, but must not overlap it otherwise.</param>
+///<param name="pixelCount">The number of pixels to convert.</param>
+///<param name="swapRedBlue">True to swap the first and third channels (BGRA to RGB), false to keep their order (RGBA to RGB).</param>
+typedef void(*PackRgb24Function)(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue);
+
+///<summary>Interleaves three planes of one byte per pixel into four-byte pixels whose alpha channel is 255.</summary>
+///<param name="reds">The first channel of each pixel. The same goes for <paramref name="greens"/> and <paramref name="blues"/>.</param>
+///<param name="dst">Receives the converted pixels.</param>
+///<param name="pixelCount">The number of pixels to convert.</param>
+typedef void(*InterleavePlanesFunction)(const uint8_t* reds, const uint8_t* greens, const uint8_t* blues, uint8_t* dst, size_t pixelCount);
+
+///<summary>Splits the first three channels of four-byte pixels into three planes of one byte per pixel, and drops the alpha channel.</summary>
+///<param name="src">The source pixels.</param>
+///<param name="reds">Receives the first channel of each pixel. The same goes for <paramref name="greens"/> and <paramref name="blues"/>.</param>
+///<param name="pixelCount">The number of pixels to convert.</param>
+typedef void(*SplitPlanesFunction)(const uint8_t* src, uint8_t* reds, uint8_t* greens, uint8_t* blues, size_t pixelCount);
+
+///<summary>Table of pixel conversion kernels that were compiled for a specific <see cref="YellowKernelLevel"/>.</summary>
+typedef struct ConvertKernels
+{
+	///<summary>The instruction set used by the kernels in this table.</summary>
+	YellowKernelLevel level;
+
+	///<summary>Converts RGBA to BGRA and back (see <see cref="SwapRedBlueFunction"/>).</summary>
+	SwapRedBlueFunction swapRedBlue;
+
+	///<summary>Converts RGB24 to RGBA (see <see cref="ExpandRgb24Function"/>).</summary>
+	ExpandRgb24Function expandRgb24;
+
+	///<summary>Converts RGBA to RGB24 (see <see cref="PackRgb24Function"/>).</summary>
+	PackRgb24Function packRgb24;
+
+	///<summary>Converts planar RGB to RGBA (see <see cref="InterleavePlanesFunction"/>).</summary>
+	InterleavePlanesFunction interleavePlanes;
+
+	///<summary>Converts RGBA to planar RGB (see <see cref="SplitPlanesFunction"/>).</summary>
+	SplitPlanesFunction splitPlanes;
+} ConvertKernels;
+
+static void _swap_red_blue_scalar(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+	for (size_t i = 0; i < pixelCount * 4; i += 4)
+	{
+		//Read the whole pixel before writing any of it, so that the conversion can be done in place
+		uint8_t r = src[i + 0];
+		uint8_t g = src[i + 1];
+		uint8_t b = src[i + 2];
+		uint8_t a = src[i + 3];
+
+		dst[i + 0] = b;
+		dst[i + 1] = g;
+		dst[i + 2] = r;
+		dst[i + 3] = a;
+	}
+}
+
+static void _expand_rgb24_scalar(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	size_t first = swapRedBlue ? 2 : 0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		dst[(i * 4) + 0] = src[(i * 3) + first];
+		dst[(i * 4) + 1] = src[(i * 3) + 1];
+		dst[(i * 4) + 2] = src[(i * 3) + 2 - first];
+		dst[(i * 4) + 3] = 255;
+	}
+}
+
+static void _pack_rgb24_scalar(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	size_t first = swapRedBlue ? 2 : 0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		//Each pixel is written no later than it is read, so the conversion can be done in place
+		uint8_t c0 = src[(i * 4) + first];
+		uint8_t c1 = src[(i * 4) + 1];
+		uint8_t c2 = src[(i * 4) + 2 - first];
+
+		dst[(i * 3) + 0] = c0;
+		dst[(i * 3) + 1] = c1;
+		dst[(i * 3) + 2] = c2;
+	}
+}
+
+static void _interleave_planes_scalar(const uint8_t* reds, const uint8_t* greens, const uint8_t* blues, uint8_t* dst, size_t pixelCount)
+{
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		dst[(i * 4) + 0] = reds[i];
+		dst[(i * 4) + 1] = greens[i];
+		dst[(i * 4) + 2] = blues[i];
+		dst[(i * 4) + 3] = 255;
+	}
+}
+
+static void _split_planes_scalar(const uint8_t* src, uint8_t* reds, uint8_t* greens, uint8_t* blues, size_t pixelCount)
+{
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		reds[i] = src[(i * 4) + 0];
+		greens[i] = src[(i * 4) + 1];
+		blues[i] = src[(i * 4) + 2];
+	}
+}
+
+#if defined(BAR_CODE_X86)
+
+//Each SIMD kernel below moves bytes with PSHUFB, which shuffles within each 16-byte lane. The 3-byte kernels first move every group
+//of four pixels (12 bytes) into a lane of its own. Every kernel writes exactly the same bytes as the scalar kernel of the same name.
+
+BAR_CODE_TARGET_SSE41 static void _swap_red_blue_sse41(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+	__m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 4 <= pixelCount; i += 4)
+		_mm_storeu_si128((__m128i*)(dst + (i * 4)), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4))), shuffle));
+	_swap_red_blue_scalar(src + (i * 4), dst + (i * 4), pixelCount - i);
+}
+
+BAR_CODE_TARGET_SSE41 static void _expand_rgb24_sse41(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m128i shuffle = swapRedBlue
+		? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+		: _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	__m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		//Three vectors hold 16 pixels; the pixels that straddle two vectors are joined with PALIGNR
+		__m128i a = _mm_loadu_si128((const __m128i*)(src + (i * 3)));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + (i * 3) + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(src + (i * 3) + 32));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4)), _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha));
+	}
+	_expand_rgb24_scalar(src + (i * 3), dst + (i * 4), pixelCount - i, swapRedBlue);
+}
+
+BAR_CODE_TARGET_SSE41 static void _pack_rgb24_sse41(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m128i shuffle = swapRedBlue
+		? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+		: _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		//All 16 pixels are loaded before the 48 bytes are stored, and the stores end before the next pixels, so this works in place
+		__m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4))), shuffle);
+		__m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 16)), shuffle);
+		__m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 32)), shuffle);
+		__m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 48)), shuffle);
+		_mm_storeu_si128((__m128i*)(dst + (i * 3)), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+		_mm_storeu_si128((__m128i*)(dst + (i * 3) + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+		_mm_storeu_si128((__m128i*)(dst + (i * 3) + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+	}
+	_pack_rgb24_scalar(src + (i * 4), dst + (i * 3), pixelCount - i, swapRedBlue);
+}
+
+BAR_CODE_TARGET_SSE41 static void _interleave_planes_sse41(const uint8_t* reds, const uint8_t* greens, const uint8_t* blues, uint8_t* dst, size_t pixelCount)
+{
+	__m128i alpha = _mm_set1_epi8(-1);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		__m128i r = _mm_loadu_si128((const __m128i*)(reds + i));
+		__m128i g = _mm_loadu_si128((const __m128i*)(greens + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(blues + i));
+		__m128i rgLow = _mm_unpacklo_epi8(r, g), rgHigh = _mm_unpackhi_epi8(r, g);
+		__m128i baLow = _mm_unpacklo_epi8(b, alpha), baHigh = _mm_unpackhi_epi8(b, alpha);
+		_mm_storeu_si128((__m128i*)(dst + (i * 4)), _mm_unpacklo_epi16(rgLow, baLow));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 16), _mm_unpackhi_epi16(rgLow, baLow));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 32), _mm_unpacklo_epi16(rgHigh, baHigh));
+		_mm_storeu_si128((__m128i*)(dst + (i * 4) + 48), _mm_unpackhi_epi16(rgHigh, baHigh));
+	}
+	_interleave_planes_scalar(reds + i, greens + i, blues + i, dst + (i * 4), pixelCount - i);
+}
+
+BAR_CODE_TARGET_SSE41 static void _split_planes_sse41(const uint8_t* src, uint8_t* reds, uint8_t* greens, uint8_t* blues, size_t pixelCount)
+{
+	//Gathers each channel of four pixels into an epi32 position, so the 4x4 transpose below yields 16 bytes of each channel
+	__m128i shuffle = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		__m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4))), shuffle);
+		__m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 16)), shuffle);
+		__m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 32)), shuffle);
+		__m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + (i * 4) + 48)), shuffle);
+		__m128i rgLow = _mm_unpacklo_epi32(a, b), baLow = _mm_unpackhi_epi32(a, b);
+		__m128i rgHigh = _mm_unpacklo_epi32(c, d), baHigh = _mm_unpackhi_epi32(c, d);
+		_mm_storeu_si128((__m128i*)(reds + i), _mm_unpacklo_epi64(rgLow, rgHigh));
+		_mm_storeu_si128((__m128i*)(greens + i), _mm_unpackhi_epi64(rgLow, rgHigh));
+		_mm_storeu_si128((__m128i*)(blues + i), _mm_unpacklo_epi64(baLow, baHigh));
+	}
+	_split_planes_scalar(src + (i * 4), reds + i, greens + i, blues + i, pixelCount - i);
+}
+
+BAR_CODE_TARGET_AVX2 static void _swap_red_blue_avx2(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+	__m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 8 <= pixelCount; i += 8)
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4)), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4))), shuffle));
+
+	if (i < pixelCount)
+	{
+		//The masked load and store never touch the bytes beyond the last pixel
+		__m256i valid = _get_tail_mask_avx2((int)(pixelCount - i));
+		__m256i pixels = _mm256_maskload_epi32((const int*)(src + (i * 4)), valid);
+		_mm256_maskstore_epi32((int*)(dst + (i * 4)), valid, _mm256_shuffle_epi8(pixels, shuffle));
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _expand_rgb24_avx2(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m256i shuffle = swapRedBlue
+		? _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+		: _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	__m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+	//The first load holds pixels 0 to 7 in its epi32 positions 0 to 5; the second load (16 bytes later) holds pixels 8 to 15 in positions 2 to 7
+	__m256i firstIndices = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+	__m256i secondIndices = _mm256_setr_epi32(2, 3, 4, 0, 5, 6, 7, 0);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		__m256i first = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(src + (i * 3))), firstIndices);
+		__m256i second = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(src + (i * 3) + 16)), secondIndices);
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4)), _mm256_or_si256(_mm256_shuffle_epi8(first, shuffle), alpha));
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4) + 32), _mm256_or_si256(_mm256_shuffle_epi8(second, shuffle), alpha));
+	}
+	_expand_rgb24_sse41(src + (i * 3), dst + (i * 4), pixelCount - i, swapRedBlue);
+}
+
+BAR_CODE_TARGET_AVX2 static void _pack_rgb24_avx2(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m256i shuffle = swapRedBlue
+		? _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+		: _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	//Joins the 12 bytes at the bottom of each lane into the bottom 24 bytes of the vector
+	__m256i indices = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+	//Move the first 8 bytes of the second group of pixels to the top of a vector, and the other 16 bytes to the bottom
+	__m256i headIndices = _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 1);
+	__m256i tailIndices = _mm256_setr_epi32(2, 3, 4, 5, 0, 0, 0, 0);
+	size_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		__m256i first = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4))), shuffle), indices);
+		__m256i second = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4) + 32)), shuffle), indices);
+
+		//Write 48 bytes without going past the last pixel; the stores end before the next pixels, so this works in place
+		_mm256_storeu_si256((__m256i*)(dst + (i * 3)), _mm256_blend_epi32(first, _mm256_permutevar8x32_epi32(second, headIndices), 0xC0));
+		_mm_storeu_si128((__m128i*)(dst + (i * 3) + 32), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(second, tailIndices)));
+	}
+	_pack_rgb24_sse41(src + (i * 4), dst + (i * 3), pixelCount - i, swapRedBlue);
+}
+
+BAR_CODE_TARGET_AVX2 static void _interleave_planes_avx2(const uint8_t* reds, const uint8_t* greens, const uint8_t* blues, uint8_t* dst, size_t pixelCount)
+{
+	__m256i alpha = _mm256_set1_epi8(-1);
+	size_t i = 0;
+	for (; i + 32 <= pixelCount; i += 32)
+	{
+		__m256i r = _mm256_loadu_si256((const __m256i*)(reds + i));
+		__m256i g = _mm256_loadu_si256((const __m256i*)(greens + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(blues + i));
+		__m256i rgLow = _mm256_unpacklo_epi8(r, g), rgHigh = _mm256_unpackhi_epi8(r, g);
+		__m256i baLow = _mm256_unpacklo_epi8(b, alpha), baHigh = _mm256_unpackhi_epi8(b, alpha);
+
+		//The unpacks work within lanes, so each result holds pixels from both halves of the row; swap the lanes back into order
+		__m256i p0 = _mm256_unpacklo_epi16(rgLow, baLow), p1 = _mm256_unpackhi_epi16(rgLow, baLow);
+		__m256i p2 = _mm256_unpacklo_epi16(rgHigh, baHigh), p3 = _mm256_unpackhi_epi16(rgHigh, baHigh);
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4)), _mm256_permute2x128_si256(p0, p1, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4) + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4) + 64), _mm256_permute2x128_si256(p0, p1, 0x31));
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4) + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+	}
+	_interleave_planes_sse41(reds + i, greens + i, blues + i, dst + (i * 4), pixelCount - i);
+}
+
+BAR_CODE_TARGET_AVX2 static void _split_planes_avx2(const uint8_t* src, uint8_t* reds, uint8_t* greens, uint8_t* blues, size_t pixelCount)
+{
+	__m256i shuffle = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15, 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+	//After the in-lane transpose, epi32 position 'p' holds the channel of pixels 4 * {0, 2, 4, 6, 1, 3, 5, 7}[p] onwards
+	__m256i indices = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; i + 32 <= pixelCount; i += 32)
+	{
+		__m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4))), shuffle);
+		__m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4) + 32)), shuffle);
+		__m256i c = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4) + 64)), shuffle);
+		__m256i d = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + (i * 4) + 96)), shuffle);
+		__m256i rgLow = _mm256_unpacklo_epi32(a, b), baLow = _mm256_unpackhi_epi32(a, b);
+		__m256i rgHigh = _mm256_unpacklo_epi32(c, d), baHigh = _mm256_unpackhi_epi32(c, d);
+		_mm256_storeu_si256((__m256i*)(reds + i), _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(rgLow, rgHigh), indices));
+		_mm256_storeu_si256((__m256i*)(greens + i), _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(rgLow, rgHigh), indices));
+		_mm256_storeu_si256((__m256i*)(blues + i), _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(baLow, baHigh), indices));
+	}
+	_split_planes_sse41(src + (i * 4), reds + i, greens + i, blues + i, pixelCount - i);
+}
+
+BAR_CODE_TARGET_AVX512 static void _swap_red_blue_avx512(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+	__m512i shuffle = _mm512_broadcast_i32x4(_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+	for (size_t i = 0; i < pixelCount; i += 16)
+	{
+		size_t remaining = pixelCount - i;
+		__mmask16 valid = remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+		__m512i pixels = _mm512_maskz_loadu_epi32(valid, src + (i * 4));
+		_mm512_mask_storeu_epi32(dst + (i * 4), valid, _mm512_shuffle_epi8(pixels, shuffle));
+	}
+}
+
+BAR_CODE_TARGET_AVX512 static void _expand_rgb24_avx512(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m512i shuffle = _mm512_broadcast_i32x4(swapRedBlue
+		? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+		: _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+	__m512i alpha = _mm512_set1_epi32((int)0xFF000000);
+
+	//Moves each group of four pixels (three epi32 positions) into a lane of its own
+	__m512i indices = _mm512_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0, 6, 7, 8, 0, 9, 10, 11, 0);
+	for (size_t i = 0; i < pixelCount; i += 16)
+	{
+		size_t remaining = pixelCount - i;
+		if (remaining > 16)
+			remaining = 16;
+		__mmask64 validBytes = (__mmask64)((1ull << (remaining * 3)) - 1);
+		__mmask16 valid = remaining == 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+		__m512i pixels = _mm512_permutexvar_epi32(indices, _mm512_maskz_loadu_epi8(validBytes, src + (i * 3)));
+		_mm512_mask_storeu_epi32(dst + (i * 4), valid, _mm512_or_si512(_mm512_shuffle_epi8(pixels, shuffle), alpha));
+	}
+}
+
+BAR_CODE_TARGET_AVX512 static void _pack_rgb24_avx512(const uint8_t* src, uint8_t* dst, size_t pixelCount, bool swapRedBlue)
+{
+	__m512i shuffle = _mm512_broadcast_i32x4(swapRedBlue
+		? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+		: _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+
+	//Joins the 12 bytes at the bottom of each lane into the bottom 48 bytes of the vector
+	__m512i indices = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 3, 7, 11, 15);
+	for (size_t i = 0; i < pixelCount; i += 16)
+	{
+		//The pixels are loaded before they are stored, and the store ends before the next pixels, so this works in place
+		size_t remaining = pixelCount - i;
+		if (remaining > 16)
+			remaining = 16;
+		__mmask16 valid = remaining == 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+		__mmask64 validBytes = (__mmask64)((1ull << (remaining * 3)) - 1);
+		__m512i pixels = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(valid, src + (i * 4)), shuffle);
+		_mm512_mask_storeu_epi8(dst + (i * 3), validBytes, _mm512_permutexvar_epi32(indices, pixels));
+	}
+}
+
+#endif
+
+///<summary>All <see cref="ConvertKernels"/> tables, indexed by <see cref="YellowKernelLevel"/>.</summary>
+///<remarks>The planar kernels gain nothing from AVX-512 over AVX2 (they are bound by memory bandwidth), so that level reuses the AVX2 ones.</remarks>
+static const ConvertKernels _convertKernelTables[] =
+{
+	{ YELLOW_KERNEL_SCALAR, _swap_red_blue_scalar, _expand_rgb24_scalar, _pack_rgb24_scalar, _interleave_planes_scalar, _split_planes_scalar },
+#if defined(BAR_CODE_X86)
+	{ YELLOW_KERNEL_SSE41, _swap_red_blue_sse41, _expand_rgb24_sse41, _pack_rgb24_sse41, _interleave_planes_sse41, _split_planes_sse41 },
+	{ YELLOW_KERNEL_AVX2, _swap_red_blue_avx2, _expand_rgb24_avx2, _pack_rgb24_avx2, _interleave_planes_avx2, _split_planes_avx2 },
+	{ YELLOW_KERNEL_AVX512, _swap_red_blue_avx512, _expand_rgb24_avx512, _pack_rgb24_avx512, _interleave_planes_avx2, _split_planes_avx2 },
+#endif
+};
+
+///<summary>Gets the <see cref="ConvertKernels"/> table of the same <see cref="YellowKernelLevel"/> as <see cref="get_yellow_kernels"/>.</summary>
+///<returns>The <see cref="ConvertKernels"/> table to use.</returns>
+BAR_CODE_FORCEINLINE const ConvertKernels* get_convert_kernels(void)
+{
+	return &_convertKernelTables[get_yellow_kernels()->level];
+}
+
+///<summary>A conversion between two pixel layouts (see <see cref="convert_bar_code_pixels"/>).</summary>
+typedef enum BarCodeConversion
+{
+	///<summary>RGBA to BGRA, or BGRA to RGBA (the red and blue channels are swapped).</summary>
+	BAR_CODE_CONVERSION_SWAP_RED_BLUE = 0,
+
+	///<summary>RGB24 to RGBA (or BGR24 to BGRA), with an alpha of 255.</summary>
+	BAR_CODE_CONVERSION_RGB24_TO_RGBA8 = 1,
+
+	///<summary>BGR24 to RGBA (or RGB24 to BGRA), with an alpha of 255.</summary>
+	BAR_CODE_CONVERSION_BGR24_TO_RGBA8 = 2,
+
+	///<summary>RGBA to RGB24 (or BGRA to BGR24).</summary>
+	BAR_CODE_CONVERSION_RGBA8_TO_RGB24 = 3,
+
+	///<summary>BGRA to RGB24 (or RGBA to BGR24).</summary>
+	BAR_CODE_CONVERSION_BGRA8_TO_RGB24 = 4,
+
+	///<summary>Three planes (red, green and blue) to RGBA, with an alpha of 255. Pass the planes in reverse order to get BGRA.</summary>
+	BAR_CODE_CONVERSION_PLANES_TO_RGBA8 = 5,
+
+	///<summary>RGBA to three planes (red, green and blue). Pass the planes in reverse order to convert from BGRA.</summary>
+	BAR_CODE_CONVERSION_RGBA8_TO_PLANES = 6,
+
+	///<summary>The number of conversions.</summary>
+	BAR_CODE_CONVERSION_COUNT = 7
+} BarCodeConversion;
+
+///<summary>The number of pixels that one task of <see cref="convert_bar_code_pixels"/> converts, which is large enough to make the
+///cost of claiming it negligible and small enough to spread a single frame across many threads.</summary>
+#define BAR_CODE_CONVERSION_TASK_PIXELS ((size_t)1 << 16)
+
+///<summary>The arguments of <see cref="_convert_bar_code_pixels_task"/>.</summary>
+typedef struct _ConversionJob
+{
+	const ConvertKernels* kernels;
+	BarCodeConversion conversion;
+
+	///<summary>The source planes. Only the first is used unless the source is planar.</summary>
+	const uint8_t* src[3];
+	size_t srcStride;
+	size_t srcPixelSize;
+
+	///<summary>The destination planes. Only the first is used unless the destination is planar.</summary>
+	uint8_t* dst[3];
+	size_t dstStride;
+	size_t dstPixelSize;
+
+	///<summary>The number of pixels in each row. When the rows of both images are packed, the whole image is treated as one long row.</summary>
+	size_t rowPixels;
+
+	///<summary>The number of rows.</summary>
+	size_t rowCount;
+
+	///<summary>The number of rows that one task converts.</summary>
+	size_t rowsPerTask;
+
+	///<summary>The number of tasks that each row is split into. If this is more than 1, <see cref="rowsPerTask"/> is 1.</summary>
+	size_t tasksPerRow;
+} _ConversionJob;
+
+///<summary>Gets the number of bytes of each pixel of each plane of the source and the destination of a conversion.</summary>
+BAR_CODE_FORCEINLINE void _get_conversion_pixel_sizes(BarCodeConversion conversion, size_t* srcPixelSize, size_t* dstPixelSize)
+{
+	switch (conversion)
+	{
+	case BAR_CODE_CONVERSION_RGB24_TO_RGBA8:
+	case BAR_CODE_CONVERSION_BGR24_TO_RGBA8:
+		*srcPixelSize = 3;
+		*dstPixelSize = 4;
+		break;
+	case BAR_CODE_CONVERSION_RGBA8_TO_RGB24:
+	case BAR_CODE_CONVERSION_BGRA8_TO_RGB24:
+		*srcPixelSize = 4;
+		*dstPixelSize = 3;
+		break;
+	case BAR_CODE_CONVERSION_PLANES_TO_RGBA8:
+		*srcPixelSize = 1;
+		*dstPixelSize = 4;
+		break;
+	case BAR_CODE_CONVERSION_RGBA8_TO_PLANES:
+		*srcPixelSize = 4;
+		*dstPixelSize = 1;
+		break;
+	default:
+		*srcPixelSize = 4;
+		*dstPixelSize = 4;
+		break;
+	}
+}
+
+///<summary>Converts a run of pixels within one row of a <see cref="_ConversionJob"/>.</summary>
+static void _convert_bar_code_pixel_run(const _ConversionJob* job, size_t row, size_t x, size_t count)
+{
+	size_t srcOffset = (row * job->srcStride) + (x * job->srcPixelSize);
+	size_t dstOffset = (row * job->dstStride) + (x * job->dstPixelSize);
+	const ConvertKernels* kernels = job->kernels;
+	switch (job->conversion)
+	{
+	case BAR_CODE_CONVERSION_RGB24_TO_RGBA8:
+	case BAR_CODE_CONVERSION_BGR24_TO_RGBA8:
+		kernels->expandRgb24(job->src[0] + srcOffset, job->dst[0] + dstOffset, count, job->conversion == BAR_CODE_CONVERSION_BGR24_TO_RGBA8);
+		break;
+	case BAR_CODE_CONVERSION_RGBA8_TO_RGB24:
+	case BAR_CODE_CONVERSION_BGRA8_TO_RGB24:
+		kernels->packRgb24(job->src[0] + srcOffset, job->dst[0] + dstOffset, count, job->conversion == BAR_CODE_CONVERSION_BGRA8_TO_RGB24);
+		break;
+	case BAR_CODE_CONVERSION_PLANES_TO_RGBA8:
+		kernels->interleavePlanes(job->src[0] + srcOffset, job->src[1] + srcOffset, job->src[2] + srcOffset, job->dst[0] + dstOffset, count);
+		break;
+	case BAR_CODE_CONVERSION_RGBA8_TO_PLANES:
+		kernels->splitPlanes(job->src[0] + srcOffset, job->dst[0] + dstOffset, job->dst[1] + dstOffset, job->dst[2] + dstOffset, count);
+		break;
+	default:
+		kernels->swapRedBlue(job->src[0] + srcOffset, job->dst[0] + dstOffset, count);
+		break;
+	}
+}
+
+///<summary>Converts the pixels of one task of <see cref="convert_bar_code_pixels"/>.</summary>
+static void _convert_bar_code_pixels_task(void* arg, size_t index, int workerIndex)
+{
+	const _ConversionJob* job = (const _ConversionJob*)arg;
+	(void)workerIndex;
+	size_t firstRow = (index / job->tasksPerRow) * job->rowsPerTask;
+	size_t lastRow = firstRow + job->rowsPerTask < job->rowCount ? firstRow + job->rowsPerTask : job->rowCount;
+	size_t x = (index % job->tasksPerRow) * BAR_CODE_CONVERSION_TASK_PIXELS;
+	size_t count = job->tasksPerRow == 1 ? job->rowPixels : (job->rowPixels - x < BAR_CODE_CONVERSION_TASK_PIXELS ? job->rowPixels - x : BAR_CODE_CONVERSION_TASK_PIXELS);
+	for (size_t row = firstRow; row < lastRow; row++)
+		_convert_bar_code_pixel_run(job, row, x, count);
+}
+
+///<summary>Converts the pixels of an image from one layout to another.</summary>
+///<param name="pool">The <see cref="ThreadPool"/> that converts large images, or NULL to convert on the calling thread only.</param>
+///<param name="conversion">The <see cref="BarCodeConversion"/> to perform.</param>
+///<param name="src">The first byte of each source plane. Only the first one is used unless the source is planar.</param>
+///<param name="srcStride">The number of bytes from the start of one source row to the start of the next (the same for each plane), or zero if the rows are packed.</param>
+///<param name="dst">The first byte of each destination plane. Only the first one is used unless the destination is planar.</param>
+///<param name="dstStride">The number of bytes from the start of one destination row to the start of the next (the same for each plane), or zero if the rows are packed.</param>
+///<param name="width">The width of the image, measured in pixels.</param>
+///<param name="height">The height of the image, measured in pixels.</param>
+///<returns>False if nothing was converted because the arguments are not valid: the conversion is unknown, a stride is smaller than a row,
+///or the image would be converted in place with different source and destination strides.</returns>
+///<remarks>The destination may be the same as the source (an in-place conversion) for <see cref="BAR_CODE_CONVERSION_SWAP_RED_BLUE"/>
+///and for the RGBA to RGB24 conversions, as long as both strides are the same. Otherwise the source and destination must not overlap.
+///Large images are split into tasks of about <see cref="BAR_CODE_CONVERSION_TASK_PIXELS"/> pixels, which never share a row's bytes,
+///so they produce exactly the same result with any number of threads.</remarks>
+static bool convert_bar_code_pixels(ThreadPool* pool, BarCodeConversion conversion, const uint8_t* const* src, size_t srcStride, uint8_t* const* dst, size_t dstStride, int width, int height)
+{
+	if ((int)conversion < 0 || conversion >= BAR_CODE_CONVERSION_COUNT || width < 0 || height < 0)
+		return false;
+
+	_ConversionJob job;
+	job.kernels = get_convert_kernels();
+	job.conversion = conversion;
+	_get_conversion_pixel_sizes(conversion, &job.srcPixelSize, &job.dstPixelSize);
+	size_t srcRowSize = (size_t)width * job.srcPixelSize, dstRowSize = (size_t)width * job.dstPixelSize;
+	job.srcStride = srcStride != 0 ? srcStride : srcRowSize;
+	job.dstStride = dstStride != 0 ? dstStride : dstRowSize;
+	if (job.srcStride < srcRowSize || job.dstStride < dstRowSize)
+		return false;
+	if ((const uint8_t*)dst[0] == src[0] && job.srcStride != job.dstStride)
+		return false;
+	for (int p = 0; p < 3; p++)
+	{
+		job.src[p] = src[p];
+		job.dst[p] = dst[p];
+	}
+
+	if (width == 0 || height == 0)
+		return true;
+
+	if (job.srcStride == srcRowSize && job.dstStride == dstRowSize)
+	{
+		//Both images are packed, so the kernels can run across row boundaries
+		job.rowPixels = (size_t)width * (size_t)height;
+		job.rowCount = 1;
+	}
+	else
+	{
+		job.rowPixels = (size_t)width;
+		job.rowCount = (size_t)height;
+	}
+
+	//A row that is packed in place is written over its own pixels from left to right, so it cannot be split between threads
+	bool splitRows = (const uint8_t*)dst[0] != src[0] || job.srcPixelSize == job.dstPixelSize;
+	if (job.rowPixels >= BAR_CODE_CONVERSION_TASK_PIXELS && splitRows)
+	{
+		job.rowsPerTask = 1;
+		job.tasksPerRow = (job.rowPixels + BAR_CODE_CONVERSION_TASK_PIXELS - 1) / BAR_CODE_CONVERSION_TASK_PIXELS;
+	}
+	else
+	{
+		job.rowsPerTask = job.rowPixels >= BAR_CODE_CONVERSION_TASK_PIXELS ? 1 : BAR_CODE_CONVERSION_TASK_PIXELS / job.rowPixels;
+		job.tasksPerRow = 1;
+	}
+
+	size_t taskCount = ((job.rowCount + job.rowsPerTask - 1) / job.rowsPerTask) * job.tasksPerRow;
+	if (taskCount == 1)
+		_convert_bar_code_pixels_task(&job, 0, 0);//Not worth waking the other threads for
+	else
+		parallel_for(pool, taskCount, _convert_bar_code_pixels_task, &job);
+	return true;
+}
@@ -1,100 +1,212 @@
 #include "BarCode.h"
+#include "BarCodeParallel.h"
+#include "BarCodeTracker.h"
+#include "BarCodePyramid.h"
+#include "ConvertKernels.h"
 
-_declspec(dllexport) void ShowYellow(const uint8_t* rgba8Source, uint8_t* rgba8Dest, int width, int height, YellowConfig config, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+BAR_CODE_EXPORT void ShowYellow(const uint8_t* rgba8Source, uint8_t* rgba8Dest, int width, int height, YellowConfig config, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
 	show_yellow(rgba8Source, rgba8Dest, width, height, config, r, g, b, a);
 }
 
-_declspec(dllexport) BarCodeFindTemporaryMemory* AllocateBarCodeFindTemporaryMemory(size_t scanLineCapacity, size_t yellowBoxCapacity, size_t tempIndexBufferCapacity, size_t appearanceCapacity, size_t appearanceSortBufferCapacity)
+BAR_CODE_EXPORT int GetYellowKernelLevel(void)
 {
-	BarCodeFindTemporaryMemory* ret = (BarCodeFindTemporaryMemory*)malloc(sizeof(BarCodeFindTemporaryMemory));
-	if (ret == NULL)
-		return NULL;
+	return (int)get_yellow_kernels()->level;
+}
 
-	YellowScanLine* scanLines = (YellowScanLine*)malloc(sizeof(YellowScanLine) * scanLineCapacity);
-	YellowBoundingBox* boxes = (YellowBoundingBox*)malloc(sizeof(YellowBoundingBox) * yellowBoxCapacity);
-	size_t* tempIndexBuf = (size_t*)malloc(sizeof(size_t) * tempIndexBufferCapacity);
-	BarCodeAppearance* appearances = (BarCodeAppearance*)malloc(sizeof(BarCodeAppearance) * appearanceCapacity);
-	BarCodeAppearance** appearanceSortBuffer = (BarCodeAppearance * *)malloc(sizeof(BarCodeAppearance*) * appearanceSortBufferCapacity);
-	float* appearanceSortMatchScoreBuffer = (float*)malloc(sizeof(float) * appearanceSortBufferCapacity);
+BAR_CODE_EXPORT bool SetYellowKernelLevel(int level)
+{
+	return select_yellow_kernels((YellowKernelLevel)level);
+}
 
-	if (scanLines == NULL || boxes == NULL || tempIndexBuf == NULL || appearances == NULL || appearanceSortBuffer == NULL || appearanceSortMatchScoreBuffer == NULL)
-	{
-		//An allocation failed, so free all allocations that did not fail
-		if (scanLines != NULL)
-			free(scanLines);
-		if (boxes != NULL)
-			free(boxes);
-		if (tempIndexBuf != NULL)
-			free(tempIndexBuf);
-		if (appearances != NULL)
-			free(appearances);
-		if (appearanceSortBuffer != NULL)
-			free(appearanceSortBuffer);
-		if (appearanceSortMatchScoreBuffer != NULL)
-			free(appearanceSortMatchScoreBuffer);
-
-		free(ret);
-		return NULL;
-	}
-	else
-	{
-		ret->scanLines = scanLines;
-		ret->scanLineCapacity = scanLineCapacity;
-		
-		ret->yellowBoxes = boxes;
-		ret->yellowBoxCapacity = yellowBoxCapacity;
+BAR_CODE_EXPORT BarCodeFindTemporaryMemory* AllocateBarCodeFindTemporaryMemoryInArena(size_t scanLineCapacity, size_t yellowBoxCapacity, size_t tempIndexBufferCapacity, size_t appearanceCapacity, size_t appearanceSortBufferCapacity, int arenaFlags)
+{
+	return allocate_bar_code_find_temporary_memory(scanLineCapacity, yellowBoxCapacity, tempIndexBufferCapacity, appearanceCapacity, appearanceSortBufferCapacity, arenaFlags);
+}
 
-		ret->temporaryIndexBuffer = tempIndexBuf;
-		ret->temporaryIndexBufferCapacity = tempIndexBufferCapacity;
+BAR_CODE_EXPORT BarCodeFindTemporaryMemory* AllocateBarCodeFindTemporaryMemory(size_t scanLineCapacity, size_t yellowBoxCapacity, size_t tempIndexBufferCapacity, size_t appearanceCapacity, size_t appearanceSortBufferCapacity)
+{
+	return allocate_bar_code_find_temporary_memory(scanLineCapacity, yellowBoxCapacity, tempIndexBufferCapacity, appearanceCapacity, appearanceSortBufferCapacity, BAR_CODE_ARENA_DEFAULT);
+}
 
-		ret->appearances = appearances;
-		ret->appearanceCapacity = appearanceCapacity;
+BAR_CODE_EXPORT void FreeBarCodeFindTemporaryMemory(BarCodeFindTemporaryMemory* memory)
+{
+	free_bar_code_find_temporary_memory(memory);
+}
 
-		ret->appearanceSortBuffer = appearanceSortBuffer;
-		ret->appearanceSortBufferCapacity = appearanceSortBufferCapacity;
-		ret->appearanceSortMatchScoreBuffer = appearanceSortMatchScoreBuffer;
+BAR_CODE_EXPORT void SetBarCodeFindPairing(BarCodeFindTemporaryMemory* memory, int maxPairDistance, int maxPairNeighbors)
+{
+	memory->pairing.maxDistance = maxPairDistance < 0 ? 0 : maxPairDistance;
+	memory->pairing.maxNeighbors = maxPairNeighbors < 0 ? 0 : (maxPairNeighbors > BAR_CODE_MAX_PAIR_NEIGHBORS ? BAR_CODE_MAX_PAIR_NEIGHBORS : maxPairNeighbors);
+}
 
-		return ret;
-	}
+BAR_CODE_EXPORT void SetBarCodeFindMemoryGrowth(BarCodeFindTemporaryMemory* memory, size_t maxScanLineCapacity, size_t maxYellowBoxCapacity, size_t maxAppearanceCapacity, size_t maxAppearanceSortBufferCapacity)
+{
+	memory->maxCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES] = maxScanLineCapacity;
+	memory->maxCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] = maxYellowBoxCapacity;
+	memory->maxCapacities[BAR_CODE_FIND_STAGE_APPEARANCES] = maxAppearanceCapacity;
+	memory->maxCapacities[BAR_CODE_FIND_STAGE_MATCHES] = maxAppearanceSortBufferCapacity;
 }
 
-_declspec(dllexport) FreeBarCodeFindTemporaryMemory(BarCodeFindTemporaryMemory* memory)
+BAR_CODE_EXPORT bool TryGetBarCodeFindStageUsage(BarCodeFindTemporaryMemory* memory, int stage, size_t* capacity, size_t* used, size_t* highWater, bool* overflowed)
 {
-	free(memory->scanLines);
-	free(memory->yellowBoxes);
-	free(memory->temporaryIndexBuffer);
-	free(memory->appearances);
-	free(memory->appearanceSortBuffer);
-	free(memory->appearanceSortMatchScoreBuffer);
+	if (stage < 0 || stage >= BAR_CODE_FIND_STAGE_COUNT || memory->usage == NULL)
+		return false;
+
+	*capacity = get_bar_code_find_stage_capacity(memory, (BarCodeFindStage)stage);
+	*used = memory->usage[stage].used;
+	*highWater = memory->usage[stage].highWater;
+	*overflowed = memory->usage[stage].overflowed;
+	return true;
 }
 
-_declspec(dllexport) BarCodeFindContext* AllocateBarCodeFindContextArray(size_t count)
+BAR_CODE_EXPORT bool EnableBarCodeFindStats(BarCodeFindTemporaryMemory* memory, size_t maxContextCount)
 {
-	return (BarCodeFindContext*)malloc(sizeof(BarCodeFindContext) * count);
+	return enable_bar_code_find_stats(memory, maxContextCount);
 }
 
-_declspec(dllexport) void FreeBarCodeFindContextArray(BarCodeFindContext* array)
+BAR_CODE_EXPORT bool TryGetBarCodeFindCounter(BarCodeFindTemporaryMemory* memory, int counter, uint64_t* value)
 {
-	free(array);
+	if (counter < 0 || counter >= BAR_CODE_FIND_COUNTER_COUNT || memory->stats == NULL)
+		return false;
+
+	*value = memory->stats->counters[counter];
+	return true;
 }
 
-_declspec(dllexport) bool TryInitBarCodeFindContext(BarCodeFindContext* array, size_t index, size_t appearanceBufferCapacity, int barCodeColorCount, BarCodeColor* barCodeColors, float minMatchScore, int minLineDistance)
+BAR_CODE_EXPORT bool TryGetBarCodeFindKeptAppearanceCount(BarCodeFindTemporaryMemory* memory, size_t contextIndex, size_t* count)
 {
-	BarCodeAppearance* appearanceBuf = (BarCodeAppearance*)malloc(sizeof(BarCodeAppearance) * appearanceBufferCapacity);
-	if (appearanceBuf == NULL)
+	if (memory->stats == NULL || contextIndex >= memory->stats->contextCount || contextIndex >= memory->stats->keptAppearanceCountCapacity)
 		return false;
-	float* appearanceMatchScores = (float*)malloc(sizeof(float) * appearanceBufferCapacity);
-	if (appearanceMatchScores == NULL)
-	{
-		free(appearanceBuf);
+
+	*count = memory->stats->keptAppearanceCounts[contextIndex];
+	return true;
+}
+
+///<summary>Describes the buffers that <see cref="AllocateBarCodeFindContextArrayInArena"/> carved for the contexts of an array. It has its own region
+///between the arena's and the array's.</summary>
+typedef struct _ContextArrayHeader
+{
+	///<summary>The capacity of the buffers of each context in the arena. Unlike <see cref="BarCodeFindContext.appearanceBufferCapacity"/>, it does not
+	///change when a context is initialized with another capacity.</summary>
+	size_t appearanceBufferCapacity;
+
+	///<summary>The first byte of the buffers of the first context, or NULL if the arena has none. The buffers of each context follow those of the
+	///previous one.</summary>
+	uint8_t* buffers;
+} _ContextArrayHeader;
+
+///<summary>Gets the <see cref="_ContextArrayHeader"/> of an array that was allocated by <see cref="AllocateBarCodeFindContextArrayInArena"/>.</summary>
+static _ContextArrayHeader* _get_context_array_header(BarCodeFindContext* array)
+{
+	return (_ContextArrayHeader*)((uint8_t*)array - get_bar_code_arena_region_size(sizeof(_ContextArrayHeader)));
+}
+
+///<summary>Gets the <see cref="BarCodeArena"/> of an array that was allocated by <see cref="AllocateBarCodeFindContextArrayInArena"/>. The array always
+///follows the arena's own region and the region of its <see cref="_ContextArrayHeader"/>.</summary>
+static BarCodeArena* _get_context_array_arena(BarCodeFindContext* array)
+{
+	BarCodeArena* arena = (BarCodeArena*)((uint8_t*)_get_context_array_header(array) - get_bar_code_arena_region_size(sizeof(BarCodeArena)));
+	assert(arena->base == (uint8_t*)arena);
+	return arena;
+}
+
+///<summary>Gets the buffers of a context in the arena of its array.</summary>
+///<returns>False if the arena has no buffers that can hold <paramref name="appearanceBufferCapacity"/> appearances.</returns>
+static bool _try_get_context_arena_buffers(BarCodeFindContext* array, size_t index, size_t appearanceBufferCapacity, BarCodeAppearance** appearanceBuffer, float** appearanceMatchScores)
+{
+	const _ContextArrayHeader* header = _get_context_array_header(array);
+	if (header->buffers == NULL || header->appearanceBufferCapacity < appearanceBufferCapacity)
 		return false;
+
+	size_t appearanceRegionSize = get_bar_code_arena_region_size(header->appearanceBufferCapacity * sizeof(BarCodeAppearance));
+	size_t matchScoreRegionSize = get_bar_code_arena_region_size(header->appearanceBufferCapacity * sizeof(float));
+	uint8_t* buffers = header->buffers + (index * (appearanceRegionSize + matchScoreRegionSize));
+	*appearanceBuffer = (BarCodeAppearance*)buffers;
+	*appearanceMatchScores = (float*)(buffers + appearanceRegionSize);
+	return true;
+}
+
+BAR_CODE_EXPORT BarCodeFindContext* AllocateBarCodeFindContextArrayInArena(size_t count, size_t appearanceBufferCapacity, int arenaFlags)
+{
+	//The header and the array come first, then the buffers of each context, each on their own cache lines
+	size_t size = 0;
+	if (!_add_arena_region(&size, 1, sizeof(_ContextArrayHeader)) || !_add_arena_region(&size, count, sizeof(BarCodeFindContext)))
+		return NULL;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!_add_arena_region(&size, appearanceBufferCapacity, sizeof(BarCodeAppearance)) || !_add_arena_region(&size, appearanceBufferCapacity, sizeof(float)))
+			return NULL;
+	}
+
+	BarCodeArena* arena = create_bar_code_arena(size, arenaFlags);
+	if (arena == NULL)
+		return NULL;
+
+	_ContextArrayHeader* header = (_ContextArrayHeader*)bar_code_arena_alloc(arena, sizeof(_ContextArrayHeader));
+	BarCodeFindContext* array = (BarCodeFindContext*)bar_code_arena_alloc(arena, count * sizeof(BarCodeFindContext));
+	header->appearanceBufferCapacity = appearanceBufferCapacity;
+	header->buffers = count > 0 && appearanceBufferCapacity > 0 ? arena->base + arena->used : NULL;
+	for (size_t i = 0; i < count && appearanceBufferCapacity > 0; i++)
+	{
+		array[i].appearanceBuffer = (BarCodeAppearance*)bar_code_arena_alloc(arena, appearanceBufferCapacity * sizeof(BarCodeAppearance));
+		array[i].appearanceMatchScores = (float*)bar_code_arena_alloc(arena, appearanceBufferCapacity * sizeof(float));
+		array[i].appearanceBufferCapacity = appearanceBufferCapacity;
+	}
+	return array;
+}
+
+BAR_CODE_EXPORT BarCodeFindContext* AllocateBarCodeFindContextArray(size_t count)
+{
+	return AllocateBarCodeFindContextArrayInArena(count, 0, BAR_CODE_ARENA_DEFAULT);
+}
+
+BAR_CODE_EXPORT void FreeBarCodeFindContextArray(BarCodeFindContext* array)
+{
+	destroy_bar_code_arena(_get_context_array_arena(array));
+}
+
+///<summary>Frees the buffers of a context unless they are in the arena of its array.</summary>
+static void _free_context_buffers(BarCodeFindContext* array, size_t index)
+{
+	//The buffers in the arena are freed with the array, and can be used again by TryInitBarCodeFindContext until then
+	if (bar_code_arena_contains(_get_context_array_arena(array), array[index].appearanceBuffer))
+		return;
+
+	array[index].appearanceBufferCapacity = 0;
+	free(array[index].appearanceBuffer);
+	free(array[index].appearanceMatchScores);
+	array[index].appearanceBuffer = NULL;
+	array[index].appearanceMatchScores = NULL;
+}
+
+BAR_CODE_EXPORT bool TryInitBarCodeFindContext(BarCodeFindContext* array, size_t index, size_t appearanceBufferCapacity, int barCodeColorCount, BarCodeColor* barCodeColors, float minMatchScore, int minLineDistance)
+{
+	//Free the buffers of an earlier initialization that were allocated separately
+	_free_context_buffers(array, index);
+
+	//Use the context's buffers in the arena if they are big enough, and allocate them separately otherwise
+	BarCodeAppearance* appearanceBuf;
+	float* appearanceMatchScores;
+	if (!_try_get_context_arena_buffers(array, index, appearanceBufferCapacity, &appearanceBuf, &appearanceMatchScores))
+	{
+		appearanceBuf = (BarCodeAppearance*)malloc(sizeof(BarCodeAppearance) * appearanceBufferCapacity);
+		if (appearanceBuf == NULL)
+			return false;
+		appearanceMatchScores = (float*)malloc(sizeof(float) * appearanceBufferCapacity);
+		if (appearanceMatchScores == NULL)
+		{
+			free(appearanceBuf);
+			return false;
+		}
 	}
 
 	array[index].appearanceBuffer = appearanceBuf;
 	array[index].appearanceBufferCapacity = appearanceBufferCapacity;
 	array[index].appearanceCount = 0;
 	array[index].appearanceMatchScores = appearanceMatchScores;
+	array[index].appearanceIndices = NULL;
+	array[index].appearancePool = NULL;
 	
 	array[index].barCode.colorCount = barCodeColorCount;
 	for(int i = 0; i < array[index].barCode.colorCount; i++)
@@ -105,16 +217,21 @@ _declspec(dllexport) bool TryInitBarCodeFindContext(BarCodeFindContext* array, s
 	return true;
 }
 
-_declspec(dllexport) int GetBarCodeAppearanceCount(BarCodeFindContext* contextArray, size_t index)
+BAR_CODE_EXPORT int GetBarCodeAppearanceCount(BarCodeFindContext* contextArray, size_t index)
 {
 	return (int)contextArray[index].appearanceCount;
 }
 
-_declspec(dllexport) bool TryReadBarCodeAppearance(BarCodeFindContext* contextArray, size_t contextIndex, size_t appearanceIndex, int* points, float* matchScore)
+BAR_CODE_EXPORT bool TryReadBarCodeAppearance(BarCodeFindContext* contextArray, size_t contextIndex, size_t appearanceIndex, int* points, float* matchScore)
 {
 	if (appearanceIndex >= contextArray[contextIndex].appearanceCount)
 		return false;
-	BarCodeAppearance appearance = contextArray[contextIndex].appearanceBuffer[appearanceIndex];
+	const BarCodeFindContext* context = &contextArray[contextIndex];
+	BarCodeAppearance appearance;
+	if (context->appearanceIndices != NULL)
+		get_pool_appearance(context->appearancePool, _get_pool_block(context->appearancePool, context->barCode.colorCount), context->appearanceIndices[appearanceIndex], &appearance);
+	else
+		appearance = context->appearanceBuffer[appearanceIndex];
 
 	points[0] = appearance.colorStartX;
 	points[1] = appearance.colorStartY;
@@ -137,46 +254,191 @@ _declspec(dllexport) bool TryReadBarCodeAppearance(BarCodeFindContext* contextAr
 	return true;
 }
 
-_declspec(dllexport) void ReleaseBarCodeFindContext(BarCodeFindContext* array, size_t index)
+BAR_CODE_EXPORT void ReleaseBarCodeFindContext(BarCodeFindContext* array, size_t index)
 {
-	array[index].appearanceBufferCapacity = 0;
-	free(array[index].appearanceBuffer);
-	array[index].appearanceBuffer = NULL;
+	_free_context_buffers(array, index);
 }
 
-_declspec(dllexport) void FindAppearancesOfBarCodeInterestsInBitmap(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory)
+BAR_CODE_EXPORT void FindAppearancesOfBarCodeInterestsInBitmap(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory)
 {
 	find_appearances_of_bar_code_interests_in_bitmap(rgba8, width, height, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory);
+	grow_bar_code_find_temporary_memory(memory);
 }
 
-_declspec(dllexport) void ConvertFromBGRAToRGBA(const uint8_t* src, uint8_t* dst, int width, int height)
+BAR_CODE_EXPORT void FindAppearancesOfBarCodeInterestsInRegions(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, const BarCodeSearchRegion* regions, size_t regionCount, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory)
 {
-	for (int i = 0; i < width * height * 4; i += 4)
-	{
-		uint8_t b = src[i + 0];
-		uint8_t g = src[i + 1];
-		uint8_t r = src[i + 2];
-		uint8_t a = src[i + 3];
-
-		dst[i + 0] = r;
-		dst[i + 1] = g;
-		dst[i + 2] = b;
-		dst[i + 3] = a;
-	}
+	find_appearances_of_bar_code_interests_in_regions(rgba8, width, height, yellowCfg, maxYellowSpacing, regions, regionCount, contexts, contextCount, *memory);
+	grow_bar_code_find_temporary_memory(memory);
 }
 
-_declspec(dllexport) void ConvertFromRGBAToBGRA(uint8_t* src, uint8_t* dst, int width, int height)
+BAR_CODE_EXPORT BarCodeFindWorkers* AllocateBarCodeFindWorkers(int threadCount)
 {
-	for (int i = 0; i < width * height * 4; i += 4)
-	{
-		uint8_t r = src[i + 0];
-		uint8_t g = src[i + 1];
-		uint8_t b = src[i + 2];
-		uint8_t a = src[i + 3];
-
-		dst[i + 0] = b;
-		dst[i + 1] = g;
-		dst[i + 2] = r;
-		dst[i + 3] = a;
-	}
-}
\ No newline at end of file
+	return create_bar_code_find_workers(threadCount);
+}
+
+BAR_CODE_EXPORT void FreeBarCodeFindWorkers(BarCodeFindWorkers* workers)
+{
+	destroy_bar_code_find_workers(workers);
+}
+
+BAR_CODE_EXPORT int GetBarCodeFindWorkerThreadCount(BarCodeFindWorkers* workers)
+{
+	return get_thread_pool_size(workers->pool);
+}
+
+BAR_CODE_EXPORT void FindAppearancesOfBarCodeInterestsInBitmapParallel(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFindWorkers* workers)
+{
+	find_appearances_of_bar_code_interests_in_bitmap_parallel(rgba8, width, height, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory, workers);
+	grow_bar_code_find_temporary_memory(memory);
+}
+
+BAR_CODE_EXPORT BarCodeTracker* AllocateBarCodeTracker(int fullScanInterval, int searchMargin)
+{
+	BarCodeTracker* tracker = (BarCodeTracker*)malloc(sizeof(BarCodeTracker));
+	if (tracker != NULL)
+		init_bar_code_tracker(tracker, fullScanInterval, searchMargin);
+	return tracker;
+}
+
+BAR_CODE_EXPORT void FreeBarCodeTracker(BarCodeTracker* tracker)
+{
+	free_bar_code_tracker(tracker);
+	free(tracker);
+}
+
+BAR_CODE_EXPORT void ResetBarCodeTracker(BarCodeTracker* tracker)
+{
+	reset_bar_code_tracker(tracker);
+}
+
+BAR_CODE_EXPORT bool TrackBarCodeInterestsInBitmap(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFindWorkers* workers, BarCodeTracker* tracker)
+{
+	bool fullScan = track_bar_code_interests_in_bitmap(tracker, rgba8, width, height, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory, workers);
+	grow_bar_code_find_temporary_memory(memory);
+	return fullScan;
+}
+
+///<summary>Describes the pixels that were passed to an export as a <see cref="BarCodeImage"/>.</summary>
+///<returns>False if <paramref name="format"/> is not a <see cref="BarCodePixelFormat"/>, or if <paramref name="stride"/> is not zero but is smaller than a row
+///(or, for NV12 with an odd width, than a chroma row).</returns>
+static bool _try_get_bar_code_image(const uint8_t* pixels, int width, int height, size_t stride, int format, BarCodeImage* image)
+{
+	if (format < 0 || format >= BAR_CODE_PIXEL_FORMAT_COUNT)
+		return false;
+
+	*image = bar_code_image(pixels, width, height, stride, (BarCodePixelFormat)format);
+	return stride == 0 || stride >= _get_image_min_stride(image);
+}
+
+BAR_CODE_EXPORT void FindAppearancesOfBarCodeInterestsInImage(const uint8_t* pixels, int width, int height, size_t stride, int format, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFindWorkers* workers)
+{
+	BarCodeImage image;
+	if (!_try_get_bar_code_image(pixels, width, height, stride, format, &image))
+		return;
+
+	if (workers != NULL)
+		find_appearances_of_bar_code_interests_in_image_parallel(&image, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory, workers);
+	else
+		find_appearances_of_bar_code_interests_in_image(&image, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory);
+	grow_bar_code_find_temporary_memory(memory);
+}
+
+BAR_CODE_EXPORT bool TrackBarCodeInterestsInImage(const uint8_t* pixels, int width, int height, size_t stride, int format, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFindWorkers* workers, BarCodeTracker* tracker)
+{
+	BarCodeImage image;
+	if (!_try_get_bar_code_image(pixels, width, height, stride, format, &image))
+		return false;
+
+	bool fullScan = track_bar_code_interests_in_image(tracker, &image, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory, workers);
+	grow_bar_code_find_temporary_memory(memory);
+	return fullScan;
+}
+
+///<summary>Describes one frame of a batch that is passed to <see cref="FindAppearancesOfBarCodeInterestsInImages"/>, with the same values as the
+///arguments of <see cref="FindAppearancesOfBarCodeInterestsInImage"/>.</summary>
+typedef struct BarCodeFrameDescriptor
+{
+	const uint8_t* pixels;
+	int width;
+	int height;
+	size_t stride;
+	int format;
+} BarCodeFrameDescriptor;
+
+BAR_CODE_EXPORT bool FindAppearancesOfBarCodeInterestsInImages(const BarCodeFrameDescriptor* frames, size_t frameCount, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodeFindWorkers* workers, BarCodeFrameMatch* matches, size_t* matchCounts)
+{
+	if (frameCount == 0)
+		return true;
+
+	BarCodeImage* images = (BarCodeImage*)malloc(frameCount * sizeof(BarCodeImage));
+	if (images == NULL)
+		return false;
+
+	//Nothing is searched unless every frame is valid, so the results never mix searched and unsearched frames
+	bool searched = true;
+	for (size_t i = 0; i < frameCount && searched; i++)
+		searched = _try_get_bar_code_image(frames[i].pixels, frames[i].width, frames[i].height, frames[i].stride, frames[i].format, &images[i]);
+	if (searched)
+		searched = find_appearances_of_bar_code_interests_in_images(workers, images, frameCount, yellowCfg, maxYellowSpacing, contexts, contextCount, memory, matches, matchCounts);
+
+	free(images);
+	return searched;
+}
+
+BAR_CODE_EXPORT BarCodePyramid* AllocateBarCodePyramid(void)
+{
+	BarCodePyramid* pyramid = (BarCodePyramid*)malloc(sizeof(BarCodePyramid));
+	if (pyramid != NULL)
+		init_bar_code_pyramid(pyramid);
+	return pyramid;
+}
+
+BAR_CODE_EXPORT void FreeBarCodePyramid(BarCodePyramid* pyramid)
+{
+	free_bar_code_pyramid(pyramid);
+	free(pyramid);
+}
+
+BAR_CODE_EXPORT void FindAppearancesOfBarCodeInterestsInBitmapCoarse(const uint8_t* rgba8, int width, int height, YellowConfig yellowCfg, int maxYellowSpacing, BarCodeFindContext* contexts, size_t contextCount, BarCodeFindTemporaryMemory* memory, BarCodePyramid* pyramid, int scale)
+{
+	find_appearances_of_bar_code_interests_in_bitmap_coarse(pyramid, scale, rgba8, width, height, yellowCfg, maxYellowSpacing, contexts, contextCount, *memory);
+	grow_bar_code_find_temporary_memory(memory);
+}
+
+BAR_CODE_EXPORT void ConvertFromBGRAToRGBA(const uint8_t* src, uint8_t* dst, int width, int height)
+{
+	const uint8_t* srcPlanes[3] = { src, NULL, NULL };
+	uint8_t* dstPlanes[3] = { dst, NULL, NULL };
+	convert_bar_code_pixels(NULL, BAR_CODE_CONVERSION_SWAP_RED_BLUE, srcPlanes, 0, dstPlanes, 0, width, height);
+}
+
+BAR_CODE_EXPORT void ConvertFromRGBAToBGRA(uint8_t* src, uint8_t* dst, int width, int height)
+{
+	const uint8_t* srcPlanes[3] = { src, NULL, NULL };
+	uint8_t* dstPlanes[3] = { dst, NULL, NULL };
+	convert_bar_code_pixels(NULL, BAR_CODE_CONVERSION_SWAP_RED_BLUE, srcPlanes, 0, dstPlanes, 0, width, height);
+}
+
+BAR_CODE_EXPORT bool ConvertBarCodePixels(int conversion, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height, BarCodeFindWorkers* workers)
+{
+	if (conversion == BAR_CODE_CONVERSION_PLANES_TO_RGBA8 || conversion == BAR_CODE_CONVERSION_RGBA8_TO_PLANES)
+		return false;//These take three planes (see InterleaveBarCodePlanes and SplitBarCodePlanes)
+
+	const uint8_t* srcPlanes[3] = { src, NULL, NULL };
+	uint8_t* dstPlanes[3] = { dst, NULL, NULL };
+	return convert_bar_code_pixels(workers != NULL ? workers->pool : NULL, (BarCodeConversion)conversion, srcPlanes, srcStride, dstPlanes, dstStride, width, height);
+}
+
+BAR_CODE_EXPORT bool InterleaveBarCodePlanes(const uint8_t* reds, const uint8_t* greens, const uint8_t* blues, size_t planeStride, uint8_t* rgba8, size_t stride, int width, int height, BarCodeFindWorkers* workers)
+{
+	const uint8_t* srcPlanes[3] = { reds, greens, blues };
+	uint8_t* dstPlanes[3] = { rgba8, NULL, NULL };
+	return convert_bar_code_pixels(workers != NULL ? workers->pool : NULL, BAR_CODE_CONVERSION_PLANES_TO_RGBA8, srcPlanes, planeStride, dstPlanes, stride, width, height);
+}
+
+BAR_CODE_EXPORT bool SplitBarCodePlanes(const uint8_t* rgba8, size_t stride, uint8_t* reds, uint8_t* greens, uint8_t* blues, size_t planeStride, int width, int height, BarCodeFindWorkers* workers)
+{
+	const uint8_t* srcPlanes[3] = { rgba8, NULL, NULL };
+	uint8_t* dstPlanes[3] = { reds, greens, blues };
+	return convert_bar_code_pixels(workers != NULL ? workers->pool : NULL, BAR_CODE_CONVERSION_RGBA8_TO_PLANES, srcPlanes, stride, dstPlanes, planeStride, width, height);
+}
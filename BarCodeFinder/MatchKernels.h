@@ -0,0 +1,185 @@
+#pragma once
+#include "Platform.h"
+#include "YellowKernels.h"
+#include <stdint.h>
+#include <stddef.h>
+
+///<summary>Scores a set of bar code appearances against one bar code, in both directions, and keeps the better direction.</summary>
+///<param name="planes">The appearances' colors, where row 'p' (of <paramref name="planeStride"/> floats) holds the value of plane 'p' for every appearance.</param>
+///<param name="planeStride">The number of floats between the starts of two rows of <paramref name="planes"/>.</param>
+///<param name="appearanceCount">The number of appearances to score, which cannot be larger than <paramref name="planeStride"/>.</param>
+///<param name="forwardPlanes">The row of each term when the line is read forward.</param>
+///<param name="reversePlanes">The row of each term when the line is read in reverse.</param>
+///<param name="weights">The weight of each term, which must be +1.0f or -1.0f.</param>
+///<param name="termCount">The number of terms.</param>
+///<param name="sectionCount">The number of sections, which the sum of the terms is divided by.</param>
+///<param name="scores">Receives the score of each appearance, clamped from 0.0f to 1.0f (a score that is not a number stays that way).</param>
+///<remarks>Each weight is exactly +1 or -1, so every product is exact and each term adds or subtracts a value in the same order as
+///<see cref="_quantify_bar_code_appearance_match"/>. The kernels of every level therefore produce exactly the same scores as it does.</remarks>
+typedef void(*ScoreAppearancesFunction)(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores);
+
+///<summary>Table of match scoring kernels that were compiled for a specific <see cref="YellowKernelLevel"/>.</summary>
+typedef struct MatchKernels
+{
+	///<summary>The instruction set used by the kernels in this table.</summary>
+	YellowKernelLevel level;
+
+	///<summary>Scores many appearances against one bar code at once (see <see cref="ScoreAppearancesFunction"/>).</summary>
+	ScoreAppearancesFunction scoreAppearances;
+} MatchKernels;
+
+static void _score_appearances_scalar(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores)
+{
+	for (size_t a = 0; a < appearanceCount; a++)
+	{
+		float forward = 0.0f, reverse = 0.0f;
+		for (int t = 0; t < termCount; t++)
+		{
+			forward += weights[t] * planes[((size_t)forwardPlanes[t] * planeStride) + a];
+			reverse += weights[t] * planes[((size_t)reversePlanes[t] * planeStride) + a];
+		}
+
+		forward /= (float)sectionCount;
+		reverse /= (float)sectionCount;
+		if (forward < 0.0f)
+			forward = 0.0f;
+		if (forward > 1.0f)
+			forward = 1.0f;
+		if (reverse < 0.0f)
+			reverse = 0.0f;
+		if (reverse > 1.0f)
+			reverse = 1.0f;
+		scores[a] = forward > reverse ? forward : reverse;
+	}
+}
+
+#if defined(BAR_CODE_X86)
+
+//The clamps below use max(0, x) and min(1, x) in that operand order, which return 'x' when it is not a number (or -0.0f) just like the
+//'if' statements of the scalar kernel. The final max(forward, reverse) likewise returns 'reverse' unless 'forward' is greater.
+
+BAR_CODE_TARGET_SSE41 static void _score_appearances_sse41(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores)
+{
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), divisor = _mm_set1_ps((float)sectionCount);
+	size_t a = 0;
+	for (; a + 4 <= appearanceCount; a += 4)
+	{
+		__m128 forward = zero, reverse = zero;
+		for (int t = 0; t < termCount; t++)
+		{
+			__m128 weight = _mm_set1_ps(weights[t]);
+			forward = _mm_add_ps(forward, _mm_mul_ps(weight, _mm_loadu_ps(planes + ((size_t)forwardPlanes[t] * planeStride) + a)));
+			reverse = _mm_add_ps(reverse, _mm_mul_ps(weight, _mm_loadu_ps(planes + ((size_t)reversePlanes[t] * planeStride) + a)));
+		}
+		forward = _mm_min_ps(one, _mm_max_ps(zero, _mm_div_ps(forward, divisor)));
+		reverse = _mm_min_ps(one, _mm_max_ps(zero, _mm_div_ps(reverse, divisor)));
+		_mm_storeu_ps(scores + a, _mm_max_ps(forward, reverse));
+	}
+	_score_appearances_scalar(planes + a, planeStride, appearanceCount - a, forwardPlanes, reversePlanes, weights, termCount, sectionCount, scores + a);
+}
+
+BAR_CODE_TARGET_AVX2 static void _score_appearances_avx2(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores)
+{
+	__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), divisor = _mm256_set1_ps((float)sectionCount);
+	size_t a = 0;
+	for (; a + 8 <= appearanceCount; a += 8)
+	{
+		__m256 forward = zero, reverse = zero;
+		for (int t = 0; t < termCount; t++)
+		{
+			__m256 weight = _mm256_set1_ps(weights[t]);
+			forward = _mm256_add_ps(forward, _mm256_mul_ps(weight, _mm256_loadu_ps(planes + ((size_t)forwardPlanes[t] * planeStride) + a)));
+			reverse = _mm256_add_ps(reverse, _mm256_mul_ps(weight, _mm256_loadu_ps(planes + ((size_t)reversePlanes[t] * planeStride) + a)));
+		}
+		forward = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(forward, divisor)));
+		reverse = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(reverse, divisor)));
+		_mm256_storeu_ps(scores + a, _mm256_max_ps(forward, reverse));
+	}
+	_score_appearances_scalar(planes + a, planeStride, appearanceCount - a, forwardPlanes, reversePlanes, weights, termCount, sectionCount, scores + a);
+}
+
+//Every processor with AVX2 also has FMA3 in practice, but the two are reported separately, so this kernel is only used when both are
+BAR_CODE_TARGET_AVX2_FMA static void _score_appearances_avx2_fma(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores)
+{
+	__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), divisor = _mm256_set1_ps((float)sectionCount);
+	size_t a = 0;
+	for (; a + 8 <= appearanceCount; a += 8)
+	{
+		__m256 forward = zero, reverse = zero;
+		for (int t = 0; t < termCount; t++)
+		{
+			//A fused multiply-add rounds once, but the product of +1 or -1 is exact, so it still matches the scalar kernel
+			__m256 weight = _mm256_set1_ps(weights[t]);
+			forward = _mm256_fmadd_ps(weight, _mm256_loadu_ps(planes + ((size_t)forwardPlanes[t] * planeStride) + a), forward);
+			reverse = _mm256_fmadd_ps(weight, _mm256_loadu_ps(planes + ((size_t)reversePlanes[t] * planeStride) + a), reverse);
+		}
+		forward = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(forward, divisor)));
+		reverse = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(reverse, divisor)));
+		_mm256_storeu_ps(scores + a, _mm256_max_ps(forward, reverse));
+	}
+	_score_appearances_scalar(planes + a, planeStride, appearanceCount - a, forwardPlanes, reversePlanes, weights, termCount, sectionCount, scores + a);
+}
+
+BAR_CODE_TARGET_AVX512 static void _score_appearances_avx512(const float* planes, size_t planeStride, size_t appearanceCount, const uint16_t* forwardPlanes, const uint16_t* reversePlanes, const float* weights, int termCount, int sectionCount, float* scores)
+{
+	__m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f), divisor = _mm512_set1_ps((float)sectionCount);
+	for (size_t a = 0; a < appearanceCount; a += 16)
+	{
+		//The last group is partial, so use masked loads (which never touch the values beyond the end of a row)
+		size_t remaining = appearanceCount - a;
+		__mmask16 valid = remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+		__m512 forward = zero, reverse = zero;
+		for (int t = 0; t < termCount; t++)
+		{
+			//A fused multiply-add rounds once, but the product of +1 or -1 is exact, so it still matches the scalar kernel
+			__m512 weight = _mm512_set1_ps(weights[t]);
+			forward = _mm512_fmadd_ps(weight, _mm512_maskz_loadu_ps(valid, planes + ((size_t)forwardPlanes[t] * planeStride) + a), forward);
+			reverse = _mm512_fmadd_ps(weight, _mm512_maskz_loadu_ps(valid, planes + ((size_t)reversePlanes[t] * planeStride) + a), reverse);
+		}
+		forward = _mm512_min_ps(one, _mm512_max_ps(zero, _mm512_div_ps(forward, divisor)));
+		reverse = _mm512_min_ps(one, _mm512_max_ps(zero, _mm512_div_ps(reverse, divisor)));
+		_mm512_mask_storeu_ps(scores + a, valid, _mm512_max_ps(forward, reverse));
+	}
+}
+
+#endif
+
+///<summary>All <see cref="MatchKernels"/> tables, indexed by <see cref="YellowKernelLevel"/>.</summary>
+static const MatchKernels _matchKernelTables[] =
+{
+	{ YELLOW_KERNEL_SCALAR, _score_appearances_scalar },
+#if defined(BAR_CODE_X86)
+	{ YELLOW_KERNEL_SSE41, _score_appearances_sse41 },
+	{ YELLOW_KERNEL_AVX2, _score_appearances_avx2 },
+	{ YELLOW_KERNEL_AVX512, _score_appearances_avx512 },
+#endif
+};
+
+#if defined(BAR_CODE_X86)
+///<summary>The <see cref="YELLOW_KERNEL_AVX2"/> table for hosts that also support FMA3 (SSE4.1 has no fused multiply-add).</summary>
+static const MatchKernels _avx2FmaMatchKernels = { YELLOW_KERNEL_AVX2, _score_appearances_avx2_fma };
+
+///<summary>Whether the host supports FMA3: -1 until it has been detected.</summary>
+static int _fmaSupport = -1;
+
+///<summary>Checks whether <see cref="_avx2FmaMatchKernels"/> can be used, detecting it on first use.</summary>
+BAR_CODE_FORCEINLINE bool _has_fma_match_kernels(void)
+{
+	if (_fmaSupport < 0)
+		_fmaSupport = (detect_cpu_features() & CPU_FEATURE_FMA) != 0;
+	return _fmaSupport != 0;
+}
+#endif
+
+///<summary>Gets the <see cref="MatchKernels"/> table of the same <see cref="YellowKernelLevel"/> as <see cref="get_yellow_kernels"/>, so
+///<see cref="select_yellow_kernels"/> and the BARCODEFINDER_KERNEL environment variable select both.</summary>
+///<returns>The <see cref="MatchKernels"/> table to use.</returns>
+BAR_CODE_FORCEINLINE const MatchKernels* get_match_kernels(void)
+{
+	YellowKernelLevel level = get_yellow_kernels()->level;
+#if defined(BAR_CODE_X86)
+	if (level == YELLOW_KERNEL_AVX2 && _has_fma_match_kernels())
+		return &_avx2FmaMatchKernels;
+#endif
+	return &_matchKernelTables[level];
+}
@@ -0,0 +1,231 @@
+#pragma once
+//Every header of the library includes this one before any system header, so this also exposes the POSIX and BSD extensions that they use
+//(such as MAP_ANONYMOUS in BarCodeArena.h, and clock_gettime below) in a strict C11 build, where the C library hides them by default.
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+///<summary>Defined when compiling for an x86 or x64 processor, which is required for all SIMD kernels.</summary>
+#define BAR_CODE_X86 (1)
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+///<summary>Forces a function to be inlined into its caller.</summary>
+#define BAR_CODE_FORCEINLINE static __forceinline
+
+///<summary>Exports a function from the shared library.</summary>
+#define BAR_CODE_EXPORT __declspec(dllexport)
+
+//MSVC allows any intrinsic in any function, so no per-function target is required
+#define BAR_CODE_TARGET_SSE41
+#define BAR_CODE_TARGET_AVX2
+#define BAR_CODE_TARGET_AVX2_FMA
+#define BAR_CODE_TARGET_AVX512
+#else
+#if defined(BAR_CODE_X86)
+#include <cpuid.h>
+#endif
+
+///<summary>Forces a function to be inlined into its caller.</summary>
+#define BAR_CODE_FORCEINLINE static inline __attribute__((always_inline))
+
+///<summary>Exports a function from the shared library.</summary>
+#define BAR_CODE_EXPORT __attribute__((visibility("default")))
+
+///<summary>Allows a function to use SSE4.1 instructions regardless of the compiler flags. The function must only
+///be called after <see cref="detect_cpu_features"/> has confirmed that the host supports it.</summary>
+#define BAR_CODE_TARGET_SSE41 __attribute__((target("sse4.1")))
+
+///<summary>Allows a function to use AVX2 instructions regardless of the compiler flags.</summary>
+#define BAR_CODE_TARGET_AVX2 __attribute__((target("avx2")))
+
+///<summary>Allows a function to use AVX2 and FMA3 instructions regardless of the compiler flags.</summary>
+#define BAR_CODE_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+
+///<summary>Allows a function to use AVX-512 (F, BW, DQ and VL) instructions regardless of the compiler flags.</summary>
+#define BAR_CODE_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw,avx512dq,avx512vl")))
+#endif
+
+#if defined(BAR_CODE_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+///<summary>Counts the number of clear bits below the lowest set bit (TZCNT).</summary>
+///<param name="value">The value, which must not be zero.</param>
+///<returns>The index of the lowest set bit, from 0 to 63.</returns>
+BAR_CODE_FORCEINLINE int count_trailing_zeros64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)value))
+		return (int)index;
+	_BitScanForward(&index, (unsigned long)(value >> 32));
+	return (int)index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+///<summary>Counts the number of clear bits above the highest set bit (LZCNT).</summary>
+///<param name="value">The value, which must not be zero.</param>
+///<returns>The number of leading clear bits, from 0 to 63.</returns>
+BAR_CODE_FORCEINLINE int count_leading_zeros64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return 63 - (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+		return 31 - (int)index;
+	_BitScanReverse(&index, (unsigned long)value);
+	return 63 - (int)index;
+#else
+	return __builtin_clzll(value);
+#endif
+}
+
+///<summary>Instruction set extensions that may be reported by <see cref="detect_cpu_features"/>.</summary>
+typedef enum CpuFeature
+{
+	CPU_FEATURE_SSE41 = 1 << 0,
+	CPU_FEATURE_AVX2 = 1 << 1,
+	CPU_FEATURE_AVX512F = 1 << 2,
+	CPU_FEATURE_AVX512BW = 1 << 3,
+	CPU_FEATURE_AVX512DQ = 1 << 4,
+	CPU_FEATURE_AVX512VL = 1 << 5,
+	CPU_FEATURE_FMA = 1 << 6
+} CpuFeature;
+
+///<summary>Reads the CPUID leaf <paramref name="leaf"/> (with sub-leaf <paramref name="subLeaf"/>) into
+///<paramref name="regs"/> (EAX, EBX, ECX, EDX).</summary>
+BAR_CODE_FORCEINLINE void _cpuid(unsigned int leaf, unsigned int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex((int*)regs, (int)leaf, (int)subLeaf);
+#elif defined(BAR_CODE_X86)
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#else
+	(void)leaf;
+	(void)subLeaf;
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+///<summary>Reads the XCR0 register, which defines which register states the operating system saves on a context switch.</summary>
+BAR_CODE_FORCEINLINE uint64_t _xgetbv0(void)
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#elif defined(BAR_CODE_X86)
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
+///<summary>Detects which <see cref="CpuFeature"/>s can be used on the current host.</summary>
+///<returns>A combination of <see cref="CpuFeature"/> flags.</returns>
+///<remarks>A feature is only reported when both the processor supports it and the operating system saves the registers that it uses.</remarks>
+static int detect_cpu_features(void)
+{
+	int features = 0;
+#if defined(BAR_CODE_X86)
+	unsigned int regs[4];
+	_cpuid(0, 0, regs);
+	unsigned int maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return 0;
+
+	_cpuid(1, 0, regs);
+	if (regs[2] & (1u << 19))
+		features |= CPU_FEATURE_SSE41;
+
+	bool osSavesYmm = false, osSavesZmm = false;
+	if ((regs[2] & (1u << 27)) != 0/*OSXSAVE*/ && (regs[2] & (1u << 28)) != 0/*AVX*/)
+	{
+		uint64_t xcr0 = _xgetbv0();
+		osSavesYmm = (xcr0 & 0x6) == 0x6;//XMM and YMM state
+		osSavesZmm = osSavesYmm && (xcr0 & 0xE0) == 0xE0;//Opmask, upper ZMM0-15 and ZMM16-31 state
+	}
+
+	if (osSavesYmm && (regs[2] & (1u << 12)) != 0/*FMA*/)
+		features |= CPU_FEATURE_FMA;
+
+	if (maxLeaf >= 7 && osSavesYmm)
+	{
+		_cpuid(7, 0, regs);
+		if (regs[1] & (1u << 5))
+			features |= CPU_FEATURE_AVX2;
+
+		if (osSavesZmm)
+		{
+			if (regs[1] & (1u << 16))
+				features |= CPU_FEATURE_AVX512F;
+			if (regs[1] & (1u << 17))
+				features |= CPU_FEATURE_AVX512DQ;
+			if (regs[1] & (1u << 30))
+				features |= CPU_FEATURE_AVX512BW;
+			if (regs[1] & (1u << 31))
+				features |= CPU_FEATURE_AVX512VL;
+		}
+	}
+#endif
+	return features;
+}
+
+///<summary>Atomically adds <paramref name="value"/> to <paramref name="target"/>.</summary>
+///<returns>The value of <paramref name="target"/> before the addition.</returns>
+BAR_CODE_FORCEINLINE size_t atomic_fetch_add_size(volatile size_t* target, size_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return (size_t)_InterlockedExchangeAdd64((volatile long long*)target, (long long)value);
+#elif defined(_MSC_VER)
+	return (size_t)_InterlockedExchangeAdd((volatile long*)target, (long)value);
+#else
+	return __atomic_fetch_add(target, value, __ATOMIC_RELAXED);
+#endif
+}
+
+///<summary>Reads a monotonic clock.</summary>
+///<returns>The time in nanoseconds, from an arbitrary starting point.</returns>
+///<remarks>Outside Windows, this needs the POSIX clocks of <c>time.h</c>, which the <c>_DEFAULT_SOURCE</c> at the top of this file exposes.</remarks>
+BAR_CODE_FORCEINLINE uint64_t get_monotonic_nanoseconds(void)
+{
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((counter.QuadPart / frequency.QuadPart) * 1000000000ull + ((counter.QuadPart % frequency.QuadPart) * 1000000000ull) / frequency.QuadPart);
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
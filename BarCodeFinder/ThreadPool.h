@@ -0,0 +1,354 @@
+#pragma once
+#include "Platform.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+typedef HANDLE _ThreadHandle;
+typedef SRWLOCK _ThreadMutex;
+typedef CONDITION_VARIABLE _ThreadCondition;
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t _ThreadHandle;
+typedef pthread_mutex_t _ThreadMutex;
+typedef pthread_cond_t _ThreadCondition;
+#endif
+
+///<summary>The maximum number of threads in a <see cref="ThreadPool"/>, including the thread that calls <see cref="parallel_for"/>.</summary>
+#define THREAD_POOL_MAX_THREADS (256)
+
+///<summary>A function that is called once per item by <see cref="parallel_for"/>.</summary>
+///<param name="arg">The argument that was passed to <see cref="parallel_for"/>.</param>
+///<param name="index">The index of the item, from 0 to the item count (exclusive).</param>
+///<param name="workerIndex">The index of the thread that runs the item, from 0 (the calling thread) to <see cref="ThreadPool.threadCount"/> (exclusive).
+///No two items with the same worker index ever run at the same time, so it can be used to select per-thread scratch memory.</param>
+typedef void(*ThreadPoolTask)(void* arg, size_t index, int workerIndex);
+
+///<summary>The items of the current job that one thread has not run yet. The owner takes items from the front, and a thread that has run out
+///of its own items steals the back half of another thread's range.</summary>
+typedef struct _ThreadPoolRange
+{
+	///<summary>Protects <see cref="begin"/> and <see cref="end"/>. It is only held for a moment, and never together with another lock.</summary>
+	_ThreadMutex mutex;
+
+	///<summary>The first item that has not been claimed.</summary>
+	size_t begin;
+
+	///<summary>The item after the last one that has not been claimed.</summary>
+	size_t end;
+
+	///<summary>Keeps the ranges of two threads out of the same cache line.</summary>
+	uint8_t _padding[64];
+} _ThreadPoolRange;
+
+///<summary>A fixed set of threads that run the items of <see cref="parallel_for"/>.</summary>
+typedef struct ThreadPool
+{
+	///<summary>The number of threads that run items, including the thread that calls <see cref="parallel_for"/>.</summary>
+	int threadCount;
+
+	///<summary>The background threads. There are <see cref="threadCount"/> - 1 of them.</summary>
+	_ThreadHandle* threads;
+
+	///<summary>The unclaimed items of each thread, indexed by worker index. Each range has its own lock.</summary>
+	_ThreadPoolRange* ranges;
+
+	///<summary>Protects all of the fields below.</summary>
+	_ThreadMutex mutex;
+
+	///<summary>Signalled when a new job is posted, or when the pool is stopping.</summary>
+	_ThreadCondition wake;
+
+	///<summary>Signalled when the last background thread finishes the current job.</summary>
+	_ThreadCondition done;
+
+	///<summary>Incremented each time a job is posted, so that each background thread runs each job once.</summary>
+	size_t generation;
+
+	///<summary>The number of background threads that are still running the current job.</summary>
+	int activeCount;
+
+	///<summary>True when the background threads should exit.</summary>
+	bool stopping;
+
+	///<summary>The current job's function.</summary>
+	ThreadPoolTask task;
+
+	///<summary>The current job's argument.</summary>
+	void* arg;
+
+} ThreadPool;
+
+#if defined(_WIN32)
+BAR_CODE_FORCEINLINE void _mutex_init(_ThreadMutex* mutex) { InitializeSRWLock(mutex); }
+BAR_CODE_FORCEINLINE void _mutex_destroy(_ThreadMutex* mutex) { (void)mutex; }
+BAR_CODE_FORCEINLINE void _mutex_lock(_ThreadMutex* mutex) { AcquireSRWLockExclusive(mutex); }
+BAR_CODE_FORCEINLINE void _mutex_unlock(_ThreadMutex* mutex) { ReleaseSRWLockExclusive(mutex); }
+BAR_CODE_FORCEINLINE void _condition_init(_ThreadCondition* condition) { InitializeConditionVariable(condition); }
+BAR_CODE_FORCEINLINE void _condition_destroy(_ThreadCondition* condition) { (void)condition; }
+BAR_CODE_FORCEINLINE void _condition_wait(_ThreadCondition* condition, _ThreadMutex* mutex) { SleepConditionVariableSRW(condition, mutex, INFINITE, 0); }
+BAR_CODE_FORCEINLINE void _condition_broadcast(_ThreadCondition* condition) { WakeAllConditionVariable(condition); }
+#else
+BAR_CODE_FORCEINLINE void _mutex_init(_ThreadMutex* mutex) { pthread_mutex_init(mutex, NULL); }
+BAR_CODE_FORCEINLINE void _mutex_destroy(_ThreadMutex* mutex) { pthread_mutex_destroy(mutex); }
+BAR_CODE_FORCEINLINE void _mutex_lock(_ThreadMutex* mutex) { pthread_mutex_lock(mutex); }
+BAR_CODE_FORCEINLINE void _mutex_unlock(_ThreadMutex* mutex) { pthread_mutex_unlock(mutex); }
+BAR_CODE_FORCEINLINE void _condition_init(_ThreadCondition* condition) { pthread_cond_init(condition, NULL); }
+BAR_CODE_FORCEINLINE void _condition_destroy(_ThreadCondition* condition) { pthread_cond_destroy(condition); }
+BAR_CODE_FORCEINLINE void _condition_wait(_ThreadCondition* condition, _ThreadMutex* mutex) { pthread_cond_wait(condition, mutex); }
+BAR_CODE_FORCEINLINE void _condition_broadcast(_ThreadCondition* condition) { pthread_cond_broadcast(condition); }
+#endif
+
+///<summary>Gets the number of logical processors on the host.</summary>
+static int get_processor_count(void)
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+#endif
+}
+
+///<summary>Claims the next item of a thread's own range, or steals the back half of another thread's range if its own is empty.</summary>
+///<returns>True if an item was claimed, or false if no thread has any unclaimed items left.</returns>
+static bool _claim_thread_pool_item(ThreadPool* pool, int workerIndex, size_t* index)
+{
+	_ThreadPoolRange* own = &pool->ranges[workerIndex];
+	_mutex_lock(&own->mutex);
+	bool claimed = own->begin < own->end;
+	if (claimed)
+		*index = own->begin++;
+	_mutex_unlock(&own->mutex);
+	if (claimed)
+		return true;
+
+	//Visit the other threads in order, starting after this one, so that the thieves spread across the victims
+	for (int i = 1; i < pool->threadCount; i++)
+	{
+		_ThreadPoolRange* victim = &pool->ranges[(workerIndex + i) % pool->threadCount];
+		_mutex_lock(&victim->mutex);
+		size_t begin = victim->end, end = victim->end;
+		if (victim->begin < victim->end)
+		{
+			begin = victim->end - (victim->end - victim->begin + 1) / 2;
+			victim->end = begin;
+		}
+		_mutex_unlock(&victim->mutex);
+		if (begin == end)
+			continue;
+
+		//Run the first stolen item now, and keep the rest (which other thieves may steal in turn)
+		_mutex_lock(&own->mutex);
+		own->begin = begin + 1;
+		own->end = end;
+		_mutex_unlock(&own->mutex);
+		*index = begin;
+		return true;
+	}
+
+	//Every item has been claimed. Some may still be running (or be held by a thief that has not stored them in its range yet), but
+	//the thread that claimed them will run them.
+	return false;
+}
+
+///<summary>Claims and runs items of the current job until there are none left.</summary>
+static void _run_thread_pool_items(ThreadPool* pool, int workerIndex)
+{
+	size_t index;
+	while (_claim_thread_pool_item(pool, workerIndex, &index))
+		pool->task(pool->arg, index, workerIndex);
+}
+
+///<summary>The main function of a background thread.</summary>
+static void _thread_pool_worker(ThreadPool* pool, int workerIndex)
+{
+	size_t seenGeneration = 0;
+	for (;;)
+	{
+		_mutex_lock(&pool->mutex);
+		while (!pool->stopping && pool->generation == seenGeneration)
+			_condition_wait(&pool->wake, &pool->mutex);
+		if (pool->stopping)
+		{
+			_mutex_unlock(&pool->mutex);
+			return;
+		}
+		seenGeneration = pool->generation;
+		_mutex_unlock(&pool->mutex);
+
+		_run_thread_pool_items(pool, workerIndex);
+
+		_mutex_lock(&pool->mutex);
+		if (--pool->activeCount == 0)
+			_condition_broadcast(&pool->done);
+		_mutex_unlock(&pool->mutex);
+	}
+}
+
+///<summary>The arguments of <see cref="_thread_pool_entry"/>, which are packed into the thread's start argument.</summary>
+typedef struct _ThreadPoolStart
+{
+	ThreadPool* pool;
+	int workerIndex;
+} _ThreadPoolStart;
+
+#if defined(_WIN32)
+static DWORD WINAPI _thread_pool_entry(LPVOID param)
+#else
+static void* _thread_pool_entry(void* param)
+#endif
+{
+	_ThreadPoolStart start = *(_ThreadPoolStart*)param;
+	free(param);
+	_thread_pool_worker(start.pool, start.workerIndex);
+	return 0;
+}
+
+///<summary>Creates a <see cref="ThreadPool"/>.</summary>
+///<param name="threadCount">The number of threads that should run items, including the thread that calls <see cref="parallel_for"/>.
+///Zero or less selects the number of logical processors.</param>
+///<returns>The new <see cref="ThreadPool"/>, or NULL if it could not be created. Destroy it with <see cref="destroy_thread_pool"/>.</returns>
+static ThreadPool* create_thread_pool(int threadCount)
+{
+	if (threadCount <= 0)
+		threadCount = get_processor_count();
+	if (threadCount > THREAD_POOL_MAX_THREADS)
+		threadCount = THREAD_POOL_MAX_THREADS;
+
+	ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+	if (pool == NULL)
+		return NULL;
+	pool->threads = (_ThreadHandle*)calloc((size_t)threadCount, sizeof(_ThreadHandle));
+	pool->ranges = (_ThreadPoolRange*)calloc((size_t)threadCount, sizeof(_ThreadPoolRange));
+	if (pool->threads == NULL || pool->ranges == NULL)
+	{
+		free(pool->threads);
+		free(pool->ranges);
+		free(pool);
+		return NULL;
+	}
+
+	_mutex_init(&pool->mutex);
+	_mutex_init(&pool->ranges[0].mutex);
+	_condition_init(&pool->wake);
+	_condition_init(&pool->done);
+	pool->threadCount = 1;
+
+	//Start the background threads. If one cannot be started, just use fewer threads.
+	for (int i = 1; i < threadCount; i++)
+	{
+		_ThreadPoolStart* start = (_ThreadPoolStart*)malloc(sizeof(_ThreadPoolStart));
+		if (start == NULL)
+			break;
+		start->pool = pool;
+		start->workerIndex = i;
+		_mutex_init(&pool->ranges[i].mutex);
+#if defined(_WIN32)
+		HANDLE thread = CreateThread(NULL, 0, _thread_pool_entry, start, 0, NULL);
+		bool started = thread != NULL;
+		pool->threads[i - 1] = thread;
+#else
+		bool started = pthread_create(&pool->threads[i - 1], NULL, _thread_pool_entry, start) == 0;
+#endif
+		if (!started)
+		{
+			_mutex_destroy(&pool->ranges[i].mutex);
+			free(start);
+			break;
+		}
+		pool->threadCount++;
+	}
+
+	return pool;
+}
+
+///<summary>Stops the threads of a <see cref="ThreadPool"/> and frees it.</summary>
+static void destroy_thread_pool(ThreadPool* pool)
+{
+	if (pool == NULL)
+		return;
+
+	_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	_condition_broadcast(&pool->wake);
+	_mutex_unlock(&pool->mutex);
+
+	for (int i = 0; i < pool->threadCount - 1; i++)
+	{
+#if defined(_WIN32)
+		WaitForSingleObject(pool->threads[i], INFINITE);
+		CloseHandle(pool->threads[i]);
+#else
+		pthread_join(pool->threads[i], NULL);
+#endif
+	}
+
+	_condition_destroy(&pool->done);
+	_condition_destroy(&pool->wake);
+	_mutex_destroy(&pool->mutex);
+	for (int i = 0; i < pool->threadCount; i++)
+		_mutex_destroy(&pool->ranges[i].mutex);
+	free(pool->threads);
+	free(pool->ranges);
+	free(pool);
+}
+
+///<summary>Gets the number of threads that run the items of <see cref="parallel_for"/>. A NULL pool has one thread (the caller).</summary>
+BAR_CODE_FORCEINLINE int get_thread_pool_size(const ThreadPool* pool)
+{
+	return pool == NULL ? 1 : pool->threadCount;
+}
+
+///<summary>Calls <paramref name="task"/> once for each item from 0 to <paramref name="itemCount"/> (exclusive), spread across the threads of
+///<paramref name="pool"/>, and waits until all of them have finished.</summary>
+///<param name="pool">The <see cref="ThreadPool"/>. If NULL, all items run on the calling thread.</param>
+///<param name="itemCount">The number of items.</param>
+///<param name="task">The function to call for each item.</param>
+///<param name="arg">The argument to pass to <paramref name="task"/>.</param>
+///<remarks>Each thread starts with an equal, contiguous range of the items and runs them in increasing order. A thread that finishes its
+///range early steals the back half of the range of another thread, so items that take very different amounts of time still keep all
+///threads busy. Each claim takes a lock, so it is best to make each item a reasonably large piece of work. The calling thread runs items
+///too (as worker 0). A <see cref="ThreadPool"/> runs one job at a time, so <paramref name="task"/> must not call this function
+///with the same pool, and two threads must not use the same pool at the same time.</remarks>
+static void parallel_for(ThreadPool* pool, size_t itemCount, ThreadPoolTask task, void* arg)
+{
+	if (pool == NULL || pool->threadCount == 1 || itemCount <= 1)
+	{
+		for (size_t i = 0; i < itemCount; i++)
+			task(arg, i, 0);
+		return;
+	}
+
+	_mutex_lock(&pool->mutex);
+	pool->task = task;
+	pool->arg = arg;
+	for (int i = 0; i < pool->threadCount; i++)
+	{
+		//The ranges are only read by the background threads after they see the new generation, under the pool's lock
+		pool->ranges[i].begin = itemCount * (size_t)i / (size_t)pool->threadCount;
+		pool->ranges[i].end = itemCount * (size_t)(i + 1) / (size_t)pool->threadCount;
+	}
+	pool->activeCount = pool->threadCount - 1;
+	pool->generation++;
+	_condition_broadcast(&pool->wake);
+	_mutex_unlock(&pool->mutex);
+
+	_run_thread_pool_items(pool, 0);
+
+	_mutex_lock(&pool->mutex);
+	while (pool->activeCount > 0)
+		_condition_wait(&pool->done, &pool->mutex);
+	_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,885 @@
+#pragma once
+#include "Platform.h"
+#include "BarCodeImage.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+///<summary>Configuration that defines whether a pixel is considered 'yellow'.</summary>
+typedef struct YellowConfig
+{
+	///<summary>The maximum separation value between the red and the green channels.</summary>
+	uint8_t maxRedGreenSeparation;
+
+	///<summary>The maximum separation value between the red and the blue channels.</summary>
+	uint8_t minRedBlueSeparation;
+
+	///<summary>The minimum value for the red channel.</summary>
+	uint8_t minRed;
+} YellowConfig;
+
+///<summary>Checks whether a pixel is considered 'yellow' as defined by the <see cref="YellowConfig"/>.</summary>
+///<param name="r">The value of the pixel's red channel.</param>
+///<param name="g">The value of the pixel's green channel.</param>
+///<param name="b">The value of the pixel's blue channel.</param>
+///<param name="config">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow'.</param>
+///<returns>True if the pixel is considered yellow, otherwise false.</returns>
+BAR_CODE_FORCEINLINE bool is_yellow(uint8_t r, uint8_t g, uint8_t b, YellowConfig config)
+{
+	uint8_t redGreenSeparation = abs(r - g);
+	int redBlueSeparation = (int)r - (int)b;
+	return redGreenSeparation <= config.maxRedGreenSeparation && redBlueSeparation >= config.minRedBlueSeparation && r >= config.minRed;
+}
+
+///<summary>Checks whether a pixel is considered 'yellow' exactly the way the vector kernels do.</summary>
+///<param name="rgba8">Pointer to the pixel, stored in RGBA 8-bit format.</param>
+///<param name="config">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow'.</param>
+///<returns>True if the pixel is considered yellow, otherwise false.</returns>
+///<remarks>Unlike <see cref="is_yellow"/>, the red-green separation is signed here (a pixel that is greener than it is red always passes that test).
+///This is what the vector kernels have always computed, so the scalar kernel and the vector tails must do the same.</remarks>
+BAR_CODE_FORCEINLINE bool _is_yellow_pixel(const uint8_t* rgba8, YellowConfig config)
+{
+	int r = rgba8[0], g = rgba8[1], b = rgba8[2];
+	return r - g <= config.maxRedGreenSeparation && r - b >= config.minRedBlueSeparation && r >= config.minRed;
+}
+
+///<summary>The set of instructions used by a <see cref="YellowKernels"/> table.</summary>
+typedef enum YellowKernelLevel
+{
+	YELLOW_KERNEL_SCALAR = 0,
+	YELLOW_KERNEL_SSE41 = 1,
+	YELLOW_KERNEL_AVX2 = 2,
+	YELLOW_KERNEL_AVX512 = 3
+} YellowKernelLevel;
+
+///<summary>Table of yellow classifier kernels that were compiled for a specific <see cref="YellowKernelLevel"/>.</summary>
+typedef struct YellowKernels
+{
+	///<summary>The instruction set used by the kernels in this table.</summary>
+	YellowKernelLevel level;
+
+	///<summary>A short, human-readable name of <see cref="level"/>.</summary>
+	const char* name;
+
+	///<summary>Classifies a run of pixels into a packed bitmask.</summary>
+	///<param name="rgba8">The first pixel, stored in RGBA 8-bit format. Does not need to be aligned.</param>
+	///<param name="pixelCount">The number of pixels to classify.</param>
+	///<param name="config">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow.'</param>
+	///<param name="yellowBits">Receives (pixelCount + 63) / 64 words. Bit 'i' of word 'w' is set when pixel (w * 64) + i is yellow.
+	///Bits beyond <paramref name="pixelCount"/> in the last word are cleared.</param>
+	void (*classifyRow)(const uint8_t* rgba8, int pixelCount, YellowConfig config, uint64_t* yellowBits);
+
+	///<summary>Copies pixels, replacing 'yellow' pixels with a specific color.</summary>
+	///<param name="src">The source pixels, stored in RGBA 8-bit format.</param>
+	///<param name="dst">The destination pixels, stored in RGBA 8-bit format. May be equal to <paramref name="src"/>.</param>
+	///<param name="pixelCount">The number of pixels to copy.</param>
+	///<param name="config">The <see cref="YellowConfig"/> that defines when a pixel is considered 'yellow.'</param>
+	///<param name="rgba">The replacement color, stored as the little-endian RGBA 8-bit representation of a single pixel.</param>
+	void (*showYellow)(const uint8_t* src, uint8_t* dst, size_t pixelCount, YellowConfig config, uint32_t rgba);
+
+	///<summary>Halves the size of two rows of pixels, averaging each 2x2 block into one pixel.</summary>
+	///<param name="top">The first row, stored in RGBA 8-bit format. Must hold 2 * <paramref name="pixelCount"/> pixels.</param>
+	///<param name="bottom">The second row, stored in RGBA 8-bit format. Must hold 2 * <paramref name="pixelCount"/> pixels.</param>
+	///<param name="pixelCount">The number of pixels to write.</param>
+	///<param name="dst">Receives the pixels, stored in RGBA 8-bit format. It may start at <paramref name="top"/> (but not after it), since each pixel
+	///is written after the pixels that it is averaged from are read.</param>
+	///<remarks>Each channel is averaged vertically, then horizontally, rounding up each time, so every level produces exactly the same pixels.</remarks>
+	void (*halveRows)(const uint8_t* top, const uint8_t* bottom, int pixelCount, uint8_t* dst);
+
+	///<summary>Classifies a run of pixels of a <see cref="BarCodeImage"/> like <see cref="classifyRow"/>, with one kernel for each
+	///<see cref="BarCodePixelFormat"/> (indexed by the format), so the pixels do not have to be converted to RGBA first.</summary>
+	///<param name="row">The first byte of the row (see <see cref="_get_image_row"/>).</param>
+	///<param name="chromaRow">The first byte of the row's chroma (see <see cref="_get_image_chroma_row"/>), or NULL if the format has none.</param>
+	///<param name="x">The first pixel of the run. It does not need to be even for the YCbCr formats.</param>
+	///<param name="pixelCount">The number of pixels to classify. The kernels never read beyond the last of them.</param>
+	void (*classifyImageRow[BAR_CODE_PIXEL_FORMAT_COUNT])(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits);
+} YellowKernels;
+
+static void _classify_yellow_row_scalar(const uint8_t* rgba8, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	for (int x = 0; x < pixelCount; x += 64)
+	{
+		int end = pixelCount - x < 64 ? pixelCount - x : 64;
+		uint64_t word = 0;
+		for (int i = 0; i < end; i++)
+		{
+			if (_is_yellow_pixel(rgba8 + ((size_t)(x + i) * 4), config))
+				word |= 1ull << i;
+		}
+		yellowBits[x / 64] = word;
+	}
+}
+
+static void _show_yellow_scalar(const uint8_t* src, uint8_t* dst, size_t pixelCount, YellowConfig config, uint32_t rgba)
+{
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		uint32_t pixel;
+		memcpy(&pixel, src + (i * 4), sizeof(pixel));
+		if (_is_yellow_pixel(src + (i * 4), config))
+			pixel = rgba;
+		memcpy(dst + (i * 4), &pixel, sizeof(pixel));
+	}
+}
+
+static void _halve_rows_scalar(const uint8_t* top, const uint8_t* bottom, int pixelCount, uint8_t* dst)
+{
+	for (int x = 0; x < pixelCount; x++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			int left = (top[(x * 8) + c] + bottom[(x * 8) + c] + 1) >> 1;
+			int right = (top[(x * 8) + 4 + c] + bottom[(x * 8) + 4 + c] + 1) >> 1;
+			dst[(x * 4) + c] = (uint8_t)((left + right + 1) >> 1);
+		}
+	}
+}
+
+///<summary>Classifies some of the pixels of one word of a row's bitmask, one at a time.</summary>
+///<param name="x">The pixel of bit 0 of the word.</param>
+///<param name="start">The first bit to classify.</param>
+///<param name="end">The bit after the last bit to classify.</param>
+///<returns>The bits from <paramref name="start"/> to <paramref name="end"/> (exclusive). The other bits are clear.</returns>
+BAR_CODE_FORCEINLINE uint64_t _classify_pixels_scalar(BarCodePixelFormat format, const uint8_t* row, const uint8_t* chromaRow, int x, int start, int end, YellowConfig config)
+{
+	uint64_t word = 0;
+	for (int i = start; i < end; i++)
+	{
+		uint8_t rgb[3];
+		_read_row_pixel(format, row, chromaRow, x + i, rgb);
+		if (_is_yellow_pixel(rgb, config))
+			word |= 1ull << i;
+	}
+	return word;
+}
+
+BAR_CODE_FORCEINLINE void _classify_format_row_scalar(BarCodePixelFormat format, const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		yellowBits[w / 64] = _classify_pixels_scalar(format, row, chromaRow, x + w, 0, end, config);
+	}
+}
+
+static void _classify_rgba8_row_scalar(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_yellow_row_scalar(row + ((size_t)x * 4), pixelCount, config, yellowBits);
+}
+
+static void _classify_bgra8_row_scalar(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_format_row_scalar(BAR_CODE_PIXEL_FORMAT_BGRA8, row, chromaRow, x, pixelCount, config, yellowBits);
+}
+
+static void _classify_rgb24_row_scalar(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_format_row_scalar(BAR_CODE_PIXEL_FORMAT_RGB24, row, chromaRow, x, pixelCount, config, yellowBits);
+}
+
+static void _classify_yuyv_row_scalar(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_format_row_scalar(BAR_CODE_PIXEL_FORMAT_YUYV, row, chromaRow, x, pixelCount, config, yellowBits);
+}
+
+static void _classify_nv12_row_scalar(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_format_row_scalar(BAR_CODE_PIXEL_FORMAT_NV12, row, chromaRow, x, pixelCount, config, yellowBits);
+}
+
+#if defined(BAR_CODE_X86)
+
+///<summary>Configuration that defines whether a pixel is considered 'yellow' using SSE data types.</summary>
+typedef struct YellowConfigSSE
+{
+	///<summary>The separation between the red and green channels must be less than this value, stored in all epi32 positions.</summary>
+	__m128i redGreenSeparationLessThan;
+
+	///<summary>The separation between the red and blue channels must be larger than this value, stored in all epi32 positions.</summary>
+	__m128i redBlueSeparationGreaterThan;
+
+	///<summary>The red channel must be larger than this value, stored in all epi32 positions.</summary>
+	__m128i redGreaterThan;
+} YellowConfigSSE;
+
+///<summary>Converts a <see cref="YellowConfig"/> to a <see cref="YellowConfigSSE"/>.</summary>
+///<param name="config">The source <see cref="YellowConfig"/>.</param>
+///<returns>The equivalent <see cref="YellowConfigSSE"/>.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_SSE41 YellowConfigSSE to_sse(YellowConfig config)
+{
+	YellowConfigSSE ret;
+
+	ret.redGreenSeparationLessThan = _mm_set1_epi32(config.maxRedGreenSeparation + 1/*+1 to go from '<=' to '<'*/);
+	ret.redBlueSeparationGreaterThan = _mm_set1_epi32(config.minRedBlueSeparation - 1/*-1 to go from '>=' to '>'*/);
+	ret.redGreaterThan = _mm_set1_epi32(config.minRed - 1/*-1 to go from '>=' to '>'*/);
+
+	return ret;
+}
+
+///<summary>Checks whether pixels are yellow within a group of 4, given their channels.</summary>
+///<param name="reds">The red channel of each pixel, stored in epi32 positions. The same goes for <paramref name="greens"/> and <paramref name="blues"/>.</param>
+///<param name="config">The <see cref="YellowConfigSSE"/> that defines when a pixel is considered 'yellow.'</param>
+///<returns>A <see cref="__m128i"/> where all bits of a pixel's epi32 position are set if that pixel is 'yellow,' otherwise clear.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_SSE41 __m128i _are_yellow_channels_sse41(__m128i reds, __m128i greens, __m128i blues, YellowConfigSSE config)
+{
+	__m128i redPassed = _mm_cmpgt_epi32(reds, config.redGreaterThan);
+	__m128i redSubGreenPassed = _mm_cmpgt_epi32(config.redGreenSeparationLessThan, _mm_sub_epi32(reds, greens));
+	__m128i redSubBluePassed = _mm_cmpgt_epi32(_mm_sub_epi32(reds, blues), config.redBlueSeparationGreaterThan);
+
+	return _mm_and_si128(redPassed, _mm_and_si128(redSubGreenPassed, redSubBluePassed));
+}
+
+///<summary>Checks whether pixels are yellow within a group of 4.</summary>
+///<param name="rgba8"><see cref="__m128i"/> containing the 4 pixels, stored in RGBA 8-bit format.</param>
+///<param name="config">The <see cref="YellowConfigSSE"/> that defines when a pixel is considered 'yellow.'</param>
+///<returns>A <see cref="__m128i"/> where all bits of a pixel's four channels are set if that pixel is 'yellow,' otherwise clear.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_SSE41 __m128i _are_yellow_sse41(__m128i rgba8, YellowConfigSSE config)
+{
+	__m128i lowByte = _mm_set1_epi32(0xFF);
+	__m128i reds = _mm_and_si128(rgba8, lowByte);
+	__m128i greens = _mm_and_si128(_mm_srli_epi32(rgba8, 8), lowByte);
+	__m128i blues = _mm_and_si128(_mm_srli_epi32(rgba8, 16), lowByte);
+	return _are_yellow_channels_sse41(reds, greens, blues, config);
+}
+
+///<summary>Checks whether pixels are yellow within a group of 4 YCbCr pixels, converting them like <see cref="_yuv_to_rgb"/>.</summary>
+///<param name="ys">The Y channel of each pixel, stored in epi32 positions. The same goes for <paramref name="us"/> and <paramref name="vs"/>.</param>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_SSE41 __m128i _are_yellow_yuv_sse41(__m128i ys, __m128i us, __m128i vs, YellowConfigSSE config)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i max = _mm_set1_epi32(255);
+	__m128i c = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(ys, _mm_set1_epi32(16)), _mm_set1_epi32(298)), _mm_set1_epi32(128));
+	__m128i d = _mm_sub_epi32(us, _mm_set1_epi32(128));
+	__m128i e = _mm_sub_epi32(vs, _mm_set1_epi32(128));
+
+	__m128i reds = _mm_add_epi32(c, _mm_mullo_epi32(e, _mm_set1_epi32(409)));
+	__m128i greens = _mm_sub_epi32(_mm_sub_epi32(c, _mm_mullo_epi32(d, _mm_set1_epi32(100))), _mm_mullo_epi32(e, _mm_set1_epi32(208)));
+	__m128i blues = _mm_add_epi32(c, _mm_mullo_epi32(d, _mm_set1_epi32(516)));
+	reds = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(reds, 8), zero), max);
+	greens = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(greens, 8), zero), max);
+	blues = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(blues, 8), zero), max);
+	return _are_yellow_channels_sse41(reds, greens, blues, config);
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_yellow_row_sse41(const uint8_t* rgba8, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	for (int x = 0; x < pixelCount; x += 64)
+	{
+		int end = pixelCount - x < 64 ? pixelCount - x : 64;
+		uint64_t word = 0;
+		int i = 0;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i yellowMask = _are_yellow_sse41(_mm_loadu_si128((const __m128i*)(rgba8 + ((size_t)(x + i) * 4))), configSse);
+			word |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(yellowMask)) << i;
+		}
+		for (; i < end; i++)
+		{
+			if (_is_yellow_pixel(rgba8 + ((size_t)(x + i) * 4), config))
+				word |= 1ull << i;
+		}
+		yellowBits[x / 64] = word;
+	}
+}
+
+BAR_CODE_TARGET_SSE41 static void _show_yellow_sse41(const uint8_t* src, uint8_t* dst, size_t pixelCount, YellowConfig config, uint32_t rgba)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	__m128i color = _mm_set1_epi32((int)rgba);
+	size_t i = 0;
+	for (; i + 4 <= pixelCount; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(src + (i * 4)));
+		__m128i results = _are_yellow_sse41(pixels, configSse);
+		_mm_storeu_si128((__m128i*)(dst + (i * 4)), _mm_blendv_epi8(pixels, color, results));
+	}
+	_show_yellow_scalar(src + (i * 4), dst + (i * 4), pixelCount - i, config, rgba);
+}
+
+BAR_CODE_TARGET_SSE41 static void _halve_rows_sse41(const uint8_t* top, const uint8_t* bottom, int pixelCount, uint8_t* dst)
+{
+	int x = 0;
+	for (; x + 4 <= pixelCount; x += 4)
+	{
+		__m128i first = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(top + (x * 8))), _mm_loadu_si128((const __m128i*)(bottom + (x * 8))));
+		__m128i second = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(top + (x * 8) + 16)), _mm_loadu_si128((const __m128i*)(bottom + (x * 8) + 16)));
+
+		//Split the even pixels from the odd pixels (a float shuffle moves whole pixels), then average them
+		__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_si128((__m128i*)(dst + (x * 4)), _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd)));
+	}
+	_halve_rows_scalar(top + (x * 8), bottom + (x * 8), pixelCount - x, dst + (x * 4));
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_rgba8_row_sse41(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_yellow_row_sse41(row + ((size_t)x * 4), pixelCount, config, yellowBits);
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_bgra8_row_sse41(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	__m128i lowByte = _mm_set1_epi32(0xFF);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		uint64_t word = 0;
+		int i = 0;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(row + ((size_t)(x + w + i) * 4)));
+			__m128i blues = _mm_and_si128(pixels, lowByte);
+			__m128i greens = _mm_and_si128(_mm_srli_epi32(pixels, 8), lowByte);
+			__m128i reds = _mm_and_si128(_mm_srli_epi32(pixels, 16), lowByte);
+			word |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_are_yellow_channels_sse41(reds, greens, blues, configSse))) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_BGRA8, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_rgb24_row_sse41(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	__m128i toRgba = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		uint64_t word = 0;
+		int i = 0;
+
+		//Each load reads 16 bytes for 4 pixels (12 bytes), so stop while 2 more pixels are left
+		for (; i + 4 <= end && w + i + 6 <= pixelCount; i += 4)
+		{
+			__m128i pixels = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(row + ((size_t)(x + w + i) * 3))), toRgba);
+			word |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_are_yellow_sse41(pixels, configSse))) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_RGB24, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_yuyv_row_sse41(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	__m128i lumas = _mm_setr_epi8(0, -1, -1, -1, 2, -1, -1, -1, 4, -1, -1, -1, 6, -1, -1, -1);
+	__m128i blueDifferences = _mm_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 5, -1, -1, -1, 5, -1, -1, -1);
+	__m128i redDifferences = _mm_setr_epi8(3, -1, -1, -1, 3, -1, -1, -1, 7, -1, -1, -1, 7, -1, -1, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		int i = (x + w) & 1;//Start the vectors at the first pixel of a pair
+		uint64_t word = _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_YUYV, row, chromaRow, x + w, 0, i < end ? i : end, config);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i pairs = _mm_loadl_epi64((const __m128i*)(row + ((size_t)(x + w + i) * 2)));
+			__m128i yellow = _are_yellow_yuv_sse41(_mm_shuffle_epi8(pairs, lumas), _mm_shuffle_epi8(pairs, blueDifferences), _mm_shuffle_epi8(pairs, redDifferences), configSse);
+			word |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(yellow)) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_YUYV, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_SSE41 static void _classify_nv12_row_sse41(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigSSE configSse = to_sse(config);
+	__m128i blueDifferences = _mm_setr_epi8(0, -1, -1, -1, 0, -1, -1, -1, 2, -1, -1, -1, 2, -1, -1, -1);
+	__m128i redDifferences = _mm_setr_epi8(1, -1, -1, -1, 1, -1, -1, -1, 3, -1, -1, -1, 3, -1, -1, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		int i = (x + w) & 1;//Start the vectors at the first pixel of a pair
+		uint64_t word = _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_NV12, row, chromaRow, x + w, 0, i < end ? i : end, config);
+		for (; i + 4 <= end; i += 4)
+		{
+			int32_t luma, chroma;
+			memcpy(&luma, row + x + w + i, sizeof(luma));
+			memcpy(&chroma, chromaRow + x + w + i, sizeof(chroma));//The pair of a pixel at an even x starts at byte x
+			__m128i chromas = _mm_cvtsi32_si128(chroma);
+			__m128i yellow = _are_yellow_yuv_sse41(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(luma)), _mm_shuffle_epi8(chromas, blueDifferences), _mm_shuffle_epi8(chromas, redDifferences), configSse);
+			word |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(yellow)) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_NV12, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+///<summary>Configuration that defines whether a pixel is considered 'yellow' using AVX data types.</summary>
+typedef struct YellowConfigAVX
+{
+	///<summary>The separation between the red and green channels must be less than this value, stored in all epi32 positions.</summary>
+	__m256i redGreenSeparationLessThan;
+
+	///<summary>The separation between the red and blue channels must be larger than this value, stored in all epi32 positions.</summary>
+	__m256i redBlueSeparationGreaterThan;
+
+	///<summary>The red channel must be larger than this value, stored in all epi32 positions.</summary>
+	__m256i redGreaterThan;
+} YellowConfigAVX;
+
+///<summary>Converts a <see cref="YellowConfig"/> to a <see cref="YellowConfigAVX"/>.</summary>
+///<param name="config">The source <see cref="YellowConfig"/>.</param>
+///<returns>The equivalent <see cref="YellowConfigAVX"/>.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX2 YellowConfigAVX to_avx(YellowConfig config)
+{
+	YellowConfigAVX ret;
+
+	ret.redGreenSeparationLessThan = _mm256_set1_epi32(config.maxRedGreenSeparation + 1/*+1 to go from '<=' to '<'*/);
+	ret.redBlueSeparationGreaterThan = _mm256_set1_epi32(config.minRedBlueSeparation - 1/*-1 to go from '>=' to '>'*/);
+	ret.redGreaterThan = _mm256_set1_epi32(config.minRed - 1/*-1 to go from '>=' to '>'*/);
+
+	return ret;
+}
+
+///<summary>Gets the mask of the first <paramref name="count"/> epi32 positions, for the masked loads and stores of the last pixels of a run.</summary>
+///<param name="count">The number of pixels that are left, from 0 to 8.</param>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX2 __m256i _get_tail_mask_avx2(int count)
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+///<summary>Checks whether pixels are yellow within a group of 8, given their channels.</summary>
+///<param name="reds">The red channel of each pixel, stored in epi32 positions. The same goes for <paramref name="greens"/> and <paramref name="blues"/>.</param>
+///<param name="config">The <see cref="YellowConfigAVX"/> that defines when a pixel is considered 'yellow.'</param>
+///<returns>A <see cref="__m256i"/> where all bits of a pixel's epi32 position are set if that pixel is 'yellow,' otherwise clear.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX2 __m256i _are_yellow_channels_avx2(__m256i reds, __m256i greens, __m256i blues, YellowConfigAVX config)
+{
+	__m256i redSubGreen = _mm256_sub_epi32(reds, greens);
+	__m256i redSubBlue = _mm256_sub_epi32(reds, blues);
+
+	__m256i redPassed = _mm256_cmpgt_epi32(reds, config.redGreaterThan);
+	__m256i redSubGreenPassed = _mm256_cmpgt_epi32(config.redGreenSeparationLessThan, redSubGreen);
+	__m256i redSubBluePassed = _mm256_cmpgt_epi32(redSubBlue, config.redBlueSeparationGreaterThan);
+
+	//Since we compared using epi32, all channels for each pixel are set to true or false.
+	return _mm256_and_si256(redPassed, _mm256_and_si256(redSubGreenPassed, redSubBluePassed));
+}
+
+///<summary>Checks whether pixels are yellow within a group of 8.</summary>
+///<param name="rgba8"><see cref="__m256i"/> containing the 8 pixels, stored in RGBA 8-bit format.</param>
+///<param name="config">The <see cref="YellowConfigAVX"/> that defines when a pixel is considered 'yellow.'</param>
+///<returns>A <see cref="__m256i"/> where each byte is 0 (no bits set) or -1 (all bits set) depending on whether
+///the pixel that contains that byte's channel is considered 'yellow.' So for a given pixel (4 channels: Red, Green
+///Blue, and Alpha), if that pixel in the <paramref name="rgba8"/> was considered 'yellow,' then all of those four
+///channels will be set to true (all bits set). If the pixel was not considered 'yellow,' then all bits in
+///those four channels will be clear.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX2 __m256i _are_yellow(__m256i rgba8, YellowConfigAVX config)
+{
+	//Get the individual RGB channels
+	__m256i reds = _mm256_and_si256(rgba8, _mm256_set_epi8(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1));
+	__m256i greens = _mm256_and_si256(rgba8, _mm256_set_epi8(0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0));
+	__m256i blues = _mm256_and_si256(rgba8, _mm256_set_epi8(0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0));
+
+	//Move the bytes for greens and blues to the correct position (so we can treat them as epi32) [reds are already in the correct position]
+	greens = _mm256_shuffle_epi8(greens, _mm256_set_epi8(0, 0, 0, 29, 0, 0, 0, 25, 0, 0, 0, 21, 0, 0, 0, 17, 0, 0, 0, 13, 0, 0, 0, 9, 0, 0, 0, 5, 0, 0, 0, 1));//Byte value at '0' is '0' due to mask above
+	blues = _mm256_shuffle_epi8(blues, _mm256_set_epi8(0, 0, 0, 30, 0, 0, 0, 26, 0, 0, 0, 22, 0, 0, 0, 18, 0, 0, 0, 14, 0, 0, 0, 10, 0, 0, 0, 6, 0, 0, 0, 2));//Byte value at '0' is '0' due to mask above
+
+	//From here on, we can treat reds, greens, and blues as epi32 values
+	return _are_yellow_channels_avx2(reds, greens, blues, config);
+}
+
+///<summary>Checks whether pixels are yellow within a group of 8 YCbCr pixels, converting them like <see cref="_yuv_to_rgb"/>.</summary>
+///<param name="ys">The Y channel of each pixel, stored in epi32 positions. The same goes for <paramref name="us"/> and <paramref name="vs"/>.</param>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX2 __m256i _are_yellow_yuv_avx2(__m256i ys, __m256i us, __m256i vs, YellowConfigAVX config)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i max = _mm256_set1_epi32(255);
+	__m256i c = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(ys, _mm256_set1_epi32(16)), _mm256_set1_epi32(298)), _mm256_set1_epi32(128));
+	__m256i d = _mm256_sub_epi32(us, _mm256_set1_epi32(128));
+	__m256i e = _mm256_sub_epi32(vs, _mm256_set1_epi32(128));
+
+	__m256i reds = _mm256_add_epi32(c, _mm256_mullo_epi32(e, _mm256_set1_epi32(409)));
+	__m256i greens = _mm256_sub_epi32(_mm256_sub_epi32(c, _mm256_mullo_epi32(d, _mm256_set1_epi32(100))), _mm256_mullo_epi32(e, _mm256_set1_epi32(208)));
+	__m256i blues = _mm256_add_epi32(c, _mm256_mullo_epi32(d, _mm256_set1_epi32(516)));
+	reds = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(reds, 8), zero), max);
+	greens = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(greens, 8), zero), max);
+	blues = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(blues, 8), zero), max);
+	return _are_yellow_channels_avx2(reds, greens, blues, config);
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_yellow_row_avx2(const uint8_t* rgba8, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	for (int x = 0; x < pixelCount; x += 64)
+	{
+		int end = pixelCount - x < 64 ? pixelCount - x : 64;
+		uint64_t word = 0;
+		int i = 0;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i yellowMask = _are_yellow(_mm256_loadu_si256((const __m256i*)(rgba8 + ((size_t)(x + i) * 4))), configAvx);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(yellowMask)) << i;
+		}
+		if (i < end)
+		{
+			//The masked load never touches the pixels beyond the end of the run
+			__m256i valid = _get_tail_mask_avx2(end - i);
+			__m256i yellowMask = _are_yellow(_mm256_maskload_epi32((const int*)(rgba8 + ((size_t)(x + i) * 4)), valid), configAvx);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(yellowMask, valid))) << i;
+		}
+		yellowBits[x / 64] = word;
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _show_yellow_avx2(const uint8_t* src, uint8_t* dst, size_t pixelCount, YellowConfig config, uint32_t rgba)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	__m256i color = _mm256_set1_epi32((int)rgba);
+	size_t i = 0;
+	for (; i + 8 <= pixelCount; i += 8)
+	{
+		__m256i pixels = _mm256_loadu_si256((const __m256i*)(src + (i * 4)));
+		__m256i results = _are_yellow(pixels, configAvx);
+
+		__m256i source = _mm256_andnot_si256(results, pixels);
+		__m256i draw = _mm256_and_si256(results, color);
+
+		_mm256_storeu_si256((__m256i*)(dst + (i * 4)), _mm256_or_si256(source, draw));
+	}
+	if (i < pixelCount)
+	{
+		__m256i valid = _get_tail_mask_avx2((int)(pixelCount - i));
+		__m256i pixels = _mm256_maskload_epi32((const int*)(src + (i * 4)), valid);
+		__m256i results = _are_yellow(pixels, configAvx);
+		_mm256_maskstore_epi32((int*)(dst + (i * 4)), valid, _mm256_blendv_epi8(pixels, color, results));
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_rgba8_row_avx2(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_yellow_row_avx2(row + ((size_t)x * 4), pixelCount, config, yellowBits);
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_bgra8_row_avx2(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	__m256i lowByte = _mm256_set1_epi32(0xFF);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		uint64_t word = 0;
+		int i = 0;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i pixels = _mm256_loadu_si256((const __m256i*)(row + ((size_t)(x + w + i) * 4)));
+			__m256i blues = _mm256_and_si256(pixels, lowByte);
+			__m256i greens = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), lowByte);
+			__m256i reds = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), lowByte);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_are_yellow_channels_avx2(reds, greens, blues, configAvx))) << i;
+		}
+		if (i < end)
+		{
+			__m256i valid = _get_tail_mask_avx2(end - i);
+			__m256i pixels = _mm256_maskload_epi32((const int*)(row + ((size_t)(x + w + i) * 4)), valid);
+			__m256i blues = _mm256_and_si256(pixels, lowByte);
+			__m256i greens = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), lowByte);
+			__m256i reds = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), lowByte);
+			__m256i yellowMask = _mm256_and_si256(_are_yellow_channels_avx2(reds, greens, blues, configAvx), valid);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(yellowMask)) << i;
+		}
+		yellowBits[w / 64] = word;
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_rgb24_row_avx2(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	__m256i toRgba = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		uint64_t word = 0;
+		int i = 0;
+
+		//Each lane reads 16 bytes for 4 pixels (12 bytes), and the second lane starts 12 bytes after the first, so stop while 2 more pixels are left
+		for (; i + 8 <= end && w + i + 10 <= pixelCount; i += 8)
+		{
+			const uint8_t* first = row + ((size_t)(x + w + i) * 3);
+			__m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)first)), _mm_loadu_si128((const __m128i*)(first + 12)), 1);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_are_yellow(_mm256_shuffle_epi8(pixels, toRgba), configAvx))) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_RGB24, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_yuyv_row_avx2(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	__m128i lumas = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m128i blueDifferences = _mm_setr_epi8(1, 1, 5, 5, 9, 9, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m128i redDifferences = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		int i = (x + w) & 1;//Start the vectors at the first pixel of a pair
+		uint64_t word = _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_YUYV, row, chromaRow, x + w, 0, i < end ? i : end, config);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m128i pairs = _mm_loadu_si128((const __m128i*)(row + ((size_t)(x + w + i) * 2)));
+			__m256i yellow = _are_yellow_yuv_avx2(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(pairs, lumas)), _mm256_cvtepu8_epi32(_mm_shuffle_epi8(pairs, blueDifferences)),
+				_mm256_cvtepu8_epi32(_mm_shuffle_epi8(pairs, redDifferences)), configAvx);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(yellow)) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_YUYV, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _classify_nv12_row_avx2(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX configAvx = to_avx(config);
+	__m128i blueDifferences = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m128i redDifferences = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		int end = pixelCount - w < 64 ? pixelCount - w : 64;
+		int i = (x + w) & 1;//Start the vectors at the first pixel of a pair
+		uint64_t word = _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_NV12, row, chromaRow, x + w, 0, i < end ? i : end, config);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m128i lumas = _mm_loadl_epi64((const __m128i*)(row + x + w + i));
+			__m128i chromas = _mm_loadl_epi64((const __m128i*)(chromaRow + x + w + i));//The pair of a pixel at an even x starts at byte x
+			__m256i yellow = _are_yellow_yuv_avx2(_mm256_cvtepu8_epi32(lumas), _mm256_cvtepu8_epi32(_mm_shuffle_epi8(chromas, blueDifferences)),
+				_mm256_cvtepu8_epi32(_mm_shuffle_epi8(chromas, redDifferences)), configAvx);
+			word |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(yellow)) << i;
+		}
+		yellowBits[w / 64] = word | _classify_pixels_scalar(BAR_CODE_PIXEL_FORMAT_NV12, row, chromaRow, x + w, i, end, config);
+	}
+}
+
+BAR_CODE_TARGET_AVX2 static void _halve_rows_avx2(const uint8_t* top, const uint8_t* bottom, int pixelCount, uint8_t* dst)
+{
+	int x = 0;
+	for (; x + 8 <= pixelCount; x += 8)
+	{
+		__m256i first = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(top + (x * 8))), _mm256_loadu_si256((const __m256i*)(bottom + (x * 8))));
+		__m256i second = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(top + (x * 8) + 32)), _mm256_loadu_si256((const __m256i*)(bottom + (x * 8) + 32)));
+
+		//The shuffle works within each 128-bit lane, so the 64-bit groups of the result are put back in order afterwards
+		__m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(first), _mm256_castsi256_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+		__m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(first), _mm256_castsi256_ps(second), _MM_SHUFFLE(3, 1, 3, 1));
+		__m256i halved = _mm256_avg_epu8(_mm256_castps_si256(even), _mm256_castps_si256(odd));
+		_mm256_storeu_si256((__m256i*)(dst + (x * 4)), _mm256_permute4x64_epi64(halved, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	_halve_rows_scalar(top + (x * 8), bottom + (x * 8), pixelCount - x, dst + (x * 4));
+}
+
+///<summary>Configuration that defines whether a pixel is considered 'yellow' using AVX-512 data types.</summary>
+typedef struct YellowConfigAVX512
+{
+	///<summary>The separation between the red and green channels must be less than or equal to this value, stored in all epi32 positions.</summary>
+	__m512i maxRedGreenSeparation;
+
+	///<summary>The separation between the red and blue channels must be greater than or equal to this value, stored in all epi32 positions.</summary>
+	__m512i minRedBlueSeparation;
+
+	///<summary>The red channel must be greater than or equal to this value, stored in all epi32 positions.</summary>
+	__m512i minRed;
+} YellowConfigAVX512;
+
+///<summary>Converts a <see cref="YellowConfig"/> to a <see cref="YellowConfigAVX512"/>.</summary>
+///<param name="config">The source <see cref="YellowConfig"/>.</param>
+///<returns>The equivalent <see cref="YellowConfigAVX512"/>.</returns>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX512 YellowConfigAVX512 to_avx512(YellowConfig config)
+{
+	YellowConfigAVX512 ret;
+
+	//AVX-512 has 'less than or equal' and 'greater than or equal' compares, so the thresholds do not need to be adjusted
+	ret.maxRedGreenSeparation = _mm512_set1_epi32(config.maxRedGreenSeparation);
+	ret.minRedBlueSeparation = _mm512_set1_epi32(config.minRedBlueSeparation);
+	ret.minRed = _mm512_set1_epi32(config.minRed);
+
+	return ret;
+}
+
+///<summary>Checks whether pixels are yellow within a group of 16.</summary>
+///<param name="rgba8"><see cref="__m512i"/> containing the 16 pixels, stored in RGBA 8-bit format.</param>
+///<param name="config">The <see cref="YellowConfigAVX512"/> that defines when a pixel is considered 'yellow.'</param>
+///<returns>A mask where bit 'i' is set if pixel 'i' is considered 'yellow.'</returns>
+///<remarks>Each compare only runs on the pixels that passed the previous compares, so the three tests are combined in the mask
+///registers rather than with vector ANDs, and the result is already the packed bitmask.</remarks>
+BAR_CODE_FORCEINLINE BAR_CODE_TARGET_AVX512 __mmask16 _are_yellow_avx512(__m512i rgba8, YellowConfigAVX512 config)
+{
+	__m512i lowByte = _mm512_set1_epi32(0xFF);
+	__m512i reds = _mm512_and_si512(rgba8, lowByte);
+	__m512i greens = _mm512_and_si512(_mm512_srli_epi32(rgba8, 8), lowByte);
+	__m512i blues = _mm512_and_si512(_mm512_srli_epi32(rgba8, 16), lowByte);
+
+	__mmask16 yellow = _mm512_cmpge_epi32_mask(reds, config.minRed);
+	yellow = _mm512_mask_cmple_epi32_mask(yellow, _mm512_sub_epi32(reds, greens), config.maxRedGreenSeparation);
+	yellow = _mm512_mask_cmpge_epi32_mask(yellow, _mm512_sub_epi32(reds, blues), config.minRedBlueSeparation);
+	return yellow;
+}
+
+BAR_CODE_TARGET_AVX512 static void _classify_yellow_row_avx512(const uint8_t* rgba8, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX512 configAvx512 = to_avx512(config);
+	const uint32_t* pixels = (const uint32_t*)rgba8;
+	int x = 0;
+	for (; x + 64 <= pixelCount; x += 64)
+	{
+		//Four groups of 16 pixels make up one word of the bitmask
+		uint64_t m0 = _are_yellow_avx512(_mm512_loadu_si512(pixels + x), configAvx512);
+		uint64_t m1 = _are_yellow_avx512(_mm512_loadu_si512(pixels + x + 16), configAvx512);
+		uint64_t m2 = _are_yellow_avx512(_mm512_loadu_si512(pixels + x + 32), configAvx512);
+		uint64_t m3 = _are_yellow_avx512(_mm512_loadu_si512(pixels + x + 48), configAvx512);
+		yellowBits[x / 64] = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+	}
+
+	if (x < pixelCount)
+	{
+		//The last word is partial, so use masked loads (which never touch the pixels beyond the end of the row)
+		uint64_t word = 0;
+		for (int i = 0; x + i < pixelCount; i += 16)
+		{
+			int remaining = pixelCount - (x + i);
+			__mmask16 valid = remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+			__m512i group = _mm512_maskz_loadu_epi32(valid, pixels + x + i);
+			word |= (uint64_t)(_are_yellow_avx512(group, configAvx512) & valid) << i;
+		}
+		yellowBits[x / 64] = word;
+	}
+}
+
+BAR_CODE_TARGET_AVX512 static void _classify_rgba8_row_avx512(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	_classify_yellow_row_avx512(row + ((size_t)x * 4), pixelCount, config, yellowBits);
+}
+
+BAR_CODE_TARGET_AVX512 static void _classify_bgra8_row_avx512(const uint8_t* row, const uint8_t* chromaRow, int x, int pixelCount, YellowConfig config, uint64_t* yellowBits)
+{
+	YellowConfigAVX512 configAvx512 = to_avx512(config);
+	__m512i toRgba = _mm512_broadcast_i32x4(_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+	const uint32_t* pixels = (const uint32_t*)row + x;
+	for (int w = 0; w < pixelCount; w += 64)
+	{
+		//Masked loads never touch the pixels beyond the end of the run
+		uint64_t word = 0;
+		for (int i = 0; i < 64 && w + i < pixelCount; i += 16)
+		{
+			int remaining = pixelCount - (w + i);
+			__mmask16 valid = remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+			__m512i group = _mm512_shuffle_epi8(_mm512_maskz_loadu_epi32(valid, pixels + w + i), toRgba);
+			word |= (uint64_t)(_are_yellow_avx512(group, configAvx512) & valid) << i;
+		}
+		yellowBits[w / 64] = word;
+	}
+}
+
+BAR_CODE_TARGET_AVX512 static void _show_yellow_avx512(const uint8_t* src, uint8_t* dst, size_t pixelCount, YellowConfig config, uint32_t rgba)
+{
+	YellowConfigAVX512 configAvx512 = to_avx512(config);
+	__m512i color = _mm512_set1_epi32((int)rgba);
+	const uint32_t* source = (const uint32_t*)src;
+	uint32_t* dest = (uint32_t*)dst;
+	for (size_t i = 0; i < pixelCount; i += 16)
+	{
+		size_t remaining = pixelCount - i;
+		__mmask16 valid = remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+		__m512i pixels = _mm512_maskz_loadu_epi32(valid, source + i);
+		__mmask16 yellow = _are_yellow_avx512(pixels, configAvx512) & valid;
+
+		if (src == dst)
+			_mm512_mask_storeu_epi32(dest + i, yellow, color);//In-place, so only the yellow pixels need to be written
+		else
+			_mm512_mask_storeu_epi32(dest + i, valid, _mm512_mask_mov_epi32(pixels, yellow, color));
+	}
+}
+
+BAR_CODE_TARGET_AVX512 static void _halve_rows_avx512(const uint8_t* top, const uint8_t* bottom, int pixelCount, uint8_t* dst)
+{
+	__m512i evenIndices = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+	__m512i oddIndices = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+	int x = 0;
+	for (; x + 16 <= pixelCount; x += 16)
+	{
+		__m512i first = _mm512_avg_epu8(_mm512_loadu_si512(top + (x * 8)), _mm512_loadu_si512(bottom + (x * 8)));
+		__m512i second = _mm512_avg_epu8(_mm512_loadu_si512(top + (x * 8) + 64), _mm512_loadu_si512(bottom + (x * 8) + 64));
+		__m512i even = _mm512_permutex2var_epi32(first, evenIndices, second);
+		__m512i odd = _mm512_permutex2var_epi32(first, oddIndices, second);
+		_mm512_storeu_si512(dst + (x * 4), _mm512_avg_epu8(even, odd));
+	}
+	_halve_rows_avx2(top + (x * 8), bottom + (x * 8), pixelCount - x, dst + (x * 4));
+}
+
+#endif
+
+///<summary>All <see cref="YellowKernels"/> tables, indexed by <see cref="YellowKernelLevel"/>. Levels that were not compiled
+///(on non-x86 targets) fall back to the scalar kernels.</summary>
+static const YellowKernels _yellowKernelTables[] =
+{
+	{ YELLOW_KERNEL_SCALAR, "scalar", _classify_yellow_row_scalar, _show_yellow_scalar, _halve_rows_scalar,
+		{ _classify_rgba8_row_scalar, _classify_bgra8_row_scalar, _classify_rgb24_row_scalar, _classify_yuyv_row_scalar, _classify_nv12_row_scalar } },
+#if defined(BAR_CODE_X86)
+	{ YELLOW_KERNEL_SSE41, "sse4.1", _classify_yellow_row_sse41, _show_yellow_sse41, _halve_rows_sse41,
+		{ _classify_rgba8_row_sse41, _classify_bgra8_row_sse41, _classify_rgb24_row_sse41, _classify_yuyv_row_sse41, _classify_nv12_row_sse41 } },
+	{ YELLOW_KERNEL_AVX2, "avx2", _classify_yellow_row_avx2, _show_yellow_avx2, _halve_rows_avx2,
+		{ _classify_rgba8_row_avx2, _classify_bgra8_row_avx2, _classify_rgb24_row_avx2, _classify_yuyv_row_avx2, _classify_nv12_row_avx2 } },
+
+	//The three-byte and YCbCr layouts spend their time unpacking rather than comparing, so they keep the AVX2 kernels
+	{ YELLOW_KERNEL_AVX512, "avx512", _classify_yellow_row_avx512, _show_yellow_avx512, _halve_rows_avx512,
+		{ _classify_rgba8_row_avx512, _classify_bgra8_row_avx512, _classify_rgb24_row_avx2, _classify_yuyv_row_avx2, _classify_nv12_row_avx2 } },
+#endif
+};
+
+///<summary>The currently selected <see cref="YellowKernels"/> table, or NULL if none has been selected yet.</summary>
+static const YellowKernels* _yellowKernels = NULL;
+
+///<summary>Finds the widest <see cref="YellowKernelLevel"/> that the current host supports.</summary>
+///<returns>The widest supported <see cref="YellowKernelLevel"/>.</returns>
+static YellowKernelLevel detect_yellow_kernel_level(void)
+{
+	int features = detect_cpu_features();
+	const int avx512 = CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW | CPU_FEATURE_AVX512DQ | CPU_FEATURE_AVX512VL;
+	if ((features & avx512) == avx512 && (features & CPU_FEATURE_AVX2) != 0)
+		return YELLOW_KERNEL_AVX512;
+	if (features & CPU_FEATURE_AVX2)
+		return YELLOW_KERNEL_AVX2;
+	if (features & CPU_FEATURE_SSE41)
+		return YELLOW_KERNEL_SSE41;
+	return YELLOW_KERNEL_SCALAR;
+}
+
+///<summary>Selects the <see cref="YellowKernels"/> table that will be used by all following classifications.</summary>
+///<param name="level">The requested <see cref="YellowKernelLevel"/>.</param>
+///<returns>True if the <paramref name="level"/> was selected, or false if the current host does not support it (in which
+///case the previous selection is kept).</returns>
+///<remarks>This is mostly useful for comparing kernels against each other, since the widest supported level is selected automatically.</remarks>
+static bool select_yellow_kernels(YellowKernelLevel level)
+{
+	if (level < YELLOW_KERNEL_SCALAR || level > detect_yellow_kernel_level() || (size_t)level >= sizeof(_yellowKernelTables) / sizeof(_yellowKernelTables[0]))
+		return false;
+
+	_yellowKernels = &_yellowKernelTables[level];
+	return true;
+}
+
+///<summary>Gets the selected <see cref="YellowKernels"/> table, selecting the widest supported one on first use.</summary>
+///<returns>The <see cref="YellowKernels"/> table to use.</returns>
+///<remarks>The BARCODEFINDER_KERNEL environment variable ("scalar", "sse4.1", "avx2" or "avx512") can cap the level that is
+///selected automatically.</remarks>
+static const YellowKernels* get_yellow_kernels(void)
+{
+	if (_yellowKernels == NULL)
+	{
+		YellowKernelLevel level = detect_yellow_kernel_level();
+		const char* requested = getenv("BARCODEFINDER_KERNEL");
+		if (requested != NULL)
+		{
+			for (size_t i = 0; i < sizeof(_yellowKernelTables) / sizeof(_yellowKernelTables[0]); i++)
+			{
+				if (strcmp(requested, _yellowKernelTables[i].name) == 0 && _yellowKernelTables[i].level < level)
+					level = _yellowKernelTables[i].level;
+			}
+		}
+		_yellowKernels = &_yellowKernelTables[level];
+	}
+	return _yellowKernels;
+}
+
+#if defined(__GNUC__)
+//Select the kernels when the library is loaded, so the first frame does not pay for CPUID
+__attribute__((constructor)) static void _select_yellow_kernels_on_load(void)
+{
+	get_yellow_kernels();
+}
+#endif
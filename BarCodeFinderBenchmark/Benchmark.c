@@ -0,0 +1,573 @@
+//Times each stage of the search on synthetic scenes (see BenchmarkScene.h), for every resolution and every yellow kernel level, and prints
+//one record per stage so that the results of two builds (or two kernel levels) can be compared by a script.
+//
+//Usage: BarCodeFinderBenchmark [--resolutions vga,720p,1080p,1440p,4k,8k] [--kernels scalar,sse4.1,avx2,avx512] [--iterations 10]
+//                              [--codes 4] [--clutter 40] [--noise 8] [--seed 1] [--threads 1] [--max-pair-distance 320]
+//                              [--max-pair-neighbors 16] [--conversions] [--csv]
+//
+//--codes and --clutter are per megapixel, so every resolution has the same density. Kernel levels that the host does not support are skipped.
+//Each record is a JSON object on its own line (or a CSV row with --csv) with the minimum, median and mean time of the stage, and the number of
+//values that it produced.
+//
+//--conversions times every conversion of ConvertKernels.h instead of the search, along with a memcpy of the same RGBA frame. The values of
+//those records are the bytes that one run reads and writes, so values / min_ns is its bandwidth in GB/s.
+#include "BarCode.h"
+#include "BarCodeParallel.h"
+#include "ConvertKernels.h"
+#include "BenchmarkScene.h"
+#include <stdio.h>
+
+///<summary>A resolution that can be benchmarked.</summary>
+typedef struct BenchmarkResolution
+{
+	const char* name;
+	int width;
+	int height;
+} BenchmarkResolution;
+
+static const BenchmarkResolution _benchmarkResolutions[] =
+{
+	{ "vga", 640, 480 },
+	{ "720p", 1280, 720 },
+	{ "1080p", 1920, 1080 },
+	{ "1440p", 2560, 1440 },
+	{ "4k", 3840, 2160 },
+	{ "8k", 7680, 4320 },
+};
+
+#define BENCHMARK_RESOLUTION_COUNT (sizeof(_benchmarkResolutions) / sizeof(_benchmarkResolutions[0]))
+
+///<summary>The bar codes that are drawn and searched for. They have two different numbers of sections, like a real set of interests.</summary>
+static const char* const _benchmarkBarCodes[] = { "RGB", "GBBRG", "RRGGB", "BRGGR", "GRBBB" };
+
+#define BENCHMARK_BAR_CODE_COUNT (sizeof(_benchmarkBarCodes) / sizeof(_benchmarkBarCodes[0]))
+
+///<summary>The stages that are timed. The first four are the separate public functions, fed with the output of the previous stage; the others are
+///the whole search, which fuses the first two stages and matches all of the bar codes at once.</summary>
+typedef enum BenchmarkStage
+{
+	BENCHMARK_STAGE_YELLOW_LINES,
+	BENCHMARK_STAGE_YELLOW_RECTANGLES,
+	BENCHMARK_STAGE_APPEARANCES,
+	BENCHMARK_STAGE_MATCH,
+	BENCHMARK_STAGE_FULL,
+	BENCHMARK_STAGE_FULL_PARALLEL,
+	BENCHMARK_STAGE_COUNT
+} BenchmarkStage;
+
+static const char* const _benchmarkStageNames[BENCHMARK_STAGE_COUNT] =
+{
+	"find_yellow_lines",
+	"find_yellow_rectangles",
+	"find_bar_code_appearances",
+	"find_appearances_of_bar_code",
+	"find_appearances_of_bar_code_interests_in_bitmap",
+	"find_appearances_of_bar_code_interests_in_bitmap_parallel",
+};
+
+///<summary>The options of a run, parsed from the command line.</summary>
+typedef struct BenchmarkOptions
+{
+	bool resolutions[BENCHMARK_RESOLUTION_COUNT];
+	bool kernels[YELLOW_KERNEL_AVX512 + 1];
+	int iterations;
+	float codesPerMegapixel;
+	float clutterPerMegapixel;
+	int noise;
+	uint64_t seed;
+	int threadCount;
+	BarCodePairingConfig pairing;
+	bool conversions;
+	bool csv;
+} BenchmarkOptions;
+
+static int _compare_uint64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+///<summary>Checks whether <paramref name="name"/> is one of the comma-separated names of <paramref name="list"/>.</summary>
+static bool _is_in_list(const char* list, const char* name)
+{
+	size_t length = strlen(name);
+	for (const char* item = list; *item != '\0';)
+	{
+		const char* end = strchr(item, ',');
+		size_t itemLength = end != NULL ? (size_t)(end - item) : strlen(item);
+		if (itemLength == length && strncmp(item, name, length) == 0)
+			return true;
+		if (end == NULL)
+			break;
+		item = end + 1;
+	}
+	return false;
+}
+
+///<returns>False if the command line is not valid.</returns>
+static bool _parse_benchmark_options(int argc, char** argv, BenchmarkOptions* options)
+{
+	for (size_t i = 0; i < BENCHMARK_RESOLUTION_COUNT; i++)
+		options->resolutions[i] = true;
+	for (int i = 0; i <= YELLOW_KERNEL_AVX512; i++)
+		options->kernels[i] = true;
+	options->iterations = 10;
+	options->codesPerMegapixel = 4;
+	options->clutterPerMegapixel = 40;
+	options->noise = 8;
+	options->seed = 1;
+	options->threadCount = 1;
+	options->pairing.maxDistance = 320;
+	options->pairing.maxNeighbors = 16;
+	options->conversions = false;
+	options->csv = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strcmp(option, "--csv") == 0)
+		{
+			options->csv = true;
+			continue;
+		}
+		if (strcmp(option, "--conversions") == 0)
+		{
+			options->conversions = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false;
+
+		const char* value = argv[++i];
+		if (strcmp(option, "--resolutions") == 0)
+		{
+			for (size_t r = 0; r < BENCHMARK_RESOLUTION_COUNT; r++)
+				options->resolutions[r] = _is_in_list(value, _benchmarkResolutions[r].name);
+		}
+		else if (strcmp(option, "--kernels") == 0)
+		{
+			for (int level = 0; level <= YELLOW_KERNEL_AVX512; level++)
+				options->kernels[level] = _is_in_list(value, _yellowKernelTables[level < (int)(sizeof(_yellowKernelTables) / sizeof(_yellowKernelTables[0])) ? level : 0].name);
+		}
+		else if (strcmp(option, "--iterations") == 0)
+			options->iterations = atoi(value);
+		else if (strcmp(option, "--codes") == 0)
+			options->codesPerMegapixel = (float)atof(value);
+		else if (strcmp(option, "--clutter") == 0)
+			options->clutterPerMegapixel = (float)atof(value);
+		else if (strcmp(option, "--noise") == 0)
+			options->noise = atoi(value);
+		else if (strcmp(option, "--seed") == 0)
+			options->seed = strtoull(value, NULL, 10);
+		else if (strcmp(option, "--threads") == 0)
+			options->threadCount = atoi(value);
+		else if (strcmp(option, "--max-pair-distance") == 0)
+			options->pairing.maxDistance = atoi(value);
+		else if (strcmp(option, "--max-pair-neighbors") == 0)
+			options->pairing.maxNeighbors = atoi(value);
+		else
+			return false;
+	}
+
+	return options->iterations >= 1 && options->noise >= 0 && options->noise <= 255 && options->threadCount >= 1 && options->pairing.maxDistance >= 0
+		&& options->pairing.maxNeighbors >= 0 && options->pairing.maxNeighbors <= BAR_CODE_MAX_PAIR_NEIGHBORS;
+}
+
+///<summary>The times of one stage over every iteration.</summary>
+typedef struct BenchmarkTimes
+{
+	uint64_t* nanoseconds;
+	int count;
+	uint64_t values;
+} BenchmarkTimes;
+
+static void _print_benchmark_header(const BenchmarkOptions* options)
+{
+	if (options->csv)
+		printf("kernel,resolution,width,height,stage,threads,iterations,codes,clutter,noise,seed,min_ns,median_ns,mean_ns,values,megapixels_per_second\n");
+}
+
+static void _print_benchmark_record(const BenchmarkOptions* options, const char* kernel, const BenchmarkResolution* resolution, const char* stage, int threads, const BenchmarkSceneConfig* scene, BenchmarkTimes* times)
+{
+	qsort(times->nanoseconds, (size_t)times->count, sizeof(uint64_t), _compare_uint64);
+	uint64_t sum = 0;
+	for (int i = 0; i < times->count; i++)
+		sum += times->nanoseconds[i];
+
+	uint64_t min = times->nanoseconds[0];
+	uint64_t median = times->nanoseconds[times->count / 2];
+	uint64_t mean = sum / (uint64_t)times->count;
+	double megapixelsPerSecond = min > 0 ? ((double)resolution->width * (double)resolution->height * 1000.0) / (double)min : 0.0;
+	if (options->csv)
+	{
+		printf("%s,%s,%d,%d,%s,%d,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%.2f\n", kernel, resolution->name, resolution->width, resolution->height, stage,
+			threads, times->count, scene->barCodeCount, scene->clutterCount, scene->noise, (unsigned long long)scene->seed, (unsigned long long)min,
+			(unsigned long long)median, (unsigned long long)mean, (unsigned long long)times->values, megapixelsPerSecond);
+	}
+	else
+	{
+		printf("{\"kernel\":\"%s\",\"resolution\":\"%s\",\"width\":%d,\"height\":%d,\"stage\":\"%s\",\"threads\":%d,\"iterations\":%d,\"codes\":%d,\"clutter\":%d,"
+			"\"noise\":%d,\"seed\":%llu,\"min_ns\":%llu,\"median_ns\":%llu,\"mean_ns\":%llu,\"values\":%llu,\"megapixels_per_second\":%.2f}\n", kernel, resolution->name,
+			resolution->width, resolution->height, stage, threads, times->count, scene->barCodeCount, scene->clutterCount, scene->noise,
+			(unsigned long long)scene->seed, (unsigned long long)min, (unsigned long long)median, (unsigned long long)mean, (unsigned long long)times->values, megapixelsPerSecond);
+	}
+	fflush(stdout);
+}
+
+///<summary>The buffers of one resolution, which are sized for the scene so that no stage drops values.</summary>
+typedef struct BenchmarkBuffers
+{
+	YellowScanLine* lines;
+	size_t lineCapacity;
+	YellowBoundingBox* boxes;
+	size_t boxCapacity;
+	BarCodeAppearance* appearances;
+	size_t appearanceCapacity;
+	size_t* results;
+	float* resultScores;
+	size_t resultCapacity;
+	YellowBoxIndex index;
+	BarCodeFindContext contexts[BENCHMARK_BAR_CODE_COUNT];
+	BarCodeFindTemporaryMemory* memory;
+} BenchmarkBuffers;
+
+///<summary>The number of matches that each <see cref="BarCodeFindContext"/> keeps.</summary>
+#define BENCHMARK_CONTEXT_CAPACITY (64)
+
+///<summary>The number of <see cref="BarCodeAppearance"/>s that the separate stages keep, and the number of lines that the whole search keeps.</summary>
+#define BENCHMARK_APPEARANCE_CAPACITY (1 << 16)
+
+///<returns>False if the buffers could not be allocated.</returns>
+static bool _create_benchmark_buffers(BenchmarkBuffers* buffers, const BarCode* barCodes, const BenchmarkOptions* options, int width, int height)
+{
+	memset(buffers, 0, sizeof(BenchmarkBuffers));
+	buffers->lineCapacity = (size_t)height * 16;//Grown by the first iteration if the scene has more
+	buffers->lines = (YellowScanLine*)malloc(buffers->lineCapacity * sizeof(YellowScanLine));
+	buffers->boxCapacity = 1 << 16;
+	buffers->boxes = (YellowBoundingBox*)malloc(buffers->boxCapacity * sizeof(YellowBoundingBox));
+	buffers->appearanceCapacity = BENCHMARK_APPEARANCE_CAPACITY;
+	buffers->appearances = (BarCodeAppearance*)malloc(buffers->appearanceCapacity * sizeof(BarCodeAppearance));
+	buffers->resultCapacity = BENCHMARK_CONTEXT_CAPACITY;
+	buffers->results = (size_t*)malloc(buffers->resultCapacity * sizeof(size_t));
+	buffers->resultScores = (float*)malloc(buffers->resultCapacity * sizeof(float));
+	buffers->memory = allocate_bar_code_find_temporary_memory((size_t)width * 8, buffers->boxCapacity, buffers->boxCapacity, BENCHMARK_APPEARANCE_CAPACITY, 4096, BAR_CODE_ARENA_DEFAULT);
+	if (buffers->lines == NULL || buffers->boxes == NULL || buffers->appearances == NULL || buffers->results == NULL || buffers->resultScores == NULL || buffers->memory == NULL)
+		return false;
+	buffers->memory->pairing = options->pairing;
+
+	for (size_t i = 0; i < BENCHMARK_BAR_CODE_COUNT; i++)
+	{
+		BarCodeFindContext* context = &buffers->contexts[i];
+		context->barCode = barCodes[i];
+		context->minMatchScore = 0.3f;
+		context->minLineDistance = 8;
+		context->appearanceBufferCapacity = BENCHMARK_CONTEXT_CAPACITY;
+		context->appearanceBuffer = (BarCodeAppearance*)malloc(BENCHMARK_CONTEXT_CAPACITY * sizeof(BarCodeAppearance));
+		context->appearanceMatchScores = (float*)malloc(BENCHMARK_CONTEXT_CAPACITY * sizeof(float));
+		if (context->appearanceBuffer == NULL || context->appearanceMatchScores == NULL)
+			return false;
+	}
+	return true;
+}
+
+static void _free_benchmark_buffers(BenchmarkBuffers* buffers)
+{
+	free(buffers->lines);
+	free(buffers->boxes);
+	free(buffers->appearances);
+	free(buffers->results);
+	free(buffers->resultScores);
+	free_yellow_box_index(&buffers->index);
+	for (size_t i = 0; i < BENCHMARK_BAR_CODE_COUNT; i++)
+	{
+		free(buffers->contexts[i].appearanceBuffer);
+		free(buffers->contexts[i].appearanceMatchScores);
+	}
+	if (buffers->memory != NULL)
+		free_bar_code_find_temporary_memory(buffers->memory);
+}
+
+///<summary>Finds the yellow lines, growing the line buffer until it holds all of them.</summary>
+static size_t _find_all_yellow_lines(BenchmarkBuffers* buffers, const uint8_t* rgba8, int width, int height, YellowConfig cfg)
+{
+	while (true)
+	{
+		size_t count = find_yellow_lines(rgba8, width, height, cfg, buffers->lines, buffers->lineCapacity);
+		if (count < buffers->lineCapacity)
+			return count;
+
+		YellowScanLine* lines = (YellowScanLine*)realloc(buffers->lines, buffers->lineCapacity * 2 * sizeof(YellowScanLine));
+		if (lines == NULL)
+			return count;
+		buffers->lines = lines;
+		buffers->lineCapacity *= 2;
+	}
+}
+
+///<summary>Describes the scene of a resolution, with the density of bar codes and clutter of the options.</summary>
+static BenchmarkSceneConfig _get_benchmark_scene_config(const BenchmarkOptions* options, const BenchmarkResolution* resolution)
+{
+	double megapixels = (double)resolution->width * (double)resolution->height / 1000000.0;
+	BenchmarkSceneConfig scene;
+	scene.width = resolution->width;
+	scene.height = resolution->height;
+	scene.barCodeCount = (int)(options->codesPerMegapixel * megapixels + 0.5);
+	scene.clutterCount = (int)(options->clutterPerMegapixel * megapixels + 0.5);
+	scene.noise = options->noise;
+	scene.minSectionLength = 6;
+	scene.maxSectionLength = 20;
+	scene.seed = options->seed;
+	return scene;
+}
+
+///<returns>False if the scene or the buffers could not be allocated.</returns>
+static bool _run_benchmark_resolution(const BenchmarkOptions* options, const BenchmarkResolution* resolution, const BarCode* barCodes, BarCodeFindWorkers* workers)
+{
+	const YellowConfig cfg = { 45, 50, 170 };//The configuration of the demo program
+	const int maxYellowSpacing = 3;
+
+	BenchmarkSceneConfig scene = _get_benchmark_scene_config(options, resolution);
+	uint8_t* rgba8 = render_benchmark_scene(&scene, barCodes, (int)BENCHMARK_BAR_CODE_COUNT);
+
+	BenchmarkBuffers buffers;
+	uint64_t* nanoseconds = (uint64_t*)malloc((size_t)BENCHMARK_STAGE_COUNT * (size_t)options->iterations * sizeof(uint64_t));
+	bool created = _create_benchmark_buffers(&buffers, barCodes, options, resolution->width, resolution->height);
+	if (rgba8 == NULL || nanoseconds == NULL || !created)
+	{
+		_free_benchmark_buffers(&buffers);
+		free(nanoseconds);
+		free(rgba8);
+		return false;
+	}
+
+	for (int level = 0; level <= YELLOW_KERNEL_AVX512; level++)
+	{
+		if (!options->kernels[level] || !select_yellow_kernels((YellowKernelLevel)level))
+			continue;
+
+		BenchmarkTimes times[BENCHMARK_STAGE_COUNT];
+		for (int s = 0; s < BENCHMARK_STAGE_COUNT; s++)
+		{
+			times[s].nanoseconds = nanoseconds + ((size_t)s * (size_t)options->iterations);
+			times[s].count = 0;
+			times[s].values = 0;
+		}
+
+		//The first iteration only warms up the caches and grows the buffers
+		for (int iteration = -1; iteration < options->iterations; iteration++)
+		{
+			uint64_t stageTimes[BENCHMARK_STAGE_COUNT] = { 0 };
+			uint64_t values[BENCHMARK_STAGE_COUNT] = { 0 };
+
+			uint64_t start = get_monotonic_nanoseconds();
+			size_t lineCount = _find_all_yellow_lines(&buffers, rgba8, resolution->width, resolution->height, cfg);
+			uint64_t end = get_monotonic_nanoseconds();
+			stageTimes[BENCHMARK_STAGE_YELLOW_LINES] = end - start;
+			values[BENCHMARK_STAGE_YELLOW_LINES] = lineCount;
+
+			start = end;
+			size_t boxCount = find_yellow_rectangles(buffers.lines, lineCount, maxYellowSpacing, buffers.boxes, buffers.boxCapacity);
+			end = get_monotonic_nanoseconds();
+			stageTimes[BENCHMARK_STAGE_YELLOW_RECTANGLES] = end - start;
+			values[BENCHMARK_STAGE_YELLOW_RECTANGLES] = boxCount;
+
+			start = end;
+			size_t appearanceCount = find_bar_code_appearances(rgba8, resolution->width, resolution->height, cfg, buffers.boxes, boxCount, barCodes[0].colorCount, options->pairing, &buffers.index, buffers.appearances, buffers.appearanceCapacity);
+			end = get_monotonic_nanoseconds();
+			stageTimes[BENCHMARK_STAGE_APPEARANCES] = end - start;
+			values[BENCHMARK_STAGE_APPEARANCES] = appearanceCount;
+
+			start = end;
+			size_t matchCount = find_appearances_of_bar_code(barCodes[0], 8, 0.3f, buffers.appearances, appearanceCount, buffers.results, buffers.resultScores, buffers.resultCapacity);
+			end = get_monotonic_nanoseconds();
+			stageTimes[BENCHMARK_STAGE_MATCH] = end - start;
+			values[BENCHMARK_STAGE_MATCH] = matchCount;
+
+			start = end;
+			find_appearances_of_bar_code_interests_in_bitmap(rgba8, resolution->width, resolution->height, cfg, maxYellowSpacing, buffers.contexts, BENCHMARK_BAR_CODE_COUNT, *buffers.memory);
+			end = get_monotonic_nanoseconds();
+			stageTimes[BENCHMARK_STAGE_FULL] = end - start;
+			for (size_t i = 0; i < BENCHMARK_BAR_CODE_COUNT; i++)
+				values[BENCHMARK_STAGE_FULL] += buffers.contexts[i].appearanceCount;
+
+			if (workers != NULL)
+			{
+				start = end;
+				find_appearances_of_bar_code_interests_in_bitmap_parallel(rgba8, resolution->width, resolution->height, cfg, maxYellowSpacing, buffers.contexts, BENCHMARK_BAR_CODE_COUNT, *buffers.memory, workers);
+				end = get_monotonic_nanoseconds();
+				stageTimes[BENCHMARK_STAGE_FULL_PARALLEL] = end - start;
+				for (size_t i = 0; i < BENCHMARK_BAR_CODE_COUNT; i++)
+					values[BENCHMARK_STAGE_FULL_PARALLEL] += buffers.contexts[i].appearanceCount;
+			}
+
+			if (iteration < 0)
+				continue;
+
+			for (int s = 0; s < BENCHMARK_STAGE_COUNT; s++)
+			{
+				times[s].nanoseconds[times[s].count++] = stageTimes[s];
+				times[s].values = values[s];
+			}
+		}
+
+		for (int s = 0; s < BENCHMARK_STAGE_COUNT; s++)
+		{
+			if (s != BENCHMARK_STAGE_FULL_PARALLEL || workers != NULL)
+				_print_benchmark_record(options, _yellowKernelTables[level].name, resolution, _benchmarkStageNames[s], s == BENCHMARK_STAGE_FULL_PARALLEL ? options->threadCount : 1, &scene, &times[s]);
+		}
+	}
+
+	_free_benchmark_buffers(&buffers);
+	free(nanoseconds);
+	free(rgba8);
+	return true;
+}
+
+///<summary>The names of the <see cref="BarCodeConversion"/>s in the records of --conversions.</summary>
+static const char* const _benchmarkConversionNames[BAR_CODE_CONVERSION_COUNT] =
+{
+	"convert_swap_red_blue",
+	"convert_rgb24_to_rgba8",
+	"convert_bgr24_to_rgba8",
+	"convert_rgba8_to_rgb24",
+	"convert_bgra8_to_rgb24",
+	"interleave_planes_to_rgba8",
+	"split_rgba8_to_planes",
+};
+
+///<summary>Times one <see cref="BarCodeConversion"/> of a whole frame, after a run that warms up the caches.</summary>
+static void _time_benchmark_conversion(const BenchmarkOptions* options, ThreadPool* pool, BarCodeConversion conversion, const uint8_t* const* src, uint8_t* const* dst, int width, int height, BenchmarkTimes* times)
+{
+	times->count = 0;
+	for (int iteration = -1; iteration < options->iterations; iteration++)
+	{
+		uint64_t start = get_monotonic_nanoseconds();
+		convert_bar_code_pixels(pool, conversion, src, 0, dst, 0, width, height);
+		uint64_t end = get_monotonic_nanoseconds();
+		if (iteration >= 0)
+			times->nanoseconds[times->count++] = end - start;
+	}
+}
+
+///<summary>Times every <see cref="BarCodeConversion"/> of the scene, and a memcpy of it to compare their bandwidth against, with each kernel level.
+///With more than one thread, the conversions are timed again on the threads of <paramref name="workers"/>.</summary>
+///<returns>False if the scene or the buffers could not be allocated.</returns>
+static bool _run_conversion_benchmark_resolution(const BenchmarkOptions* options, const BenchmarkResolution* resolution, const BarCode* barCodes, BarCodeFindWorkers* workers)
+{
+	int width = resolution->width, height = resolution->height;
+	size_t pixelCount = (size_t)width * (size_t)height;
+	BenchmarkSceneConfig scene = _get_benchmark_scene_config(options, resolution);
+	uint8_t* rgba8 = render_benchmark_scene(&scene, barCodes, (int)BENCHMARK_BAR_CODE_COUNT);
+	uint8_t* source = (uint8_t*)malloc(pixelCount * 3);
+	uint8_t* destination = (uint8_t*)malloc(pixelCount * 4);
+	uint64_t* nanoseconds = (uint64_t*)malloc((size_t)options->iterations * sizeof(uint64_t));
+	if (rgba8 == NULL || source == NULL || destination == NULL || nanoseconds == NULL)
+	{
+		free(nanoseconds);
+		free(destination);
+		free(source);
+		free(rgba8);
+		return false;
+	}
+
+	//The three-byte and planar sources are made from the scene once, and are not timed
+	const uint8_t* scenePlanes[3] = { rgba8, NULL, NULL };
+	uint8_t* sourcePlanes[3] = { source, source + pixelCount, source + (pixelCount * 2) };
+	uint8_t* destinationPlanes[3] = { destination, destination + pixelCount, destination + (pixelCount * 2) };
+	for (int level = 0; level <= YELLOW_KERNEL_AVX512; level++)
+	{
+		if (!options->kernels[level] || !select_yellow_kernels((YellowKernelLevel)level))
+			continue;
+
+		const char* kernel = _yellowKernelTables[level].name;
+		BenchmarkTimes times = { nanoseconds, 0, (uint64_t)pixelCount * 8 };
+		for (int iteration = -1; iteration < options->iterations; iteration++)
+		{
+			uint64_t start = get_monotonic_nanoseconds();
+			memcpy(destination, rgba8, pixelCount * 4);
+			uint64_t end = get_monotonic_nanoseconds();
+			if (iteration >= 0)
+				times.nanoseconds[times.count++] = end - start;
+		}
+		_print_benchmark_record(options, kernel, resolution, "memcpy", 1, &scene, &times);
+
+		for (int c = 0; c < BAR_CODE_CONVERSION_COUNT; c++)
+		{
+			BarCodeConversion conversion = (BarCodeConversion)c;
+			size_t srcPixelSize, dstPixelSize;
+			_get_conversion_pixel_sizes(conversion, &srcPixelSize, &dstPixelSize);
+			const uint8_t* src[3] = { rgba8, NULL, NULL };
+			if (srcPixelSize != 4)
+			{
+				convert_bar_code_pixels(NULL, srcPixelSize == 3 ? BAR_CODE_CONVERSION_RGBA8_TO_RGB24 : BAR_CODE_CONVERSION_RGBA8_TO_PLANES, scenePlanes, 0, sourcePlanes, 0, width, height);
+				for (int p = 0; p < 3; p++)
+					src[p] = sourcePlanes[p];
+			}
+
+			times.values = (uint64_t)pixelCount * ((conversion == BAR_CODE_CONVERSION_PLANES_TO_RGBA8 ? 3 : 1) * srcPixelSize + (conversion == BAR_CODE_CONVERSION_RGBA8_TO_PLANES ? 3 : 1) * dstPixelSize);
+			_time_benchmark_conversion(options, NULL, conversion, src, destinationPlanes, width, height, &times);
+			_print_benchmark_record(options, kernel, resolution, _benchmarkConversionNames[c], 1, &scene, &times);
+			if (workers != NULL)
+			{
+				_time_benchmark_conversion(options, workers->pool, conversion, src, destinationPlanes, width, height, &times);
+				_print_benchmark_record(options, kernel, resolution, _benchmarkConversionNames[c], options->threadCount, &scene, &times);
+			}
+		}
+	}
+
+	free(nanoseconds);
+	free(destination);
+	free(source);
+	free(rgba8);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!_parse_benchmark_options(argc, argv, &options))
+	{
+		fprintf(stderr, "Usage: %s [--resolutions vga,720p,1080p,1440p,4k,8k] [--kernels scalar,sse4.1,avx2,avx512] [--iterations N] [--codes N] [--clutter N]\n"
+			"       [--noise N] [--seed N] [--threads N] [--max-pair-distance N] [--max-pair-neighbors N] [--conversions] [--csv]\n", argv[0]);
+		return 2;
+	}
+
+	BarCode barCodes[BENCHMARK_BAR_CODE_COUNT];
+	for (size_t i = 0; i < BENCHMARK_BAR_CODE_COUNT; i++)
+	{
+		barCodes[i].colorCount = (int)strlen(_benchmarkBarCodes[i]);
+		for (int c = 0; c < barCodes[i].colorCount; c++)
+			barCodes[i].colors[c] = (BarCodeColor)_benchmarkBarCodes[i][c];
+	}
+
+	BarCodeFindWorkers* workers = NULL;
+	if (options.threadCount > 1)
+	{
+		workers = create_bar_code_find_workers(options.threadCount);
+		if (workers == NULL)
+		{
+			fprintf(stderr, "Could not create %d worker threads\n", options.threadCount);
+			return 1;
+		}
+	}
+
+	_print_benchmark_header(&options);
+	int result = 0;
+	for (size_t r = 0; r < BENCHMARK_RESOLUTION_COUNT; r++)
+	{
+		if (!options.resolutions[r])
+			continue;
+
+		bool ran = options.conversions ? _run_conversion_benchmark_resolution(&options, &_benchmarkResolutions[r], barCodes, workers)
+			: _run_benchmark_resolution(&options, &_benchmarkResolutions[r], barCodes, workers);
+		if (!ran)
+		{
+			fprintf(stderr, "Could not allocate the buffers for %s\n", _benchmarkResolutions[r].name);
+			result = 1;
+		}
+	}
+
+	if (workers != NULL)
+		destroy_bar_code_find_workers(workers);
+	return result;
+}
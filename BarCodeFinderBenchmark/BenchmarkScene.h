@@ -0,0 +1,190 @@
+#pragma once
+#include "BarCode.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+///<summary>A small, fast pseudo-random number generator (xorshift64*), so that a scene only depends on its seed and not on the C library.</summary>
+typedef struct BenchmarkRandom
+{
+	uint64_t state;
+} BenchmarkRandom;
+
+static uint32_t _next_benchmark_random(BenchmarkRandom* random)
+{
+	random->state ^= random->state >> 12;
+	random->state ^= random->state << 25;
+	random->state ^= random->state >> 27;
+	return (uint32_t)((random->state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+///<summary>Gets a random value from <paramref name="min"/> to <paramref name="max"/>.</summary>
+static float _next_benchmark_float(BenchmarkRandom* random, float min, float max)
+{
+	return min + ((max - min) * (float)(_next_benchmark_random(random) >> 8) / (float)(1u << 24));
+}
+
+///<summary>Describes a synthetic scene for <see cref="render_benchmark_scene"/>.</summary>
+typedef struct BenchmarkSceneConfig
+{
+	///<summary>The width of the bitmap, in pixels.</summary>
+	int width;
+
+	///<summary>The height of the bitmap, in pixels.</summary>
+	int height;
+
+	///<summary>The number of bar codes to draw.</summary>
+	int barCodeCount;
+
+	///<summary>The number of yellow blobs to scatter over the scene. Each one becomes a <see cref="YellowBoundingBox"/> that is not the end of a bar code.</summary>
+	int clutterCount;
+
+	///<summary>The largest amount that is added to or subtracted from each channel of each pixel, from 0 to 255.</summary>
+	int noise;
+
+	///<summary>The shortest and longest section of a bar code, in pixels. The thickness of a bar code is about the length of its sections.</summary>
+	float minSectionLength, maxSectionLength;
+
+	///<summary>The seed of the scene. The same config always renders the same scene.</summary>
+	uint64_t seed;
+} BenchmarkSceneConfig;
+
+///<summary>The colors that the scene draws, which are well inside the classes of the YellowConfig that the demo program uses.</summary>
+static const uint8_t _benchmarkYellow[3] = { 230, 215, 40 };
+static const uint8_t _benchmarkRed[3] = { 200, 40, 40 };
+static const uint8_t _benchmarkGreen[3] = { 40, 170, 60 };
+static const uint8_t _benchmarkBlue[3] = { 40, 60, 200 };
+
+BAR_CODE_FORCEINLINE void _put_benchmark_pixel(uint8_t* rgba8, int width, int height, int x, int y, const uint8_t* rgb)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+		return;
+
+	uint8_t* pixel = rgba8 + ((((size_t)y * (size_t)width) + (size_t)x) * 4);
+	pixel[0] = rgb[0];
+	pixel[1] = rgb[1];
+	pixel[2] = rgb[2];
+}
+
+///<summary>Draws a bar code: a yellow bar, one section per color, then another yellow bar, along a line through (centerX, centerY).</summary>
+static void _draw_benchmark_bar_code(uint8_t* rgba8, int width, int height, const BarCode* barCode, float centerX, float centerY, float angle, float sectionLength, float thickness)
+{
+	int sectionCount = barCode->colorCount + 2;
+	float length = sectionLength * (float)sectionCount;
+	float ux = cosf(angle), uy = sinf(angle);
+	float startX = centerX - (ux * length / 2), startY = centerY - (uy * length / 2);
+	int radius = (int)((length + thickness) / 2) + 2;
+	for (int y = (int)centerY - radius; y <= (int)centerY + radius; y++)
+	{
+		for (int x = (int)centerX - radius; x <= (int)centerX + radius; x++)
+		{
+			float dx = (float)x - startX, dy = (float)y - startY;
+			float along = (dx * ux) + (dy * uy);
+			float across = (dy * ux) - (dx * uy);
+			if (along < 0 || along >= length || fabsf(across) > thickness / 2)
+				continue;
+
+			int section = (int)(along / sectionLength);
+			const uint8_t* rgb = _benchmarkYellow;
+			if (section > 0 && section < sectionCount - 1)
+			{
+				switch (barCode->colors[section - 1])
+				{
+				case BAR_CODE_RED:
+					rgb = _benchmarkRed;
+					break;
+				case BAR_CODE_GREEN:
+					rgb = _benchmarkGreen;
+					break;
+				default:
+					rgb = _benchmarkBlue;
+					break;
+				}
+			}
+			_put_benchmark_pixel(rgba8, width, height, x, y, rgb);
+		}
+	}
+}
+
+///<summary>Draws a ragged yellow blob, which is clutter that the search has to pair and reject.</summary>
+static void _draw_benchmark_clutter(uint8_t* rgba8, int width, int height, BenchmarkRandom* random, float maxRadius)
+{
+	int centerX = (int)(_next_benchmark_random(random) % (uint32_t)width);
+	int centerY = (int)(_next_benchmark_random(random) % (uint32_t)height);
+	float radius = _next_benchmark_float(random, 1.0f, maxRadius);
+	int r = (int)radius;
+	for (int y = centerY - r; y <= centerY + r; y++)
+	{
+		for (int x = centerX - r; x <= centerX + r; x++)
+		{
+			float dx = (float)(x - centerX), dy = (float)(y - centerY);
+			if ((dx * dx) + (dy * dy) <= radius * radius && (_next_benchmark_random(random) & 3) != 0)
+				_put_benchmark_pixel(rgba8, width, height, x, y, _benchmarkYellow);
+		}
+	}
+}
+
+///<summary>Renders a synthetic scene: a gray textured background, bar codes at random positions, angles and scales, yellow clutter,
+///and noise on every pixel.</summary>
+///<param name="barCodes">The bar codes to choose from. Each drawn bar code is one of these, chosen at random.</param>
+///<returns>The RGBA bitmap, which the caller frees with free(), or NULL if it could not be allocated.</returns>
+static uint8_t* render_benchmark_scene(const BenchmarkSceneConfig* config, const BarCode* barCodes, int barCodeCount)
+{
+	int width = config->width, height = config->height;
+	size_t pixelCount = (size_t)width * (size_t)height;
+	uint8_t* rgba8 = (uint8_t*)malloc(pixelCount * 4);
+	if (rgba8 == NULL)
+		return NULL;
+
+	BenchmarkRandom random = { (config->seed * 0x9E3779B97F4A7C15ull) | 1 };
+
+	//Background: gray blocks of slightly different brightness, so the lines between the codes are not all the same
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			uint32_t block = (uint32_t)((x / 32) * 7919 + (y / 32) * 104729) ^ (uint32_t)config->seed;
+			uint8_t value = (uint8_t)(80 + ((block * 2654435761u) >> 26));
+			uint8_t* pixel = rgba8 + ((((size_t)y * (size_t)width) + (size_t)x) * 4);
+			pixel[0] = value;
+			pixel[1] = value;
+			pixel[2] = value;
+			pixel[3] = 255;
+		}
+	}
+
+	float margin = config->maxSectionLength * (BAR_CODE_MAX_COLOR_COUNT + 2) / 2;
+	for (int i = 0; i < config->barCodeCount && barCodeCount > 0; i++)
+	{
+		const BarCode* barCode = &barCodes[_next_benchmark_random(&random) % (uint32_t)barCodeCount];
+		float sectionLength = _next_benchmark_float(&random, config->minSectionLength, config->maxSectionLength);
+		float x = _next_benchmark_float(&random, 0, (float)width), y = _next_benchmark_float(&random, 0, (float)height);
+		if (width > 2 * margin && height > 2 * margin)
+		{
+			x = _next_benchmark_float(&random, margin, (float)width - margin);
+			y = _next_benchmark_float(&random, margin, (float)height - margin);
+		}
+		float angle = _next_benchmark_float(&random, 0, 6.2831853f);
+		float thickness = sectionLength * _next_benchmark_float(&random, 0.6f, 1.2f);
+		_draw_benchmark_bar_code(rgba8, width, height, barCode, x, y, angle, sectionLength, thickness);
+	}
+
+	for (int i = 0; i < config->clutterCount; i++)
+		_draw_benchmark_clutter(rgba8, width, height, &random, config->maxSectionLength);
+
+	if (config->noise > 0)
+	{
+		uint32_t span = (uint32_t)(2 * config->noise) + 1;
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			uint32_t bits = _next_benchmark_random(&random);
+			for (int c = 0; c < 3; c++)
+			{
+				int value = rgba8[(i * 4) + c] + (int)((bits >> (c * 10)) % span) - config->noise;
+				rgba8[(i * 4) + c] = (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+			}
+		}
+	}
+	return rgba8;
+}
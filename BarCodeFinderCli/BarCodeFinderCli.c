@@ -0,0 +1,525 @@
+//Searches a batch of frames for bar codes without a display, spreading the frames over a thread pool, and prints the appearances of each frame
+//as one JSON object per line, in the order of the inputs.
+//
+//Usage: BarCodeFinderCli --code RGB [--code GBBRG ...] [--raw WIDTHxHEIGHT:rgba|bgra|rgb24|yuyv|nv12] [--threads 0] [--yellow 45,50,170]
+//                        [--max-yellow-spacing 2] [--min-score 0.1] [--min-line-distance 8] [--max-appearances 64]
+//                        [--max-pair-distance 0] [--max-pair-neighbors 0] [--no-summary] INPUT...
+//
+//Each INPUT is a frame, a directory (whose frames are read in name order, but not its subdirectories) or @LIST, a file that lists one frame per
+//line. A frame is a binary PPM (.ppm), a PNG (.png, if libpng was found when the tool was built) or, with --raw, any other file that holds one
+//frame of the given size and format. --threads 0 uses every processor.
+//
+//When every frame has been searched, a summary with the number of frames per second and the percentiles of the per-frame latency (reading
+//plus searching) is printed to stderr as one JSON object. The exit code is 0 if every frame was read, 1 if some were not, and 2 if the command
+//line is not valid.
+#include "BarCode.h"
+#include "ThreadPool.h"
+#include "FrameReader.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+///<summary>The largest number of bar codes that one run can search for.</summary>
+#define CLI_MAX_BAR_CODE_COUNT (64)
+
+///<summary>The options of a run, parsed from the command line.</summary>
+typedef struct CliOptions
+{
+	BarCode barCodes[CLI_MAX_BAR_CODE_COUNT];
+	const char* barCodeNames[CLI_MAX_BAR_CODE_COUNT];
+	size_t barCodeCount;
+	RawFrameFormat raw;
+	int threadCount;
+	YellowConfig yellowCfg;
+	int maxYellowSpacing;
+	float minMatchScore;
+	int minLineDistance;
+	size_t maxAppearances;
+	BarCodePairingConfig pairing;
+	bool summary;
+} CliOptions;
+
+///<summary>What the search of one frame produced. Filled in by a worker, and printed by the main thread once every frame before it has been printed.</summary>
+typedef struct FrameResult
+{
+	///<summary>The JSON record of the frame, which is freed once it has been printed.</summary>
+	char* record;
+
+	///<summary>Nanoseconds spent reading and searching the frame.</summary>
+	uint64_t latency;
+
+	///<summary>Whether the frame was read.</summary>
+	bool succeeded;
+} FrameResult;
+
+///<summary>A growable string, which a worker reuses for the record of every frame it searches.</summary>
+typedef struct CliText
+{
+	char* text;
+	size_t length;
+	size_t capacity;
+} CliText;
+
+///<summary>What a worker keeps from one frame to the next: its frame buffer, its <see cref="BarCodeFindTemporaryMemory"/> (which grows until it holds
+///the largest frame) and its <see cref="BarCodeFindContext"/>s. No two frames that use the same worker are searched at once.</summary>
+typedef struct CliWorker
+{
+	Frame frame;
+	BarCodeFindTemporaryMemory* memory;
+	BarCodeFindContext* contexts;
+	CliText text;
+} CliWorker;
+
+///<summary>The state that is shared by the items of one <see cref="parallel_for"/>.</summary>
+typedef struct CliBatch
+{
+	const CliOptions* options;
+	CliWorker* workers;
+	char** paths;
+	FrameResult* results;
+} CliBatch;
+
+///<summary>The number of frames that are searched before their records are printed, per thread. It bounds the number of records that wait to be printed.</summary>
+#define CLI_FRAMES_PER_THREAD (16)
+
+///<summary>The number of times that a frame is searched again after the <see cref="BarCodeFindTemporaryMemory"/> has grown because a stage overflowed.</summary>
+#define CLI_MAX_SEARCH_RETRIES (4)
+
+static int _compare_uint64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+///<summary>Appends formatted text. If the text cannot grow, the rest is dropped.</summary>
+static void _append_text(CliText* text, const char* format, ...)
+{
+	while (true)
+	{
+		va_list args;
+		va_start(args, format);
+		size_t available = text->capacity - text->length;
+		int written = vsnprintf(text->text != NULL ? text->text + text->length : NULL, available, format, args);
+		va_end(args);
+		if (written < 0)
+			return;
+		if ((size_t)written < available)
+		{
+			text->length += (size_t)written;
+			return;
+		}
+
+		size_t capacity = text->capacity < 256 ? 1024 : text->capacity * 2;
+		while (capacity - text->length <= (size_t)written)
+			capacity *= 2;
+		char* grown = (char*)realloc(text->text, capacity);
+		if (grown == NULL)
+			return;
+		text->text = grown;
+		text->capacity = capacity;
+	}
+}
+
+///<summary>Appends a JSON string, escaping the characters that JSON does not allow in one.</summary>
+static void _append_json_string(CliText* text, const char* value)
+{
+	_append_text(text, "\"");
+	for (const unsigned char* c = (const unsigned char*)value; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			_append_text(text, "\\%c", *c);
+		else if (*c < 0x20)
+			_append_text(text, "\\u%04x", *c);
+		else
+			_append_text(text, "%c", *c);
+	}
+	_append_text(text, "\"");
+}
+
+///<summary>Copies the text of a worker into a new string.</summary>
+static char* _copy_text(const CliText* text)
+{
+	char* copy = (char*)malloc(text->length + 1);
+	if (copy != NULL)
+	{
+		if (text->length > 0)
+			memcpy(copy, text->text, text->length);
+		copy[text->length] = '\0';
+	}
+	return copy;
+}
+
+///<summary>Checks whether a stage of the last search overflowed and can still grow, so that searching the frame again would find more.</summary>
+static bool _can_grow_after_overflow(const BarCodeFindTemporaryMemory* memory)
+{
+	for (int i = 0; i < BAR_CODE_FIND_STAGE_COUNT; i++)
+	{
+		BarCodeFindStage stage = (BarCodeFindStage)i;
+		if (memory->usage[stage].overflowed && get_bar_code_find_stage_capacity(memory, stage) < memory->maxCapacities[stage])
+			return true;
+	}
+	return false;
+}
+
+///<summary>Checks whether a stage of the last search overflowed, so that its results may be missing some appearances.</summary>
+static bool _overflowed(const BarCodeFindTemporaryMemory* memory)
+{
+	for (int i = 0; i < BAR_CODE_FIND_STAGE_COUNT; i++)
+	{
+		if (memory->usage[i].overflowed)
+			return true;
+	}
+	return false;
+}
+
+///<summary>Reads and searches one frame (the task of <see cref="parallel_for"/>), and formats its record.</summary>
+static void _search_frame(void* arg, size_t index, int workerIndex)
+{
+	CliBatch* batch = (CliBatch*)arg;
+	const CliOptions* options = batch->options;
+	CliWorker* worker = &batch->workers[workerIndex];
+	FrameResult* result = &batch->results[index];
+	const char* path = batch->paths[index];
+
+	uint64_t start = get_monotonic_nanoseconds();
+	const char* error = read_frame(path, &options->raw, &worker->frame);
+	uint64_t read = get_monotonic_nanoseconds();
+
+	worker->text.length = 0;
+	_append_text(&worker->text, "{\"file\":");
+	_append_json_string(&worker->text, path);
+	if (error != NULL)
+	{
+		_append_text(&worker->text, ",\"error\":");
+		_append_json_string(&worker->text, error);
+		_append_text(&worker->text, "}");
+		result->record = _copy_text(&worker->text);
+		result->latency = read - start;
+		result->succeeded = false;
+		return;
+	}
+
+	//A stage that overflowed has grown for the next frame, so this one is searched again rather than reported with missing appearances
+	const BarCodeImage* image = &worker->frame.image;
+	for (int attempt = 0; ; attempt++)
+	{
+		find_appearances_of_bar_code_interests_in_image(image, options->yellowCfg, options->maxYellowSpacing, worker->contexts, options->barCodeCount, *worker->memory);
+		bool retry = attempt < CLI_MAX_SEARCH_RETRIES && _can_grow_after_overflow(worker->memory);
+		grow_bar_code_find_temporary_memory(worker->memory);
+		if (!retry)
+			break;
+	}
+	uint64_t end = get_monotonic_nanoseconds();
+
+	_append_text(&worker->text, ",\"width\":%d,\"height\":%d,\"read_ms\":%.3f,\"search_ms\":%.3f,\"truncated\":%s,\"appearances\":[", image->width, image->height,
+		(double)(read - start) / 1000000.0, (double)(end - read) / 1000000.0, _overflowed(worker->memory) ? "true" : "false");
+	bool first = true;
+	for (size_t c = 0; c < options->barCodeCount; c++)
+	{
+		const BarCodeFindContext* context = &worker->contexts[c];
+		for (size_t i = 0; i < context->appearanceCount; i++)
+		{
+			const BarCodeAppearance* appearance = &context->appearanceBuffer[i];
+			_append_text(&worker->text, "%s{\"code\":\"%s\",\"score\":%.4f,\"start\":[%d,%d],\"end\":[%d,%d]}", first ? "" : ",", options->barCodeNames[c],
+				context->appearanceMatchScores[i], appearance->colorStartX, appearance->colorStartY, appearance->colorEndX, appearance->colorEndY);
+			first = false;
+		}
+	}
+	_append_text(&worker->text, "]}");
+
+	result->record = _copy_text(&worker->text);
+	result->latency = end - start;
+	result->succeeded = true;
+}
+
+///<returns>False if the worker could not be allocated. It is then freed by <see cref="_free_cli_worker"/>.</returns>
+static bool _create_cli_worker(CliWorker* worker, const CliOptions* options)
+{
+	memset(worker, 0, sizeof(CliWorker));
+
+	//Enough for a 1080p frame with some clutter. The buffers grow (and stay grown) when a frame needs more.
+	worker->memory = allocate_bar_code_find_temporary_memory(16384, 4096, 4096, 4096, 1024, BAR_CODE_ARENA_DEFAULT);
+	worker->contexts = (BarCodeFindContext*)calloc(options->barCodeCount, sizeof(BarCodeFindContext));
+	if (worker->memory == NULL || worker->contexts == NULL)
+		return false;
+
+	worker->memory->pairing = options->pairing;
+	worker->memory->maxCapacities[BAR_CODE_FIND_STAGE_SCAN_LINES] = (size_t)1 << 22;
+	worker->memory->maxCapacities[BAR_CODE_FIND_STAGE_YELLOW_BOXES] = (size_t)1 << 20;
+	worker->memory->maxCapacities[BAR_CODE_FIND_STAGE_APPEARANCES] = (size_t)1 << 20;
+	worker->memory->maxCapacities[BAR_CODE_FIND_STAGE_MATCHES] = (size_t)1 << 20;
+
+	for (size_t i = 0; i < options->barCodeCount; i++)
+	{
+		BarCodeFindContext* context = &worker->contexts[i];
+		context->barCode = options->barCodes[i];
+		context->minMatchScore = options->minMatchScore;
+		context->minLineDistance = options->minLineDistance;
+		context->appearanceBufferCapacity = options->maxAppearances;
+		context->appearanceBuffer = (BarCodeAppearance*)malloc(options->maxAppearances * sizeof(BarCodeAppearance));
+		context->appearanceMatchScores = (float*)malloc(options->maxAppearances * sizeof(float));
+		if (context->appearanceBuffer == NULL || context->appearanceMatchScores == NULL)
+			return false;
+	}
+	return true;
+}
+
+static void _free_cli_worker(CliWorker* worker, size_t contextCount)
+{
+	if (worker->contexts != NULL)
+	{
+		for (size_t i = 0; i < contextCount; i++)
+		{
+			free(worker->contexts[i].appearanceBuffer);
+			free(worker->contexts[i].appearanceMatchScores);
+		}
+		free(worker->contexts);
+	}
+	if (worker->memory != NULL)
+		free_bar_code_find_temporary_memory(worker->memory);
+	free_frame(&worker->frame);
+	free(worker->text.text);
+}
+
+///<summary>Parses a bar code such as "RGB".</summary>
+///<returns>False if it is not a valid bar code.</returns>
+static bool _parse_bar_code(const char* value, BarCode* barCode)
+{
+	size_t length = strlen(value);
+	if (length == 0 || length > BAR_CODE_MAX_COLOR_COUNT)
+		return false;
+
+	barCode->colorCount = length;
+	for (size_t i = 0; i < length; i++)
+	{
+		char color = (char)toupper((unsigned char)value[i]);
+		if (color != BAR_CODE_RED && color != BAR_CODE_GREEN && color != BAR_CODE_BLUE)
+			return false;
+		barCode->colors[i] = (BarCodeColor)color;
+	}
+	return true;
+}
+
+///<summary>Parses the --raw option, such as "1920x1080:nv12".</summary>
+///<returns>False if it is not valid.</returns>
+static bool _parse_raw_frame_format(const char* value, RawFrameFormat* raw)
+{
+	static const char* const formatNames[BAR_CODE_PIXEL_FORMAT_COUNT] = { "rgba", "bgra", "rgb24", "yuyv", "nv12" };
+
+	char formatName[16];
+	if (sscanf(value, "%dx%d:%15s", &raw->width, &raw->height, formatName) != 3 || raw->width <= 0 || raw->height <= 0)
+		return false;
+
+	for (int i = 0; i < BAR_CODE_PIXEL_FORMAT_COUNT; i++)
+	{
+		if (strcmp(formatName, formatNames[i]) == 0)
+		{
+			raw->format = (BarCodePixelFormat)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+///<returns>False if the command line is not valid.</returns>
+static bool _parse_cli_options(int argc, char** argv, CliOptions* options, PathList* inputs)
+{
+	memset(options, 0, sizeof(CliOptions));
+	options->yellowCfg.maxRedGreenSeparation = 45;//The configuration of the demo program
+	options->yellowCfg.minRedBlueSeparation = 50;
+	options->yellowCfg.minRed = 170;
+	options->maxYellowSpacing = 2;
+	options->minMatchScore = 0.1f;
+	options->minLineDistance = 8;
+	options->maxAppearances = 64;
+	options->summary = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strncmp(option, "--", 2) != 0)
+		{
+			//The inputs are collected once the options are known, since --raw changes which files a directory holds
+			if (!add_path(inputs, option))
+				return false;
+			continue;
+		}
+		if (strcmp(option, "--no-summary") == 0)
+		{
+			options->summary = false;
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false;
+
+		const char* value = argv[++i];
+		if (strcmp(option, "--code") == 0)
+		{
+			if (options->barCodeCount == CLI_MAX_BAR_CODE_COUNT || !_parse_bar_code(value, &options->barCodes[options->barCodeCount]))
+				return false;
+			options->barCodeNames[options->barCodeCount++] = value;
+		}
+		else if (strcmp(option, "--raw") == 0)
+		{
+			if (!_parse_raw_frame_format(value, &options->raw))
+				return false;
+		}
+		else if (strcmp(option, "--threads") == 0)
+			options->threadCount = atoi(value);
+		else if (strcmp(option, "--yellow") == 0)
+		{
+			int maxRedGreenSeparation, minRedBlueSeparation, minRed;
+			if (sscanf(value, "%d,%d,%d", &maxRedGreenSeparation, &minRedBlueSeparation, &minRed) != 3)
+				return false;
+			options->yellowCfg.maxRedGreenSeparation = maxRedGreenSeparation;
+			options->yellowCfg.minRedBlueSeparation = minRedBlueSeparation;
+			options->yellowCfg.minRed = minRed;
+		}
+		else if (strcmp(option, "--max-yellow-spacing") == 0)
+			options->maxYellowSpacing = atoi(value);
+		else if (strcmp(option, "--min-score") == 0)
+			options->minMatchScore = (float)atof(value);
+		else if (strcmp(option, "--min-line-distance") == 0)
+			options->minLineDistance = atoi(value);
+		else if (strcmp(option, "--max-appearances") == 0)
+			options->maxAppearances = (size_t)atoi(value);
+		else if (strcmp(option, "--max-pair-distance") == 0)
+			options->pairing.maxDistance = atoi(value);
+		else if (strcmp(option, "--max-pair-neighbors") == 0)
+			options->pairing.maxNeighbors = atoi(value);
+		else
+			return false;
+	}
+
+	return options->barCodeCount > 0 && inputs->count > 0 && options->threadCount >= 0 && options->maxYellowSpacing >= 0 && options->minLineDistance >= 0
+		&& options->maxAppearances >= 1 && options->pairing.maxDistance >= 0 && options->pairing.maxNeighbors >= 0
+		&& options->pairing.maxNeighbors <= BAR_CODE_MAX_PAIR_NEIGHBORS;
+}
+
+///<summary>Expands the inputs of the command line (frames, directories and @LIST files) into the list of frames.</summary>
+///<returns>False if a directory or list file could not be read.</returns>
+static bool _collect_frames(const PathList* inputs, const RawFrameFormat* raw, PathList* frames)
+{
+	for (size_t i = 0; i < inputs->count; i++)
+	{
+		const char* input = inputs->paths[i];
+		bool added = true;
+		if (input[0] == '@')
+			added = add_list_file(frames, input + 1);
+		else if (is_directory(input))
+			added = add_directory(frames, input, raw);
+		else
+			added = add_path(frames, input);
+
+		if (!added)
+		{
+			fprintf(stderr, "Could not read %s\n", input);
+			return false;
+		}
+	}
+	return true;
+}
+
+///<summary>Gets a percentile of sorted latencies, in milliseconds.</summary>
+static double _get_latency_percentile(const uint64_t* sortedLatencies, size_t count, double percentile)
+{
+	if (count == 0)
+		return 0.0;
+
+	size_t index = (size_t)((percentile / 100.0) * (double)(count - 1) + 0.5);
+	return (double)sortedLatencies[index] / 1000000.0;
+}
+
+static void _print_cli_summary(uint64_t* latencies, size_t frameCount, size_t failedCount, int threadCount, uint64_t elapsed)
+{
+	qsort(latencies, frameCount, sizeof(uint64_t), _compare_uint64);
+	uint64_t sum = 0;
+	for (size_t i = 0; i < frameCount; i++)
+		sum += latencies[i];
+
+	double seconds = (double)elapsed / 1000000000.0;
+	fprintf(stderr, "{\"frames\":%llu,\"failed\":%llu,\"threads\":%d,\"seconds\":%.3f,\"frames_per_second\":%.2f,\"latency_ms\":{\"mean\":%.3f,\"p50\":%.3f,"
+		"\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}}\n", (unsigned long long)frameCount, (unsigned long long)failedCount, threadCount, seconds,
+		seconds > 0 ? (double)frameCount / seconds : 0.0, frameCount > 0 ? (double)sum / (double)frameCount / 1000000.0 : 0.0,
+		_get_latency_percentile(latencies, frameCount, 50), _get_latency_percentile(latencies, frameCount, 90), _get_latency_percentile(latencies, frameCount, 99),
+		_get_latency_percentile(latencies, frameCount, 100));
+}
+
+int main(int argc, char** argv)
+{
+	CliOptions options;
+	PathList inputs = { 0 }, frames = { 0 };
+	if (!_parse_cli_options(argc, argv, &options, &inputs))
+	{
+		fprintf(stderr, "Usage: %s --code RGB [--code GBBRG ...] [--raw WIDTHxHEIGHT:rgba|bgra|rgb24|yuyv|nv12] [--threads N] [--yellow R,G,B]\n"
+			"       [--max-yellow-spacing N] [--min-score F] [--min-line-distance N] [--max-appearances N] [--max-pair-distance N]\n"
+			"       [--max-pair-neighbors N] [--no-summary] FRAME|DIRECTORY|@LIST...\n", argv[0]);
+		free_path_list(&inputs);
+		return 2;
+	}
+
+	bool collected = _collect_frames(&inputs, &options.raw, &frames);
+	free_path_list(&inputs);
+	if (!collected)
+	{
+		free_path_list(&frames);
+		return 1;
+	}
+
+	ThreadPool* pool = create_thread_pool(options.threadCount);
+	int threadCount = pool != NULL ? get_thread_pool_size(pool) : 0;
+	size_t batchSize = (size_t)threadCount * CLI_FRAMES_PER_THREAD;
+	CliWorker* workers = (CliWorker*)calloc((size_t)(threadCount > 0 ? threadCount : 1), sizeof(CliWorker));
+	FrameResult* results = (FrameResult*)calloc(batchSize > 0 ? batchSize : 1, sizeof(FrameResult));
+	uint64_t* latencies = (uint64_t*)malloc((frames.count > 0 ? frames.count : 1) * sizeof(uint64_t));
+	bool created = pool != NULL && workers != NULL && results != NULL && latencies != NULL;
+	for (int i = 0; created && i < threadCount; i++)
+		created = _create_cli_worker(&workers[i], &options);
+
+	int exitCode = 0;
+	if (!created)
+	{
+		fprintf(stderr, "Could not allocate %d workers\n", threadCount);
+		exitCode = 1;
+	}
+	else
+	{
+		CliBatch batch = { &options, workers, NULL, results };
+		size_t failedCount = 0;
+		uint64_t start = get_monotonic_nanoseconds();
+		for (size_t first = 0; first < frames.count; first += batchSize)
+		{
+			size_t count = frames.count - first < batchSize ? frames.count - first : batchSize;
+			batch.paths = frames.paths + first;
+			parallel_for(pool, count, _search_frame, &batch);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				if (results[i].record != NULL)
+					puts(results[i].record);
+				free(results[i].record);
+				results[i].record = NULL;
+				latencies[first + i] = results[i].latency;
+				if (!results[i].succeeded)
+					failedCount++;
+			}
+			fflush(stdout);
+		}
+
+		if (options.summary)
+			_print_cli_summary(latencies, frames.count, failedCount, threadCount, get_monotonic_nanoseconds() - start);
+		exitCode = failedCount > 0 ? 1 : 0;
+	}
+
+	if (workers != NULL)
+	{
+		for (int i = 0; i < threadCount; i++)
+			_free_cli_worker(&workers[i], options.barCodeCount);
+	}
+	free(workers);
+	free(results);
+	free(latencies);
+	if (pool != NULL)
+		destroy_thread_pool(pool);
+	free_path_list(&frames);
+	return exitCode;
+}
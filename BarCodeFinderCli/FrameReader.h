@@ -0,0 +1,354 @@
+#pragma once
+#include "BarCodeImage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#if defined(BAR_CODE_CLI_PNG)
+#include <png.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+///<summary>Describes the frames of files that have no header, which are read by <see cref="read_frame"/> when their size matches.</summary>
+typedef struct RawFrameFormat
+{
+	///<summary>The width of each frame, in pixels. Zero if raw frames are not accepted.</summary>
+	int width;
+
+	///<summary>The height of each frame, in pixels.</summary>
+	int height;
+
+	///<summary>The <see cref="BarCodePixelFormat"/> of the frames, whose rows are packed.</summary>
+	BarCodePixelFormat format;
+} RawFrameFormat;
+
+///<summary>A decoded frame. Its pixels are kept between frames, so a reader that reads many frames of the same size only allocates once.</summary>
+typedef struct Frame
+{
+	///<summary>The pixels, described by <see cref="image"/>.</summary>
+	uint8_t* pixels;
+
+	///<summary>The number of bytes that fit in <see cref="pixels"/>.</summary>
+	size_t capacity;
+
+	///<summary>The frame. Its pixels point into <see cref="pixels"/>.</summary>
+	BarCodeImage image;
+} Frame;
+
+///<summary>Gets the number of bytes of a packed frame.</summary>
+static size_t _get_frame_size(int width, int height, BarCodePixelFormat format)
+{
+	BarCodeImage image = bar_code_image(NULL, width, height, 0, format);
+	size_t size = _get_image_row_size(&image) * (size_t)height;
+	//A packed NV12 chroma row holds a U, V pair for each two pixels, so it is one byte longer than a luma row if the width is odd
+	if (format == BAR_CODE_PIXEL_FORMAT_NV12)
+		size += (size_t)((width + 1) / 2) * 2 * (size_t)((height + 1) / 2);
+	return size;
+}
+
+///<returns>False if the buffer could not be grown.</returns>
+static bool _reserve_frame(Frame* frame, size_t size)
+{
+	if (size <= frame->capacity)
+		return true;
+
+	uint8_t* pixels = (uint8_t*)realloc(frame->pixels, size);
+	if (pixels == NULL)
+		return false;
+	frame->pixels = pixels;
+	frame->capacity = size;
+	return true;
+}
+
+static void free_frame(Frame* frame)
+{
+	free(frame->pixels);
+	frame->pixels = NULL;
+	frame->capacity = 0;
+}
+
+///<summary>Checks whether <paramref name="path"/> ends with <paramref name="extension"/>, ignoring case.</summary>
+static bool _has_extension(const char* path, const char* extension)
+{
+	size_t pathLength = strlen(path), extensionLength = strlen(extension);
+	if (pathLength < extensionLength)
+		return false;
+
+	for (size_t i = 0; i < extensionLength; i++)
+	{
+		if (tolower((unsigned char)path[pathLength - extensionLength + i]) != tolower((unsigned char)extension[i]))
+			return false;
+	}
+	return true;
+}
+
+///<summary>Reads the next number of a PPM header, skipping whitespace and comments.</summary>
+///<returns>The number, or -1 if there is none.</returns>
+static int _read_ppm_number(FILE* file)
+{
+	int c = fgetc(file);
+	while (c != EOF && (isspace(c) || c == '#'))
+	{
+		if (c == '#')
+		{
+			while (c != EOF && c != '\n')
+				c = fgetc(file);
+		}
+		c = fgetc(file);
+	}
+
+	int value = 0;
+	if (c == EOF || !isdigit(c))
+		return -1;
+	for (; c != EOF && isdigit(c); c = fgetc(file))
+	{
+		if (value > (INT32_MAX - 9) / 10)
+			return -1;
+		value = (value * 10) + (c - '0');
+	}
+	return value;//The single whitespace character after the number has been consumed, as the format requires
+}
+
+///<summary>Reads a binary (P6) PPM file with 8-bit channels. Its pixels are kept as RGB24, since the search reads that format directly.</summary>
+static const char* _read_ppm_frame(FILE* file, Frame* frame)
+{
+	if (fgetc(file) != 'P' || fgetc(file) != '6')
+		return "not a binary (P6) PPM file";
+
+	int width = _read_ppm_number(file), height = _read_ppm_number(file), maxValue = _read_ppm_number(file);
+	if (width <= 0 || height <= 0 || maxValue <= 0)
+		return "invalid PPM header";
+	if (maxValue > 255)
+		return "16-bit PPM files are not supported";
+
+	size_t size = (size_t)width * (size_t)height * 3;
+	if (!_reserve_frame(frame, size))
+		return "out of memory";
+	if (fread(frame->pixels, 1, size, file) != size)
+		return "truncated PPM file";
+
+	frame->image = bar_code_image(frame->pixels, width, height, 0, BAR_CODE_PIXEL_FORMAT_RGB24);
+	return NULL;
+}
+
+///<summary>Reads a frame without a header, whose size must match <paramref name="raw"/>.</summary>
+static const char* _read_raw_frame(FILE* file, const RawFrameFormat* raw, Frame* frame)
+{
+	if (raw->width <= 0)
+		return "unknown file type (pass --raw to read frames without a header)";
+
+	size_t size = _get_frame_size(raw->width, raw->height, raw->format);
+	if (fseek(file, 0, SEEK_END) != 0 || ftell(file) != (long)size || fseek(file, 0, SEEK_SET) != 0)
+		return "the size of the raw frame does not match --raw";
+	if (!_reserve_frame(frame, size))
+		return "out of memory";
+	if (fread(frame->pixels, 1, size, file) != size)
+		return "could not read the raw frame";
+
+	frame->image = bar_code_image(frame->pixels, raw->width, raw->height, 0, raw->format);
+	return NULL;
+}
+
+#if defined(BAR_CODE_CLI_PNG)
+///<summary>Reads a PNG file with libpng, converting it to RGBA.</summary>
+static const char* _read_png_frame(const char* path, Frame* frame)
+{
+	png_image png;
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&png, path))
+		return "invalid PNG file";
+
+	png.format = PNG_FORMAT_RGBA;
+	size_t size = PNG_IMAGE_SIZE(png);
+	if (!_reserve_frame(frame, size))
+	{
+		png_image_free(&png);
+		return "out of memory";
+	}
+	if (!png_image_finish_read(&png, NULL, frame->pixels, 0, NULL))
+	{
+		png_image_free(&png);
+		return "invalid PNG file";
+	}
+
+	frame->image = bar_code_image(frame->pixels, (int)png.width, (int)png.height, 0, BAR_CODE_PIXEL_FORMAT_RGBA8);
+	return NULL;
+}
+#endif
+
+///<summary>Reads a frame from a file: a binary PPM (.ppm), a PNG (.png, if the tool was built with libpng) or, for any other file, a raw frame.</summary>
+///<param name="frame">Receives the frame. Its buffer is reused.</param>
+///<returns>NULL if the frame was read, otherwise a description of the error.</returns>
+static const char* read_frame(const char* path, const RawFrameFormat* raw, Frame* frame)
+{
+	if (_has_extension(path, ".png"))
+	{
+#if defined(BAR_CODE_CLI_PNG)
+		return _read_png_frame(path, frame);
+#else
+		return "PNG files are not supported (libpng was not found when the tool was built)";
+#endif
+	}
+
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return "could not open the file";
+
+	const char* error = _has_extension(path, ".ppm") ? _read_ppm_frame(file, frame) : _read_raw_frame(file, raw, frame);
+	fclose(file);
+	return error;
+}
+
+///<summary>A growable list of paths.</summary>
+typedef struct PathList
+{
+	char** paths;
+	size_t count;
+	size_t capacity;
+} PathList;
+
+///<returns>False if the path could not be added.</returns>
+static bool add_path(PathList* list, const char* path)
+{
+	if (list->count == list->capacity)
+	{
+		size_t capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+		char** paths = (char**)realloc(list->paths, capacity * sizeof(char*));
+		if (paths == NULL)
+			return false;
+		list->paths = paths;
+		list->capacity = capacity;
+	}
+
+	size_t length = strlen(path);
+	char* copy = (char*)malloc(length + 1);
+	if (copy == NULL)
+		return false;
+	memcpy(copy, path, length + 1);
+	list->paths[list->count++] = copy;
+	return true;
+}
+
+static void free_path_list(PathList* list)
+{
+	for (size_t i = 0; i < list->count; i++)
+		free(list->paths[i]);
+	free(list->paths);
+	memset(list, 0, sizeof(PathList));
+}
+
+static int _compare_paths(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+///<summary>Checks whether a file in a directory should be read: any PPM or PNG file, and any other file if raw frames are accepted.</summary>
+static bool _is_frame_file(const char* name, const RawFrameFormat* raw)
+{
+	if (name[0] == '.')
+		return false;
+	return _has_extension(name, ".ppm") || _has_extension(name, ".png") || raw->width > 0;
+}
+
+///<summary>Adds the frame files of a directory (not its subdirectories) to a list, sorted by name, so every run reads them in the same order.</summary>
+///<returns>False if the directory could not be read.</returns>
+static bool add_directory(PathList* list, const char* directory, const RawFrameFormat* raw)
+{
+	size_t first = list->count;
+	size_t directoryLength = strlen(directory);
+	char* path = (char*)malloc(directoryLength + 2 + 4096);
+	if (path == NULL)
+		return false;
+	memcpy(path, directory, directoryLength);
+	path[directoryLength] = '/';
+
+#if defined(_WIN32)
+	memcpy(path + directoryLength + 1, "*", 2);
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(path, &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		free(path);
+		return false;
+	}
+	do
+	{
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 && _is_frame_file(data.cFileName, raw) && strlen(data.cFileName) < 4096)
+		{
+			memcpy(path + directoryLength + 1, data.cFileName, strlen(data.cFileName) + 1);
+			add_path(list, path);
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(directory);
+	if (dir == NULL)
+	{
+		free(path);
+		return false;
+	}
+	for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir))
+	{
+		if (!_is_frame_file(entry->d_name, raw) || strlen(entry->d_name) >= 4096)
+			continue;
+
+		memcpy(path + directoryLength + 1, entry->d_name, strlen(entry->d_name) + 1);
+		struct stat info;
+		if (stat(path, &info) == 0 && S_ISREG(info.st_mode))
+			add_path(list, path);
+	}
+	closedir(dir);
+#endif
+
+	free(path);
+	qsort(list->paths + first, list->count - first, sizeof(char*), _compare_paths);
+	return true;
+}
+
+///<summary>Checks whether a path is a directory.</summary>
+static bool is_directory(const char* path)
+{
+#if defined(_WIN32)
+	DWORD attributes = GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat info;
+	return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+///<summary>Adds the paths of a list file (one per line; empty lines and lines that start with '#' are skipped) to a list.</summary>
+///<returns>False if the list file could not be read.</returns>
+static bool add_list_file(PathList* list, const char* listPath)
+{
+	FILE* file = fopen(listPath, "r");
+	if (file == NULL)
+		return false;
+
+	char line[4096];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		size_t length = strlen(line);
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+			line[--length] = '\0';
+		if (length > 0 && line[0] != '#')
+			add_path(list, line);
+	}
+	fclose(file);
+	return true;
+}